@@ -402,3 +402,86 @@ const boost::array<uint16_t, 8> CHashKey8::getRoles() const {
 	 */
 	return roles;
 }
+
+/* *************************************************************
+ * Key type HashKeyIdPair: address id pair key                 *
+ * *************************************************************/
+
+HashKeyIdPair::HashKeyIdPair(const uint32_t id1, const uint32_t id2) {
+	memcpy(key.begin(), &id1, sizeof(uint32_t));
+	memcpy(key.begin() + 4, &id2, sizeof(uint32_t));
+}
+
+HashKeyIdPair::HashKeyIdPair(const HashKeyIdPair & b) {
+	key = b.key;
+}
+
+HashKeyIdPair::~HashKeyIdPair() {
+	// nothing to do in here
+}
+
+size_t HashKeyIdPair::size() const {
+	return key.size();
+}
+
+const HashKeyIdPair::key_type & HashKeyIdPair::getkey() const {
+	return key;
+}
+
+std::string HashKeyIdPair::printkey() const {
+	uint32_t id1, id2;
+	memcpy(&id1, key.begin(), sizeof(uint32_t));
+	memcpy(&id2, key.begin() + 4, sizeof(uint32_t));
+	std::stringstream ss;
+	ss << id1 << " " << id2;
+	return ss.str();
+}
+
+/* *************************************************************
+ * Key type HashKeyId_4T: address id Four-Tuple key            *
+ * *************************************************************/
+
+HashKeyId_4T::HashKeyId_4T(const uint32_t id, const uint8_t & protocol, const uint16_t & port, const uint8_t & flowtype) {
+	memcpy(key.begin(), &id, sizeof(uint32_t));
+	memcpy(key.begin() + 4, &protocol, sizeof(uint8_t));
+	memcpy(key.begin() + 5, &flowtype, sizeof(uint8_t));
+	memcpy(key.begin() + 6, &port, sizeof(uint16_t));
+}
+
+HashKeyId_4T::HashKeyId_4T(const HashKeyId_4T & b) {
+	key = b.key;
+}
+
+HashKeyId_4T::~HashKeyId_4T() {
+	// nothing to do in here
+}
+
+size_t HashKeyId_4T::size() const {
+	return key.size();
+}
+
+const HashKeyId_4T::key_type & HashKeyId_4T::getkey() const {
+	return key;
+}
+
+std::string HashKeyId_4T::printkey() const {
+	uint32_t id;
+	uint8_t protocol;
+	uint16_t port;
+	uint8_t flowtype;
+	memcpy(&id, key.begin(), sizeof(uint32_t));
+	memcpy(&protocol, key.begin() + 4, sizeof(uint8_t));
+	memcpy(&flowtype, key.begin() + 5, sizeof(uint8_t));
+	memcpy(&port, key.begin() + 6, sizeof(uint16_t));
+
+	std::stringstream ss;
+	ss << "id: ";
+	ss << id;
+	ss << "proto: ";
+	ss << (int)protocol;
+	ss << "port: ";
+	ss << port;
+	ss << "flowtype: ";
+	ss << (int)flowtype;
+	return ss.str();
+}
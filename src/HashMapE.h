@@ -210,6 +210,65 @@ protected:
 	key_type key;
 };
 
+/* *************************************************************
+ * Key type HashKeyIdPair: address id pair key                 *
+ * *************************************************************/
+
+/**
+ *	\class HashKeyIdPair
+ *	\brief Hash Key for pairs of address ids (see CIPDictionary). The size of the key amounts to 8 bytes.
+ */
+class HashKeyIdPair {
+public:
+	/**
+	 * Constructor.
+	 * \param id1 the first address id
+	 * \param id2 the second address id
+	 */
+	typedef boost::array<char, 8> key_type;
+
+	HashKeyIdPair(const uint32_t id1, const uint32_t id2);
+	HashKeyIdPair(const HashKeyIdPair & b);
+	~HashKeyIdPair();
+	size_t size() const;
+	const key_type & getkey() const;
+	std::string printkey() const;
+
+protected:
+	key_type key;
+};
+
+/* *************************************************************
+ * Key type HashKeyId_4T: address id Four-Tuple key            *
+ * *************************************************************/
+
+/**
+ *	\class HashKeyId_4T
+ *	\brief Hash Key for 4-tuple [address id, protocol, port, flowtype]. Replaces HashKeyIPv6_4T where the
+ *	address is known by its id (see CIPDictionary). The size of the key amounts to 8 bytes.
+ */
+class HashKeyId_4T {
+public:
+	/**
+	 * Constructor.
+	 * \param id address id
+	 * \param protocol protocol number (e.g. 6=tcp, 17=UDP)
+	 * \param port port
+	 * \param flowtype flow direction type
+	 */
+	typedef boost::array<char, 8> key_type;
+
+	HashKeyId_4T(const uint32_t id, const uint8_t & protocol, const uint16_t & port, const uint8_t & flowtype);
+	HashKeyId_4T(const HashKeyId_4T & b);
+	~HashKeyId_4T();
+	size_t size() const;
+	const key_type & getkey() const;
+	std::string printkey() const;
+
+protected:
+	key_type key;
+};
+
 /* *************************************************************
  * Key type CHashKey4_4: 2-tuples of 32 bit values             *
  * *************************************************************/
@@ -25,15 +25,6 @@ using namespace std;
 const std::string IPv6_addr::ipRegex = "[:\\.A-Fa-f0-9]+";
 const boost::hash<uint32_t> IPv6_addr::partial_ip_hasher = boost::hash<uint32_t>(); // initializes the hasher
 
-/**
- *	Constructor: default, assigns 0 to all bits
- *	\pre sizeof(IPv6_addr) == 16
- */
-IPv6_addr::IPv6_addr() {
-	assert(sizeof(IPv6_addr) == 16); // make sure we do not add any overhead to this class
-	assign(0);
-}
-
 /**
  *	Constructor: from in6_addr.
  *
@@ -135,18 +126,6 @@ IPv6_addr::IPv6_addr(const boost::array<unsigned char, 16> & src) {
 	copy(src.begin(), src.end(), this->begin());
 }
 
-/**
- *	Implements the assign operator
- *
- *	\param other IP address to assign
- *
- *	\return IPv6_addr Reference to this object
- */
-IPv6_addr & IPv6_addr::operator=(const IPv6_addr & other) {
-	std::copy(other.begin(), other.end(), begin());
-	return *this;
-}
-
 /**
  *	Returns a string representation of this IP address
  *
@@ -186,75 +165,6 @@ std::ostream & operator<<(std::ostream & os, const IPv6_addr & ip) {
 	return os;
 }
 
-/**
- *	Implements the bitwise AND operator
- *
- *	\param other Reference to the other IP address
- *
- *	\return IPv6_addr Resulting IP address
- */
-IPv6_addr IPv6_addr::operator &(const IPv6_addr & other) {
-	IPv6_addr result;
-	for (uint32_t i = 0; i < size(); i++) {
-		result[i] = (*this)[i] & other[i];
-	}
-	return result;
-}
-
-
-/**
- *	Implements the less operator
- *
- *	\param other Reference the the IP address which we should compare to
- *
- *	\return bool True if this is smaller than other
- */
-bool IPv6_addr::operator<(const IPv6_addr & other) const {
-	for(unsigned int i = 0; i < sizeof(IPv6_addr); i++ ) {
-		if((*this)[i] < other[i])
-			return true;
-		if((*this)[i] > other[i])
-			return false;
-	}
-	return false;
-}
-
-
-/**
- *	Implements the equals operator
- *
- *	\param other Reference the the IP address which we should compare to
- *
- *	\return bool True if both addresses are the same, false if not
- */
-bool IPv6_addr::operator==(const IPv6_addr & other) const {
-	return equal(this->begin(), this->end(), other.begin());
-}
-
-/**
- *	Implements the not-equals operator
- *
- *	\param other Reference the the IP address which we should compare to
- *
- *	\return bool false if both addresses are the same, true if not
- */
-bool IPv6_addr::operator!=(const IPv6_addr & other) const {
-	return !(*this == other);
-}
-
-/**
- *	Checks if this IP is an IPv6 address
- *
- *	\return bool True if the address is a IPv6 address, false if it is an IPv4 address
- */
-bool IPv6_addr::isIPv6() const {
-	if ((*this)[0] == 0x00 && (*this)[1] == 0x00 && (*this)[2] == 0x00 && (*this)[3] == 0x00 && (*this)[4] == 0x00 && (*this)[5] == 0x00 && (*this)[6] == 0x00
-	      && (*this)[7] == 0x00 && (*this)[8] == 0x00 && (*this)[9] == 0x00 && (*this)[10] == 0xff && (*this)[11] == 0xff) {
-		return false;
-	}
-	return true;
-}
-
 /**
  *
  * @return
@@ -265,30 +175,6 @@ std::string IPv6_addr::toNumericString() const {
 	return ss.str();
 }
 
-/**
- *	Checks if this IP is an IPv4 address
- *
- *	\return bool True if the address is a IPv4 address, false if it is an IPv6 address
- */
-bool IPv6_addr::isIPv4() const {
-	return !isIPv6();
-}
-
-/**
- * Generates a 24 bit hash from the ipv6 address
- *
- * \return uint32_t first 24 bits contain the hash code, the last 8 bits are set to 0
- *
- * \exception std::sring Errormessage
- */
-uint32_t IPv6_addr::get24bitHash() const {
-	long hash = partial_ip_hasher(*((uint32_t*) begin())); // hashes the first 32 bits
-	hash += partial_ip_hasher(*((uint32_t*) (begin() + 1 * sizeof(uint32_t)))); // hashes the next 32 bits
-	hash += partial_ip_hasher(*((uint32_t*) (begin() + 2 * sizeof(uint32_t)))); // hashes the next 32 bits
-	hash += partial_ip_hasher(*((uint32_t*) (begin() + 3 *sizeof(uint32_t)))); // hashes the next 32 bits
-	return hash & 0xffffff;
-}
-
 /**
  * Generate a bitmask for the given prefix
  *
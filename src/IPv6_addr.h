@@ -9,11 +9,25 @@
 #include <boost/array.hpp>
 #include <netinet/in.h>
 #include <netinet/ip6.h>
+#include <arpa/inet.h>
+#include <endian.h>
+#include <string.h>
 #include <stdint.h>
 #include <fstream>
 #include <string>
 #include <boost/functional/hash.hpp>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+/**
+ *	\class	IPv6_addr
+ *	\brief	IP address (IPv4 addresses are stored IPv4-mapped) as 16 bytes in network byte order.
+ *
+ *	The hot operations (comparison, masking, IPv4 test, hashing) work on the address as two 64 bit
+ *	words (big endian words for ordering) or as one SSE2 register instead of byte by byte. They are
+ *	inline as they run inside std::sort, every local network test and every graphlet edge.
+ */
 class IPv6_addr: public boost::array<unsigned char, 16> {
 	public:
 		// Default constructor, initializes with zeros
@@ -35,7 +49,7 @@ class IPv6_addr: public boost::array<unsigned char, 16> {
 		bool operator==(const IPv6_addr & other) const;
 		bool operator<(const IPv6_addr & other) const;
 		bool operator!=(const IPv6_addr & other) const;
-		IPv6_addr operator &(const IPv6_addr & other);
+		IPv6_addr operator &(const IPv6_addr & other) const;
 
 		std::string toNumericString() const;
 		uint32_t get24bitHash() const;
@@ -43,8 +57,149 @@ class IPv6_addr: public boost::array<unsigned char, 16> {
 
 		const static std::string ipRegex;
 		const static boost::hash<uint32_t> partial_ip_hasher;
+
+	private:
+		uint64_t word(unsigned int i) const;
+		uint64_t be_word(unsigned int i) const;
 };
 
+/**
+ *	Constructor: default, assigns 0 to all bits
+ */
+inline IPv6_addr::IPv6_addr() {
+	memset(data(), 0, 16);
+}
+
+/**
+ *	Get one of the two 64 bit words in memory order (for bitwise operations and equality).
+ *
+ *	\param i Word index (0: bytes 0-7, 1: bytes 8-15)
+ *
+ *	\return Word
+ */
+inline uint64_t IPv6_addr::word(unsigned int i) const {
+	uint64_t w;
+	memcpy(&w, data() + 8 * i, sizeof(w));
+	return w;
+}
+
+/**
+ *	Get one of the two 64 bit words as number (for ordering).
+ *
+ *	\param i Word index (0: bytes 0-7, 1: bytes 8-15)
+ *
+ *	\return Word in host byte order
+ */
+inline uint64_t IPv6_addr::be_word(unsigned int i) const {
+	return be64toh(word(i));
+}
+
+/**
+ *	Implements the assign operator
+ *
+ *	\param other IP address to assign
+ *
+ *	\return IPv6_addr Reference to this object
+ */
+inline IPv6_addr & IPv6_addr::operator=(const IPv6_addr & other) {
+	memcpy(data(), other.data(), 16);
+	return *this;
+}
+
+/**
+ *	Implements the equals operator
+ *
+ *	\param other Reference the the IP address which we should compare to
+ *
+ *	\return bool True if both addresses are the same, false if not
+ */
+inline bool IPv6_addr::operator==(const IPv6_addr & other) const {
+#ifdef __SSE2__
+	__m128i a = _mm_loadu_si128((const __m128i *) data());
+	__m128i b = _mm_loadu_si128((const __m128i *) other.data());
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff;
+#else
+	return ((word(0) ^ other.word(0)) | (word(1) ^ other.word(1))) == 0;
+#endif
+}
+
+/**
+ *	Implements the not-equals operator
+ *
+ *	\param other Reference the the IP address which we should compare to
+ *
+ *	\return bool false if both addresses are the same, true if not
+ */
+inline bool IPv6_addr::operator!=(const IPv6_addr & other) const {
+	return !(*this == other);
+}
+
+/**
+ *	Implements the less operator (byte wise lexicographic order)
+ *
+ *	\param other Reference the the IP address which we should compare to
+ *
+ *	\return bool True if this is smaller than other
+ */
+inline bool IPv6_addr::operator<(const IPv6_addr & other) const {
+	uint64_t a = be_word(0), b = other.be_word(0);
+	if (a != b)
+		return a < b;
+	return be_word(1) < other.be_word(1);
+}
+
+/**
+ *	Implements the bitwise AND operator
+ *
+ *	\param other Reference to the other IP address
+ *
+ *	\return IPv6_addr Resulting IP address
+ */
+inline IPv6_addr IPv6_addr::operator &(const IPv6_addr & other) const {
+	IPv6_addr result;
+#ifdef __SSE2__
+	__m128i a = _mm_loadu_si128((const __m128i *) data());
+	__m128i b = _mm_loadu_si128((const __m128i *) other.data());
+	_mm_storeu_si128((__m128i *) result.data(), _mm_and_si128(a, b));
+#else
+	uint64_t w[2] = { word(0) & other.word(0), word(1) & other.word(1) };
+	memcpy(result.data(), w, sizeof(w));
+#endif
+	return result;
+}
+
+/**
+ *	Checks if this IP is an IPv6 address
+ *
+ *	\return bool True if the address is a IPv6 address, false if it is an IPv4 address (::ffff:0:0/96)
+ */
+inline bool IPv6_addr::isIPv6() const {
+	uint32_t w2;
+	memcpy(&w2, data() + 8, sizeof(w2));
+	return word(0) != 0 || w2 != htonl(0x0000ffff);
+}
+
+/**
+ *	Checks if this IP is an IPv4 address
+ *
+ *	\return bool True if the address is a IPv4 address, false if it is an IPv6 address
+ */
+inline bool IPv6_addr::isIPv4() const {
+	return !isIPv6();
+}
+
+/**
+ * Generates a 24 bit hash from the ipv6 address: sum of the four 32 bit words (the value
+ * partial_ip_hasher gives for each word).
+ *
+ * \return uint32_t first 24 bits contain the hash code, the last 8 bits are set to 0
+ */
+inline uint32_t IPv6_addr::get24bitHash() const {
+	uint32_t w[4];
+	memcpy(w, data(), sizeof(w));
+	return (w[0] + w[1] + w[2] + w[3]) & 0xffffff;
+}
+
 std::ostream & operator<<(std::ostream& os, const IPv6_addr & ip);
 
 #endif /* IPV6_ADDR_H_ */
@@ -15,6 +15,8 @@
 #include "cflow.h"
 #include "grole.h"
 #include "gutil.h"
+#include "gflowcolumns.h"
+#include "gflowexpression.h"
 
 using namespace std;
 
@@ -70,12 +72,110 @@ cflow6::cflow6(const IPv6_addr & localIP, uint16_t localPort, const IPv6_addr &
 	tos_flags = 0;
 }
 
+/**
+ *	Constructor: Converts an in-memory flow into the on-disk format
+ *
+ *	\param flow In-memory flow
+ */
+cflow6::cflow6(const cflow_mem & flow) {
+	this->magic = flow.magic;
+	this->localIP = flow.localIP;
+	this->localPort = flow.localPort;
+	this->remoteIP = flow.remoteIP;
+	this->remotePort = flow.remotePort;
+	this->prot = flow.prot;
+	this->flowtype = flow.flowtype;
+	this->startMs = flow.startMs;
+	this->durationMs = flow.durationMs;
+	this->dOctets = flow.dOctets;
+	this->dPkts = flow.dPkts;
+	this->localAS = flow.localAS;
+	this->remoteAS = flow.remoteAS;
+	this->tos_flags = flow.tos_flags;
+}
+
 /**
  *	Writes a cflow6 to ostream
  *
  *	\param out Reference to the ostream where the cflow6 should be written to
  */
 void cflow6::print(std::ostream & out) const {
+	cflow_mem(*this).print(out);
+}
+
+/**
+ *	Implements the "less than" operator
+ *
+ *	\param flow Reference to the cflow6 which this object should be compared to
+ *
+ *	\return True if this object is smaller than other
+ */
+bool cflow6::operator<(const cflow6 & other) const {
+	if (localIP != other.localIP)
+		return localIP < other.localIP;
+	if (remoteIP != other.remoteIP)
+		return remoteIP < other.remoteIP;
+	return startMs < other.startMs;
+}
+
+/**
+ *	Implements the operator for cflow6
+ *
+ *	\param os Reference to the ostream where the cflow6 should be written to
+ *	\param flow Cflow to be written to ostream
+ *
+ *	\return ostream Reference to the submitted ostream
+ */
+std::ostream & operator<<(std::ostream & os, const cflow6 & flow) {
+	flow.print(os);
+	return os;
+}
+
+/**
+ *	Constructor: Default constructor. Initializes to 0 and sets magic to CFLOW_6_MAGIC_NUMBER
+ */
+cflow_mem::cflow_mem() :
+	startMs(0), dOctets(0), durationMs(0), dPkts(0), localPort(0), remotePort(0), prot(0), flowtype(0), tos_flags(0), magic(CFLOW_6_MAGIC_NUMBER),
+	      localAS(0), remoteAS(0) {
+}
+
+/**
+ *	Constructor: Sets the value of all elements, magic to CFLOW_6_MAGIC_NUMBER
+ *
+ *	\param localIP Local IP
+ *	\param localPort Local port
+ *	\param remoteIP Remote IP
+ *	\param remotePort Remote port
+ *	\param prot IP Protocol number
+ *	\param flowtype Flow type or direction (for values see enum flow_type_t)
+ *	\param startMs Flow start time in milliseconds since the epoch
+ *	\param durationMs Flow duration in milliseconds
+ *	\param dOctets flow size in byte
+ *	\param dPkts number of packets contained in flow
+ */
+cflow_mem::cflow_mem(const IPv6_addr & localIP, uint16_t localPort, const IPv6_addr & remoteIP, uint16_t remotePort, uint8_t prot, uint8_t flowtype,
+      uint64_t startMs, uint32_t durationMs, uint64_t dOctets, uint32_t dPkts, uint8_t magic) :
+	localIP(localIP), remoteIP(remoteIP), startMs(startMs), dOctets(dOctets), durationMs(durationMs), dPkts(dPkts), localPort(localPort),
+	      remotePort(remotePort), prot(prot), flowtype(flowtype), tos_flags(0), magic(magic), localAS(0), remoteAS(0) {
+}
+
+/**
+ *	Constructor: Converts a flow read in on-disk format
+ *
+ *	\param flow Flow in on-disk format
+ */
+cflow_mem::cflow_mem(const cflow6 & flow) :
+	localIP(flow.localIP), remoteIP(flow.remoteIP), startMs(flow.startMs), dOctets(flow.dOctets), durationMs(flow.durationMs), dPkts(flow.dPkts),
+	      localPort(flow.localPort), remotePort(flow.remotePort), prot(flow.prot), flowtype(flow.flowtype), tos_flags(flow.tos_flags), magic(flow.magic),
+	      localAS(flow.localAS), remoteAS(flow.remoteAS) {
+}
+
+/**
+ *	Writes a cflow_mem to ostream
+ *
+ *	\param out Reference to the ostream where the flow should be written to
+ */
+void cflow_mem::print(std::ostream & out) const {
 
 	if (localIP.isIPv6()) {
 		out << setw(4) << left << util::ipV6ProtocolToString(prot) << ": " << right << util::print_flowtype(dir) << " " << util::getIPandPortWithStableSize(
@@ -94,11 +194,11 @@ void cflow6::print(std::ostream & out) const {
 /**
  *	Implements the "less than" operator
  *
- *	\param flow Reference to the cflow6 which this object should be compared to
+ *	\param flow Reference to the flow which this object should be compared to
  *
  *	\return True if this object is smaller than other
  */
-bool cflow6::operator<(const cflow6 & other) const {
+bool cflow_mem::operator<(const cflow_mem & other) const {
 	if (localIP != other.localIP)
 		return localIP < other.localIP;
 	if (remoteIP != other.remoteIP)
@@ -107,14 +207,14 @@ bool cflow6::operator<(const cflow6 & other) const {
 }
 
 /**
- *	Implements the operator for cflow6
+ *	Implements the operator for cflow_mem
  *
- *	\param os Reference to the ostream where the cflow6 should be written to
- *	\param flow Cflow to be written to ostream
+ *	\param os Reference to the ostream where the flow should be written to
+ *	\param flow Flow to be written to ostream
  *
  *	\return ostream Reference to the submitted ostream
  */
-std::ostream & operator<<(std::ostream & os, const cflow6 & flow) {
+std::ostream & operator<<(std::ostream & os, const cflow_mem & flow) {
 	flow.print(os);
 	return os;
 }
@@ -150,6 +250,8 @@ Subflowlist::Subflowlist(const Subflowlist & subflowlist) {
 	_end = subflowlist.end();
 	initializedBegin = true;
 	initializedEnd = true;
+	_columns = subflowlist._columns;
+	_dictionary = subflowlist._dictionary;
 }
 
 /**
@@ -173,6 +275,7 @@ void Subflowlist::setBegin(const_iterator begin) {
 	assert(!initializedBegin);
 	_begin = begin;
 	initializedBegin = true;
+	_columns.reset();
 }
 
 /**
@@ -184,6 +287,7 @@ void Subflowlist::setEnd(const_iterator end) {
 	assert(!initializedEnd);
 	_end = end;
 	initializedEnd = true;
+	_columns.reset();
 }
 
 /**
@@ -251,11 +355,44 @@ const cflow_t & Subflowlist::operator[](difference_type n) const {
 	return *(_begin + n);
 }
 
+/**
+ *	Get the columnar view of the flows. It is built on the first call.
+ *
+ *	\return CFlowColumns Columns, index n belongs to element n
+ */
+const CFlowColumns & Subflowlist::columns() const {
+	assert(initializedBegin && initializedEnd);
+	if (!_columns)
+		_columns.reset(new CFlowColumns(_begin, _end, _dictionary));
+	return *_columns;
+}
+
+/**
+ *	Get the memory held by the columnar view, without building it.
+ *
+ *	\return Bytes (0 if columns() has not been called yet)
+ */
+uint64_t Subflowlist::get_columns_memory_size() const {
+	return _columns ? _columns->get_memory_size() : 0;
+}
+
+/**
+ *	Set the address dictionary used to build the columns. It has to contain all addresses of the flows.
+ *
+ *	\param dictionary Address dictionary (NULL: columns build their own)
+ */
+void Subflowlist::set_dictionary(boost::shared_ptr<const CIPDictionary> dictionary) {
+	_dictionary = dictionary;
+	_columns.reset();
+}
+
 /**
  *	Constructor:	CFlowFilter
  *
  *	\param	subflowlist	Vector of flows
  *	\param	prefs	Filter settings
+ *
+ *	\exception std::string Errortext (invalid filter expression)
  */
 CFlowFilter::CFlowFilter(const Subflowlist & subflowlist, const prefs_t & prefs) :
 	flow_filter(subflowlist.size()) {
@@ -274,9 +411,14 @@ CFlowFilter::CFlowFilter(const Subflowlist & subflowlist, const prefs_t & prefs)
 		flowtype_filter |= outflow;
 		not_flowtype_filter = unibiflow;
 	}
+	const CFlowColumns & columns = subflowlist.columns();
+	const uint8_t * flowtypes = columns.flowtypes();
+	const uint8_t * prots = columns.prots();
+	size_t size = columns.size();
+
 	// Apply flow direction type filter
-	for (unsigned int i = 0; i < subflowlist.size(); i++) {
-		if (((subflowlist[i].flowtype & flowtype_filter) != 0) && ((subflowlist[i].flowtype & not_flowtype_filter) == 0)) {
+	for (size_t i = 0; i < size; i++) {
+		if (((flowtypes[i] & flowtype_filter) != 0) && ((flowtypes[i] & not_flowtype_filter) == 0)) {
 			flow_filter[i] = true;
 		} else {
 			flow_filter[i] = false;
@@ -285,8 +427,8 @@ CFlowFilter::CFlowFilter(const Subflowlist & subflowlist, const prefs_t & prefs)
 
 	// Apply protocol filter
 	if (prefs.filter_TCP || prefs.filter_UDP || prefs.filter_ICMP || prefs.filter_OTHER) {
-		for (uint i = 0; i < subflowlist.size(); i++) {
-			switch (subflowlist[i].prot) {
+		for (size_t i = 0; i < size; i++) {
+			switch (prots[i]) {
 				case IPPROTO_TCP:
 					if (prefs.filter_TCP)
 						flow_filter[i] = true;
@@ -306,6 +448,17 @@ CFlowFilter::CFlowFilter(const Subflowlist & subflowlist, const prefs_t & prefs)
 			}
 		}
 	}
+
+	// Apply filter expression
+	if (!prefs.filter_expression.empty()) {
+		CFlowExpression expression(prefs.filter_expression);
+		vector<uint64_t> matches;
+		expression.evaluate(columns, matches);
+		for (size_t i = 0; i < size; i++) {
+			if (!CFlowExpression::test(matches, i))
+				flow_filter[i] = true;
+		}
+	}
 }
 
 std::string role_associations::toString(const role_associations & ra) {
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <iosfwd>
 #include <vector>
+#include <boost/shared_ptr.hpp>
 
 #include "global.h"
 #include "IPv6_addr.h"
@@ -37,10 +38,14 @@ struct role_associations {
 };
 
 
+struct cflow_mem;
+
 /**
  *	\class	cflow6
  *	\brief	Cflow format, used to store the relevant parts of NetFlow records (suitable for IPv4/6; size is 72 bytes)
  *				The members of this struct should not be aligned (#pragma pack(1)) as we serialize cflow6 directly to files.
+ *				cflow6 is the on-disk format only: flows are held in memory as cflow_mem (see cflow_t), the
+ *				conversion is done by the cflow readers and writers.
  *
  *				Cflow format (suitable for IPv4/6; size is 72 bytes)
  *
@@ -78,6 +83,7 @@ struct cflow6 {
 					uint16_t remotePort, uint8_t prot, uint8_t flowtype, uint64_t startMs = 0,
 					uint32_t durationMs = 0, uint64_t dOctets = 0, uint32_t dPkts = 0, uint8_t
 					magic = CFLOW_6_MAGIC_NUMBER);
+		explicit cflow6(const cflow_mem & flow);
 		bool operator<(const cflow6 & flow) const;
 		void print(std::ostream & out) const;
 };
@@ -85,16 +91,55 @@ struct cflow6 {
 
 std::ostream & operator<<(std::ostream& os, const cflow6 & flow);
 
+/**
+ *	\class	cflow_mem
+ *	\brief	In-memory flow record (suitable for IPv4/6; size is 72 bytes).
+ *
+ *				Holds the same information as cflow6 but every member is naturally aligned. The members
+ *				accessed by role identification (addresses, ports, protocol, flow type, counters and
+ *				start time) are grouped into the first 64 bytes.
+ */
+struct cflow_mem {
+		IPv6_addr localIP; ///< Numeric ip address of source/server/client vertex (network byte order)
+		IPv6_addr remoteIP; ///< Numeric ip address of destination vertex (network byte order)
+		uint64_t startMs; ///< Flow start time in milliseconds
+		uint64_t dOctets; ///< flow size in byte
+		uint32_t durationMs; ///< Flow duration in milliseconds since the epoch
+		uint32_t dPkts; ///< number of packets contained in flow
+		uint16_t localPort; ///< Source port of vertex
+		uint16_t remotePort; ///< Destination port of vertex
+		uint8_t prot; ///< protocol type
+		union {
+				uint8_t dir; ///< direction: for values see enum flow_type_t
+				uint8_t flowtype; ///< Flow type
+		};
+		uint8_t tos_flags; ///< ToS flags
+		uint8_t magic; ///< Magic number (format version)
+		uint32_t localAS; ///< source AS
+		uint32_t remoteAS; ///< destination AS
+
+		cflow_mem();
+		cflow_mem(const IPv6_addr & localIP, uint16_t localPort, const IPv6_addr & remoteIP,
+					uint16_t remotePort, uint8_t prot, uint8_t flowtype, uint64_t startMs = 0,
+					uint32_t durationMs = 0, uint64_t dOctets = 0, uint32_t dPkts = 0, uint8_t
+					magic = CFLOW_6_MAGIC_NUMBER);
+		explicit cflow_mem(const cflow6 & flow);
+		bool operator<(const cflow_mem & flow) const;
+		void print(std::ostream & out) const;
+};
+
+std::ostream & operator<<(std::ostream& os, const cflow_mem & flow);
+
 /**
  *	\typedef cflow_t
- *	\brief cflow_t is a typedef for the currently used version of cflow.
- *			 Currently its is an alias for cflow6.
+ *	\brief cflow_t is a typedef for the currently used in-memory version of cflow.
+ *			 Currently its is an alias for cflow_mem (stored as cflow6 in files).
  *			 Use wherever possible cflow_t so it is possible to update this line
  *			 typedef to use a new version of the cflow6 struct.  This should be possible
  *			 relatively painless, as long as the new version just extend the cflow6 and not
  *			 modifies anything
  */
-typedef cflow6 cflow_t;
+typedef cflow_mem cflow_t;
 
 /**
  *	\typedef CFlowList
@@ -102,9 +147,16 @@ typedef cflow6 cflow_t;
  */
 typedef std::vector<cflow_t> CFlowList;
 
+class CFlowColumns;
+class CIPDictionary;
+
 /**
  *	\class	Subflowlist
  *	\brief	Subflowlist allows to access parts of a CFlowList without copying the CFlowList.
+ *
+ *	For scans over a few members of all flows, columns() provides a columnar view of the flows. It
+ *	is built on first use and shared by copies of the Subflowlist. Views of the same data set should
+ *	be given the data set's address dictionary (set_dictionary()) so their address ids agree.
  */
 class Subflowlist {
 	public:
@@ -138,12 +190,17 @@ class Subflowlist {
 		const_iterator begin() const;
 		size_type size() const;
 		const cflow_t & operator[](difference_type n) const;
+		const CFlowColumns & columns() const;
+		uint64_t get_columns_memory_size() const;
+		void set_dictionary(boost::shared_ptr<const CIPDictionary> dictionary);
 
 	private:
 		const_iterator _begin; ///< first element
 		const_iterator _end; ///< one element behind the latest one
 		bool initializedBegin; ///< true if _begin was set
 		bool initializedEnd; ///< true if _end was set
+		mutable boost::shared_ptr<CFlowColumns> _columns; ///< Columnar view (built on demand)
+		boost::shared_ptr<const CIPDictionary> _dictionary; ///< Address ids used by the columns (NULL: own dictionary)
 };
 
 // Compacted flow4 format (suitable for ipv4 only; size is 48 bytes)
@@ -261,6 +318,7 @@ enum flow_type_t {
  *	\brief Supports flow filtering by:
  *	- flow direction type (biflow, inflow, outflow, prod. inflow, prod. outflow)
  *	- protocol (granularity: TCP/UDP/ICMP/OTHER)
+ *	- filter expression (flows not matching prefs_t::filter_expression, see CFlowExpression)
  *
  *	A flow filter object defines for each flow contained in flowlist if it
  *	is filtered or not. For this purpose a boolean array is initialized at
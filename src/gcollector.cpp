@@ -0,0 +1,425 @@
+/**
+ *	\file gcollector.cpp
+ *	\brief Live NetFlow v9/IPFIX collector maintaining per-host flow runs and incremental graphlets.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <boost/bind.hpp>
+
+#include "gcollector.h"
+#include "HAPviewer.h"
+
+using namespace std;
+
+static const size_t max_datagram_size = 65536; ///< Largest UDP payload
+static const int receive_buffer_size = 4 * 1024 * 1024; ///< Socket buffer requested to bridge bursts
+static const int poll_timeout_ms = 100; ///< Granularity for noticing stop()
+static const size_t consumer_batch_size = 4096; ///< Records moved from the ring per round
+
+const size_t CCollector::default_ring_size;
+const unsigned int CCollector::default_interval;
+const unsigned int CCollector::default_window;
+
+/**
+ *	Constructor: open and bind the UDP socket (IPv6 dual stack if available, else IPv4).
+ *
+ *	\param port UDP port to listen on (0: let the system pick one, see get_port())
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param prefs Preferences used for graphlet creation (must outlive the collector)
+ *	\param interval Seconds between snapshots
+ *	\param ring_size Flow records buffered between receiver and consumer thread
+ *
+ *	\exception std::string Errortext
+ */
+CCollector::CCollector(uint16_t port, const CLocalNets & local_nets, const prefs_t & prefs, unsigned int interval, size_t ring_size) :
+	sock(-1), port(port), local_nets(local_nets), prefs(prefs), interval(interval > 0 ? interval : 1), window(default_window), ring(ring_size), latestMs(0),
+	      receiver(NULL), consumer(NULL), running(false), host_selected(false), hpg_filename(default_hpg_filename) {
+	sock = socket(AF_INET6, SOCK_DGRAM, 0);
+	if (sock >= 0) {
+		int off = 0;
+		setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+		struct sockaddr_in6 addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin6_family = AF_INET6;
+		addr.sin6_addr = in6addr_any;
+		addr.sin6_port = htons(port);
+		if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+			close(sock);
+			sock = -1;
+		}
+	}
+	if (sock < 0) {
+		sock = socket(AF_INET, SOCK_DGRAM, 0);
+		if (sock < 0)
+			throw string("Could not create UDP socket: ") + strerror(errno);
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_ANY);
+		addr.sin_port = htons(port);
+		if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+			string errtext = string("Could not bind UDP socket: ") + strerror(errno);
+			close(sock);
+			throw errtext;
+		}
+	}
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &receive_buffer_size, sizeof(receive_buffer_size));
+
+	// Find out port chosen by the system
+	struct sockaddr_storage bound;
+	socklen_t len = sizeof(bound);
+	if (getsockname(sock, (struct sockaddr *) &bound, &len) == 0) {
+		if (bound.ss_family == AF_INET6)
+			this->port = ntohs(((struct sockaddr_in6 *) &bound)->sin6_port);
+		else
+			this->port = ntohs(((struct sockaddr_in *) &bound)->sin_port);
+	}
+}
+
+/**
+ *	Destructor: stop threads and close socket
+ */
+CCollector::~CCollector() {
+	stop();
+	close(sock);
+}
+
+/**
+ *	Set the function receiving the snapshots. It is called from the consumer thread.
+ *
+ *	\param callback Snapshot receiver
+ */
+void CCollector::set_update_callback(const update_callback_t & callback) {
+	boost::mutex::scoped_lock lock(mutex);
+	this->callback = callback;
+}
+
+/**
+ *	Select the host whose graphlet is prepared with each snapshot.
+ *
+ *	\param IP Local host address
+ */
+void CCollector::select_host(const IPv6_addr & IP) {
+	boost::mutex::scoped_lock lock(mutex);
+	selected_host = IP;
+	host_selected = true;
+}
+
+/**
+ *	Set the file the graphlet of the selected host is written to.
+ *
+ *	\param filename Name of hpg file
+ */
+void CCollector::set_hpg_filename(const std::string & filename) {
+	boost::mutex::scoped_lock lock(mutex);
+	hpg_filename = filename;
+}
+
+/**
+ *	Only keep flows which ended within the last seconds (relative to the latest flow seen).
+ *	Has to be called before start().
+ *
+ *	\param seconds Window size (default: default_window; 0: keep all flows, memory grows without bound)
+ */
+void CCollector::set_window(unsigned int seconds) {
+	window = seconds;
+}
+
+/**
+ *	Start receiver and consumer thread.
+ */
+void CCollector::start() {
+	if (running)
+		return;
+	running = true;
+	consumer = new boost::thread(boost::bind(&CCollector::consume_loop, this));
+	receiver = new boost::thread(boost::bind(&CCollector::receive_loop, this));
+}
+
+/**
+ *	Stop receiver and consumer thread. Records already received are processed and a final snapshot
+ *	is prepared before the consumer thread ends.
+ */
+void CCollector::stop() {
+	if (!running)
+		return;
+	running = false;
+	receiver->join();
+	consumer->join();
+	delete receiver;
+	delete consumer;
+	receiver = NULL;
+	consumer = NULL;
+}
+
+/**
+ *	Get the UDP port the collector listens on.
+ *
+ *	\return Port number
+ */
+uint16_t CCollector::get_port() const {
+	return port;
+}
+
+/**
+ *	Get current counters.
+ *
+ *	\return Counters
+ */
+CCollector::stats_t CCollector::get_stats() const {
+	boost::mutex::scoped_lock lock(mutex);
+	return stats;
+}
+
+/**
+ *	Receiver thread: decode datagrams and pass the flow records on to the consumer thread.
+ */
+void CCollector::receive_loop() {
+	vector<uint8_t> buffer(max_datagram_size);
+	vector<CExportDecoder::decoded_t> records;
+	while (running) {
+		struct pollfd pfd;
+		pfd.fd = sock;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, poll_timeout_ms) <= 0)
+			continue;
+
+		struct sockaddr_storage from;
+		socklen_t fromlen = sizeof(from);
+		ssize_t n = recvfrom(sock, &buffer[0], buffer.size(), 0, (struct sockaddr *) &from, &fromlen);
+		if (n <= 0)
+			continue;
+
+		records.clear();
+		decoder.decode_message(&buffer[0], n, get_exporter(from, fromlen), records);
+		uint64_t dropped = 0;
+		for (vector<CExportDecoder::decoded_t>::const_iterator it = records.begin(); it != records.end(); ++it) {
+			if (!ring.push(*it))
+				dropped++;
+		}
+
+		boost::mutex::scoped_lock lock(mutex);
+		stats.datagrams++;
+		stats.records += records.size();
+		stats.dropped_records += dropped;
+	}
+}
+
+/**
+ *	Map an exporter transport address onto a number used to keep template scopes apart.
+ *
+ *	\param addr Exporter address
+ *	\param addrlen Length of exporter address
+ *
+ *	\return Exporter number
+ */
+uint16_t CCollector::get_exporter(const struct sockaddr_storage & addr, socklen_t addrlen) {
+	string key((const char *) &addr, addrlen);
+	map<string, uint16_t>::const_iterator it = exporters.find(key);
+	if (it != exporters.end())
+		return it->second;
+	uint16_t exporter = exporters.size();
+	exporters[key] = exporter;
+	return exporter;
+}
+
+/**
+ *	Consumer thread: move records from the ring into the host flow runs and prepare a snapshot
+ *	every interval seconds.
+ */
+void CCollector::consume_loop() {
+	boost::system_time next_snapshot = boost::get_system_time() + boost::posix_time::seconds(interval);
+	bool stopping = false;
+	while (!stopping) {
+		stopping = !running; // drain the ring a last time after stop()
+		CExportDecoder::decoded_t decoded;
+		size_t n = 0;
+		while (n < consumer_batch_size && ring.pop(decoded)) {
+			add_flow(decoded);
+			n++;
+		}
+		if (n == consumer_batch_size)
+			stopping = false; // more records waiting
+		else if (n == 0 && !stopping)
+			boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+
+		if (stopping || boost::get_system_time() >= next_snapshot) {
+			make_snapshot();
+			next_snapshot = boost::get_system_time() + boost::posix_time::seconds(interval);
+		}
+	}
+}
+
+/**
+ *	Constructor: empty run
+ */
+CCollector::host_run_t::host_run_t() {
+	metadata.graphlet_number = 0;
+	metadata.uniflow_count = 0;
+}
+
+/**
+ *	Count a flow appended to the run in the metadata of the host.
+ *
+ *	\param flow New flow of the run
+ */
+void CCollector::host_run_t::add_metadata(const cflow_t & flow) {
+	metadata.IP = flow.localIP;
+	metadata.flow_count++;
+	if (flow.flowtype & uniflow)
+		metadata.uniflow_count++;
+	metadata.packet_count += flow.dPkts;
+	metadata.bytesForAllFlows += flow.dOctets;
+	protocols.insert(flow.prot);
+	metadata.prot_count = protocols.size();
+}
+
+/**
+ *	Append a flow to the run of its local host. A uniflow is merged into the latest unpaired uniflow
+ *	of the opposite direction having the same 5-tuple.
+ *
+ *	\param decoded Decoded flow record
+ */
+void CCollector::add_flow(const CExportDecoder::decoded_t & decoded) {
+	cflow_t flow;
+	CFlowAssembler::make_flow(decoded.rec, local_nets, flow);
+	if (decoded.rec.endMs > latestMs)
+		latestMs = decoded.rec.endMs;
+
+	host_run_t & run = hosts[flow.localIP];
+	if (!decoded.paired && flow.flowtype != biflow) {
+		HashKeyIPv6_5T key(flow.localIP, flow.remoteIP, flow.localPort, flow.remotePort, flow.prot);
+		flowIndexMap::iterator it = run.uniflows.find(key);
+		if (it != run.uniflows.end()) {
+			cflow_t & other = run.flows[it->second];
+			if (other.flowtype != flow.flowtype) {
+				uint64_t endMs = max(other.startMs + other.durationMs, flow.startMs + flow.durationMs);
+				other.startMs = min(other.startMs, flow.startMs);
+				other.durationMs = endMs - other.startMs;
+				other.dOctets += flow.dOctets;
+				other.dPkts += flow.dPkts;
+				other.tos_flags |= flow.tos_flags;
+				other.flowtype = biflow;
+				run.uniflows.erase(it);
+				run.metadata.uniflow_count--;
+				run.metadata.packet_count += flow.dPkts;
+				run.metadata.bytesForAllFlows += flow.dOctets;
+				boost::mutex::scoped_lock lock(mutex);
+				stats.paired_flows++;
+				return;
+			}
+			it->second = run.flows.size(); // newest uniflow of this direction waits for its counterpart
+		} else {
+			run.uniflows[key] = run.flows.size();
+		}
+	}
+	run.flows.push_back(flow);
+	run.add_metadata(flow);
+}
+
+/**
+ *	Remove all flows which ended before a point in time.
+ *
+ *	\param oldestMs Flows ending earlier are removed
+ */
+void CCollector::expire_flows(uint64_t oldestMs) {
+	uint64_t expired = 0;
+	hostRunMap::iterator host = hosts.begin();
+	while (host != hosts.end()) {
+		host_run_t & run = host->second;
+		size_t first_expired = 0;
+		while (first_expired < run.flows.size() && run.flows[first_expired].startMs + run.flows[first_expired].durationMs >= oldestMs)
+			first_expired++;
+		if (first_expired == run.flows.size()) { // Nothing to expire: keep run and metadata
+			++host;
+			continue;
+		}
+		CFlowList kept;
+		kept.reserve(run.flows.size());
+		run.uniflows.clear();
+		run.metadata = host_run_t().metadata;
+		run.protocols.clear();
+		for (CFlowList::const_iterator it = run.flows.begin(); it != run.flows.end(); ++it) {
+			if (it->startMs + it->durationMs < oldestMs) {
+				expired++;
+				continue;
+			}
+			run.add_metadata(*it);
+			if (it->flowtype != biflow) {
+				HashKeyIPv6_5T key(it->localIP, it->remoteIP, it->localPort, it->remotePort, it->prot);
+				run.uniflows[key] = kept.size();
+			}
+			kept.push_back(*it);
+		}
+		run.flows.swap(kept);
+		if (run.flows.empty())
+			hosts.erase(host++);
+		else
+			++host;
+	}
+	boost::mutex::scoped_lock lock(mutex);
+	stats.expired_flows += expired;
+}
+
+/**
+ *	Prepare host list and graphlet of the selected host and pass them to the update callback.
+ */
+void CCollector::make_snapshot() {
+	if (window > 0 && latestMs > (uint64_t) window * 1000)
+		expire_flows(latestMs - (uint64_t) window * 1000);
+
+	snapshot_t snapshot;
+	update_callback_t cb;
+	bool selected;
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		cb = callback;
+		selected = host_selected;
+		snapshot.selected_host = selected_host;
+		snapshot.hpg_filename = hpg_filename;
+	}
+
+	// Host list from the metadata kept up to date by add_flow()
+	uint64_t flows = 0;
+	for (hostRunMap::const_iterator it = hosts.begin(); it != hosts.end(); ++it) {
+		snapshot.hosts.push_back(it->second.metadata);
+		snapshot.hosts.back().graphlet_number = snapshot.hosts.size() - 1;
+		snapshot.hosts.back().index = flows; // As if the runs were sorted into one flow list
+		flows += it->second.flows.size();
+	}
+
+	// Graphlet from the flow run of the selected host only
+	hostRunMap::const_iterator run = selected ? hosts.find(snapshot.selected_host) : hosts.end();
+	if (run != hosts.end()) {
+		CFlowList flowlist(run->second.flows);
+		sort(flowlist.begin(), flowlist.end());
+		CImport import(flowlist, prefs);
+		import.get_hostMetadata();
+		import.set_hpg_filename(snapshot.hpg_filename);
+		if (import.set_localIP(snapshot.selected_host, 1)) {
+			try {
+				import.cflow2hpg();
+				snapshot.graphlet_ready = true;
+			} catch (string & e) {
+				cerr << "ERROR: graphlet of " << snapshot.selected_host << " failed: " << e << endl;
+			}
+		}
+	}
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		stats.snapshots++;
+		stats.flows = flows;
+		stats.hosts = hosts.size();
+		snapshot.stats = stats;
+	}
+	if (cb)
+		cb(snapshot);
+}
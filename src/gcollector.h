@@ -0,0 +1,148 @@
+#ifndef GCOLLECTOR_H_
+#define GCOLLECTOR_H_
+
+/**
+ *	\file gcollector.h
+ *	\brief Live NetFlow v9/IPFIX collector maintaining per-host flow runs and incremental graphlets.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <sys/socket.h>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+#include "cflow.h"
+#include "IPv6_addr.h"
+#include "HashMapE.h"
+#include "glocalnets.h"
+#include "global.h"
+#include "gimport.h"
+#include "gexportdecoder.h"
+#include "gringbuffer.h"
+
+/**
+ *	\class	CCollector
+ *	\brief	CCollector receives NetFlow v9/IPFIX export datagrams on a local UDP port and keeps the flows
+ *				grouped by local host.
+ *
+ *	A receiver thread decodes each datagram (CExportDecoder) and passes the flow records through a
+ *	lock-free ring buffer to a consumer thread. The receiver never blocks on the consumer: records
+ *	not fitting into the ring are dropped and counted. The consumer appends each flow to the flow run
+ *	of its local host, pairing opposite uniflows into biflows, and updates the metadata of the host.
+ *	Every interval seconds it prepares a snapshot: the host list and, if a host has been selected, the
+ *	graphlet of that host (built from its flow run only) written as hpg file. The snapshot is passed to
+ *	the update callback (called from the consumer thread).
+ */
+class CCollector {
+	public:
+		/**
+		 *	\struct	stats_t
+		 *	\brief	Collector counters
+		 */
+		struct stats_t {
+				uint64_t datagrams; ///< Datagrams received
+				uint64_t records; ///< Flow records decoded
+				uint64_t dropped_records; ///< Flow records dropped as the ring buffer was full
+				uint64_t paired_flows; ///< Uniflows paired into biflows
+				uint64_t expired_flows; ///< Flows removed as they left the time window
+				uint64_t flows; ///< Flows currently kept
+				uint64_t hosts; ///< Local hosts currently kept
+				uint64_t snapshots; ///< Snapshots prepared
+				stats_t() :
+					datagrams(0), records(0), dropped_records(0), paired_flows(0), expired_flows(0), flows(0), hosts(0), snapshots(0) {
+				}
+		};
+
+		/**
+		 *	\struct	snapshot_t
+		 *	\brief	State passed to the update callback
+		 */
+		struct snapshot_t {
+				std::vector<ChostMetadata> hosts; ///< Host list (ascending IP order)
+				IPv6_addr selected_host; ///< Host of the graphlet
+				bool graphlet_ready; ///< True if the graphlet of selected_host has been written to hpg_filename
+				std::string hpg_filename; ///< Graphlet file
+				stats_t stats; ///< Counters at snapshot time
+				snapshot_t() :
+					graphlet_ready(false) {
+				}
+		};
+
+		typedef boost::function<void(const snapshot_t &)> update_callback_t;
+
+		static const size_t default_ring_size = 65536; ///< Flow records buffered between receiver and consumer
+		static const unsigned int default_interval = 5; ///< Seconds between snapshots
+		static const unsigned int default_window = 3600; ///< Seconds of flows kept, bounds the memory of a live collector
+
+		CCollector(uint16_t port, const CLocalNets & local_nets, const prefs_t & prefs, unsigned int interval = default_interval, size_t ring_size =
+		      default_ring_size);
+		~CCollector();
+
+		void set_update_callback(const update_callback_t & callback);
+		void select_host(const IPv6_addr & IP);
+		void set_hpg_filename(const std::string & filename);
+		void set_window(unsigned int seconds);
+
+		void start();
+		void stop();
+		uint16_t get_port() const;
+		stats_t get_stats() const;
+
+	private:
+		CCollector(const CCollector &);
+		CCollector & operator=(const CCollector &);
+
+		typedef hash_map<HashKeyIPv6_5T, size_t, HashFunction<HashKeyIPv6_5T> , HashFunction<HashKeyIPv6_5T> > flowIndexMap;
+
+		/**
+		 *	\struct	host_run_t
+		 *	\brief	All flows of a single local host
+		 */
+		struct host_run_t {
+				CFlowList flows; ///< Flows in order of arrival
+				flowIndexMap uniflows; ///< Unpaired uniflows by 5-tuple (index into flows)
+				ChostMetadata metadata; ///< Metadata of the flows (graphlet_number and index are set by snapshots)
+				std::set<uint8_t> protocols; ///< Protocols of the flows
+				host_run_t();
+				void add_metadata(const cflow_t & flow);
+		};
+
+		typedef std::map<IPv6_addr, host_run_t> hostRunMap;
+
+		void receive_loop();
+		void consume_loop();
+		void add_flow(const CExportDecoder::decoded_t & decoded);
+		void expire_flows(uint64_t oldestMs);
+		void make_snapshot();
+		uint16_t get_exporter(const struct sockaddr_storage & addr, socklen_t addrlen);
+
+		int sock; ///< UDP socket
+		uint16_t port; ///< Bound port
+		CLocalNets local_nets; ///< Local networks used to infer flow directions
+		const prefs_t & prefs; ///< Preferences used for graphlet creation
+		unsigned int interval; ///< Seconds between snapshots
+		unsigned int window; ///< Seconds of flows to keep (default: default_window; 0: keep all)
+
+		CExportDecoder decoder; ///< Used by receiver thread only
+		std::map<std::string, uint16_t> exporters; ///< Exporter address to exporter number (receiver thread only)
+		CRingBuffer<CExportDecoder::decoded_t> ring; ///< Receiver to consumer
+		hostRunMap hosts; ///< Flow runs (consumer thread only)
+		uint64_t latestMs; ///< Latest flow end seen (consumer thread only)
+
+		boost::thread * receiver; ///< Receiver thread
+		boost::thread * consumer; ///< Consumer thread
+		volatile bool running; ///< Cleared to stop the threads
+
+		mutable boost::mutex mutex; ///< Protects the members below
+		stats_t stats; ///< Counters
+		update_callback_t callback; ///< Snapshot receiver
+		IPv6_addr selected_host; ///< Host for which the graphlet is prepared
+		bool host_selected; ///< True if selected_host is valid
+		std::string hpg_filename; ///< Graphlet output file
+};
+
+#endif /* GCOLLECTOR_H_ */
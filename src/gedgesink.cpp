@@ -0,0 +1,135 @@
+/**
+ *	\file gedgesink.cpp
+ *	\brief Consumers of the graphlet edges built by CGraphlet.
+ */
+
+#include "gedgesink.h"
+#include "ghpgdata.h"
+#include "gutil.h"
+
+using namespace std;
+
+/**
+ *	Encode an edge as stored in hpg data: graphlet number and rank, followed by the annotations of the nodes.
+ *
+ *	\param graphlet_nr Number of the graphlet
+ *	\param rank Rank of the edge
+ *	\param value1 Annotation of node 1
+ *	\param value2 Annotation of node 2
+ *	\param edge Encoded edge
+ */
+void CEdgeSink::encode_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2, hpg_field edge[3]) {
+	edge[0].reset();
+	edge[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
+	edge[1] = value1;
+	edge[2] = value2;
+}
+
+/**
+ *	Constructor: open the hpg file.
+ *
+ *	\param filename Name of the hpg file
+ *	\param append Append the edges to an existing hpg file instead of replacing its contents
+ *
+ *	\exception std::string Errortext
+ */
+CHpgFileSink::CHpgFileSink(const string & filename, bool append) :
+	filename(filename) {
+	util::open_outfile(outfs, filename, append);
+}
+
+CHpgFileSink::~CHpgFileSink() {
+	outfs.close();
+}
+
+/**
+ *	Write an edge to the hpg file.
+ *
+ *	\exception std::string Errortext
+ */
+void CHpgFileSink::add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) {
+	hpg_field edge[3];
+	encode_edge(graphlet_nr, rank, value1, value2, edge);
+	if (!outfs.write((char *) edge, sizeof(edge)))
+		throw "ERROR: could not write to " + filename;
+}
+
+/**
+ *	Append an edge to the hpg data.
+ */
+void CHpgBufferSink::add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) {
+	hpg_field edge[3];
+	encode_edge(graphlet_nr, rank, value1, value2, edge);
+	data.insert(data.end(), edge, edge + 3);
+}
+
+/**
+ *	Append a version edge (version 3), as at the start of an hpg file.
+ *
+ *	\param graphlet_nr Number of the graphlet
+ */
+void CHpgBufferSink::add_version_edge(unsigned int graphlet_nr) {
+	hpg_field version_num, build_time;
+	version_num.reset();
+	version_num.eightbytevalue.data = 3;
+	build_time.reset();
+	add_edge(graphlet_nr, version, version_num, build_time);
+}
+
+/**
+ *	Get the hpg data as string, i.e. the contents of an hpg file.
+ *
+ *	\return hpg data
+ */
+string CHpgBufferSink::get_contents() const {
+	if (data.empty())
+		return "";
+	return string((const char *) &data[0], data.size() * sizeof(hpg_field));
+}
+
+/**
+ *	Drop all hpg data.
+ */
+void CHpgBufferSink::clear() {
+	data.clear();
+}
+
+/**
+ *	Constructor
+ *
+ *	\param out Stream receiving the dot data of each graphlet (one "graph G { ... }" per graphlet)
+ */
+CDotSink::CDotSink(ostream & out) :
+	out(out) {
+}
+
+/**
+ *	Keep an edge of the current graphlet. Version edges are dropped, end_graphlet() adds its own.
+ */
+void CDotSink::add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) {
+	if (rank == version)
+		return;
+	if (graphlet.get_data().empty())
+		graphlet.add_version_edge(graphlet_nr);
+	graphlet.add_edge(graphlet_nr, rank, value1, value2);
+}
+
+/**
+ *	Transform the current graphlet to dot format.
+ *
+ *	\exception std::string Errortext
+ */
+void CDotSink::end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos) {
+	vector<hpg_field> & data = graphlet.get_data();
+	if (data.empty())
+		return;
+	try {
+		ChpgData hpgData(&data[0], data.size() * sizeof(hpg_field));
+		hpgData.nodeInfos = nodeInfos;
+		hpgData.hpg2dot(0, out);
+	} catch (...) {
+		graphlet.clear();
+		throw;
+	}
+	graphlet.clear();
+}
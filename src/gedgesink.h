@@ -0,0 +1,120 @@
+#ifndef GEDGESINK_H_
+#define GEDGESINK_H_
+
+/**
+ *	\file gedgesink.h
+ *	\brief Consumers of the graphlet edges built by CGraphlet.
+ *
+ *	CGraphlet passes every edge of a graphlet it finalizes to a sink, followed by the node infos of the
+ *	graphlet. The standard sinks write the edges to an hpg file (CHpgFileSink), keep them in memory
+ *	(CHpgBufferSink) or transform each graphlet to dot format (CDotSink). Other sinks can store graphlets
+ *	directly in a database of the caller, without any hpg or dot file in between.
+ */
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "hpg.h"
+#include "gsummarynodeinfo.h"
+
+/**
+ *	\class	CEdgeSink
+ *	\brief	Receives the edges and node infos of graphlets.
+ *
+ *	The edges of a graphlet arrive in hpg order (see hpg.h), partially ordered by rank. An edge of rank edge_label
+ *	annotates the edge just before it (bytes and packets, or flows and packets per flow). The pseudo edge of rank
+ *	totalBytes is last. Only the first graphlet of a new hpg data set starts with an edge of rank version.
+ */
+class CEdgeSink {
+	public:
+		virtual ~CEdgeSink() {
+		}
+
+		/**
+		 *	Receive an edge.
+		 *
+		 *	\param graphlet_nr Number of the graphlet
+		 *	\param rank Rank of the edge: partitions connected, or edge_label, totalBytes, version
+		 *	\param value1 Annotation of node 1 (see hpg.h)
+		 *	\param value2 Annotation of node 2 (see hpg.h)
+		 *
+		 *	\exception std::string Errortext
+		 */
+		virtual void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) = 0;
+
+		/**
+		 *	Receive the end of a graphlet, after its last edge.
+		 *
+		 *	\param graphlet_nr Number of the graphlet
+		 *	\param nodeInfos Node infos of the summary nodes of the graphlet (NULL unless hap4nfsen), only valid during the call
+		 *
+		 *	\exception std::string Errortext
+		 */
+		virtual void end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos) {
+		}
+
+		/**
+		 *	Receive the end of the data: no more graphlets follow.
+		 *
+		 *	\exception std::string Errortext
+		 */
+		virtual void finish() {
+		}
+
+		static void encode_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2, hpg_field edge[3]);
+};
+
+/**
+ *	\class	CHpgFileSink
+ *	\brief	Writes the edges to an hpg file.
+ */
+class CHpgFileSink: public CEdgeSink {
+	public:
+		CHpgFileSink(const std::string & filename, bool append = false);
+		~CHpgFileSink();
+		void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2);
+
+	private:
+		std::ofstream outfs;
+		std::string filename;
+};
+
+/**
+ *	\class	CHpgBufferSink
+ *	\brief	Keeps the edges in memory, in the format of an hpg file.
+ */
+class CHpgBufferSink: public CEdgeSink {
+	public:
+		void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2);
+		void add_version_edge(unsigned int graphlet_nr = 0);
+
+		/// \return hpg data: 3 fields per edge (empty if no edge received)
+		std::vector<hpg_field> & get_data() {
+			return data;
+		}
+
+		std::string get_contents() const;
+		void clear();
+
+	protected:
+		std::vector<hpg_field> data; ///< hpg data received
+};
+
+/**
+ *	\class	CDotSink
+ *	\brief	Transforms each graphlet to dot format and writes it to a stream.
+ */
+class CDotSink: public CEdgeSink {
+	public:
+		CDotSink(std::ostream & out);
+		void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2);
+		void end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos);
+
+	private:
+		std::ostream & out; ///< Receives the dot data
+		CHpgBufferSink graphlet; ///< Edges of the current graphlet, after a version edge
+};
+
+#endif /* GEDGESINK_H_ */
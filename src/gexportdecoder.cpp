@@ -0,0 +1,563 @@
+/**
+ *	\file gexportdecoder.cpp
+ *	\brief Template based decoding of NetFlow v9 and IPFIX export messages.
+ */
+
+#include <string.h>
+#include <netinet/in.h>
+
+#include "gexportdecoder.h"
+
+using namespace std;
+
+// Message and set layout as defined by RFC 3954 (NetFlow v9) and RFC 7011 (IPFIX)
+static const size_t NETFLOW_V9_HEADER_LENGTH = 20;
+static const uint16_t NETFLOW_V9_TEMPLATE_SET = 0;
+static const uint16_t NETFLOW_V9_OPTIONS_TEMPLATE_SET = 1;
+static const uint16_t IPFIX_TEMPLATE_SET = 2;
+static const uint16_t IPFIX_OPTIONS_TEMPLATE_SET = 3;
+static const uint16_t MIN_DATA_SET = 256;
+static const uint16_t IPFIX_VARLEN = 0xffff;
+static const uint16_t IPFIX_ENTERPRISE_BIT = 0x8000;
+static const uint32_t IPFIX_REVERSE_PEN = 29305; ///< Private enterprise number of reverse elements (RFC 5103)
+
+// Information elements (see http://www.iana.org/assignments/ipfix); NetFlow v9 uses the same numbers
+static const uint16_t IE_OCTET_DELTA_COUNT = 1;
+static const uint16_t IE_PACKET_DELTA_COUNT = 2;
+static const uint16_t IE_PROTOCOL_IDENTIFIER = 4;
+static const uint16_t IE_IP_CLASS_OF_SERVICE = 5;
+static const uint16_t IE_SOURCE_TRANSPORT_PORT = 7;
+static const uint16_t IE_SOURCE_IPV4_ADDRESS = 8;
+static const uint16_t IE_DESTINATION_TRANSPORT_PORT = 11;
+static const uint16_t IE_DESTINATION_IPV4_ADDRESS = 12;
+static const uint16_t IE_FLOW_END_SYS_UP_TIME = 21; ///< LAST_SWITCHED in NetFlow v9
+static const uint16_t IE_FLOW_START_SYS_UP_TIME = 22; ///< FIRST_SWITCHED in NetFlow v9
+static const uint16_t IE_SOURCE_IPV6_ADDRESS = 27;
+static const uint16_t IE_DESTINATION_IPV6_ADDRESS = 28;
+static const uint16_t IE_OCTET_TOTAL_COUNT = 85;
+static const uint16_t IE_PACKET_TOTAL_COUNT = 86;
+static const uint16_t IE_FLOW_START_SECONDS = 150;
+static const uint16_t IE_FLOW_END_SECONDS = 151;
+static const uint16_t IE_FLOW_START_MILLISECONDS = 152;
+static const uint16_t IE_FLOW_END_MILLISECONDS = 153;
+static const uint16_t IE_FLOW_START_MICROSECONDS = 154;
+static const uint16_t IE_FLOW_END_MICROSECONDS = 155;
+static const uint16_t IE_FLOW_START_NANOSECONDS = 156;
+static const uint16_t IE_FLOW_END_NANOSECONDS = 157;
+static const uint16_t IE_FLOW_START_DELTA_MICROSECONDS = 158;
+static const uint16_t IE_FLOW_END_DELTA_MICROSECONDS = 159;
+static const uint16_t IE_SYSTEM_INIT_TIME_MILLISECONDS = 160;
+static const uint16_t IE_FLOW_DURATION_MILLISECONDS = 161;
+static const uint16_t IE_FLOW_DURATION_MICROSECONDS = 162;
+
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL; ///< Seconds from 1900 (NTP era) to 1970 (Unix epoch)
+
+/**
+ *	Read 16 bit value in network byte order.
+ */
+static inline uint16_t net16(const uint8_t * p) {
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+/**
+ *	Read 32 bit value in network byte order.
+ */
+static inline uint32_t net32(const uint8_t * p) {
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+/**
+ *	Read unsigned value of 1 to 8 bytes in network byte order (reduced size encoding).
+ */
+static inline uint64_t net_uint(const uint8_t * p, size_t width) {
+	uint64_t v = 0;
+	for (size_t i = 0; i < width; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+/**
+ *	Convert NTP timestamp (seconds since 1900, 32 bit binary fraction) into milliseconds since the epoch.
+ */
+static inline uint64_t ntp2ms(const uint8_t * p) {
+	return ((uint64_t) net32(p) - NTP_UNIX_OFFSET) * 1000 + (((uint64_t) net32(p + 4) * 1000) >> 32);
+}
+
+/**
+ *	Get the version of an export message.
+ *
+ *	\param msg Start of message
+ *	\param length Length of message buffer
+ *
+ *	\return Message version (0 if buffer is too short)
+ */
+uint16_t CExportDecoder::get_version(const uint8_t * msg, size_t length) {
+	return (length >= 2) ? net16(msg) : 0;
+}
+
+/**
+ *	Build the key identifying a template scope.
+ *
+ *	\param exporter Exporter number assigned by the caller (15 bit)
+ *	\param domain Observation domain (IPFIX) or source id (NetFlow v9)
+ *	\param version Message version (templates of NetFlow v9 and IPFIX are kept apart)
+ *
+ *	\return Domain key
+ */
+uint64_t CExportDecoder::make_domain_key(uint16_t exporter, uint32_t domain, uint16_t version) {
+	uint64_t key = ((uint64_t) (exporter & 0x7fff) << 48) | ((uint64_t) domain << 16);
+	if (version == netflow_v9_version)
+		key |= 1ULL << 63;
+	return key;
+}
+
+/**
+ *	Decode a complete NetFlow v9 or IPFIX message: update the template cache and decode all data
+ *	sets having a known flow template.
+ *
+ *	\param msg Start of message
+ *	\param length Length of message buffer (e.g. size of received datagram)
+ *	\param exporter Exporter number assigned by the caller
+ *	\param records Decoded flow records are appended here
+ */
+void CExportDecoder::decode_message(const uint8_t * msg, size_t length, uint16_t exporter, std::vector<decoded_t> & records) {
+	message_sets.clear();
+	collect_data_sets(msg, length, exporter, message_sets);
+	for (std::vector<data_set_t>::const_iterator it = message_sets.begin(); it != message_sets.end(); ++it)
+		decode_data_set(*it, records, stats);
+}
+
+/**
+ *	Walk a NetFlow v9 or IPFIX message: update the template cache and collect all data sets having a
+ *	known flow template, without decoding them. The data sets stay valid as long as the message
+ *	and this decoder, so they can be decoded later, e.g. by several threads (see decode_data_set()).
+ *
+ *	\param msg Start of message
+ *	\param length Length of message buffer (e.g. remainder of a file)
+ *	\param exporter Exporter number assigned by the caller
+ *	\param data_sets Data sets found are appended here
+ *
+ *	\return Length of the message (IPFIX: from its header, NetFlow v9: length), 0 if the message header is malformed.
+ *	Sets behind a malformed set are dropped and counted as malformed message.
+ */
+size_t CExportDecoder::collect_data_sets(const uint8_t * msg, size_t length, uint16_t exporter, std::vector<data_set_t> & data_sets) {
+	uint16_t version = get_version(msg, length);
+	time_base_t time_base;
+	uint32_t domain;
+	size_t spos;
+	uint16_t template_set, options_template_set;
+
+	if (version == ipfix_version && length >= ipfix_header_length && net16(msg + 2) >= ipfix_header_length && net16(msg + 2) <= length) {
+		length = net16(msg + 2);
+		time_base.export_time = net32(msg + 4);
+		domain = net32(msg + 12);
+		spos = ipfix_header_length;
+		template_set = IPFIX_TEMPLATE_SET;
+		options_template_set = IPFIX_OPTIONS_TEMPLATE_SET;
+	} else if (version == netflow_v9_version && length >= NETFLOW_V9_HEADER_LENGTH) {
+		time_base.export_time = net32(msg + 8);
+		time_base.boot_ms = (uint64_t) time_base.export_time * 1000 - net32(msg + 4);
+		domain = net32(msg + 16);
+		spos = NETFLOW_V9_HEADER_LENGTH;
+		template_set = NETFLOW_V9_TEMPLATE_SET;
+		options_template_set = NETFLOW_V9_OPTIONS_TEMPLATE_SET;
+	} else {
+		stats.malformed_messages++;
+		return 0;
+	}
+	stats.messages++;
+	uint64_t domain_key = make_domain_key(exporter, domain, version);
+
+	while (spos + set_header_length <= length) {
+		const uint8_t * set = msg + spos;
+		uint16_t set_id = net16(set);
+		size_t set_length = net16(set + 2);
+		if (set_length < set_header_length || set_length > length - spos) {
+			stats.malformed_messages++;
+			break;
+		}
+		if (set_id == template_set || set_id == options_template_set) {
+			add_template_set(set, set_length, version, set_id == options_template_set, domain_key);
+		} else if (set_id >= MIN_DATA_SET) {
+			const template_t * tmpl = find_template(domain_key, set_id);
+			if (tmpl == NULL) {
+				stats.skipped_sets++;
+			} else if (!tmpl->options) {
+				data_set_t data_set;
+				data_set.data = set;
+				data_set.length = set_length;
+				data_set.tmpl = tmpl;
+				data_set.time_base = time_base;
+				data_sets.push_back(data_set);
+			}
+		}
+		spos += set_length;
+	}
+	return length;
+}
+
+/**
+ *	Decode all records of a data set. Only reads the decoder state, several threads can decode data
+ *	sets of the same decoder.
+ *
+ *	\param data_set Data set (see collect_data_sets())
+ *	\param records Decoded flow records are appended here
+ *	\param stats Receives the record counters
+ */
+void CExportDecoder::decode_data_set(const data_set_t & data_set, std::vector<decoded_t> & records, stats_t & stats) {
+	const template_t & tmpl = *data_set.tmpl;
+	const uint8_t * p = data_set.data + set_header_length;
+	const uint8_t * end = data_set.data + data_set.length;
+	while ((size_t) (end - p) >= tmpl.min_length) { // remainder is padding
+		decoded_t d;
+		if (!decode_record(p, end, tmpl, data_set.time_base, d.rec)) {
+			stats.malformed_records++;
+			return;
+		}
+		d.paired = tmpl.reverse;
+		records.push_back(d);
+		stats.records++;
+	}
+}
+
+/**
+ *	Decode a template or options template set and update the template cache.
+ *
+ *	\param set Start of set (set header)
+ *	\param length Set length in bytes
+ *	\param version Message version (NetFlow v9 and IPFIX differ in options templates and enterprise elements)
+ *	\param options True for options template sets
+ *	\param domain_key Template scope (see make_domain_key())
+ */
+void CExportDecoder::add_template_set(const uint8_t * set, size_t length, uint16_t version, bool options, uint64_t domain_key) {
+	const uint8_t * p = set + set_header_length;
+	const uint8_t * end = set + length;
+	while (end - p >= 4) {
+		uint16_t template_id = net16(p);
+		uint16_t count = net16(p + 2);
+		p += 4;
+		if (template_id < MIN_DATA_SET)
+			return; // padding
+
+		if (version == ipfix_version) {
+			if (count == 0) { // template withdrawal
+				cache.erase(domain_key | template_id);
+				continue;
+			}
+			if (options) {
+				if (end - p < 2)
+					return;
+				p += 2; // scope field count
+			}
+		} else if (options) {
+			// NetFlow v9 options templates give scope and option lengths in bytes
+			if (end - p < 2)
+				return;
+			count = (count + net16(p)) / 4;
+			p += 2;
+		}
+
+		template_t tmpl;
+		tmpl.options = options;
+		for (uint16_t i = 0; i < count; i++) {
+			if (end - p < 4)
+				return;
+			uint16_t id = net16(p);
+			field_t field;
+			field.length = net16(p + 2);
+			p += 4;
+			uint32_t enterprise = 0;
+			if (version == ipfix_version && (id & IPFIX_ENTERPRISE_BIT)) {
+				if (end - p < 4)
+					return;
+				enterprise = net32(p);
+				p += 4;
+				id &= ~IPFIX_ENTERPRISE_BIT;
+			}
+			field.action = classify_field(id, enterprise, field.length);
+			if (field.action == field_reverse_octets || field.action == field_reverse_packets)
+				tmpl.reverse = true;
+			tmpl.min_length += (field.length == IPFIX_VARLEN) ? 1 : field.length;
+			tmpl.fields.push_back(field);
+		}
+		if (tmpl.min_length == 0)
+			continue;
+		store_template(domain_key, template_id, tmpl);
+	}
+}
+
+/**
+ *	Make a template current. Exporters resend their templates periodically: a new version is only
+ *	stored if the definition has changed.
+ *
+ *	\param domain_key Template scope
+ *	\param template_id Template id
+ *	\param tmpl Decoded template
+ */
+void CExportDecoder::store_template(uint64_t domain_key, uint16_t template_id, const template_t & tmpl) {
+	stats.templates++;
+	template_cache_t::iterator it = cache.find(domain_key | template_id);
+	if (it != cache.end() && it->second->options == tmpl.options && it->second->fields == tmpl.fields)
+		return;
+	templates.push_back(tmpl);
+	cache[domain_key | template_id] = &templates.back();
+}
+
+/**
+ *	Look up the current version of a template.
+ *
+ *	\param domain_key Template scope
+ *	\param template_id Template id
+ *
+ *	\return Template or NULL if unknown
+ */
+const CExportDecoder::template_t * CExportDecoder::find_template(uint64_t domain_key, uint16_t template_id) const {
+	template_cache_t::const_iterator it = cache.find(domain_key | template_id);
+	return (it == cache.end()) ? NULL : it->second;
+}
+
+/**
+ *	Get decoder counters.
+ *
+ *	\return Counters
+ */
+const CExportDecoder::stats_t & CExportDecoder::get_stats() const {
+	return stats;
+}
+
+/**
+ *	Map an information element onto a decoding action.
+ *
+ *	\param id Information element id
+ *	\param enterprise Private enterprise number (0 for IANA elements)
+ *	\param length Field length in the template
+ *
+ *	\return Decoding action (field_skip for unsupported elements or lengths)
+ */
+CExportDecoder::field_action_t CExportDecoder::classify_field(uint16_t id, uint32_t enterprise, uint16_t length) {
+	bool integer = (length >= 1 && length <= 8);
+	if (enterprise == IPFIX_REVERSE_PEN) {
+		if (integer && (id == IE_OCTET_DELTA_COUNT || id == IE_OCTET_TOTAL_COUNT))
+			return field_reverse_octets;
+		if (integer && (id == IE_PACKET_DELTA_COUNT || id == IE_PACKET_TOTAL_COUNT))
+			return field_reverse_packets;
+		return field_skip;
+	}
+	if (enterprise != 0)
+		return field_skip;
+
+	switch (id) {
+		case IE_OCTET_DELTA_COUNT:
+		case IE_OCTET_TOTAL_COUNT:
+			return integer ? field_octets : field_skip;
+		case IE_PACKET_DELTA_COUNT:
+		case IE_PACKET_TOTAL_COUNT:
+			return integer ? field_packets : field_skip;
+		case IE_PROTOCOL_IDENTIFIER:
+			return (length == 1) ? field_prot : field_skip;
+		case IE_IP_CLASS_OF_SERVICE:
+			return (length == 1) ? field_tos : field_skip;
+		case IE_SOURCE_TRANSPORT_PORT:
+			return (length == 2) ? field_src_port : field_skip;
+		case IE_DESTINATION_TRANSPORT_PORT:
+			return (length == 2) ? field_dst_port : field_skip;
+		case IE_SOURCE_IPV4_ADDRESS:
+			return (length == 4) ? field_src_ipv4 : field_skip;
+		case IE_DESTINATION_IPV4_ADDRESS:
+			return (length == 4) ? field_dst_ipv4 : field_skip;
+		case IE_SOURCE_IPV6_ADDRESS:
+			return (length == 16) ? field_src_ipv6 : field_skip;
+		case IE_DESTINATION_IPV6_ADDRESS:
+			return (length == 16) ? field_dst_ipv6 : field_skip;
+		case IE_FLOW_START_SYS_UP_TIME:
+			return integer ? field_start_uptime : field_skip;
+		case IE_FLOW_END_SYS_UP_TIME:
+			return integer ? field_end_uptime : field_skip;
+		case IE_FLOW_START_SECONDS:
+			return integer ? field_start_sec : field_skip;
+		case IE_FLOW_END_SECONDS:
+			return integer ? field_end_sec : field_skip;
+		case IE_FLOW_START_MILLISECONDS:
+			return integer ? field_start_ms : field_skip;
+		case IE_FLOW_END_MILLISECONDS:
+			return integer ? field_end_ms : field_skip;
+		case IE_FLOW_START_MICROSECONDS:
+		case IE_FLOW_START_NANOSECONDS:
+			return (length == 8) ? field_start_ntp : field_skip;
+		case IE_FLOW_END_MICROSECONDS:
+		case IE_FLOW_END_NANOSECONDS:
+			return (length == 8) ? field_end_ntp : field_skip;
+		case IE_FLOW_START_DELTA_MICROSECONDS:
+			return integer ? field_start_delta_us : field_skip;
+		case IE_FLOW_END_DELTA_MICROSECONDS:
+			return integer ? field_end_delta_us : field_skip;
+		case IE_SYSTEM_INIT_TIME_MILLISECONDS:
+			return integer ? field_system_init_ms : field_skip;
+		case IE_FLOW_DURATION_MILLISECONDS:
+			return integer ? field_duration_ms : field_skip;
+		case IE_FLOW_DURATION_MICROSECONDS:
+			return integer ? field_duration_us : field_skip;
+		default:
+			return field_skip;
+	}
+}
+
+/**
+ *	Decode a single data record.
+ *
+ *	\param p Start of record, advanced behind the record
+ *	\param end End of enclosing data set
+ *	\param tmpl Template of the record
+ *	\param time_base Time information of the enclosing message
+ *	\param rec Decoded record
+ *
+ *	\return False if the record exceeds the data set
+ */
+bool CExportDecoder::decode_record(const uint8_t * & p, const uint8_t * end, const template_t & tmpl, const time_base_t & time_base,
+      CFlowAssembler::record_t & rec) {
+	uint64_t start = 0, finish = 0, duration = 0, start_uptime = 0, end_uptime = 0;
+	bool have_start = false, have_finish = false, have_duration = false, have_start_uptime = false, have_end_uptime = false;
+	uint64_t boot_ms = time_base.boot_ms;
+	uint64_t reverse_octets = 0, reverse_packets = 0;
+	in6_addr addr;
+
+	for (std::vector<field_t>::const_iterator f = tmpl.fields.begin(); f != tmpl.fields.end(); ++f) {
+		size_t length = f->length;
+		if (length == IPFIX_VARLEN) {
+			if (p >= end)
+				return false;
+			length = *p++;
+			if (length == 255) {
+				if (end - p < 2)
+					return false;
+				length = net16(p);
+				p += 2;
+			}
+		}
+		if ((size_t) (end - p) < length)
+			return false;
+
+		switch (f->action) {
+			case field_skip:
+				break;
+			case field_octets:
+				rec.dOctets = net_uint(p, length);
+				break;
+			case field_packets:
+				rec.dPkts = net_uint(p, length);
+				break;
+			case field_reverse_octets:
+				reverse_octets = net_uint(p, length);
+				break;
+			case field_reverse_packets:
+				reverse_packets = net_uint(p, length);
+				break;
+			case field_prot:
+				rec.prot = *p;
+				break;
+			case field_tos:
+				rec.tos_flags = *p;
+				break;
+			case field_src_port:
+				rec.srcPort = net16(p);
+				break;
+			case field_dst_port:
+				rec.dstPort = net16(p);
+				break;
+			case field_src_ipv4:
+				rec.srcIP = IPv6_addr(net32(p));
+				break;
+			case field_dst_ipv4:
+				rec.dstIP = IPv6_addr(net32(p));
+				break;
+			case field_src_ipv6:
+				memcpy(&addr, p, sizeof(addr));
+				rec.srcIP = IPv6_addr(addr);
+				break;
+			case field_dst_ipv6:
+				memcpy(&addr, p, sizeof(addr));
+				rec.dstIP = IPv6_addr(addr);
+				break;
+			case field_start_sec:
+				start = net_uint(p, length) * 1000;
+				have_start = true;
+				break;
+			case field_end_sec:
+				finish = net_uint(p, length) * 1000;
+				have_finish = true;
+				break;
+			case field_start_ms:
+				start = net_uint(p, length);
+				have_start = true;
+				break;
+			case field_end_ms:
+				finish = net_uint(p, length);
+				have_finish = true;
+				break;
+			case field_start_ntp:
+				start = ntp2ms(p);
+				have_start = true;
+				break;
+			case field_end_ntp:
+				finish = ntp2ms(p);
+				have_finish = true;
+				break;
+			case field_start_delta_us:
+				start = (uint64_t) time_base.export_time * 1000 - net_uint(p, length) / 1000;
+				have_start = true;
+				break;
+			case field_end_delta_us:
+				finish = (uint64_t) time_base.export_time * 1000 - net_uint(p, length) / 1000;
+				have_finish = true;
+				break;
+			case field_start_uptime:
+				start_uptime = net_uint(p, length);
+				have_start_uptime = true;
+				break;
+			case field_end_uptime:
+				end_uptime = net_uint(p, length);
+				have_end_uptime = true;
+				break;
+			case field_system_init_ms:
+				boot_ms = net_uint(p, length);
+				break;
+			case field_duration_ms:
+				duration = net_uint(p, length);
+				have_duration = true;
+				break;
+			case field_duration_us:
+				duration = net_uint(p, length) / 1000;
+				have_duration = true;
+				break;
+		}
+		p += length;
+	}
+
+	// Complete flow times from what the template provides
+	if (boot_ms != 0) {
+		if (have_start_uptime && !have_start) {
+			start = boot_ms + start_uptime;
+			have_start = true;
+		}
+		if (have_end_uptime && !have_finish) {
+			finish = boot_ms + end_uptime;
+			have_finish = true;
+		}
+	}
+	if (!have_start && !have_finish) {
+		start = finish = (uint64_t) time_base.export_time * 1000;
+	} else if (!have_start) {
+		start = (have_duration && duration < finish) ? finish - duration : finish;
+	} else if (!have_finish) {
+		finish = start + duration;
+	}
+	rec.startMs = start;
+	rec.endMs = finish;
+
+	rec.bidir = (reverse_octets > 0 || reverse_packets > 0);
+	rec.dOctets += reverse_octets;
+	rec.dPkts += reverse_packets;
+	if (rec.dPkts == 0)
+		rec.dPkts = 1; // template without packet counter: a flow has at least one packet
+	return true;
+}
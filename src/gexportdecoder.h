@@ -0,0 +1,165 @@
+#ifndef GEXPORTDECODER_H_
+#define GEXPORTDECODER_H_
+
+/**
+ *	\file gexportdecoder.h
+ *	\brief Template based decoding of NetFlow v9 and IPFIX export messages.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <list>
+#include <map>
+
+#include "gflowassembler.h"
+
+/**
+ *	\class	CExportDecoder
+ *	\brief	CExportDecoder decodes NetFlow v9 (RFC 3954) and IPFIX (RFC 7011) messages into flow records.
+ *
+ *	Templates are cached per exporter, observation domain (IPFIX) or source id (NetFlow v9) and
+ *	template id. A redefined template is stored as a new version, so records already pointing
+ *	to the previous version stay valid for the lifetime of the decoder. Reverse information
+ *	elements (RFC 5103) are understood natively.
+ */
+class CExportDecoder {
+	public:
+		/**
+		 *	\enum field_action_t
+		 *	\brief What to do with a template field while decoding a data record
+		 */
+		enum field_action_t {
+			field_skip,
+			field_octets,
+			field_packets,
+			field_reverse_octets,
+			field_reverse_packets,
+			field_prot,
+			field_tos,
+			field_src_port,
+			field_dst_port,
+			field_src_ipv4,
+			field_dst_ipv4,
+			field_src_ipv6,
+			field_dst_ipv6,
+			field_start_sec,
+			field_end_sec,
+			field_start_ms,
+			field_end_ms,
+			field_start_ntp,
+			field_end_ntp,
+			field_start_delta_us,
+			field_end_delta_us,
+			field_start_uptime,
+			field_end_uptime,
+			field_system_init_ms,
+			field_duration_ms,
+			field_duration_us
+		};
+
+		/**
+		 *	\struct	field_t
+		 *	\brief	Single field of a template
+		 */
+		struct field_t {
+				uint16_t length; ///< Field length in bytes (0xffff: variable length)
+				field_action_t action; ///< Decoding action
+
+				bool operator==(const field_t & other) const {
+					return length == other.length && action == other.action;
+				}
+		};
+
+		/**
+		 *	\struct	template_t
+		 *	\brief	Decoded (options) template
+		 */
+		struct template_t {
+				std::vector<field_t> fields; ///< Fields in record order
+				size_t min_length; ///< Minimal length of a data record
+				bool options; ///< Options template (records are not flows)
+				bool reverse; ///< Template contains RFC 5103 reverse counters
+				template_t() :
+					min_length(0), options(false), reverse(false) {
+				}
+		};
+
+		/**
+		 *	\struct	time_base_t
+		 *	\brief	Message level time information needed to resolve relative timestamps
+		 */
+		struct time_base_t {
+				uint32_t export_time; ///< Export time of the message (seconds since the epoch)
+				uint64_t boot_ms; ///< Exporter boot time in milliseconds since the epoch (0: unknown)
+				time_base_t() :
+					export_time(0), boot_ms(0) {
+				}
+		};
+
+		/**
+		 *	\struct	data_set_t
+		 *	\brief	Data set of a message together with the template version valid at its position
+		 */
+		struct data_set_t {
+				const uint8_t * data; ///< Start of set (set header)
+				size_t length; ///< Set length in bytes
+				const template_t * tmpl; ///< Template describing the records
+				time_base_t time_base; ///< Time information of the enclosing message
+		};
+
+		/**
+		 *	\struct	decoded_t
+		 *	\brief	Decoded flow record
+		 */
+		struct decoded_t {
+				CFlowAssembler::record_t rec; ///< Flow record in source/destination view
+				bool paired; ///< Record of a template with reverse counters: exporter has already paired both directions
+		};
+
+		/**
+		 *	\struct	stats_t
+		 *	\brief	Decoder counters
+		 */
+		struct stats_t {
+				uint64_t messages; ///< Messages decoded
+				uint64_t malformed_messages; ///< Messages dropped (bad version or length)
+				uint64_t templates; ///< (Options) template records
+				uint64_t records; ///< Flow records decoded
+				uint64_t skipped_sets; ///< Data sets without (flow) template
+				uint64_t malformed_records; ///< Records not matching their template
+				stats_t() :
+					messages(0), malformed_messages(0), templates(0), records(0), skipped_sets(0), malformed_records(0) {
+				}
+		};
+
+		static const uint16_t netflow_v9_version = 9; ///< NetFlow v9 message version
+		static const uint16_t ipfix_version = 10; ///< IPFIX message version
+		static const size_t ipfix_header_length = 16; ///< IPFIX message header length
+		static const size_t set_header_length = 4; ///< (Flow) set header length
+
+		void decode_message(const uint8_t * msg, size_t length, uint16_t exporter, std::vector<decoded_t> & records);
+		size_t collect_data_sets(const uint8_t * msg, size_t length, uint16_t exporter, std::vector<data_set_t> & data_sets);
+		void add_template_set(const uint8_t * set, size_t length, uint16_t version, bool options, uint64_t domain_key);
+		const template_t * find_template(uint64_t domain_key, uint16_t template_id) const;
+		const stats_t & get_stats() const;
+
+		static uint64_t make_domain_key(uint16_t exporter, uint32_t domain, uint16_t version);
+		static field_action_t classify_field(uint16_t id, uint32_t enterprise, uint16_t length);
+		static bool decode_record(const uint8_t * & p, const uint8_t * end, const template_t & tmpl, const time_base_t & time_base,
+		      CFlowAssembler::record_t & rec);
+		static uint16_t get_version(const uint8_t * msg, size_t length);
+		static void decode_data_set(const data_set_t & data_set, std::vector<decoded_t> & records, stats_t & stats);
+
+	private:
+		typedef std::map<uint64_t, const template_t *> template_cache_t; ///< Key: domain key and template id
+
+		void store_template(uint64_t domain_key, uint16_t template_id, const template_t & tmpl);
+
+		std::list<template_t> templates; ///< All template versions (stable addresses)
+		template_cache_t cache; ///< Current template per domain key and template id
+		stats_t stats; ///< Counters
+		std::vector<data_set_t> message_sets; ///< Data sets of the message decode_message() decodes
+};
+
+#endif /* GEXPORTDECODER_H_ */
@@ -0,0 +1,315 @@
+/**
+ *	\file gexternalsort.cpp
+ *	\brief Sorting of flow lists larger than the memory budget (external merge sort).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "gexternalsort.h"
+
+using namespace std;
+
+const size_t CExternalSort::max_fan_in;
+const size_t CExternalSort::min_buffer_flows;
+
+/**
+ *	Constructor
+ *
+ *	\param memory_budget Bytes to use for buffered flows (in-memory sorting and merge buffers)
+ *	\param tmp_dir Directory for the run files (empty: $TMPDIR or /tmp)
+ */
+CExternalSort::CExternalSort(uint64_t memory_budget, const string & tmp_dir) :
+	memory_budget(memory_budget), tmp_dir(tmp_dir), total_flows(0), spilled_bytes(0), spilled_runs(0), buffer_pos(0), finished(false),
+	      have_lookahead(false) {
+	if (this->tmp_dir.empty()) {
+		const char * env = getenv("TMPDIR");
+		this->tmp_dir = (env != NULL && *env != '\0') ? env : "/tmp";
+	}
+	max_buffered = max<uint64_t>(memory_budget / sizeof(cflow_t), min_buffer_flows);
+}
+
+/**
+ *	Destructor: closes (and thereby deletes) all run files
+ */
+CExternalSort::~CExternalSort() {
+	for (vector<run_t *>::iterator it = runs.begin(); it != runs.end(); ++it) {
+		fclose((*it)->file);
+		delete *it;
+	}
+	for (vector<run_t *>::iterator it = heap.begin(); it != heap.end(); ++it) {
+		fclose((*it)->file);
+		delete *it;
+	}
+}
+
+/**
+ *	Add a flow. Spills the buffer to a run file when it reaches the memory budget.
+ *
+ *	\param flow Flow
+ *
+ *	\exception std::string Errortext
+ */
+void CExternalSort::add(const cflow_t & flow) {
+	if (finished)
+		throw string("ERROR: CExternalSort::add() called after finish().");
+	if (buffer.size() >= max_buffered)
+		spill();
+	if (buffer.size() == buffer.capacity())
+		buffer.reserve(min<size_t>(max_buffered, max<size_t>(2 * buffer.capacity(), 1024)));
+	buffer.push_back(flow);
+	total_flows++;
+}
+
+/**
+ *	End adding flows and prepare reading them in sorted order.
+ *
+ *	\exception std::string Errortext
+ */
+void CExternalSort::finish() {
+	if (finished)
+		return;
+	finished = true;
+	if (spilled_runs == 0) {
+		sort(buffer.begin(), buffer.end());
+		return;
+	}
+	if (!buffer.empty())
+		spill();
+	CFlowList().swap(buffer);
+
+	// Intermediate passes: merge the oldest runs into a new one until all runs can be merged at once
+	uint64_t budget_flows = memory_budget / sizeof(cflow_t);
+	while (runs.size() > max_fan_in) {
+		size_t buffer_flows = max<uint64_t>(budget_flows / (max_fan_in + 1), min_buffer_flows);
+		start_merge(0, max_fan_in, buffer_flows);
+		run_t * out = create_run();
+		CFlowList out_buffer;
+		out_buffer.reserve(buffer_flows);
+		cflow_t flow;
+		while (merge_next(flow)) {
+			out_buffer.push_back(flow);
+			if (out_buffer.size() == buffer_flows) {
+				write_flows(out, &out_buffer[0], out_buffer.size());
+				out_buffer.clear();
+			}
+		}
+		if (!out_buffer.empty())
+			write_flows(out, &out_buffer[0], out_buffer.size());
+	}
+	start_merge(0, runs.size(), max<uint64_t>(budget_flows / runs.size(), min_buffer_flows));
+}
+
+/**
+ *	Get the next flow in sorted order.
+ *
+ *	\param flow Flow (out)
+ *
+ *	\return False if all flows have been read
+ *
+ *	\exception std::string Errortext
+ */
+bool CExternalSort::next(cflow_t & flow) {
+	if (!finished)
+		throw string("ERROR: CExternalSort::next() called before finish().");
+	if (have_lookahead) {
+		flow = lookahead;
+		have_lookahead = false;
+		return true;
+	}
+	if (spilled_runs == 0) {
+		if (buffer_pos == buffer.size())
+			return false;
+		flow = buffer[buffer_pos++];
+		return true;
+	}
+	return merge_next(flow);
+}
+
+/**
+ *	Get all flows of the next local host in sorted order.
+ *
+ *	\param flows Flows of the host (out)
+ *
+ *	\return False if all flows have been read
+ *
+ *	\exception std::string Errortext
+ */
+bool CExternalSort::next_host(CFlowList & flows) {
+	flows.clear();
+	cflow_t flow;
+	if (!next(flow))
+		return false;
+	flows.push_back(flow);
+	while (next(flow)) {
+		if (flow.localIP != flows.front().localIP) {
+			lookahead = flow;
+			have_lookahead = true;
+			break;
+		}
+		flows.push_back(flow);
+	}
+	return true;
+}
+
+/**
+ *	\return Number of flows added
+ */
+uint64_t CExternalSort::size() const {
+	return total_flows;
+}
+
+/**
+ *	\return Number of runs spilled to disk (0: sorted in memory)
+ */
+size_t CExternalSort::get_run_count() const {
+	return spilled_runs;
+}
+
+/**
+ *	\return Bytes written to run files, including intermediate merge passes
+ */
+uint64_t CExternalSort::get_spilled_bytes() const {
+	return spilled_bytes;
+}
+
+/**
+ *	Create an empty run file in tmp_dir and add it to runs. The file is unlinked right away.
+ *
+ *	\return Run
+ *
+ *	\exception std::string Errortext
+ */
+CExternalSort::run_t * CExternalSort::create_run() {
+	string pattern = tmp_dir + "/hapviewer_sort_XXXXXX";
+	vector<char> path(pattern.begin(), pattern.end());
+	path.push_back('\0');
+	int fd = mkstemp(&path[0]);
+	if (fd == -1)
+		throw "ERROR: could not create temporary file in " + tmp_dir + ": " + strerror(errno);
+	unlink(&path[0]);
+	FILE * file = fdopen(fd, "w+b");
+	if (file == NULL) {
+		close(fd);
+		throw "ERROR: could not open temporary file in " + tmp_dir + ": " + strerror(errno);
+	}
+	run_t * run = new run_t;
+	run->file = file;
+	run->flows = 0;
+	run->read = 0;
+	run->pos = 0;
+	runs.push_back(run);
+	return run;
+}
+
+/**
+ *	Sort the buffered flows and write them to a new run.
+ *
+ *	\exception std::string Errortext
+ */
+void CExternalSort::spill() {
+	sort(buffer.begin(), buffer.end());
+	run_t * run = create_run();
+	write_flows(run, &buffer[0], buffer.size());
+	spilled_runs++;
+	buffer.clear();
+}
+
+/**
+ *	Append flows to a run.
+ *
+ *	\param run Run
+ *	\param flows Flows
+ *	\param count Number of flows
+ *
+ *	\exception std::string Errortext
+ */
+void CExternalSort::write_flows(run_t * run, const cflow_t * flows, size_t count) {
+	if (fwrite(flows, sizeof(cflow_t), count, run->file) != count)
+		throw "ERROR: writing temporary file in " + tmp_dir + " failed: " + strerror(errno);
+	run->flows += count;
+	spilled_bytes += count * sizeof(cflow_t);
+}
+
+/**
+ *	Read the next flows of a run into its buffer.
+ *
+ *	\param run Run
+ *
+ *	\return False if the run has been read completely
+ *
+ *	\exception std::string Errortext
+ */
+bool CExternalSort::fill(run_t * run) {
+	if (run->read == run->flows)
+		return false;
+	size_t count = min<uint64_t>(run->buffer.capacity(), run->flows - run->read);
+	run->buffer.resize(count);
+	if (fread(&run->buffer[0], sizeof(cflow_t), count, run->file) != count)
+		throw "ERROR: reading temporary file in " + tmp_dir + " failed.";
+	run->read += count;
+	run->pos = 0;
+	return true;
+}
+
+/**
+ *	Move runs from runs to the merge heap.
+ *
+ *	\param first Index of first run
+ *	\param count Number of runs
+ *	\param buffer_flows Flows to read ahead per run
+ *
+ *	\exception std::string Errortext
+ */
+void CExternalSort::start_merge(size_t first, size_t count, size_t buffer_flows) {
+	for (size_t i = first; i < first + count; i++) {
+		run_t * run = runs[i];
+		if (fflush(run->file) != 0 || fseek(run->file, 0, SEEK_SET) != 0)
+			throw "ERROR: rewinding temporary file in " + tmp_dir + " failed: " + strerror(errno);
+		run->read = 0;
+		run->buffer.reserve(buffer_flows);
+		if (fill(run))
+			heap.push_back(run);
+		else
+			close_run(run);
+	}
+	runs.erase(runs.begin() + first, runs.begin() + first + count);
+	make_heap(heap.begin(), heap.end(), CRunGreater());
+}
+
+/**
+ *	Get the smallest flow of the runs being merged.
+ *
+ *	\param flow Flow (out)
+ *
+ *	\return False if all runs being merged have been read completely
+ *
+ *	\exception std::string Errortext
+ */
+bool CExternalSort::merge_next(cflow_t & flow) {
+	if (heap.empty())
+		return false;
+	pop_heap(heap.begin(), heap.end(), CRunGreater());
+	run_t * run = heap.back();
+	flow = run->buffer[run->pos++];
+	if (run->pos == run->buffer.size() && !fill(run)) {
+		heap.pop_back();
+		close_run(run);
+	} else {
+		push_heap(heap.begin(), heap.end(), CRunGreater());
+	}
+	return true;
+}
+
+/**
+ *	Close (and thereby delete) a run file.
+ *
+ *	\param run Run
+ */
+void CExternalSort::close_run(run_t * run) {
+	fclose(run->file);
+	delete run;
+}
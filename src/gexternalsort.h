@@ -0,0 +1,96 @@
+#ifndef GEXTERNALSORT_H_
+#define GEXTERNALSORT_H_
+
+/**
+ *	\file gexternalsort.h
+ *	\brief Sorting of flow lists larger than the memory budget (external merge sort).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "cflow.h"
+
+/**
+ *	\class	CExternalSort
+ *	\brief	CExternalSort sorts flows (by localIP, remoteIP, startMs as CFlowList does) within a memory budget.
+ *
+ *	Flows are collected with add() into an in-memory buffer of at most the memory budget. A full buffer is
+ *	sorted and spilled to a temporary file (a run). After finish() the flows are read back in sorted order with
+ *	next() or host by host with next_host(): the runs are merged through a heap, each run reading through its
+ *	own buffer. If more than max_fan_in runs have been spilled, intermediate merge passes reduce them first.
+ *	If all flows fit into the budget, nothing is spilled and the buffer is sorted in memory.
+ *
+ *	Run files are unlinked as soon as they are created, so they vanish with the object (or the process).
+ */
+class CExternalSort {
+	public:
+		static const size_t max_fan_in = 64; ///< Maximum number of runs merged at once
+		static const size_t min_buffer_flows = 16; ///< Minimum number of flows buffered per run
+
+		CExternalSort(uint64_t memory_budget, const std::string & tmp_dir = "");
+		~CExternalSort();
+
+		void add(const cflow_t & flow);
+		void finish();
+		bool next(cflow_t & flow);
+		bool next_host(CFlowList & flows);
+
+		uint64_t size() const;
+		size_t get_run_count() const;
+		uint64_t get_spilled_bytes() const;
+
+	private:
+		/**
+		 *	\struct	run_t
+		 *	\brief	Sorted run of flows spilled to a temporary file
+		 */
+		struct run_t {
+				FILE * file; ///< Unlinked temporary file
+				uint64_t flows; ///< Flows in the file
+				uint64_t read; ///< Flows read from the file so far
+				CFlowList buffer; ///< Flows read ahead
+				size_t pos; ///< Next flow of buffer
+		};
+
+		/**
+		 *	\class	CRunGreater
+		 *	\brief	Orders runs by their next flow, largest first (for a min-heap with std::push_heap)
+		 */
+		class CRunGreater {
+			public:
+				bool operator()(const run_t * a, const run_t * b) const {
+					return b->buffer[b->pos] < a->buffer[a->pos];
+				}
+		};
+
+		// Not copyable (owns the run files)
+		CExternalSort(const CExternalSort &);
+		CExternalSort & operator=(const CExternalSort &);
+
+		run_t * create_run();
+		void spill();
+		void write_flows(run_t * run, const cflow_t * flows, size_t count);
+		bool fill(run_t * run);
+		void start_merge(size_t first, size_t count, size_t buffer_flows);
+		bool merge_next(cflow_t & flow);
+		void close_run(run_t * run);
+
+		uint64_t memory_budget; ///< Bytes to use for buffered flows
+		std::string tmp_dir; ///< Directory of the run files
+		CFlowList buffer; ///< Flows not yet spilled (sorted by finish() if nothing was spilled)
+		size_t max_buffered; ///< Flows buffered before spilling
+		std::vector<run_t *> runs; ///< Spilled runs
+		std::vector<run_t *> heap; ///< Runs being merged, ordered by CRunGreater
+		uint64_t total_flows; ///< Flows added
+		uint64_t spilled_bytes; ///< Bytes written to run files (all passes)
+		size_t spilled_runs; ///< Runs spilled by add() and finish()
+		size_t buffer_pos; ///< Next flow of buffer (in-memory mode)
+		bool finished; ///< True after finish()
+		bool have_lookahead; ///< True if lookahead holds the first flow of the next host
+		cflow_t lookahead; ///< Flow read ahead by next_host()
+};
+
+#endif /* GEXTERNALSORT_H_ */
@@ -8,6 +8,7 @@
 #include <libgen.h>
 
 #include "gfilter.h"
+#include "gexternalsort.h"
 
 using namespace std;
 
@@ -42,6 +43,64 @@ bool GFilter::acceptFilename(std::string in_filename) const {
 	return false;
 }
 
+/**
+ *	Read a file using a single local network given by address and netmask.
+ *
+ *	\param in_filename Inputfilename
+ *	\param flowlist Reference to the flowlist
+ *	\param local_net Local network address
+ *	\param netmask Network mask for local network address
+ *	\param append Future flag to allow the import of more than one file (not yet used)
+ *
+ *	\exception std::string Errortext
+ */
+void GFilter::read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
+	read_file(in_filename, flowlist, CLocalNets(local_net, netmask), append);
+}
+
+/**
+ *	Read a file without import predicate (all flows are added to the flow list).
+ *
+ *	\param in_filename Inputfilename
+ *	\param flowlist Reference to the flowlist
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param append Future flag to allow the import of more than one file (not yet used)
+ *
+ *	\exception std::string Errortext
+ */
+void GFilter::read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, bool append) const {
+	CFlowPredicate predicate;
+	read_file(in_filename, flowlist, local_nets, predicate, append);
+}
+
+/**
+ *	Read a file into an external sorter (out-of-core import). This default implementation reads the file
+ *	into a flow list first; filters that can stream their input override it.
+ *
+ *	\param in_filename Inputfilename
+ *	\param sorter Sorter receiving the flows
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate
+ *
+ *	\exception std::string Errortext
+ */
+void GFilter::read_file(std::string in_filename, CExternalSort & sorter, const CLocalNets & local_nets, CFlowPredicate & predicate) const {
+	CFlowList flowlist;
+	read_file(in_filename, flowlist, local_nets, predicate, false);
+	for (CFlowList::const_iterator it = flowlist.begin(); it != flowlist.end(); ++it)
+		sorter.add(*it);
+}
+
+/**
+ *	Tell if the flows read depend on the local networks passed to read_file() (i.e. the format has no flow
+ *	directions and they are inferred). Imports of other formats can be shared between local networks.
+ *
+ *	\return True (default)
+ */
+bool GFilter::usesLocalNets() const {
+	return true;
+}
+
 /**
  *	Gives the format name back
  *
@@ -12,6 +12,10 @@
 #include "cflow.h"
 #include "gutil.h"
 #include "HashMapE.h"
+#include "glocalnets.h"
+#include "gflowpredicate.h"
+
+class CExternalSort;
 
 /**
  *	\class	GFilter
@@ -28,17 +32,18 @@ class GFilter {
 		virtual bool acceptFilename(std::string in_filename) const;
 
 		// import methods
-		virtual void read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const=0;
+		virtual void read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const=0;
+		void read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, bool append) const;
+		void read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const;
+		virtual void read_file(std::string in_filename, CExternalSort & sorter, const CLocalNets & local_nets, CFlowPredicate & predicate) const;
 		virtual bool acceptFileForReading(std::string in_filename) const=0;
+		virtual bool usesLocalNets() const;
 
 		// export methods
 		virtual bool acceptFileForWriting(std::string in_filename) const;
 		virtual void write_file(const std::string & in_filename, const Subflowlist subflowlist, bool appendIfExisting = true) const;
 
 	protected:
-		typedef HashKeyIPv6_5T flowHashKey;
-		typedef hash_map<HashKeyIPv6_5T, cflow_t *, HashFunction<HashKeyIPv6_5T> , HashFunction<HashKeyIPv6_5T> > flowHashMap;
-
 		std::string formatName; ///< Name of this format (e.g. pcap, cflow, nfdump)
 		std::string humanReadablePattern; ///< A human "readable" pattern for the fileextension (e.g. *.pcap)
 		std::string regexPattern; ///< A regex pattern for the file extension (e.g. .*\\.pcap$)
@@ -6,6 +6,7 @@
 #include "gfilter_argus.h"
 
 #include <cstdio>
+#include <string.h>
 #include <sys/stat.h>
 #include <iostream>
 #include <fstream>
@@ -14,10 +15,56 @@
 
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
-#include <netinet/in.h>
+
+#include "gmappedfile.h"
 
 using namespace std;
 
+// Argus 3 binary record layout (see argus_def.h of the argus client tools).
+// Records and DSRs (data set records) start with a 4 byte header; all fields are in network byte order.
+static const uint8_t ARGUS_RECORD_TYPE_MASK = 0xf0; ///< Record type is stored in the upper nibble
+static const uint8_t ARGUS_MAR = 0x80; ///< Management record
+static const uint8_t ARGUS_FAR = 0x10; ///< Flow activity record
+static const uint32_t ARGUS_COOKIE = 0xe5712dcb; ///< Cookie of the initial management record (Argus 3)
+static const uint8_t ARGUS_IMMEDIATE_DATA = 0x80; ///< DSR consists of its header only
+static const uint8_t ARGUS_FLOW_DSR = 0x10;
+static const uint8_t ARGUS_TIME_DSR = 0x20;
+static const uint8_t ARGUS_METER_DSR = 0x30;
+static const uint8_t ARGUS_DATA_DSR = 0x50; ///< Only DSR with a 16 bit length field
+static const uint8_t ARGUS_FLOW_CLASSIC5TUPLE = 0x01;
+static const uint8_t ARGUS_TYPE_IPV4 = 0x01;
+static const uint8_t ARGUS_TYPE_IPV6 = 0x02;
+static const uint8_t ARGUS_TIME_SRC_START = 0x01;
+static const uint8_t ARGUS_TIME_SRC_END = 0x02;
+static const uint8_t ARGUS_TIME_DST_START = 0x04;
+static const uint8_t ARGUS_TIME_DST_END = 0x08;
+static const uint8_t ARGUS_METER_PKTS_BYTES = 0x01;
+static const uint8_t ARGUS_METER_PKTS_BYTES_APP = 0x02;
+
+/**
+ *	Read 16 bit value in network byte order.
+ */
+static inline uint16_t net16(const uint8_t * p) {
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+/**
+ *	Read 32 bit value in network byte order.
+ */
+static inline uint32_t net32(const uint8_t * p) {
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+/**
+ *	Read unsigned value of 1, 2, 4 or 8 bytes in network byte order.
+ */
+static inline uint64_t net_uint(const uint8_t * p, size_t width) {
+	uint64_t v = 0;
+	for (size_t i = 0; i < width; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
 /**
  *	Constructor
  *
@@ -39,7 +86,51 @@ GFilter_argus::GFilter_argus(std::string formatName, std::string humanReadablePa
  *
  */
 bool GFilter_argus::acceptFileForReading(std::string in_filename) const {
-	// step 1: check if ra executable can be found
+	// step 1: check if file name looks like a valid argus file name
+	static const boost::regex file_pattern(".*\\.log");
+	if (!regex_match(in_filename, file_pattern)) {
+		cout << "argus file does not match expected file pattern" << endl;
+		return false;
+	}
+
+	// step 2: argus binary record files are read without ra
+	if (is_native_file(in_filename)) {
+		return true;
+	}
+
+	// step 3: check if ra executable can be found
+	if (!is_ra_available()) {
+		cerr << "ra executable could not be found. Please ensure that argus client tools are installed on the system and accessable and in the users' PATH"
+		      << endl;
+		return false;
+	}
+
+	// step 4: check if file is a valid argus file containing at least one ip record
+	stringstream ss;
+	ss << "ra -N 1 -r ";
+	ss << in_filename;
+	ss << " - ip";
+	FILE * fp;
+	if ((fp = popen(ss.str().c_str(), "r")) == NULL) {
+		cerr << "failed to run ra" << endl;
+		return false;
+	}
+	char buffer[8 * 1024];
+	// request a single line from ra to check if file exists and can be read by argus
+	bool found = (fgets(buffer, sizeof buffer, fp) != NULL);
+	pclose(fp);
+	if (!found) {
+		cout << in_filename << " is not an argus file or does not contain a single ip record" << endl;
+	}
+	return found;
+}
+
+/**
+ *	Check if the argus client tool ra can be found in the PATH.
+ *
+ *	\return True if an executable ra was found
+ */
+bool GFilter_argus::is_ra_available() {
 	char * val = getenv("PATH");
 	if (val == NULL) {
 		cout << "could not access env variable PATH" << endl;
@@ -55,7 +146,6 @@ bool GFilter_argus::acceptFileForReading(std::string in_filename) const {
 		i++;
 	}
 
-	bool ra_found = false;
 	struct stat stFileInfo;
 	int intStat;
 	for (set<string>::const_iterator it = path_set.begin(); it != path_set.end(); ++it) {
@@ -64,49 +154,36 @@ bool GFilter_argus::acceptFileForReading(std::string in_filename) const {
 		intStat = stat(file_name.c_str(), &stFileInfo);
 		if (intStat == 0) {
 			if (stFileInfo.st_mode & S_IXUSR) {
-				cout << "ra found: " << file_name << endl;
-				ra_found = true;
-				break;
+				return true;
 			} else {
 				cout << "no execute premissions for ra: " << file_name << endl;
 			}
 		}
 	}
-	if (!ra_found) {
-		cerr << "ra executable could not be found. Please ensure that argus client tools are installed on the system and accessable and in the users' PATH"
-		      << endl;
-		return false;
-	}
-
-	// step 2: check if file name looks like a valid argus file name
-	static const boost::regex file_pattern(".*\\.log");
-	if (!regex_match(in_filename, file_pattern)) {
-		cout << "argus file does not match expected file pattern" << endl;
-		return false;
-	}
+	return false;
+}
 
-	// step 3: check if file is a valid argus file containing at least one ip record
-	static const boost::regex flow_direction_pattern("[<-|\\?>]+");
-	stringstream ss;
-	ss << "ra -N 1 -r ";
-	ss << in_filename;
-	ss << " - ip";
-	FILE * fp;
-	if ((fp = popen(ss.str().c_str(), "r")) == NULL) {
-		cerr << "failed to run ra" << endl;
+/**
+ *	Check if a file is an uncompressed Argus 3 binary record file, i.e. starts with an
+ *	Argus management record carrying the Argus 3 cookie.
+ *
+ *	\param in_filename Inputfilename
+ *
+ *	\return True if the file can be read by read_file_native()
+ */
+bool GFilter_argus::is_native_file(const std::string & in_filename) {
+	try {
+		CMappedFile file(in_filename);
+		const uint8_t * data = file.data();
+		if (file.size() < 12 || (data[0] & ARGUS_RECORD_TYPE_MASK) != ARGUS_MAR)
+			return false;
+		size_t len = net16(data + 2) * 4;
+		if (len < 12 || len > file.size())
+			return false;
+		return net32(data + 4) == ARGUS_COOKIE || net32(data + 8) == ARGUS_COOKIE;
+	} catch (string &) {
 		return false;
 	}
-	char buffer[8 * 1024];
-	char* l = NULL;
-	// request a single line from ra to check if file exists and can be read by argus
-	while ((l = fgets(buffer, sizeof buffer, fp)) != NULL) {
-		return true; // output found, contains direction information => file ok
-		if (regex_match(in_filename, file_pattern)) {
-			return true;
-		}
-	}
-	cout << in_filename << " is not an argus file or does not contain a single ip record" << endl;
-	return false;
 }
 
 /**
@@ -116,13 +193,221 @@ bool GFilter_argus::acceptFileForReading(std::string in_filename) const {
  *
  *	\param in_filename Inputfilename
  *	\param flowlist Reference to the flowlist
- *	\param local_net Local network address
- *	\param netmask Network mask for local network address
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate selecting the flows to add (collects the skip counters)
  *	\param append Future flag to allow the import of more than one file (not yet used)
  *
  * \exception string Errortext
  */
-void GFilter_argus::read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
+void GFilter_argus::read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const {
+	if (is_native_file(in_filename)) {
+		try {
+			read_file_native(in_filename, flowlist, local_nets, &predicate);
+			return;
+		} catch (string & e) {
+			if (!is_ra_available())
+				throw;
+			cerr << e << " Falling back to ra." << endl;
+		}
+	}
+	read_file_ra(in_filename, flowlist, local_nets, &predicate);
+}
+
+/**
+ *	Read an Argus 3 binary record file directly (without ra).
+ *	Flow activity records are decoded from their flow, time and metric DSRs (data set records);
+ *	all other records are skipped.
+ *
+ *	\param in_filename Inputfilename
+ *	\param flowlist Reference to the flowlist (flows are appended)
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate selecting the flows to add (NULL: all)
+ *
+ * \exception string Errortext
+ */
+void GFilter_argus::read_file_native(const std::string & in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate * predicate) const {
+	CMappedFile file(in_filename);
+	const uint8_t * data = file.data();
+	size_t size = file.size();
+
+	// Argus records carry no record count: estimate it from the file size
+	flowlist.reserve(flowlist.size() + size / 128);
+
+	uint64_t far_count = 0;
+	uint64_t skipped = 0;
+	uint64_t decoded = 0;
+	size_t flows_before = flowlist.size();
+	size_t pos = 0;
+	while (pos + 4 <= size) {
+		const uint8_t * rec = data + pos;
+		size_t len = net16(rec + 2) * 4;
+		if (len < 4 || len > size - pos) {
+			cerr << "WARNING: " << in_filename << " is truncated or corrupt at offset " << pos << ".\n";
+			break;
+		}
+		if ((rec[0] & ARGUS_RECORD_TYPE_MASK) == ARGUS_FAR) {
+			far_count++;
+			cflow_t flow;
+			if (decode_far(rec, len, flow)) {
+				decoded++;
+				invert_flow_if_needed(flow, local_nets);
+				if (predicate == NULL || predicate->accept(flow))
+					flowlist.push_back(flow);
+			} else {
+				skipped++;
+			}
+		}
+		pos += len;
+	}
+
+	if (far_count > 0 && decoded == 0) {
+		stringstream error;
+		error << "None of the " << far_count << " argus flow records of " << in_filename << " could be decoded.";
+		throw error.str();
+	}
+	cout << "*** Processed " << far_count << " argus records to " << (flowlist.size() - flows_before) << " flows (" << skipped << " skipped).\n";
+}
+
+/**
+ *	Decode an argus flow activity record (FAR). Only IPv4/IPv6 5-tuple flows are decoded.
+ *
+ *	\param rec Start of record (record header)
+ *	\param len Record length in bytes
+ *	\param flow Flow to fill (localIP/localPort hold the argus source)
+ *
+ *	\return True if the record contained a supported flow DSR
+ */
+bool GFilter_argus::decode_far(const uint8_t * rec, size_t len, cflow_t & flow) {
+	bool have_flow = false;
+	uint64_t src_pkts = 0, dst_pkts = 0, src_bytes = 0, dst_bytes = 0;
+	uint64_t startMs = 0, endMs = 0;
+
+	size_t pos = 4;
+	while (pos + 4 <= len) {
+		const uint8_t * dsr = rec + pos;
+		uint8_t type = dsr[0];
+		size_t dlen;
+		if (type & ARGUS_IMMEDIATE_DATA) {
+			dlen = 4;
+		} else if ((type & 0x7f) == ARGUS_DATA_DSR) {
+			dlen = net16(dsr + 2) * 4;
+		} else {
+			dlen = dsr[3] * 4;
+		}
+		if (dlen < 4 || dlen > len - pos)
+			return false;
+
+		switch (type & 0x7f) {
+			case ARGUS_FLOW_DSR:
+				if ((dsr[1] & 0x3f) != ARGUS_FLOW_CLASSIC5TUPLE)
+					break;
+				if ((dsr[2] & 0x1f) == ARGUS_TYPE_IPV4 && dlen >= 20) {
+					flow.localIP = IPv6_addr(net32(dsr + 4));
+					flow.remoteIP = IPv6_addr(net32(dsr + 8));
+					flow.prot = dsr[12];
+					flow.localPort = net16(dsr + 14);
+					flow.remotePort = net16(dsr + 16);
+					have_flow = true;
+				} else if ((dsr[2] & 0x1f) == ARGUS_TYPE_IPV6 && dlen >= 44) {
+					in6_addr a;
+					memcpy(&a, dsr + 4, sizeof(a));
+					flow.localIP = IPv6_addr(a);
+					memcpy(&a, dsr + 20, sizeof(a));
+					flow.remoteIP = IPv6_addr(a);
+					flow.prot = dsr[36];
+					flow.localPort = net16(dsr + 40);
+					flow.remotePort = net16(dsr + 42);
+					have_flow = true;
+				}
+				break;
+			case ARGUS_TIME_DSR: {
+				// Timestamps (seconds, microseconds) are present as flagged by the qualifier
+				size_t n = (dlen - 4) / 8;
+				uint8_t present = dsr[2] & (ARGUS_TIME_SRC_START | ARGUS_TIME_SRC_END | ARGUS_TIME_DST_START | ARGUS_TIME_DST_END);
+				if (present == 0)
+					present = ARGUS_TIME_SRC_START | ARGUS_TIME_SRC_END;
+				size_t t = 0;
+				for (uint8_t bit = ARGUS_TIME_SRC_START; bit <= ARGUS_TIME_DST_END && t < n; bit <<= 1) {
+					if ((present & bit) == 0)
+						continue;
+					const uint8_t * ts = dsr + 4 + 8 * t++;
+					uint64_t ms = (uint64_t) net32(ts) * 1000 + net32(ts + 4) / 1000;
+					if (ms == 0)
+						continue;
+					if (bit == ARGUS_TIME_SRC_START || bit == ARGUS_TIME_DST_START) {
+						if (startMs == 0 || ms < startMs)
+							startMs = ms;
+					}
+					if (ms > endMs)
+						endMs = ms;
+				}
+				break;
+			}
+			case ARGUS_METER_DSR: {
+				uint8_t subtype = dsr[1];
+				if (subtype != ARGUS_METER_PKTS_BYTES && subtype != ARGUS_METER_PKTS_BYTES_APP)
+					break;
+				uint8_t code = dsr[2] & 0x0f;
+				if (code < 1 || code > 12)
+					break;
+				static const size_t widths[4] = { 1, 2, 4, 8 };
+				size_t width = widths[(code - 1) % 4];
+				bool src = (code <= 8);
+				bool dst = (code <= 4 || code > 8);
+				size_t fields = (subtype == ARGUS_METER_PKTS_BYTES_APP) ? 3 : 2;
+				if (4 + ((src ? 1 : 0) + (dst ? 1 : 0)) * fields * width > dlen)
+					break;
+				const uint8_t * p = dsr + 4;
+				if (src) {
+					src_pkts = net_uint(p, width);
+					src_bytes = net_uint(p + width, width);
+					p += fields * width;
+				}
+				if (dst) {
+					dst_pkts = net_uint(p, width);
+					dst_bytes = net_uint(p + width, width);
+				}
+				break;
+			}
+			default:
+				break; // Skip all other DSRs
+		}
+		pos += dlen;
+	}
+	if (!have_flow)
+		return false;
+
+	if (flow.prot == IPPROTO_ICMP || flow.prot == IPPROTO_ICMPV6) {
+		// Ports hold ICMP type/code
+		flow.localPort = 0;
+		flow.remotePort = 0;
+	}
+	if (src_pkts > 0 && dst_pkts > 0) {
+		flow.flowtype = biflow;
+	} else if (dst_pkts > 0) {
+		flow.flowtype = inflow;
+	} else {
+		flow.flowtype = outflow;
+	}
+	flow.dir = flow.flowtype;
+	flow.dPkts = src_pkts + dst_pkts;
+	flow.dOctets = src_bytes + dst_bytes;
+	flow.startMs = startMs;
+	flow.durationMs = (endMs > startMs) ? (endMs - startMs) : 0;
+	return true;
+}
+
+/**
+ *	Read argus data by converting the file to text with the argus client tool ra.
+ *
+ *	\param in_filename Inputfilename
+ *	\param flowlist Reference to the flowlist (flows are appended)
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate selecting the flows to add (NULL: all)
+ *
+ * \exception string Errortext
+ */
+void GFilter_argus::read_file_ra(const std::string & in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate * predicate) const {
 	static const boost::regex re("\\s+"); // columns are separated by spaces
 
 	stringstream ss;
@@ -134,16 +419,12 @@ void GFilter_argus::read_file(std::string in_filename, CFlowList & flowlist, con
 	cout << "importing argus data using ra:\t" << ra_cmd << endl;
 	FILE * fp;
 	if ((fp = popen(ra_cmd.c_str(), "r")) == NULL) {
-		throw "failed to run ra";
+		throw string("failed to run ra");
 	}
 
-	flowlist.get_allocator().allocate(1000);
 	char buffer[8 * 1024];
 	char* l = NULL;
 	while ((l = fgets(buffer, sizeof buffer, fp)) != NULL) {
-		if (flowlist.size() > 0 && (flowlist.size() % 1000) == 0) {
-			cout << flowlist.size() << " argus records read so far" << endl;
-		}
 		string line(l);
 		cflow_t argus_flow;
 		boost::sregex_token_iterator i(line.begin(), line.end(), re, -1);
@@ -220,9 +501,11 @@ void GFilter_argus::read_file(std::string in_filename, CFlowList & flowlist, con
 			error_msg << e.what();
 			throw error_msg.str();
 		}
-		invert_flow_if_needed(argus_flow, local_net, netmask);
-		flowlist.push_back(argus_flow);
+		invert_flow_if_needed(argus_flow, local_nets);
+		if (predicate == NULL || predicate->accept(argus_flow))
+			flowlist.push_back(argus_flow);
 	}
+	pclose(fp);
 	cout << "end of argus import" << endl;
 }
 
@@ -230,12 +513,10 @@ void GFilter_argus::read_file(std::string in_filename, CFlowList & flowlist, con
  * Invert flow if required
  *
  * \param flow Flow to be inverted
- * \param local_net Local network address
- * \param netmask (Bit) mask for ip addresses
+ * \param local_nets Local networks
  */
-void GFilter_argus::invert_flow_if_needed(cflow_t& flow, const IPv6_addr& local_net, const IPv6_addr& netmask) {
-	IPv6_addr flow_net(flow.localIP & netmask);
-	if (flow_net != local_net) {
+void GFilter_argus::invert_flow_if_needed(cflow_t& flow, const CLocalNets& local_nets) {
+	if (!local_nets.is_local(flow.localIP)) {
 		// must be an inflow => invert flow direction
 		cflow_t flow_cpy = flow;
 		// ip addresses
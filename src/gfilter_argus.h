@@ -5,22 +5,34 @@
 #ifndef GFILTER_ARGUS_H_
 #define GFILTER_ARGUS_H_
 
+#include <stdint.h>
+
 #include "gfilter.h"
 
 /**
  *	\class	GFilter_argus
  *	\brief	GFilter_argus is an class which can import argus files
+ *
+ *	Argus 3 binary record files are decoded natively. Files the native decoder does not recognize
+ *	(e.g. compressed or Argus 2 files) are converted by the argus client tool ra.
  */
 class GFilter_argus: public GFilter {
 	public:
 		GFilter_argus(std::string formatName = "argus", std::string humanReadablePattern = "*.log", std::string regexPattern = ".*\\.log");
-		virtual void read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const;
+		using GFilter::read_file;
+		virtual void read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const;
 		virtual bool acceptFileForReading(std::string in_filename) const;
 
+		void read_file_native(const std::string & in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate * predicate = NULL) const;
+		void read_file_ra(const std::string & in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate * predicate = NULL) const;
+		static bool is_native_file(const std::string & in_filename);
+		static bool is_ra_available();
+
 	private:
+		static bool decode_far(const uint8_t * rec, size_t len, cflow_t & flow);
 		static uint8_t proto_string_to_proto_num(const std::string& p_str);
 		static uint8_t flow_dir_string_to_flow_dir(const std::string& fd_str);
-		static void invert_flow_if_needed(cflow_t& flow, const IPv6_addr& local_net, const IPv6_addr& netmask);
+		static void invert_flow_if_needed(cflow_t& flow, const CLocalNets& local_nets);
 
 		enum ARGUS_FIELDS {
 			START_TS = 0,
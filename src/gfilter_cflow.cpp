@@ -13,6 +13,7 @@
 #include "gfilter_cflow.h"
 #include "gutil.h"
 #include "cflow.h"
+#include "gexternalsort.h"
 
 using namespace std;
 
@@ -150,13 +151,60 @@ void GFilter_cflow::openGunzipStream(boost::iostreams::filtering_istream & in_fi
  *
  *	\param filename Filename of the compressed cflow_t file
  *	\param flowlist List which will be filled with the cflows
- *	\param local_net Contains the IP
- *	\param netmask Contains the netmask
+ *	\param local_nets Local networks (not used, cflow files store the flow directions)
+ *	\param predicate Import predicate selecting the flows to keep (collects the skip counters)
  *	\param append If true, do not clear the flowlist, instead append it to the existing data (not yet used)
  */
-void GFilter_cflow::read_file(std::string filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
+void GFilter_cflow::read_file(std::string filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const {
 	read_file(filename, flowlist, append);
-	return;
+	if (predicate.accepts_all())
+		return;
+
+	// Flows are read as one block: drop the rejected ones before the flow list is sorted and qualified
+	CFlowList::iterator out = flowlist.begin();
+	for (CFlowList::const_iterator it = flowlist.begin(); it != flowlist.end(); ++it) {
+		if (predicate.accept(*it))
+			*out++ = *it;
+	}
+	flowlist.erase(out, flowlist.end());
+}
+
+/**
+ *	cflow files store the flow directions, local networks are not used.
+ *
+ *	\return False
+ */
+bool GFilter_cflow::usesLocalNets() const {
+	return false;
+}
+
+/**
+ *	Streams a given file into an external sorter, one flow at a time. Unlike read_file() into a flow list
+ *	this does not rely on the gzip size field (which wraps at 4 GB uncompressed), so files of any size can be read.
+ *
+ *	\param filename Filename of the compressed cflow_t file
+ *	\param sorter Sorter receiving the flows
+ *	\param local_nets Local networks (not used, cflow files store the flow directions)
+ *	\param predicate Import predicate selecting the flows to keep (collects the skip counters)
+ *
+ *	\exception std::string Errortext
+ */
+void GFilter_cflow::read_file(std::string filename, CExternalSort & sorter, const CLocalNets & local_nets, CFlowPredicate & predicate) const {
+	if (!util::fileExists(filename)) {
+		string errormsg = "ERROR: check input file " + filename + " and try again.";
+		throw errormsg;
+	}
+	boost::iostreams::filtering_istream cflow_uncompressed_inputstream;
+	boost::iostreams::file_source infs(filename);
+	openGunzipStream(cflow_uncompressed_inputstream, infs, filename);
+
+	cflow_t flow;
+	while (cflow_uncompressed_inputstream.peek() != EOF) {
+		read_flow(cflow_uncompressed_inputstream, flow);
+		flow.flowtype &= (flow_type_t) simpleflow; // Clear early/late attributes
+		if (predicate.accept(flow))
+			sorter.add(flow);
+	}
 }
 
 /**
@@ -211,11 +259,11 @@ void GFilter_cflow::read_file(string in_filename, CFlowList & flowlist, bool app
 		} catch (string & error) {
 			throw error;
 		}
-		// advance to next index in flowlist
-		flowlist_iterator++;
-
 		// Clear early/late attributes
 		flowlist_iterator->flowtype &= (flow_type_t) simpleflow;
+
+		// advance to next index in flowlist
+		flowlist_iterator++;
 	}
 
 	// tellg() does not work on boost::iostreams::filtering_istream, so we have to work around
@@ -466,11 +514,11 @@ bool GFilter_cflow6::acceptFileForReading(string in_filename) const {
  *	\return True if the given number is a multiple of sizeof(cflow6)
  */
 bool GFilter_cflow6::checkCflowFileSize(uint32_t uncompressed_size) const {
-	if (uncompressed_size % sizeof(cflow_t) != 0) {
+	if (uncompressed_size % sizeof(cflow6) != 0) {
 		string errtext = "\nERROR: input file data size is not a multiple of a cflow4 record.\n";
 		errtext += "Possibly this is not a gzipped file containing cflow4 data.\n";
 		stringstream ss;
-		ss << "File size is: " << uncompressed_size << ", sizeof(struct cflow) is: " << sizeof(cflow_t) << "\n";
+		ss << "File size is: " << uncompressed_size << ", sizeof(struct cflow) is: " << sizeof(cflow6) << "\n";
 		errtext += ss.str();
 		cerr << errtext;
 		return false;
@@ -486,7 +534,7 @@ bool GFilter_cflow6::checkCflowFileSize(uint32_t uncompressed_size) const {
  *	\return Number of cflow4 version flows fit into this size
  */
 unsigned int GFilter_cflow6::getNumberOfFlows(uint32_t size) const {
-	return size / (sizeof(cflow_t));
+	return size / (sizeof(cflow6));
 }
 
 /**
@@ -511,23 +559,25 @@ void GFilter_cflow6::read_flow(boost::iostreams::filtering_istream & infs, cflow
  *	\exception std::string Errortext
  */
 void GFilter_cflow6::read_flow(boost::iostreams::filtering_istream & infs, cflow_t & cf) const {
-	infs.read((char *) &cf, sizeof(cflow_t));
+	cflow6 tmpCflow6;
+	infs.read((char *) &tmpCflow6, sizeof(cflow6));
 
 	streamsize num_read = infs.gcount();
-	if (num_read != sizeof(cflow_t)) {
+	if (num_read != sizeof(cflow6)) {
 		string errtext = "ERROR: read ";
 		errtext += num_read;
 		errtext += " byte instead of ";
-		errtext += sizeof(struct cflow4);
+		errtext += sizeof(cflow6);
 		errtext += ". Possibly incomplete flow read from file.";
 		throw errtext;
 	}
 
 	// Check flow data
-	if (cf.magic != CFLOW_CURRENT_MAGIC_NUMBER) {
+	if (tmpCflow6.magic != CFLOW_CURRENT_MAGIC_NUMBER) {
 		string errtext = "ERROR: file check failed (wrong magic number) in in CImport::read_flow6.";
 		throw errtext;
 	}
+	cf = cflow_t(tmpCflow6);
 }
 
 /**
@@ -562,5 +612,6 @@ void GFilter_cflow6::openGzipStream(boost::iostreams::filtering_ostream & out_fi
  *	\param cf Cflow which should get saved
  */
 void GFilter_cflow6::write_flow(boost::iostreams::filtering_ostream & out_filestream, const cflow_t & cf) const {
-	out_filestream.write((char *) &(cf), sizeof(cflow_t));
+	cflow6 tmpCflow6(cf);
+	out_filestream.write((char *) &tmpCflow6, sizeof(cflow6));
 }
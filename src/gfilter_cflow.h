@@ -24,7 +24,10 @@ public:
 
 	// import methods
 	void read_file(std::string filename, CFlowList & flowlist, bool append = false) const;
-	virtual void read_file(std::string filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const;
+	using GFilter::read_file;
+	virtual void read_file(std::string filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const;
+	virtual void read_file(std::string filename, CExternalSort & sorter, const CLocalNets & local_nets, CFlowPredicate & predicate) const;
+	virtual bool usesLocalNets() const;
 
 	// export methods
 	virtual void write_file(const std::string & out_filename, const Subflowlist flowlist, bool appendIfExisting = true) const;
@@ -4,8 +4,14 @@
  */
 
 #include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 #include "gfilter_ipfix.h"
+#include "gmappedfile.h"
 
 using namespace std;
 
@@ -24,245 +30,146 @@ GFilter_ipfix::GFilter_ipfix(std::string formatName, std::string humanReadablePa
 /**
  *	Read ipfix data from file into memory-based temporary flow list.
  *	Converts ipfix flows into cflow_t flows.
- *	Uses routines from libfixbuf and the file read/writer example to read ipfix files.
- *	The template used supports IPv4 uniflows only.
+ *	Supports IPv4 and IPv6 uniflows and biflows (RFC 5103).
  *
  *	The temporary flow list is not yet sorted and uniflows are not yet qualified.
  *
  *	\param in_filename Inputfilename
  *	\param flowlist Reference to the flowlist
- *	\param local_net Local network address
- *	\param netmask Network mask for local network address
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate selecting the flows to add (collects the skip counters)
  *	\param append Future flag to allow the import of more than one file (not yet used)
  *
  *	@exception std::string Errortext
  */
-void GFilter_ipfix::read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
-	bool debug5 = false; //FIXME: remove this kind of errorhandling
-
-	// Allocate temp_flowlist
-	int maxnum_flows = 1000000; // TODO We do not know in advance how many flows will be assembled
-	flowlist.resize(maxnum_flows);
-
-	// Hash map for biflow pairing
-	flowHashMap * flowHM = new flowHashMap();
-	flowHashMap::iterator iter;
-
-	// Prepare for reading of ipfix file
-	// *********************************
-	FILE * pFile = util::openFile(in_filename.c_str(), "r");
-
-	GError * err1 = NULL;
-	fBuf_t * fbuf = vx5ReaderForFP(pFile, &err1);
-
-	size_t s = 256;
-	uint8_t * recbase = new uint8_t[s];
-
-	// Read ipfix file
-	// ***************
-	// Read flow-by-flow, transform into cflow_t format and store in temporary flowlist
-	int j = 0;
-	int k = 0;
-	gboolean ok = true;
-	// cout<<"----"<<sizeof(vx5Flow_st)<<endl;
-	while (ok) {
-		GError * err2 = NULL;
-		ok = fBufNext(fbuf, recbase, &s, &err2);
-
-		if (!ok) {
-			if (err2->code == FB_ERROR_EOF) {
-				cout << "Read complete: EOF\n";
-			} else {
-				cerr << "INFO: failed reading, reason: ";
-				cerr << err2->message << endl;
-				throw string(err2->message);
-			}
-		} else {
-			vx5Flow_t * irec = (vx5Flow_t *) recbase; // cast to ipfix record
-
-			// check if record contains IPv6 data
-			//cout << "version:" << util::bin2hexstring(&(irec->ipVersion), 1) << endl;
-			bool isIPv6 = (irec->sourceIPv4Address == 0/*irec->ipVersion == IP_VERS_NR_IPv6*/); // TODO: check & fix
-
-			// Get protocol
-			uint8_t prot = irec->protocolIdentifier;
-			// uint8_t prot = irec->nextHeaderIPv6;
-
-			// Get ports and IP addresses
-			uint16_t srcPort = irec->sourceTransportPort;
-			uint16_t dstPort = irec->destinationTransportPort;
-			IPv6_addr srcIP;
-			IPv6_addr dstIP;
-			if (isIPv6) {
-				srcIP = util::ipV6IpfixToIpV6(irec->sourceIPv6Address);
-				dstIP = util::ipV6IpfixToIpV6(irec->destinationIPv6Address);
-			} else {
-				srcIP = IPv6_addr(irec->sourceIPv4Address);
-				dstIP = IPv6_addr(irec->destinationIPv4Address);
-			}
-
-			if (debug5) {
-				if (srcIP == IPv6_addr() || dstIP == IPv6_addr()) {
-					print_ipfix_record(recbase);
-				}
-			}
-
-			// Assign src/dst fields to appropriate local/remote fields
-			// Assign src/dst fields to appropriate local/remote fields
-			IPv6_addr localIP, remoteIP;
-			uint32_t localPort, remotePort;
-
-			// Infer flow direction from known network/netmask values
-			flow_type_t flowtype = inflow;
-			if ((srcIP & netmask) == local_net) {
-				flowtype = outflow;
-			}
-
-			// Biflow matching: revert src/dst such that biflows are formed
-			if (flowtype == outflow) {
-				localIP = srcIP;
-				remoteIP = dstIP;
-				localPort = srcPort;
-				remotePort = dstPort;
-			} else {
-				localIP = dstIP;
-				remoteIP = srcIP;
-				localPort = dstPort;
-				remotePort = srcPort;
-			}
-
-			uint64_t startMs = irec->flowStartMilliseconds;
-			uint64_t endMs = irec->flowEndMilliseconds;
-
-			uint64_t revdOctets = irec->reverseOctetTotalCount;
-			uint32_t revdPkts = irec->reversePacketTotalCount;
-
-			bool bidir = false;
-			if (revdOctets > 0)
-				bidir = true;
-
-			uint64_t dOctets = irec->octetTotalCount + revdOctets;
-			uint32_t dPkts = irec->packetTotalCount + revdPkts;
-
-			// Check if flow is a new flow or updates/matches an existing flow
-			flowHashKey mykey(localIP, remoteIP, localPort, remotePort, prot);
-			iter = flowHM->find(mykey);
-
-			if (iter != flowHM->end()) {
-				// Found: update found cflow_t with new nfdump's flow data
-				// Fetch reference to flow entry hash map
-				cflow_t * f = iter->second;
-				// Found: update flow by contents of current packet
-				f->dOctets += dOctets;
-
-				if (startMs > f->startMs) {
-					// New flow starts later: modify duration
-					f->durationMs = endMs - f->startMs;
-				} else {
-					// New flow starts earlier
-					f->durationMs = (f->startMs + f->durationMs) - startMs;
-					// Set flow start to earlier flow start
-					flowlist[j].startMs = startMs;
-				}
-
-				f->dPkts += dPkts;
-				if ((f->flowtype != flowtype) && (f->flowtype != biflow)) {
-					// New packet has opposite direction to earlier packets
-					// Make it a biflow
-					f->flowtype = biflow;
-				}
-
-			} else { // Not found
-				// Make an initial entry into temp_flowlist
-				flowlist[j].localIP = localIP;
-				flowlist[j].remoteIP = remoteIP;
-				flowlist[j].localPort = localPort;
-				flowlist[j].remotePort = remotePort;
-				if (bidir) {
-					flowlist[j].flowtype = biflow;
-				} else {
-					flowlist[j].flowtype = flowtype;
-				}
-				flowlist[j].prot = prot;
-				flowlist[j].dOctets = dOctets;
-				flowlist[j].startMs = startMs;
-				flowlist[j].durationMs = endMs - startMs;
-				flowlist[j].dPkts = dPkts;
-				flowlist[j].localAS = 0;
-				flowlist[j].remoteAS = 0;
-				flowlist[j].tos_flags = 0;
-				flowlist[j].magic = 1;
-
-				// Store 5-tuple together with reference to flow record in flow list
-				(*flowHM)[mykey] = &flowlist[j];
-				j++;
-				if (j >= maxnum_flows) {
-					string errtext = "INFO: terminating file reading due to full flow list.\n";
-					errtext += maxnum_flows;
-					errtext += " is the configured import limit.\n";
-					cerr << errtext;
-					throw errtext;
-				}
-			}
-			k++;
+void GFilter_ipfix::read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const {
+	CMappedFile file(in_filename);
+
+	// 1. Collect data sets and templates (sequential, templates may be redefined within the file)
+	// *******************************************************************************************
+	CExportDecoder decoder;
+	std::vector<CExportDecoder::data_set_t> data_sets;
+	scan_messages(file, decoder, data_sets);
+	ipfix_stats_t stats;
+	stats.messages = decoder.get_stats().messages;
+	stats.skipped_sets = decoder.get_stats().skipped_sets;
+
+	// 2. Decode data sets in parallel, split into ranges of about equal size
+	// *********************************************************************
+	size_t total = 0;
+	for (std::vector<CExportDecoder::data_set_t>::const_iterator it = data_sets.begin(); it != data_sets.end(); ++it)
+		total += it->length;
+	size_t threads = CFlowAssembler::get_default_threads();
+	if (threads > data_sets.size())
+		threads = data_sets.size();
+
+	std::vector<decode_job_t> jobs(threads);
+	std::vector<CExportDecoder::data_set_t>::const_iterator pos = data_sets.begin();
+	size_t done = 0;
+	for (size_t i = 0; i < threads; i++) {
+		jobs[i].local_nets = &local_nets;
+		jobs[i].predicate = &predicate;
+		jobs[i].begin = pos;
+		size_t limit = (i + 1 == threads) ? total : total * (i + 1) / threads;
+		while (pos != data_sets.end() && (done < limit || pos == jobs[i].begin)) {
+			done += pos->length;
+			++pos;
 		}
+		jobs[i].end = pos;
 	}
-	util::closeFile(pFile);
 
-	flowlist.resize(j);
+	if (threads == 1) {
+		decode_data_sets(&jobs[0]);
+	} else {
+		boost::thread_group workers;
+		for (size_t i = 0; i < threads; i++)
+			workers.create_thread(boost::bind(&GFilter_ipfix::decode_data_sets, &jobs[i]));
+		workers.join_all();
+	}
 
-	cout << "*** Processed " << k << " ipfix flows to " << flowlist.size() << " final flows.\n";
+	// 3. Collect flows: biflow records are final, uniflows are paired by the flow assembler
+	// ************************************************************************************
+	flowlist.clear();
+	CFlowAssembler assembler(flowlist, local_nets, CFlowAssembler::get_default_threads());
+	assembler.set_predicate(&predicate);
+	for (std::vector<decode_job_t>::iterator job = jobs.begin(); job != jobs.end(); ++job) {
+		flowlist.insert(flowlist.end(), job->flows.begin(), job->flows.end());
+		CFlowList().swap(job->flows);
+		for (std::vector<CFlowAssembler::record_t>::const_iterator it = job->uniflows.begin(); it != job->uniflows.end(); ++it)
+			assembler.add_record(*it);
+		std::vector<CFlowAssembler::record_t>().swap(job->uniflows);
+		stats.records += job->stats.records;
+		stats.biflow_records += job->stats.biflow_records;
+		stats.malformed_records += job->stats.malformed_records;
+		predicate.add_stats(job->predicate_stats);
+	}
+	assembler.flush();
+
+	if (stats.skipped_sets > 0)
+		cerr << "WARNING: skipped " << stats.skipped_sets << " data sets without flow template.\n";
+	if (stats.malformed_records > 0)
+		cerr << "WARNING: skipped " << stats.malformed_records << " malformed records.\n";
+	cout << "*** Processed " << stats.records << " ipfix flows (" << stats.biflow_records << " biflow records) in " << stats.messages << " messages to "
+	      << flowlist.size() << " final flows.\n";
 }
 
 /**
- *	Print a single ipfix record to console in human readable form.
+ *	Walk all messages of a file, decode template sets and collect data sets together with the
+ *	template valid at their position (see CExportDecoder::collect_data_sets()).
  *
- *	\param	recbase	Address of a single ipfix flow
+ *	\param file Mapped ipfix file
+ *	\param decoder Template cache (keeps all template versions referenced by data_sets)
+ *	\param data_sets Data sets found
  */
-void GFilter_ipfix::print_ipfix_record(uint8_t * recbase) const {
-	vx5Flow_t * irec = (vx5Flow_t *) recbase; // cast to ipfix record
-
-	// 1. Copy ipfix record fields to cflow_t record fields
-	// **************************************************
-	// So far, we assign srcIP to localIP. IPFIX uses the initiator of a connection
-	// as the srcIP. We use the terminology local/remote under the assumption
-	// that one of the two endpoints is located within our local network/AS, i.e.
-	// the capture point is the border btw. local/remote.
-	// Furthermore, we assume an ipfix template containing the reverse counters.
-	bool isIPv6 = (irec->sourceIPv4Address == 0/*irec->ipVersion==IP_VERS_NR_IPv6*/); // TODO: check&fix
-	cflow_t flow;
-	if (isIPv6) {
-		flow.localIP = util::ipV6IpfixToIpV6(irec->sourceIPv6Address);
-		flow.remoteIP = util::ipV6IpfixToIpV6(irec->destinationIPv6Address);
-	} else {
-		flow.localIP = IPv6_addr(irec->sourceIPv4Address);
-		flow.remoteIP = IPv6_addr(irec->destinationIPv4Address);
-	}
-	flow.startMs = irec->flowStartMilliseconds;
-	flow.durationMs = irec->flowEndMilliseconds - irec->flowStartMilliseconds;
-	flow.localPort = irec->sourceTransportPort;
-	flow.remotePort = irec->destinationTransportPort;
-	flow.dOctets = irec->octetTotalCount + irec->reverseOctetTotalCount;
-	flow.dPkts = irec->packetTotalCount + irec->reversePacketTotalCount;
-	flow.localAS = 0;
-	flow.remoteAS = 0;
-	flow.prot = irec->protocolIdentifier;
-	if (irec->reverseOctetTotalCount > 0) {
-		flow.dir = biflow;
-	} else {
-		flow.dir = outflow;
+void GFilter_ipfix::scan_messages(const CMappedFile & file, CExportDecoder & decoder, std::vector<CExportDecoder::data_set_t> & data_sets) {
+	size_t pos = 0;
+	while (pos < file.size()) {
+		const uint8_t * msg = file.data() + pos;
+		uint64_t malformed = decoder.get_stats().malformed_messages;
+		size_t length = 0;
+		if (CExportDecoder::get_version(msg, file.size() - pos) == CExportDecoder::ipfix_version)
+			length = decoder.collect_data_sets(msg, file.size() - pos, 0, data_sets);
+		if (length == 0) {
+			cerr << "WARNING: " << file.get_filename() << " is truncated or corrupt at offset " << pos << ".\n";
+			break;
+		}
+		if (decoder.get_stats().malformed_messages != malformed)
+			cerr << "WARNING: corrupt set in message at offset " << pos << ".\n";
+		pos += length;
 	}
-	flow.tos_flags = irec->tcpControlBits;
+}
 
-	// 2. Print cflow_t record obtained from ipfix record
-	// ************************************************
-	char text[1024];
-	util::record2StringShort(flow, text);
-	cout << text << endl;
+/**
+ *	Decode a range of data sets (thread body).
+ *
+ *	\param job Data sets to decode, receives the results
+ */
+void GFilter_ipfix::decode_data_sets(decode_job_t * job) {
+	std::vector<CExportDecoder::decoded_t> records;
+	CExportDecoder::stats_t stats;
+	for (std::vector<CExportDecoder::data_set_t>::const_iterator ds = job->begin; ds != job->end; ++ds) {
+		records.clear();
+		CExportDecoder::decode_data_set(*ds, records, stats);
+		for (std::vector<CExportDecoder::decoded_t>::const_iterator it = records.begin(); it != records.end(); ++it) {
+			if (it->paired) {
+				// RFC 5103 biflow: exporter has already paired both directions
+				cflow_t flow;
+				CFlowAssembler::make_flow(it->rec, *job->local_nets, flow);
+				if (job->predicate->accept(flow, job->predicate_stats))
+					job->flows.push_back(flow);
+				job->stats.biflow_records++;
+			} else {
+				job->uniflows.push_back(it->rec);
+			}
+		}
+	}
+	job->stats.records = stats.records;
+	job->stats.malformed_records = stats.malformed_records;
 }
 
 /**
- *	Decide if this filter supports this file, using the filename to decide
+ *	Decide if this filter supports this file: file name has to match and the file has to start
+ *	with an IPFIX message header.
  *
  *	\param in_filename Inputfilename
  *
@@ -270,5 +177,12 @@ void GFilter_ipfix::print_ipfix_record(uint8_t * recbase) const {
  *
  */
 bool GFilter_ipfix::acceptFileForReading(std::string in_filename) const {
-	return acceptFilename(in_filename);
+	if (!acceptFilename(in_filename))
+		return false;
+	try {
+		CMappedFile file(in_filename);
+		return file.size() >= CExportDecoder::ipfix_header_length && CExportDecoder::get_version(file.data(), file.size()) == CExportDecoder::ipfix_version;
+	} catch (string &) {
+		return false;
+	}
 }
@@ -7,21 +7,65 @@
  */
 
 #include <string>
+#include <vector>
+#include <stdint.h>
 
-#include "fixbuf/public.h"	// fixbuf routines to read ipfix files
-#include "gfilter_ipfix_vx5ipfix_bi.h"	// Auxiliary functions to create an IPFIX file reader
 #include "gfilter.h"
+#include "IPv6_addr.h"
+#include "cflow.h"
+#include "gflowassembler.h"
+#include "gexportdecoder.h"
+
+class CMappedFile;
 
 /**
  *	\class	GFilter_ipfix
  *	\brief	GFilter_ipfix is an class which can import ipfix files
+ *
+ *	The file is memory mapped and parsed in place (RFC 7011), templates are handled by CExportDecoder.
+ *	Records of templates carrying reverse elements (RFC 5103) are complete biflows and are used as they
+ *	are, all other records are paired by CFlowAssembler. Data sets are decoded in parallel.
  */
 class GFilter_ipfix: public GFilter {
-public:
-	GFilter_ipfix(std::string name = "ipfix", std::string simplePattern = "*.dat", std::string regexPattern = ".*\\.dat");
-	virtual void read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const;
-	virtual bool acceptFileForReading(std::string in_filename) const;
-	void print_ipfix_record(uint8_t * recbase) const;
+	public:
+		GFilter_ipfix(std::string name = "ipfix", std::string simplePattern = "*.dat", std::string regexPattern = ".*\\.dat");
+		using GFilter::read_file;
+		virtual void read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const;
+		virtual bool acceptFileForReading(std::string in_filename) const;
+
+	private:
+		/**
+		 *	\struct	ipfix_stats_t
+		 *	\brief	Counters of a single import
+		 */
+		struct ipfix_stats_t {
+				uint64_t messages; ///< IPFIX messages found in file
+				uint64_t records; ///< Flow records decoded
+				uint64_t biflow_records; ///< Records of templates carrying reverse counters
+				uint64_t skipped_sets; ///< Data sets without (flow) template
+				uint64_t malformed_records; ///< Records not matching their template
+				ipfix_stats_t() :
+					messages(0), records(0), biflow_records(0), skipped_sets(0), malformed_records(0) {
+				}
+		};
+
+		/**
+		 *	\struct	decode_job_t
+		 *	\brief	Range of data sets decoded by one thread and its results
+		 */
+		struct decode_job_t {
+				std::vector<CExportDecoder::data_set_t>::const_iterator begin; ///< First data set
+				std::vector<CExportDecoder::data_set_t>::const_iterator end; ///< Behind last data set
+				const CLocalNets * local_nets; ///< Local networks used to infer flow directions
+				const CFlowPredicate * predicate; ///< Import predicate biflow records have to fulfill
+				CFlowPredicate::stats_t predicate_stats; ///< Predicate counters of this job
+				CFlowList flows; ///< Flows of templates carrying reverse counters (final)
+				std::vector<CFlowAssembler::record_t> uniflows; ///< Records still to be paired
+				ipfix_stats_t stats; ///< Record counters
+		};
+
+		static void scan_messages(const CMappedFile & file, CExportDecoder & decoder, std::vector<CExportDecoder::data_set_t> & data_sets);
+		static void decode_data_sets(decode_job_t * job);
 };
 
 #endif /* GFILTER_IPFIX_H_ */
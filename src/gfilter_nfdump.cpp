@@ -13,6 +13,7 @@
 #include "gfilter_nfdump_gnfdump.h"	// nfdump file format support (extracted from nfdump tool set)
 #include "cflow.h"
 #include "IPv6_addr.h"
+#include "gflowassembler.h"
 
 using namespace std;
 
@@ -36,25 +37,22 @@ GFilter_nfdump::GFilter_nfdump(std::string formatName, std::string humanReadable
  *
  *	\param in_filename Inputfilename
  *	\param flowlist Reference to the flowlist
- *	\param local_net Local network address
- *	\param netmask Network mask for local network address
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate selecting the flows to add (collects the skip counters)
  *	\param append Future flag to allow the import of more than one file (not yet used)
  *
  * \exception char* Errortext
  * \exception string Errortext
  */
-void GFilter_nfdump::read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
+void GFilter_nfdump::read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const {
 	cout << "Input file " << in_filename << " contains " << util::getFileSize(in_filename) << " bytes.\n";
 
 	bool debug4 = false;
 
-	// Allocate temp_flowlist
-	int maxnum_flows = 1000000; // TODO We do not know in advance how many flows will be assembled
-	flowlist.resize(maxnum_flows);
-
-	// Hash map for biflow pairing
-	flowHashMap * flowHM = new flowHashMap();
-	flowHashMap::iterator iter;
+	// Flow merging and biflow pairing
+	flowlist.clear();
+	CFlowAssembler assembler(flowlist, local_nets, CFlowAssembler::get_default_threads());
+	assembler.set_predicate(&predicate);
 
 	// Prepare for reading of nfdump file
 	// **********************************
@@ -101,7 +99,6 @@ void GFilter_nfdump::read_file(std::string in_filename, CFlowList & flowlist, co
 	// ****************
 	// Read flow-by-flow, transform into cflow_t format and store in temporary flowlist
 	int done = 0;
-	int j = 0;
 	while (!done) {
 		int ret;
 
@@ -139,121 +136,31 @@ void GFilter_nfdump::read_file(std::string in_filename, CFlowList & flowlist, co
 				 */
 				ExpandRecord_v2(flow_record, extension_map_list.slot[map_id], master_record);
 
-				// Get protocol
-				uint8_t prot = master_record->prot;
-
-				// Get ports and IP addresses
-				uint16_t srcPort = master_record->srcport;
-				uint16_t dstPort = master_record->dstport;
-				IPv6_addr srcIP;
-				IPv6_addr dstIP;
+				CFlowAssembler::record_t rec;
+				rec.prot = master_record->prot;
+				rec.srcPort = master_record->srcport;
+				rec.dstPort = master_record->dstport;
 				if ((master_record->flags & FLAG_IPV6_ADDR) != 0) {
-					srcIP = util::ipV6NfDumpToIpV6(master_record->v6.srcaddr);
-					dstIP = util::ipV6NfDumpToIpV6(master_record->v6.dstaddr);
-
+					rec.srcIP = util::ipV6NfDumpToIpV6(master_record->v6.srcaddr);
+					rec.dstIP = util::ipV6NfDumpToIpV6(master_record->v6.dstaddr);
 				} else {
-					srcIP = IPv6_addr(master_record->v4.srcaddr);
-					dstIP = IPv6_addr(master_record->v4.dstaddr);
-				}
-
-				// Assign src/dst fields to appropriate local/remote fields
-				// Assign src/dst fields to appropriate local/remote fields
-				IPv6_addr localIP, remoteIP;
-				uint16_t localPort, remotePort;
-
-				// Infer flow direction from known network/netmask values
-				flow_type_t flowtype = inflow;
-				if ((srcIP & netmask) == local_net) {
-					flowtype = outflow;
+					rec.srcIP = IPv6_addr(master_record->v4.srcaddr);
+					rec.dstIP = IPv6_addr(master_record->v4.dstaddr);
 				}
-
-				// Biflow matching: revert src/dst such that biflows are formed
-				if (flowtype == outflow) {
-					localIP = srcIP;
-					remoteIP = dstIP;
-					localPort = srcPort;
-					remotePort = dstPort;
-				} else {
-					localIP = dstIP;
-					remoteIP = srcIP;
-					localPort = dstPort;
-					remotePort = srcPort;
-				}
-
-				uint64_t startMs = (uint64_t) master_record->first * 1000 + master_record->msec_first;
-				uint64_t endMs = (uint64_t) master_record->last * 1000 + master_record->msec_last;
-
-				uint64_t dOctets = master_record->dOctets;
-				uint32_t dPkts = master_record->dPkts;
-				uint8_t tos_flags = master_record->tos;
+				rec.startMs = (uint64_t) master_record->first * 1000 + master_record->msec_first;
+				rec.endMs = (uint64_t) master_record->last * 1000 + master_record->msec_last;
+				rec.dOctets = master_record->dOctets;
+				rec.dPkts = master_record->dPkts;
+				rec.tos_flags = master_record->tos;
 
 				if (debug4) {
-					// Print cflow_t record
-					char s[512];
-					//					util::record2StringShort(&flow, s);
-					//					printf("%s\n", s);
-
 					// print nfdump record
+					char s[512];
 					print_record(master_record, s);
 					printf("%s\n", s);
 				}
 
-				// Check if flow is a new flow or updates/matches an existing flow
-				flowHashKey mykey(localIP, remoteIP, localPort, remotePort, prot);
-				iter = flowHM->find(mykey);
-
-				if (iter != flowHM->end()) {
-					// Found: update found cflow_t with new nfdump's flow data
-					// Fetch reference to flow entry hash map
-					cflow_t * f = iter->second;
-					// Found: update flow by contents of current packet
-					f->dOctets += dOctets;
-
-					if (startMs > f->startMs) {
-						// New flow starts later: modify duration
-						f->durationMs = endMs - f->startMs;
-					} else {
-						// New flow starts earlier
-						f->durationMs = (f->startMs + f->durationMs) - startMs;
-						// Set flow start to earlierflow start
-						flowlist[j].startMs = startMs;
-					}
-
-					f->dPkts += dPkts;
-					if ((f->flowtype != flowtype) && (f->flowtype != biflow)) {
-						// New packet has opposite direction to earlier packets
-						// Make it a biflow
-						f->flowtype = biflow;
-					}
-
-				} else { // Not found
-					// Make an initial entry into flowlist
-					flowlist[j].localIP = localIP;
-					flowlist[j].remoteIP = remoteIP;
-					flowlist[j].localPort = localPort;
-					flowlist[j].remotePort = remotePort;
-					flowlist[j].flowtype = flowtype;
-					flowlist[j].prot = prot;
-					flowlist[j].dOctets = dOctets;
-					flowlist[j].startMs = startMs;
-					flowlist[j].durationMs = endMs - startMs;
-					flowlist[j].dPkts = dPkts;
-					flowlist[j].localAS = 0;
-					flowlist[j].remoteAS = 0;
-					flowlist[j].tos_flags = tos_flags;
-					flowlist[j].magic = 1;
-
-					// Store 5-tuple together with reference to flow record in flow list
-					(*flowHM)[mykey] = &flowlist[j];
-					j++;
-					if (j >= maxnum_flows) {
-						string errtext = "INFO: terminating file reading due to full flow list.\n";
-						errtext += maxnum_flows;
-						errtext += " is the configured import limit.\n";
-						cerr << errtext;
-						throw errtext;
-					}
-				}
+				assembler.add_record(rec);
 
 				// Update statistics
 				UpdateStat(&stat_record, master_record);
@@ -289,8 +196,8 @@ void GFilter_nfdump::read_file(std::string in_filename, CFlowList & flowlist, co
 
 	free((void *) in_buff);
 
-	flowlist.resize(j);
-	if(j == 0)
+	assembler.flush();
+	if(flowlist.empty())
 		throw "This looks like a compressed nfdump file which we can not handle";
 
 	cout << "*** Processed " << total_flows << " nfdump flows to " << flowlist.size() << " final flows.\n";
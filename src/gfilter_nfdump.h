@@ -17,7 +17,8 @@
 class GFilter_nfdump: public GFilter {
 	public:
 		GFilter_nfdump(std::string name = "nfdump", std::string simplePattern = "nfcapd*", std::string regexPattern = "^nfcapd.*");
-		virtual void read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const;
+		using GFilter::read_file;
+		virtual void read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const;
 		virtual bool acceptFileForReading(std::string in_filename) const;
 };
 
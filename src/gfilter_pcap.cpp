@@ -1,30 +1,108 @@
 /**
  *	\file gfilter_pcap.cpp
- *	\brief Filter to import pcap files
+ *	\brief Filter to import pcap and pcapng files
  */
 
-#include <pcap++.h>	// C++ wrapper for libpcap
 #include <string>
-#ifdef __linux__
-#include <linux/if_ether.h>	// Ethernet header, ethernet protocol types
-#else
-#include <netinet/if_ether.h>	// Ethernet header, ethernet protocol types
-#endif // __linux__
-#include <netinet/in_systm.h>
-#include <sys/socket.h>
-#include <net/if.h>
-#include <netinet/in.h>
-#include <netinet/ip.h>			// IPv4 header
-#include <netinet/ip6.h>		// IPv6 header
-#include <netinet/tcp.h>		// TCP header
-#include <netinet/udp.h>		// UDP header
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
 #include <netinet/in.h>			// IP protocol types
+
 #include "gfilter_pcap.h"
+#include "gmappedfile.h"
 #include "cflow.h"
 
-using namespace pcappp;
 using namespace std;
 
+// Magic numbers and block types as defined by the pcap and pcapng file formats
+static const uint32_t PCAP_MAGIC_USEC = 0xa1b2c3d4;
+static const uint32_t PCAP_MAGIC_NSEC = 0xa1b23c4d;
+static const uint32_t PCAPNG_SECTION_HEADER = 0x0a0d0d0a;
+static const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+static const uint32_t PCAPNG_INTERFACE_DESCRIPTION = 0x00000001;
+static const uint32_t PCAPNG_PACKET = 0x00000002; // obsolete, still written by some tools
+static const uint32_t PCAPNG_SIMPLE_PACKET = 0x00000003;
+static const uint32_t PCAPNG_ENHANCED_PACKET = 0x00000006;
+static const uint16_t PCAPNG_OPT_ENDOFOPT = 0;
+static const uint16_t PCAPNG_OPT_IF_TSRESOL = 9;
+
+// Link types (see http://www.tcpdump.org/linktypes.html)
+static const uint32_t LINKTYPE_ETHERNET = 1;
+static const uint32_t LINKTYPE_RAW = 101;
+static const uint32_t LINKTYPE_RAW_BSD = 12;
+static const uint32_t LINKTYPE_LINUX_SLL = 113;
+static const uint32_t LINKTYPE_IPV4 = 228;
+static const uint32_t LINKTYPE_IPV6 = 229;
+static const uint32_t LINKTYPE_LINUX_SLL2 = 276;
+
+// Ethernet types
+static const uint16_t ETH_TYPE_IPV4 = 0x0800;
+static const uint16_t ETH_TYPE_ARP = 0x0806;
+static const uint16_t ETH_TYPE_IPV6 = 0x86dd;
+static const uint16_t ETH_TYPE_8021Q = 0x8100;
+static const uint16_t ETH_TYPE_8021AD = 0x88a8;
+static const uint16_t ETH_TYPE_QINQ = 0x9100;
+
+static const size_t record_batch_size = 1024; ///< Decoded packets handed over to the flow assembler at once
+
+/**
+ *	Reverse byte order of a 16 bit value.
+ */
+static inline uint16_t swap16(uint16_t v) {
+	return (uint16_t) ((v >> 8) | (v << 8));
+}
+
+/**
+ *	Reverse byte order of a 32 bit value.
+ */
+static inline uint32_t swap32(uint32_t v) {
+	return (v >> 24) | ((v >> 8) & 0x0000ff00) | ((v << 8) & 0x00ff0000) | (v << 24);
+}
+
+/**
+ *	Read 16 bit value in file byte order.
+ */
+static inline uint16_t get16(const uint8_t * p, bool swapped) {
+	uint16_t v;
+	memcpy(&v, p, sizeof(v));
+	return swapped ? swap16(v) : v;
+}
+
+/**
+ *	Read 32 bit value in file byte order.
+ */
+static inline uint32_t get32(const uint8_t * p, bool swapped) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return swapped ? swap32(v) : v;
+}
+
+/**
+ *	Read 16 bit value in network byte order.
+ */
+static inline uint16_t net16(const uint8_t * p) {
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+/**
+ *	Read 32 bit value in network byte order.
+ */
+static inline uint32_t net32(const uint8_t * p) {
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+/**
+ *	Hand a batch of decoded packets over to the flow assembler.
+ */
+static inline void flush_batch(vector<CFlowAssembler::record_t> & batch, CFlowAssembler & assembler) {
+	for (vector<CFlowAssembler::record_t>::const_iterator it = batch.begin(); it != batch.end(); ++it)
+		assembler.add_record(*it);
+	batch.clear();
+}
+
 /**
  *	Constructor
  *
@@ -38,395 +116,443 @@ GFilter_pcap::GFilter_pcap(std::string formatName, std::string humanReadablePatt
 }
 
 /**
- *	Read pcap data from file into memory-based temporary flow list.
+ *	Read pcap or pcapng data from file into memory-based temporary flow list.
  *	Assembles packets to flows.
  *	The temporary flow list is not yet sorted and uniflows are not yet qualified.
  *
  *	\param in_filename Filename to read
  *	\param flowlist List to fill with the flows
- *	\param local_net Local network address
- *	\param netmask Network mask for local network address
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate selecting the flows to add (collects the skip counters)
  *	\param append Future flag to allow the import of more than one file (not yet used)
  *
  *	@exception std::string Errortext
  */
-void GFilter_pcap::read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
-	// Allocate temp_flowlist
-	int maxnum_flows = 1000000; // We do not know in advance how many flows will be assembled FIXME: we could guess it from the filesize ?!
+void GFilter_pcap::read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const {
 	flowlist.clear();
-	flowlist.resize(maxnum_flows);
-
-	// Hash map for packet-to-flow assembling and biflow pairing
-	flowHashMap * flowHM = new flowHashMap();
-	flowHashMap::iterator iter;
-
-	int i = 0;
-	long pcount = 0; // Packet counter
-	long arp_packet_count = 0;
-	long other_packet_count = 0;
-
-	// (1) Open file for packet reading
-	// ********************************
-	try {
-		PcapOffline pco(in_filename.c_str());
 
-		DataLink dl = pco.get_datalink();
-
-		if (true) {
-			// Get some general infos from file
-			string filename = pco.get_filename();
-			cout << "File name is: " << filename << endl;
+	CMappedFile file(in_filename);
+	if (file.size() < 4) {
+		throw "ERROR: " + in_filename + " is not a pcap file (too short).";
+	}
 
-			int major = pco.get_major_version();
-			int minor = pco.get_minor_version();
-			cout << "Pcap file format used is version: " << major << "." << minor << endl;
+	// Packet-to-flow assembling and biflow pairing
+	CFlowAssembler assembler(flowlist, local_nets, CFlowAssembler::get_default_threads());
+	assembler.set_predicate(&predicate);
+	pcap_stats_t stats;
+
+	uint32_t magic = get32(file.data(), false);
+	if (magic == PCAPNG_SECTION_HEADER) {
+		read_pcapng(file, assembler, stats);
+	} else if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC || magic == swap32(PCAP_MAGIC_USEC) || magic == swap32(PCAP_MAGIC_NSEC)) {
+		read_pcap(file, assembler, stats);
+	} else {
+		throw "ERROR: " + in_filename + " is neither a pcap nor a pcapng file.";
+	}
+	assembler.flush();
 
-			cout << "Using local_net=" << local_net << " and netmask=0x" << hex << netmask << dec << endl;
+	cout << "*** Processed " << stats.packets << " packets (" << stats.ip_packets << " IP) to " << flowlist.size() << " flows.\n";
+	cout << "(ignored packets: " << stats.arp_packets << " (ARP), " << stats.other_packets << " (OTHER), " << stats.malformed_packets
+	      << " (MALFORMED)).\n";
+}
 
-			if (pco.is_swapped()) {
-				cout << "Capture data byte order differs from byte order used on this system.\n";
-			} else {
-				cout << "Capture data byte order complies with byte order used on this system.\n";
-			}
+/**
+ *	Read packets of a classic pcap file (microsecond or nanosecond timestamps, either byte order).
+ *
+ *	\param file Mapped pcap file
+ *	\param assembler Flow assembler receiving the packets
+ *	\param stats Packet counters to update
+ *
+ *	@exception std::string Errortext
+ */
+void GFilter_pcap::read_pcap(const CMappedFile & file, CFlowAssembler & assembler, pcap_stats_t & stats) const {
+	const uint8_t * data = file.data();
+	size_t size = file.size();
+	const size_t file_header_len = 24;
+	const size_t record_header_len = 16;
+
+	if (size < file_header_len) {
+		throw "ERROR: " + file.get_filename() + " has a truncated pcap file header.";
+	}
+	uint32_t magic = get32(data, false);
+	bool swapped = (magic == swap32(PCAP_MAGIC_USEC) || magic == swap32(PCAP_MAGIC_NSEC));
+	bool nsec = (magic == PCAP_MAGIC_NSEC || magic == swap32(PCAP_MAGIC_NSEC));
+	uint32_t linktype = get32(data + 20, swapped) & 0x0fffffff; // upper bits may carry FCS information
+
+	cout << "Pcap file format used is version: " << get16(data + 4, swapped) << "." << get16(data + 6, swapped) << ", link type " << linktype
+	      << endl;
+	if (!is_supported_linktype(linktype)) {
+		stringstream errtext;
+		errtext << "ERROR: data link type " << linktype << " is not supported.";
+		cerr << errtext.str() << endl;
+		throw errtext.str();
+	}
 
-			cout << "Data link code: " << dl.get_description() << endl;
+	vector<CFlowAssembler::record_t> batch;
+	batch.reserve(record_batch_size);
+	size_t pos = file_header_len;
+	while (pos + record_header_len <= size) {
+		const uint8_t * hdr = data + pos;
+		uint32_t ts_sec = get32(hdr, swapped);
+		uint32_t ts_frac = get32(hdr + 4, swapped);
+		uint32_t caplen = get32(hdr + 8, swapped);
+		uint32_t origlen = get32(hdr + 12, swapped);
+		if (caplen > size - pos - record_header_len) {
+			cerr << "WARNING: " << file.get_filename() << " is truncated (last packet incomplete).\n";
+			break;
 		}
-
-		if (dl.get_type() == DataLink::EN10MB) {
-			if (true)
-				cout << "INFO: data link type is standard Ethernet (10 MB up).\n";
+		stats.packets++;
+
+		batch.push_back(CFlowAssembler::record_t());
+		CFlowAssembler::record_t & rec = batch.back();
+		decode_result_t result = decode_packet(linktype, hdr + record_header_len, caplen, origlen, rec);
+		count_packet(result, stats);
+		if (result == decoded_ip) {
+			rec.startMs = (uint64_t) ts_sec * 1000 + (nsec ? ts_frac / 1000000 : ts_frac / 1000);
+			rec.endMs = rec.startMs;
+			if (batch.size() >= record_batch_size)
+				flush_batch(batch, assembler);
 		} else {
-			string errtext = "ERROR: data link type is NOT Ethernet. Type code is: ";
-			errtext += dl.get_type();
-			errtext += " (not supported).\n";
-			cerr << errtext;
-			throw errtext;
-		}
-		if (true) {
-			unsigned int slen = pco.get_snaplen();
-			cout << "Snap length: " << slen << endl;
+			batch.pop_back();
 		}
+		pos += record_header_len + caplen;
+	}
+	flush_batch(batch, assembler);
+}
 
-		// (2) Process saved packets
-		// *************************
-		// Loop through pcap file by reading packet-by-packet.
-		// Assemble packets to a flowlist.
-		// Flowtype is correctly set to inflow/outflow or biflow.
-		// NOTE: uniflow qualification is done in step 3
-
-		Packet p;
-		while (pco.ok()) {
-			// Get next packet from file
-			if (!pco.next(p))
-				break; // Quit if no more packets avaliable
-			pcount++;
-
-			// Get packet length from header, but limit it to capture length
-			Packet::Length len = (p.get_length() > p.get_capture_length()) ? p.get_length() : p.get_capture_length();
-
-			if (len < sizeof(struct ethhdr)) { // Is packet too small?
-				string errtext = "Found malformed packet. Packet # ";
-				errtext += pcount;
-				errtext += ".\n";
-				cerr << errtext;
-				throw errtext;
+/**
+ *	Read packets of a pcapng file (all sections and interfaces).
+ *	Packets of interfaces with an unsupported link type are counted as "other".
+ *
+ *	\param file Mapped pcapng file
+ *	\param assembler Flow assembler receiving the packets
+ *	\param stats Packet counters to update
+ *
+ *	@exception std::string Errortext
+ */
+void GFilter_pcap::read_pcapng(const CMappedFile & file, CFlowAssembler & assembler, pcap_stats_t & stats) const {
+	/// Per interface information from the interface description block
+	struct interface_t {
+			uint32_t linktype;
+			uint32_t snaplen;
+			bool decimal; ///< Timestamp resolution is 10^-tsresol (else 2^-tsresol)
+			uint8_t tsresol;
+			bool valid; ///< Timestamp resolution can be converted to ms (else packets are ignored)
+	};
+	vector<interface_t> interfaces;
+
+	const uint8_t * data = file.data();
+	size_t size = file.size();
+	bool swapped = false;
+	bool warned_linktype = false;
+	bool warned_tsresol = false;
+
+	vector<CFlowAssembler::record_t> batch;
+	batch.reserve(record_batch_size);
+	size_t pos = 0;
+	while (pos + 12 <= size) {
+		const uint8_t * block = data + pos;
+		uint32_t type = get32(block, swapped);
+		if (type == PCAPNG_SECTION_HEADER) {
+			// New section: byte order and interfaces may change
+			uint32_t bom = get32(block + 8, false);
+			if (bom == PCAPNG_BYTE_ORDER_MAGIC) {
+				swapped = false;
+			} else if (bom == swap32(PCAPNG_BYTE_ORDER_MAGIC)) {
+				swapped = true;
+			} else {
+				throw "ERROR: " + file.get_filename() + " has an invalid pcapng section header.";
 			}
-
-			Packet::Data const * pdata = p.get_data();
-
-			struct ethhdr * ether_hdr = (struct ethhdr *) pdata;
-
-			// Process packet header data: check if data link protocol is ethernet
-			if (ntohs(ether_hdr->h_proto) == ETH_P_IP) { // Check if IPv4 packet
-
-				// Process IPv4 packet
-				// -------------------
-
-				if (len < (sizeof(struct ethhdr) + sizeof(struct iphdr))) { // Is packet too small?
-					string errtext = "Found malformed packet. Packet # ";
-					errtext += pcount;
-					errtext += ".\n";
-					cerr << errtext;
-					throw errtext;
-				}
-				struct iphdr * ip_hdr = (struct iphdr *) (pdata + sizeof(struct ethhdr));
-
-				// Get protocol
-				uint8_t prot = ip_hdr->protocol;
-
-				// Get IP addresses
-				IPv6_addr srcIP = IPv6_addr(ntohl(ip_hdr->saddr));
-				IPv6_addr dstIP = IPv6_addr(ntohl(ip_hdr->daddr));
-
-				// Infer flow direction from known network/netmask values
-				flow_type_t flowtype = inflow;
-				IPv6_addr net(srcIP & netmask);
-				if (net == local_net)
-					flowtype = outflow;
-
-				{
-					string dir;
-					if (flowtype == outflow)
-						dir = "local";
-					else
-						dir = "remote";
-					cout << "Found " << dir << " address srcIP = " << srcIP << endl;
-				}
-
-				// Get ports and flags (if TCP)
-				uint16_t srcPort = 0, dstPort = 0;
-				struct tcphdr * tcp_hdr = NULL;
-				struct udphdr * udp_hdr = NULL;
-				uint8_t flags = 0;
-				if (prot == IPPROTO_TCP) {
-					tcp_hdr = (struct tcphdr *) (pdata + sizeof(struct ethhdr) + sizeof(struct iphdr));
-					srcPort = ntohs(tcp_hdr->source);
-					dstPort = ntohs(tcp_hdr->dest);
-					flags = *(((uint8_t *) &(tcp_hdr->ack_seq)) + 5);
-				} else if (prot == IPPROTO_UDP) {
-					udp_hdr = (struct udphdr *) (pdata + sizeof(struct ethhdr) + sizeof(struct iphdr));
-					srcPort = ntohs(udp_hdr->source);
-					dstPort = ntohs(udp_hdr->dest);
-				}
-
-				// Get start time (note: get_miliseconds() returns microsecs in libpcap++ V 0.0.2)
-				// NOTE: we do not round the microsecs here, but cut-off not needed digits;
-				// by this, an error of up to 1 ms may result which is acceptable for a ms-precision.
-				uint64_t startMs = (uint64_t) (p.get_miliseconds() / 1000);
-				startMs += 1000 * (uint64_t) (p.get_seconds());
-				// Get layer 3 byte count
-				long layer3len = p.get_length() - sizeof(struct ethhdr);
-				uint8_t ToS = ip_hdr->tos;
-
-				// Assign src/dst fields to appropriate local/remote fields
-				IPv6_addr localIP, remoteIP;
-				uint16_t localPort, remotePort;
-
-				// Biflow matching: revert src/dst such that biflows are formed
-				if (flowtype == outflow) {
-					localIP = srcIP;
-					remoteIP = dstIP;
-					localPort = srcPort;
-					remotePort = dstPort;
-				} else {
-					localIP = dstIP;
-					remoteIP = srcIP;
-					localPort = dstPort;
-					remotePort = srcPort;
-				}
-
-				// Check if packet belongs to a new flow or updates an existing flow
-
-				flowHashKey mykey(localIP, remoteIP, localPort, remotePort, prot);
-				iter = flowHM->find(mykey);
-
-				if (iter != flowHM->end()) {
-					// Found: update found flow with new packet's data
-					// Fetch reference to flow entry hash map
-					cflow_t * f = iter->second;
-					// Found: update flow by contents of current packet
-					f->dOctets += layer3len;
-					if (startMs > flowlist[i].startMs) {
-						// New packet starts later
-						f->durationMs = startMs - f->startMs;
-					} else {
-						// New packet starts earlier
-						f->durationMs = f->startMs - startMs;
-						// Set flow start to earlier packet start
-						flowlist[i].startMs = startMs;
-					}
-					f->dPkts++;
-					if ((f->flowtype != flowtype) && (f->flowtype != biflow)) {
-						// New packet has opposite direction to earlier packets
-						// Make it a biflow
-						f->flowtype = biflow;
-					}
-
-				} else { // Not found
-					// Make an initial entry into temp_flowlist
-					flowlist[i].localIP = localIP;
-					flowlist[i].remoteIP = remoteIP;
-					flowlist[i].localPort = localPort;
-					flowlist[i].remotePort = remotePort;
-					flowlist[i].flowtype = flowtype;
-					flowlist[i].prot = prot;
-					flowlist[i].dOctets = layer3len;
-					flowlist[i].startMs = startMs;
-					flowlist[i].durationMs = 0;
-					flowlist[i].dPkts = 1;
-					flowlist[i].localAS = 0;
-					flowlist[i].remoteAS = 0;
-					flowlist[i].tos_flags = ToS;
-					flowlist[i].magic = CFLOW_CURRENT_MAGIC_NUMBER;
-
-					// Store 5-tuple together with reference to flow record in flow list
-					(*flowHM)[mykey] = &flowlist[i];
-					i++;
-					if (i >= maxnum_flows) {
-						string errtext = "INFO: terminating file reading due to full flow list.\n";
-						errtext += maxnum_flows;
-						errtext += " is the configured import limit.\n";
-						cerr << errtext;
-						throw errtext;
+			interfaces.clear();
+		}
+		uint32_t block_len = get32(block + 4, swapped);
+		if (block_len < 12 || (block_len % 4) != 0 || block_len > size - pos) {
+			cerr << "WARNING: " << file.get_filename() << " is truncated or corrupt at offset " << pos << ".\n";
+			break;
+		}
+		const uint8_t * body = block + 8;
+		size_t body_len = block_len - 12;
+
+		const uint8_t * pkt = NULL;
+		uint32_t caplen = 0, origlen = 0, ifid = 0;
+		uint64_t ts = 0;
+		bool has_ts = true;
+		switch (type) {
+			case PCAPNG_INTERFACE_DESCRIPTION: {
+				if (body_len < 8)
+					break;
+				interface_t intf;
+				intf.linktype = get16(body, swapped);
+				intf.snaplen = get32(body + 4, swapped);
+				intf.decimal = true;
+				intf.tsresol = 6;
+				intf.valid = true;
+				// Scan options for the timestamp resolution
+				size_t opos = 8;
+				while (opos + 4 <= body_len) {
+					uint16_t code = get16(body + opos, swapped);
+					uint16_t len = get16(body + opos + 2, swapped);
+					if (code == PCAPNG_OPT_ENDOFOPT || opos + 4 + len > body_len)
+						break;
+					if (code == PCAPNG_OPT_IF_TSRESOL && len >= 1) {
+						intf.decimal = (body[opos + 4] & 0x80) == 0;
+						intf.tsresol = body[opos + 4] & 0x7f;
+						if (intf.decimal && intf.tsresol > 19) { // 10^tsresol does not fit into 64 bits
+							intf.valid = false;
+							if (!warned_tsresol) {
+								cerr << "WARNING: timestamp resolution 10^-" << (int) intf.tsresol << " is not supported, ignoring packets of this interface.\n";
+								warned_tsresol = true;
+							}
+						}
 					}
+					opos += 4 + ((len + 3) & ~3);
 				}
-
-			} else if (ntohs(ether_hdr->h_proto) == ETH_P_IPV6) {
-				// Process IPv6 packet
-				// -------------------
-				if (len < (sizeof(struct ethhdr) + sizeof(struct ip6_hdr))) { // Is packet too small?
-					string errtext = "Found malformed packet. Packet # ";
-					errtext += pcount;
-					errtext += ".\n";
-					cerr << errtext;
-					throw errtext;
-				}
-				struct ip6_hdr * ip6_header = (struct ip6_hdr *) (pdata + sizeof(struct ethhdr));
-
-				// Get protocol
-				uint8_t prot = ip6_header->ip6_ctlun.ip6_un1.ip6_un1_nxt;
-
-				// Get IP addresses
-				IPv6_addr srcIP(ip6_header->ip6_src);
-				IPv6_addr dstIP(ip6_header->ip6_dst);
-
-				// Infer flow direction from known network/netmask values
-				flow_type_t flowtype = inflow;
-				IPv6_addr net(srcIP & netmask);
-				if (net == local_net)
-					flowtype = outflow;
-
-				{
-					string dir;
-					if (flowtype == outflow)
-						dir = "local";
-					else
-						dir = "remote";
-					cout << "Found " << dir << " address srcIPv6 = " << srcIP << endl;
-				}
-
-				// Get ports and flags (if TCP)
-				uint16_t srcPort = 0, dstPort = 0;
-				struct tcphdr * tcp_hdr = NULL;
-				struct udphdr * udp_hdr = NULL;
-				uint8_t flags = 0;
-				if (prot == IPPROTO_TCP) {
-					tcp_hdr = (struct tcphdr *) (pdata + sizeof(struct ethhdr) + sizeof(struct ip6_hdr));
-					srcPort = ntohs(tcp_hdr->source);
-					dstPort = ntohs(tcp_hdr->dest);
-					flags = *(((uint8_t *) &(tcp_hdr->ack_seq)) + 5);
-				} else if (prot == IPPROTO_UDP) {
-					udp_hdr = (struct udphdr *) (pdata + sizeof(struct ethhdr) + sizeof(struct ip6_hdr));
-					srcPort = ntohs(udp_hdr->source);
-					dstPort = ntohs(udp_hdr->dest);
+				if (!is_supported_linktype(intf.linktype) && !warned_linktype) {
+					cerr << "WARNING: data link type " << intf.linktype << " is not supported, ignoring packets of this interface.\n";
+					warned_linktype = true;
 				}
+				interfaces.push_back(intf);
+				break;
+			}
+			case PCAPNG_ENHANCED_PACKET:
+			case PCAPNG_PACKET:
+				if (body_len < 20)
+					break;
+				ifid = (type == PCAPNG_ENHANCED_PACKET) ? get32(body, swapped) : get16(body, swapped);
+				ts = ((uint64_t) get32(body + 4, swapped) << 32) | get32(body + 8, swapped);
+				caplen = get32(body + 12, swapped);
+				origlen = get32(body + 16, swapped);
+				if (caplen <= body_len - 20)
+					pkt = body + 20;
+				break;
+			case PCAPNG_SIMPLE_PACKET:
+				if (body_len < 4)
+					break;
+				ifid = 0;
+				has_ts = false; // simple packet blocks carry no timestamp
+				origlen = get32(body, swapped);
+				caplen = min((size_t) origlen, body_len - 4);
+				if (!interfaces.empty() && interfaces[0].snaplen != 0 && caplen > interfaces[0].snaplen)
+					caplen = interfaces[0].snaplen;
+				pkt = body + 4;
+				break;
+			default:
+				break; // Skip all other block types
+		}
 
-				// Get start time (note: get_miliseconds() returns microsecs in libpcap++ V 0.0.2)
-				// NOTE: we do not round the microsecs here, but cut-off not needed digits;
-				// by this, an error of up to 1 ms may result which is acceptable for a ms-precision.
-				uint64_t startMs = (uint64_t) (p.get_miliseconds() / 1000);
-				startMs += 1000 * (uint64_t) (p.get_seconds());
-				// Get layer 3 byte count
-				long layer3len = p.get_length() - sizeof(struct ethhdr);
-				uint8_t ToS = ip6_header->ip6_ctlun.ip6_un1.ip6_un1_hlim;
-
-				// Assign src/dst fields to appropriate local/remote fields
-				IPv6_addr localIP, remoteIP;
-				uint16_t localPort, remotePort;
-
-				// Biflow matching: revert src/dst such that biflows are formed
-				if (flowtype == outflow) {
-					localIP = srcIP;
-					remoteIP = dstIP;
-					localPort = srcPort;
-					remotePort = dstPort;
+		if (type == PCAPNG_ENHANCED_PACKET || type == PCAPNG_PACKET || type == PCAPNG_SIMPLE_PACKET) {
+			stats.packets++;
+			if (pkt == NULL || ifid >= interfaces.size()) {
+				stats.malformed_packets++;
+			} else if (!interfaces[ifid].valid || !is_supported_linktype(interfaces[ifid].linktype)) {
+				stats.other_packets++;
+			} else {
+				const interface_t & intf = interfaces[ifid];
+				batch.push_back(CFlowAssembler::record_t());
+				CFlowAssembler::record_t & rec = batch.back();
+				decode_result_t result = decode_packet(intf.linktype, pkt, caplen, origlen, rec);
+				count_packet(result, stats);
+				if (result == decoded_ip) {
+					uint64_t ms = 0;
+					if (has_ts) {
+						if (intf.decimal) {
+							uint64_t div = 1;
+							for (int i = 3; i < intf.tsresol; i++)
+								div *= 10;
+							ms = ts / div;
+							for (int i = intf.tsresol; i < 3; i++)
+								ms *= 10;
+						} else {
+							uint8_t bits = min(intf.tsresol, (uint8_t) 63);
+							uint64_t frac = ts & ((1ULL << bits) - 1);
+							if (bits <= 54)
+								ms = (ts >> bits) * 1000 + ((frac * 1000) >> bits);
+							else // frac * 1000 would overflow, keep 10 bits of the fraction
+								ms = (ts >> bits) * 1000 + (((frac >> (bits - 10)) * 1000) >> 10);
+						}
+					}
+					rec.startMs = ms;
+					rec.endMs = ms;
+					if (batch.size() >= record_batch_size)
+						flush_batch(batch, assembler);
 				} else {
-					localIP = dstIP;
-					remoteIP = srcIP;
-					localPort = dstPort;
-					remotePort = srcPort;
+					batch.pop_back();
 				}
+			}
+		}
+		pos += block_len;
+	}
+	flush_batch(batch, assembler);
+}
 
-				// Check if packet belongs to a new flow or updates an existing flow
-
-				flowHashKey mykey(localIP, remoteIP, localPort, remotePort, prot);
-				iter = flowHM->find(mykey);
-
-				if (iter != flowHM->end()) {
-					// Found: update found flow with new packet's data
-					// Fetch reference to flow entry hash map
-					cflow_t * f = iter->second;
-					// Found: update flow by contents of current packet
-					f->dOctets += layer3len;
-					if (startMs > flowlist[i].startMs) {
-						// New packet starts later
-						f->durationMs = startMs - f->startMs;
-					} else {
-						// New packet starts earlier
-						f->durationMs = f->startMs - startMs;
-						// Set flow start to earlier packet start
-						flowlist[i].startMs = startMs;
-					}
-					f->dPkts++;
-					if ((f->flowtype != flowtype) && (f->flowtype != biflow)) {
-						// New packet has opposite direction to earlier packets
-						// Make it a biflow
-						f->flowtype = biflow;
-					}
+/**
+ *	Check if a link type can be decoded.
+ *
+ *	\param linktype Link type as stored in the capture file
+ *
+ *	\return True if decode_packet() understands the link type
+ */
+bool GFilter_pcap::is_supported_linktype(uint32_t linktype) {
+	switch (linktype) {
+		case LINKTYPE_ETHERNET:
+		case LINKTYPE_LINUX_SLL:
+		case LINKTYPE_LINUX_SLL2:
+		case LINKTYPE_RAW:
+		case LINKTYPE_RAW_BSD:
+		case LINKTYPE_IPV4:
+		case LINKTYPE_IPV6:
+			return true;
+		default:
+			return false;
+	}
+}
 
-				} else { // Not found
-					// Make an initial entry into temp_flowlist
-					flowlist[i].localIP = localIP;
-					flowlist[i].remoteIP = remoteIP;
-					flowlist[i].localPort = localPort;
-					flowlist[i].remotePort = remotePort;
-					flowlist[i].flowtype = flowtype;
-					flowlist[i].prot = prot;
-					flowlist[i].dOctets = layer3len;
-					flowlist[i].startMs = startMs;
-					flowlist[i].durationMs = 0;
-					flowlist[i].dPkts = 1;
-					flowlist[i].localAS = 0;
-					flowlist[i].remoteAS = 0;
-					flowlist[i].tos_flags = ToS;
-					flowlist[i].magic = CFLOW_CURRENT_MAGIC_NUMBER;
-
-					// Store 5-tuple together with reference to flow record in flow list
-					(*flowHM)[mykey] = &flowlist[i];
-					i++;
-					if (i >= maxnum_flows) {
-						string errtext = "INFO: terminating file reading due to full flow list.\n";
-						errtext += maxnum_flows;
-						errtext += " is the configured import limit.\n";
-						cerr << errtext;
-						throw errtext;
-					}
-				}
-			} else {
+/**
+ *	Decode link, network and transport layer headers of a single captured packet.
+ *	Fills in addresses, ports, protocol, ToS and layer 3 byte count of "rec" (timestamps are left to the caller).
+ *
+ *	\param linktype Link type of the capturing interface
+ *	\param pkt Captured bytes
+ *	\param caplen Number of captured bytes
+ *	\param origlen Original length of the packet on the wire
+ *	\param rec Record to fill
+ *
+ *	\return Outcome of decoding
+ */
+GFilter_pcap::decode_result_t GFilter_pcap::decode_packet(uint32_t linktype, const uint8_t * pkt, uint32_t caplen, uint32_t origlen,
+      CFlowAssembler::record_t & rec) {
+	// Link layer
+	// ----------
+	uint32_t off = 0;
+	uint16_t ethertype = 0;
+	switch (linktype) {
+		case LINKTYPE_ETHERNET:
+			if (caplen < 14)
+				return decoded_malformed;
+			ethertype = net16(pkt + 12);
+			off = 14;
+			// Skip (possibly stacked) VLAN tags
+			while (ethertype == ETH_TYPE_8021Q || ethertype == ETH_TYPE_8021AD || ethertype == ETH_TYPE_QINQ) {
+				if (caplen < off + 4)
+					return decoded_malformed;
+				ethertype = net16(pkt + off + 2);
+				off += 4;
+			}
+			break;
+		case LINKTYPE_LINUX_SLL:
+			if (caplen < 16)
+				return decoded_malformed;
+			ethertype = net16(pkt + 14);
+			off = 16;
+			break;
+		case LINKTYPE_LINUX_SLL2:
+			if (caplen < 20)
+				return decoded_malformed;
+			ethertype = net16(pkt);
+			off = 20;
+			break;
+		default: // Raw IP
+			if (caplen < 1)
+				return decoded_malformed;
+			ethertype = ((pkt[0] >> 4) == 6) ? ETH_TYPE_IPV6 : ETH_TYPE_IPV4;
+			break;
+	}
 
-				// Handle all non-IPv4/IPv6 traffic
-				// ---------------------------
-				//
-				// Just update some statistics.
-				switch (ntohs(ether_hdr->h_proto)) {
-					case ETH_P_ARP:
-						arp_packet_count++;
-						break;
-					default:
-						other_packet_count++;
-				}
+	// Network layer
+	// -------------
+	uint32_t l4 = 0;
+	bool has_ports = false;
+	if (ethertype == ETH_TYPE_IPV4) {
+		if (caplen < off + 20 || (pkt[off] >> 4) != 4)
+			return decoded_malformed;
+		uint32_t ihl = (pkt[off] & 0x0f) * 4;
+		if (ihl < 20)
+			return decoded_malformed;
+		rec.tos_flags = pkt[off + 1];
+		rec.prot = pkt[off + 9];
+		rec.srcIP = IPv6_addr(net32(pkt + off + 12));
+		rec.dstIP = IPv6_addr(net32(pkt + off + 16));
+		uint16_t frag_offset = net16(pkt + off + 6) & 0x1fff;
+		l4 = off + ihl;
+		has_ports = (frag_offset == 0);
+	} else if (ethertype == ETH_TYPE_IPV6) {
+		if (caplen < off + 40 || (pkt[off] >> 4) != 6)
+			return decoded_malformed;
+		rec.tos_flags = (uint8_t) (((pkt[off] & 0x0f) << 4) | (pkt[off + 1] >> 4)); // Traffic class
+		in6_addr a;
+		memcpy(&a, pkt + off + 8, sizeof(a));
+		rec.srcIP = IPv6_addr(a);
+		memcpy(&a, pkt + off + 24, sizeof(a));
+		rec.dstIP = IPv6_addr(a);
+		uint8_t nxt = pkt[off + 6];
+		l4 = off + 40;
+		has_ports = true;
+		// Skip extension headers to find the transport protocol
+		bool ext = true;
+		while (ext && caplen >= l4 + 8) {
+			switch (nxt) {
+				case IPPROTO_HOPOPTS:
+				case IPPROTO_ROUTING:
+				case IPPROTO_DSTOPTS:
+					nxt = pkt[l4];
+					l4 += (pkt[l4 + 1] + 1) * 8;
+					break;
+				case IPPROTO_FRAGMENT:
+					if ((net16(pkt + l4 + 2) >> 3) != 0)
+						has_ports = false; // not the first fragment
+					nxt = pkt[l4];
+					l4 += 8;
+					break;
+				case IPPROTO_AH:
+					nxt = pkt[l4];
+					l4 += (pkt[l4 + 1] + 2) * 4;
+					break;
+				default:
+					ext = false;
+					break;
 			}
 		}
+		rec.prot = nxt;
+	} else if (ethertype == ETH_TYPE_ARP) {
+		return decoded_arp;
+	} else {
+		return decoded_other;
+	}
 
-	} catch (PcapError & pcerror) {
-		cerr << "ERROR: " << pcerror.what() << endl;
-		throw pcerror.what();
-	} catch (...) {
-		throw "Error in CImport::read_pcap_file_raw()";
+	// Transport layer
+	// ---------------
+	if (has_ports && (rec.prot == IPPROTO_TCP || rec.prot == IPPROTO_UDP) && caplen >= l4 + 4) {
+		rec.srcPort = net16(pkt + l4);
+		rec.dstPort = net16(pkt + l4 + 2);
 	}
 
-	flowlist.resize(i);
-	cout << "(ignored packets: " << arp_packet_count << " (ARP), " << other_packet_count << " (OTHER).\n";
+	// Layer 3 byte count
+	rec.dOctets = (origlen > off) ? (origlen - off) : 0;
+	rec.dPkts = 1;
+	return decoded_ip;
+}
+
+/**
+ *	Update packet counters according to a decoding result.
+ *
+ *	\param result Outcome of decode_packet()
+ *	\param stats Counters to update
+ */
+void GFilter_pcap::count_packet(decode_result_t result, pcap_stats_t & stats) {
+	switch (result) {
+		case decoded_ip:
+			stats.ip_packets++;
+			break;
+		case decoded_arp:
+			stats.arp_packets++;
+			break;
+		case decoded_other:
+			stats.other_packets++;
+			break;
+		case decoded_malformed:
+			stats.malformed_packets++;
+			break;
+	}
 }
 
 /**
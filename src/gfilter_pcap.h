@@ -3,23 +3,64 @@
 
 /**
  *	\file gfilter_pcap.h
- *	\brief Filter to import pcap files
+ *	\brief Filter to import pcap and pcapng files
  */
 #include <string>
+#include <stdint.h>
 
 #include "gfilter.h"
 #include "IPv6_addr.h"
 #include "cflow.h"
+#include "gflowassembler.h"
+
+class CMappedFile;
 
 /**
  *	\class	GFilter_pcap
- *	\brief	GFilter_pcap is an class which can import pcap files
+ *	\brief	GFilter_pcap is an class which can import pcap and pcapng files.
+ *
+ *	The capture file is memory mapped and parsed in place. Supported link types are Ethernet
+ *	(including 802.1Q/802.1ad VLAN tags), Linux cooked capture (SLL and SLL2) and raw IP.
  */
 class GFilter_pcap: public GFilter {
 	public:
-		GFilter_pcap(std::string name = "pcap", std::string simplePattern = "*.pcap", std::string regexPattern = "^.+\\.pcap$");
-		virtual void read_file(std::string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const;
+		GFilter_pcap(std::string name = "pcap", std::string simplePattern = "*.pcap*", std::string regexPattern = "^.+\\.pcap(ng)?$");
+		using GFilter::read_file;
+		virtual void read_file(std::string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const;
 		virtual bool acceptFileForReading(std::string in_filename) const;
+
+	private:
+		/**
+		 *	\struct	pcap_stats_t
+		 *	\brief	Packet counters of a single import
+		 */
+		struct pcap_stats_t {
+				uint64_t packets; ///< Packets found in file
+				uint64_t ip_packets; ///< IPv4/IPv6 packets passed on to flow assembly
+				uint64_t arp_packets; ///< ARP packets (ignored)
+				uint64_t other_packets; ///< Other non IP packets (ignored)
+				uint64_t malformed_packets; ///< Truncated or malformed packets (ignored)
+				pcap_stats_t() :
+					packets(0), ip_packets(0), arp_packets(0), other_packets(0), malformed_packets(0) {
+				}
+		};
+
+		/**
+		 *	\enum decode_result_t
+		 *	\brief Outcome of decoding a single captured packet
+		 */
+		enum decode_result_t {
+			decoded_ip, ///< IPv4/IPv6 packet, record is valid
+			decoded_arp, ///< ARP packet
+			decoded_other, ///< Other non IP packet
+			decoded_malformed ///< Packet too short or inconsistent
+		};
+
+		void read_pcap(const CMappedFile & file, CFlowAssembler & assembler, pcap_stats_t & stats) const;
+		void read_pcapng(const CMappedFile & file, CFlowAssembler & assembler, pcap_stats_t & stats) const;
+		static bool is_supported_linktype(uint32_t linktype);
+		static decode_result_t decode_packet(uint32_t linktype, const uint8_t * pkt, uint32_t caplen, uint32_t origlen, CFlowAssembler::record_t & rec);
+		static void count_packet(decode_result_t result, pcap_stats_t & stats);
 };
 
 #endif /* GFILTER_PCAP_H_ */
@@ -0,0 +1,551 @@
+/**
+ *	\file gflowassembler.cpp
+ *	\brief Assembles packets and flow records into (bi)flows; shared by the input filters.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "gflowassembler.h"
+#include "HashMapE.h"
+#include "lookup3.h"
+
+using namespace std;
+
+static const size_t initial_table_size = 1024; ///< Initial number of slots per shard (power of two)
+static const size_t batch_size = 4096; ///< Records handed over to a worker thread at once
+static const size_t max_queued_batches = 16; ///< Limits the memory used by records not yet processed by a worker
+static const unsigned int max_default_threads = 8; ///< Upper bound for get_default_threads()
+
+/**
+ *	\class	CFlowAssembler::CShard
+ *	\brief	One shard of the assembler: a flat open addressing (linear probing) hash table holding the open flows
+ *				of a subset of the 5-tuples, optionally served by a worker thread.
+ */
+class CFlowAssembler::CShard {
+	public:
+		CShard(CFlowList * out, uint64_t activeTimeoutMs, uint64_t idleTimeoutMs, bool threaded);
+		~CShard();
+
+		void push(const cflow_t & flow, uint32_t hash);
+		void finish();
+
+		CFlowList exported; ///< Flows exported by this shard (threaded mode only)
+		uint64_t flows; ///< Number of exported flows
+		uint64_t active_timeouts; ///< Flows exported due to the active timeout
+		uint64_t idle_timeouts; ///< Flows exported due to the idle timeout
+		uint64_t peak; ///< Maximum number of concurrently open flows
+
+	private:
+		/// Slot of the flat hash table
+		struct slot_t {
+				cflow_t flow; ///< Open flow
+				uint32_t hash; ///< Cached 5-tuple hash
+				bool used; ///< Slot is occupied
+				slot_t() :
+					hash(0), used(false) {
+				}
+		};
+		/// Record waiting to be merged by the worker thread
+		struct pending_t {
+				cflow_t flow;
+				uint32_t hash;
+		};
+
+		void merge(const cflow_t & flow, uint32_t hash);
+		size_t find_slot(const cflow_t & flow, uint32_t hash) const;
+		void grow();
+		void sweep(bool all);
+		void export_flow(const cflow_t & flow);
+		void enqueue();
+		void run();
+
+		CFlowList * out; ///< Destination of exported flows
+		uint64_t activeTimeoutMs; ///< Active timeout (0: disabled)
+		uint64_t idleTimeoutMs; ///< Idle timeout (0: disabled)
+		uint64_t sweepIntervalMs; ///< Interval between two timeout scans (0: never scan)
+		uint64_t clockMs; ///< Latest flow end time seen by this shard
+		uint64_t nextSweepMs; ///< Record time at which the next timeout scan is due
+
+		std::vector<slot_t> table; ///< Slots, size is a power of two
+		size_t count; ///< Number of used slots
+
+		boost::thread * worker; ///< Worker thread or NULL if records are merged by the caller
+		boost::mutex mutex; ///< Protects queue and done
+		boost::condition_variable dataAvailable; ///< Signalled when a batch is queued or done is set
+		boost::condition_variable spaceAvailable; ///< Signalled when a batch is taken off the queue
+		std::deque<std::vector<pending_t> > queue; ///< Batches waiting for the worker thread
+		std::vector<pending_t> batch; ///< Batch currently filled by the producer
+		bool done; ///< No more batches will be queued
+};
+
+/**
+ *	Constructor
+ *
+ *	\param out Flow list receiving exported flows (ignored in threaded mode, the shard then exports into "exported")
+ *	\param activeTimeoutMs Active timeout in milliseconds (0: disabled)
+ *	\param idleTimeoutMs Idle timeout in milliseconds (0: disabled)
+ *	\param threaded Start a worker thread for this shard
+ */
+CFlowAssembler::CShard::CShard(CFlowList * out, uint64_t activeTimeoutMs, uint64_t idleTimeoutMs, bool threaded) :
+	flows(0), active_timeouts(0), idle_timeouts(0), peak(0), out(out), activeTimeoutMs(activeTimeoutMs), idleTimeoutMs(idleTimeoutMs),
+	      sweepIntervalMs(0), clockMs(0), nextSweepMs(0), table(initial_table_size), count(0), worker(NULL), done(false) {
+	// Scan for expired flows twice per (shortest) timeout interval
+	if (activeTimeoutMs != 0 && idleTimeoutMs != 0) {
+		sweepIntervalMs = min(activeTimeoutMs, idleTimeoutMs) / 2;
+	} else {
+		sweepIntervalMs = max(activeTimeoutMs, idleTimeoutMs) / 2;
+	}
+	if ((activeTimeoutMs != 0 || idleTimeoutMs != 0) && sweepIntervalMs == 0)
+		sweepIntervalMs = 1;
+
+	if (threaded) {
+		this->out = &exported;
+		batch.reserve(batch_size);
+		worker = new boost::thread(boost::bind(&CFlowAssembler::CShard::run, this));
+	}
+}
+
+/**
+ *	Destructor: stops the worker thread (if still running)
+ */
+CFlowAssembler::CShard::~CShard() {
+	if (worker != NULL) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			done = true;
+		}
+		dataAvailable.notify_one();
+		worker->join();
+		delete worker;
+	}
+}
+
+/**
+ *	Add a flow (in local/remote view) to this shard.
+ *
+ *	\param flow Flow to merge
+ *	\param hash 5-tuple hash of the flow
+ */
+void CFlowAssembler::CShard::push(const cflow_t & flow, uint32_t hash) {
+	if (worker == NULL) {
+		merge(flow, hash);
+		return;
+	}
+	pending_t p;
+	p.flow = flow;
+	p.hash = hash;
+	batch.push_back(p);
+	if (batch.size() >= batch_size)
+		enqueue();
+}
+
+/**
+ *	Hand the current batch over to the worker thread. Blocks while too many batches are waiting.
+ */
+void CFlowAssembler::CShard::enqueue() {
+	if (batch.empty())
+		return;
+	boost::mutex::scoped_lock lock(mutex);
+	while (queue.size() >= max_queued_batches)
+		spaceAvailable.wait(lock);
+	queue.push_back(std::vector<pending_t>());
+	queue.back().swap(batch);
+	lock.unlock();
+	dataAvailable.notify_one();
+	batch.reserve(batch_size);
+}
+
+/**
+ *	Worker thread: merge queued batches until done is set, then export all open flows.
+ */
+void CFlowAssembler::CShard::run() {
+	std::vector<pending_t> work;
+	while (true) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			while (queue.empty() && !done)
+				dataAvailable.wait(lock);
+			if (queue.empty())
+				break;
+			work.swap(queue.front());
+			queue.pop_front();
+		}
+		spaceAvailable.notify_one();
+		for (std::vector<pending_t>::const_iterator it = work.begin(); it != work.end(); ++it)
+			merge(it->flow, it->hash);
+		work.clear();
+	}
+	sweep(true);
+}
+
+/**
+ *	Export all flows still open. In threaded mode this waits for the worker thread to finish.
+ */
+void CFlowAssembler::CShard::finish() {
+	if (worker != NULL) {
+		enqueue();
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			done = true;
+		}
+		dataAvailable.notify_one();
+		worker->join();
+		delete worker;
+		worker = NULL;
+	} else {
+		sweep(true);
+	}
+}
+
+/**
+ *	Locate the slot holding the flow with the same 5-tuple or the empty slot where it has to be inserted.
+ *
+ *	\param flow Flow to look up
+ *	\param hash 5-tuple hash of the flow
+ *
+ *	\return Slot index
+ */
+size_t CFlowAssembler::CShard::find_slot(const cflow_t & flow, uint32_t hash) const {
+	size_t mask = table.size() - 1;
+	size_t idx = hash & mask;
+	while (table[idx].used) {
+		const cflow_t & f = table[idx].flow;
+		if (table[idx].hash == hash && f.localPort == flow.localPort && f.remotePort == flow.remotePort && f.prot == flow.prot && f.localIP
+		      == flow.localIP && f.remoteIP == flow.remoteIP)
+			break;
+		idx = (idx + 1) & mask;
+	}
+	return idx;
+}
+
+/**
+ *	Merge a flow into the table: update an open flow with the same 5-tuple or open a new one.
+ *	An open flow whose timeout expires with respect to the new flow is exported first.
+ *
+ *	\param flow Flow to merge
+ *	\param hash 5-tuple hash of the flow
+ */
+void CFlowAssembler::CShard::merge(const cflow_t & flow, uint32_t hash) {
+	uint64_t endMs = flow.startMs + flow.durationMs;
+	size_t idx = find_slot(flow, hash);
+	slot_t & slot = table[idx];
+
+	if (slot.used) {
+		cflow_t & f = slot.flow;
+		uint64_t fEndMs = f.startMs + f.durationMs;
+		if (idleTimeoutMs != 0 && flow.startMs > fEndMs + idleTimeoutMs) {
+			idle_timeouts++;
+			export_flow(f);
+			f = flow;
+		} else if (activeTimeoutMs != 0 && endMs > f.startMs + activeTimeoutMs) {
+			active_timeouts++;
+			export_flow(f);
+			f = flow;
+		} else {
+			// Update open flow
+			uint64_t startMs = min(f.startMs, flow.startMs);
+			f.durationMs = max(fEndMs, endMs) - startMs;
+			f.startMs = startMs;
+			f.dOctets += flow.dOctets;
+			f.dPkts += flow.dPkts;
+			if ((f.flowtype != flow.flowtype) && (f.flowtype != biflow)) {
+				// Opposite direction to earlier packets: make it a biflow
+				f.flowtype = biflow;
+			}
+		}
+	} else {
+		slot.flow = flow;
+		slot.hash = hash;
+		slot.used = true;
+		count++;
+		if (count > peak)
+			peak = count;
+		if (2 * count > table.size())
+			grow();
+	}
+
+	if (sweepIntervalMs != 0) {
+		if (endMs > clockMs)
+			clockMs = endMs;
+		if (nextSweepMs == 0) {
+			nextSweepMs = clockMs + sweepIntervalMs;
+		} else if (clockMs >= nextSweepMs) {
+			sweep(false);
+			nextSweepMs = clockMs + sweepIntervalMs;
+		}
+	}
+}
+
+/**
+ *	Double the table size.
+ */
+void CFlowAssembler::CShard::grow() {
+	std::vector<slot_t> old(table.size() * 2);
+	old.swap(table);
+	for (std::vector<slot_t>::const_iterator it = old.begin(); it != old.end(); ++it) {
+		if (it->used)
+			table[find_slot(it->flow, it->hash)] = *it;
+	}
+}
+
+/**
+ *	Export expired flows (or all flows) and remove them from the table.
+ *
+ *	\param all Export all open flows regardless of their timeouts
+ */
+void CFlowAssembler::CShard::sweep(bool all) {
+	size_t expired = 0;
+	for (std::vector<slot_t>::iterator it = table.begin(); it != table.end(); ++it) {
+		if (!it->used)
+			continue;
+		const cflow_t & f = it->flow;
+		bool idle = idleTimeoutMs != 0 && clockMs > f.startMs + f.durationMs + idleTimeoutMs;
+		bool active = activeTimeoutMs != 0 && clockMs >= f.startMs + activeTimeoutMs;
+		if (all || idle || active) {
+			if (!all) {
+				if (idle)
+					idle_timeouts++;
+				else
+					active_timeouts++;
+			}
+			export_flow(f);
+			it->used = false;
+			expired++;
+		}
+	}
+	if (expired == 0)
+		return;
+	count -= expired;
+
+	// Linear probing does not allow to just clear slots: re-insert the remaining flows
+	std::vector<slot_t> old(table.size());
+	old.swap(table);
+	if (count != 0) {
+		for (std::vector<slot_t>::const_iterator it = old.begin(); it != old.end(); ++it) {
+			if (it->used)
+				table[find_slot(it->flow, it->hash)] = *it;
+		}
+	}
+}
+
+/**
+ *	Append a finished flow to the output flow list.
+ *
+ *	\param flow Finished flow
+ */
+void CFlowAssembler::CShard::export_flow(const cflow_t & flow) {
+	out->push_back(flow);
+	flows++;
+}
+
+/**
+ *	Constructor: record_t with all fields cleared
+ */
+CFlowAssembler::record_t::record_t() :
+	startMs(0), endMs(0), dOctets(0), dPkts(0), srcPort(0), dstPort(0), prot(0), tos_flags(0), bidir(false) {
+}
+
+/**
+ *	Constructor: stats_t with all counters cleared
+ */
+CFlowAssembler::stats_t::stats_t() :
+	records(0), packets(0), flows(0), active_timeouts(0), idle_timeouts(0), peak_open_flows(0) {
+}
+
+/**
+ *	Constructor
+ *
+ *	\param flowlist Flow list receiving the exported flows (flows are appended)
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param threads Number of shards, each served by its own worker thread; 1 merges within the calling thread
+ *	\param activeTimeoutMs Active timeout in milliseconds (0: disabled)
+ *	\param idleTimeoutMs Idle timeout in milliseconds (0: disabled)
+ */
+CFlowAssembler::CFlowAssembler(CFlowList & flowlist, const CLocalNets & local_nets, unsigned int threads, uint64_t activeTimeoutMs,
+      uint64_t idleTimeoutMs) :
+	flowlist(flowlist), local_nets(local_nets), predicate(NULL), flushed(false) {
+	create_shards(threads, activeTimeoutMs, idleTimeoutMs);
+}
+
+/**
+ *	Constructor: single local network given by address and netmask
+ *
+ *	\param flowlist Flow list receiving the exported flows (flows are appended)
+ *	\param local_net Local network address used to infer flow directions
+ *	\param netmask Network mask for local network address
+ *	\param threads Number of shards, each served by its own worker thread; 1 merges within the calling thread
+ *	\param activeTimeoutMs Active timeout in milliseconds (0: disabled)
+ *	\param idleTimeoutMs Idle timeout in milliseconds (0: disabled)
+ */
+CFlowAssembler::CFlowAssembler(CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, unsigned int threads,
+      uint64_t activeTimeoutMs, uint64_t idleTimeoutMs) :
+	flowlist(flowlist), local_nets(local_net, netmask), predicate(NULL), flushed(false) {
+	create_shards(threads, activeTimeoutMs, idleTimeoutMs);
+}
+
+/**
+ *	Create the shards (and their worker threads).
+ *
+ *	\param threads Number of shards
+ *	\param activeTimeoutMs Active timeout in milliseconds (0: disabled)
+ *	\param idleTimeoutMs Idle timeout in milliseconds (0: disabled)
+ */
+void CFlowAssembler::create_shards(unsigned int threads, uint64_t activeTimeoutMs, uint64_t idleTimeoutMs) {
+	if (threads == 0)
+		threads = 1;
+	bool threaded = threads > 1;
+	for (unsigned int i = 0; i < threads; i++) {
+		shards.push_back(new CShard(&flowlist, activeTimeoutMs, idleTimeoutMs, threaded));
+	}
+}
+
+/**
+ *	Destructor: stops all worker threads. Flows still open are lost unless flush() was called.
+ */
+CFlowAssembler::~CFlowAssembler() {
+	for (std::vector<CShard *>::iterator it = shards.begin(); it != shards.end(); ++it) {
+		delete *it;
+	}
+}
+
+/**
+ *	Add a single packet.
+ *
+ *	\param srcIP Source IP address
+ *	\param dstIP Destination IP address
+ *	\param srcPort Source port
+ *	\param dstPort Destination port
+ *	\param prot Protocol number
+ *	\param timeMs Capture time in milliseconds since the epoch
+ *	\param bytes Layer 3 packet length
+ *	\param tos_flags ToS flags
+ */
+void CFlowAssembler::add_packet(const IPv6_addr & srcIP, const IPv6_addr & dstIP, uint16_t srcPort, uint16_t dstPort, uint8_t prot, uint64_t timeMs,
+      uint64_t bytes, uint8_t tos_flags) {
+	record_t rec;
+	rec.srcIP = srcIP;
+	rec.dstIP = dstIP;
+	rec.srcPort = srcPort;
+	rec.dstPort = dstPort;
+	rec.prot = prot;
+	rec.startMs = timeMs;
+	rec.endMs = timeMs;
+	rec.dOctets = bytes;
+	rec.dPkts = 1;
+	rec.tos_flags = tos_flags;
+	add_record(rec);
+}
+
+/**
+ *	Convert a record into a flow. Infers the flow direction from the local network and maps
+ *	source/destination onto local/remote.
+ *
+ *	\param rec Packet or flow record
+ *	\param local_nets Local networks
+ *	\param flow Resulting flow
+ */
+void CFlowAssembler::make_flow(const record_t & rec, const CLocalNets & local_nets, cflow_t & flow) {
+	flow_type_t flowtype = local_nets.is_local(rec.srcIP) ? outflow : inflow;
+
+	if (flowtype == outflow) {
+		flow.localIP = rec.srcIP;
+		flow.remoteIP = rec.dstIP;
+		flow.localPort = rec.srcPort;
+		flow.remotePort = rec.dstPort;
+	} else {
+		flow.localIP = rec.dstIP;
+		flow.remoteIP = rec.srcIP;
+		flow.localPort = rec.dstPort;
+		flow.remotePort = rec.srcPort;
+	}
+	flow.flowtype = rec.bidir ? biflow : flowtype;
+	flow.prot = rec.prot;
+	flow.startMs = rec.startMs;
+	flow.durationMs = (rec.endMs > rec.startMs) ? (rec.endMs - rec.startMs) : 0;
+	flow.dOctets = rec.dOctets;
+	flow.dPkts = rec.dPkts;
+	flow.tos_flags = rec.tos_flags;
+	flow.magic = CFLOW_CURRENT_MAGIC_NUMBER;
+}
+
+/**
+ *	Add a packet or flow record. Infers the flow direction from the local network and maps
+ *	source/destination onto local/remote such that both directions of a connection share one flow.
+ *
+ *	\param rec Packet or flow record
+ *
+ *	\exception std::string Errormessage
+ */
+void CFlowAssembler::add_record(const record_t & rec) {
+	if (flushed)
+		throw string("CFlowAssembler::add_record(): assembler has already been flushed");
+
+	cflow_t flow;
+	make_flow(rec, local_nets, flow);
+	stats.records++;
+	stats.packets += rec.dPkts;
+	if (predicate != NULL && !predicate->accept(flow))
+		return;
+
+	HashKeyIPv6_5T key(flow.localIP, flow.remoteIP, flow.localPort, flow.remotePort, flow.prot);
+	uint32_t hash = hashlittle(&key.getkey(), key.size(), 0);
+	// Low hash bits index the shard tables, use the high bits to select the shard
+	shards[(hash >> 16) % shards.size()]->push(flow, hash);
+}
+
+/**
+ *	Set an import predicate: records whose flow is not accepted are dropped before they are merged.
+ *	The predicate counts the accepted and skipped records.
+ *
+ *	\param predicate Predicate (NULL: accept all records), has to outlive the assembler
+ */
+void CFlowAssembler::set_predicate(CFlowPredicate * predicate) {
+	this->predicate = predicate;
+}
+
+/**
+ *	Export all flows still open and collect the statistics. No records may be added afterwards.
+ */
+void CFlowAssembler::flush() {
+	if (flushed)
+		return;
+	flushed = true;
+	for (std::vector<CShard *>::iterator it = shards.begin(); it != shards.end(); ++it) {
+		(*it)->finish();
+	}
+	for (std::vector<CShard *>::iterator it = shards.begin(); it != shards.end(); ++it) {
+		CShard * shard = *it;
+		if (!shard->exported.empty()) {
+			flowlist.insert(flowlist.end(), shard->exported.begin(), shard->exported.end());
+			CFlowList().swap(shard->exported);
+		}
+		stats.flows += shard->flows;
+		stats.active_timeouts += shard->active_timeouts;
+		stats.idle_timeouts += shard->idle_timeouts;
+		stats.peak_open_flows += shard->peak;
+	}
+}
+
+/**
+ *	Get assembler statistics. Flow and timeout counters are valid after flush() only.
+ *
+ *	\return Statistics
+ */
+const CFlowAssembler::stats_t & CFlowAssembler::get_stats() const {
+	return stats;
+}
+
+/**
+ *	Get the number of threads the input filters use for flow assembly.
+ *
+ *	\return Number of hardware threads (at least 1, at most 8)
+ */
+unsigned int CFlowAssembler::get_default_threads() {
+	unsigned int threads = boost::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	return min(threads, max_default_threads);
+}
@@ -0,0 +1,102 @@
+#ifndef GFLOWASSEMBLER_H_
+#define GFLOWASSEMBLER_H_
+
+/**
+ *	\file gflowassembler.h
+ *	\brief Assembles packets and flow records into (bi)flows; shared by the input filters.
+ */
+
+#include <stdint.h>
+#include <vector>
+
+#include "cflow.h"
+#include "IPv6_addr.h"
+#include "glocalnets.h"
+#include "gflowpredicate.h"
+
+/**
+ *	\class	CFlowAssembler
+ *	\brief	CFlowAssembler merges packets or flow records sharing the same local/remote 5-tuple into
+ *				a single flow and pairs opposite directions into biflows.
+ *
+ *				Open flows are kept in flat open addressing hash tables. The tables are sharded by the
+ *				5-tuple hash; with more than one thread each shard is served by a worker thread of its own.
+ *				A flow is exported to the flow list as soon as its active timeout (flow lasts too long) or its
+ *				idle timeout (no packet seen for too long) expires. Timeouts are evaluated against the record
+ *				timestamps, not the wall clock. A timeout of 0 disables it. All flows still open are exported
+ *				by flush().
+ *
+ *				The exported flow list is neither sorted nor are uniflows qualified (see CImport).
+ */
+class CFlowAssembler {
+	public:
+		/**
+		 *	\struct	record_t
+		 *	\brief	A single packet or flow record in source/destination view as delivered by an input filter
+		 */
+		struct record_t {
+				IPv6_addr srcIP; ///< Source IP address
+				IPv6_addr dstIP; ///< Destination IP address
+				uint64_t startMs; ///< Start time in milliseconds since the epoch
+				uint64_t endMs; ///< End time in milliseconds since the epoch (equals startMs for packets)
+				uint64_t dOctets; ///< Layer 3 bytes
+				uint32_t dPkts; ///< Packets
+				uint16_t srcPort; ///< Source port
+				uint16_t dstPort; ///< Destination port
+				uint8_t prot; ///< Protocol number
+				uint8_t tos_flags; ///< ToS flags
+				bool bidir; ///< Record covers both directions already (e.g. RFC 5103 biflow record)
+
+				record_t();
+		};
+
+		/**
+		 *	\struct	stats_t
+		 *	\brief	Assembler statistics
+		 */
+		struct stats_t {
+				uint64_t records; ///< Packets/records fed into the assembler
+				uint64_t packets; ///< Sum of the packet counters of all records
+				uint64_t flows; ///< Flows exported
+				uint64_t active_timeouts; ///< Flows exported due to the active timeout
+				uint64_t idle_timeouts; ///< Flows exported due to the idle timeout
+				uint64_t peak_open_flows; ///< Sum of the per shard maxima of concurrently open flows
+
+				stats_t();
+		};
+
+		static const uint64_t default_active_timeout = 1800000; ///< 30 minutes
+		static const uint64_t default_idle_timeout = 300000; ///< 5 minutes
+
+		CFlowAssembler(CFlowList & flowlist, const CLocalNets & local_nets, unsigned int threads = 1, uint64_t activeTimeoutMs =
+		      default_active_timeout, uint64_t idleTimeoutMs = default_idle_timeout);
+		CFlowAssembler(CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, unsigned int threads = 1,
+		      uint64_t activeTimeoutMs = default_active_timeout, uint64_t idleTimeoutMs = default_idle_timeout);
+		~CFlowAssembler();
+
+		void add_packet(const IPv6_addr & srcIP, const IPv6_addr & dstIP, uint16_t srcPort, uint16_t dstPort, uint8_t prot, uint64_t timeMs,
+		      uint64_t bytes, uint8_t tos_flags = 0);
+		void add_record(const record_t & rec);
+		void flush();
+
+		void set_predicate(CFlowPredicate * predicate);
+		const stats_t & get_stats() const;
+		static unsigned int get_default_threads();
+		static void make_flow(const record_t & rec, const CLocalNets & local_nets, cflow_t & flow);
+
+	private:
+		class CShard;
+
+		CFlowAssembler(const CFlowAssembler &);
+		CFlowAssembler & operator=(const CFlowAssembler &);
+		void create_shards(unsigned int threads, uint64_t activeTimeoutMs, uint64_t idleTimeoutMs);
+
+		CFlowList & flowlist; ///< Flow list receiving the exported flows
+		CLocalNets local_nets; ///< Local networks used to infer flow directions
+		CFlowPredicate * predicate; ///< Import predicate records have to fulfill (NULL: none)
+		std::vector<CShard *> shards; ///< Shards holding the open flows
+		bool flushed; ///< True after flush() has been called
+		stats_t stats; ///< Statistics, complete after flush()
+};
+
+#endif /* GFLOWASSEMBLER_H_ */
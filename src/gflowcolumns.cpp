@@ -0,0 +1,171 @@
+/**
+ *	\file gflowcolumns.cpp
+ *	\brief Columnar (structure of arrays) view of a flow list.
+ */
+
+#include "gflowcolumns.h"
+
+using namespace std;
+
+const uint32_t CFlowColumns::no_id;
+
+/**
+ *	Constructor: copy the scanned members of a range of flows into columns.
+ *
+ *	\param begin First flow
+ *	\param end Behind last flow
+ *	\param dictionary Address ids to use, has to contain all addresses of the flows (NULL: build a dictionary of the range)
+ */
+CFlowColumns::CFlowColumns(CFlowList::const_iterator begin, CFlowList::const_iterator end, boost::shared_ptr<const CIPDictionary> dictionary) :
+	dictionary(dictionary) {
+	if (!this->dictionary)
+		this->dictionary.reset(new CIPDictionary(begin, end));
+
+	size_t n = end - begin;
+	localIP_col.reserve(n);
+	remoteIP_col.reserve(n);
+	localPort_col.reserve(n);
+	remotePort_col.reserve(n);
+	prot_col.reserve(n);
+	flowtype_col.reserve(n);
+	dOctets_col.reserve(n);
+	dPkts_col.reserve(n);
+	startMs_col.reserve(n);
+
+	this->dictionary->encode(begin, end, localIP_col, remoteIP_col);
+	for (CFlowList::const_iterator it = begin; it != end; ++it) {
+		localPort_col.push_back(it->localPort);
+		remotePort_col.push_back(it->remotePort);
+		prot_col.push_back(it->prot);
+		flowtype_col.push_back(it->flowtype);
+		dOctets_col.push_back(it->dOctets);
+		dPkts_col.push_back(it->dPkts);
+		startMs_col.push_back(it->startMs);
+	}
+}
+
+/**
+ *	Get number of flows.
+ *
+ *	\return Number of flows
+ */
+size_t CFlowColumns::size() const {
+	return flowtype_col.size();
+}
+
+/**
+ *	Get the memory held by the columns. A dictionary shared with other columns is not included.
+ *
+ *	\return Bytes
+ */
+uint64_t CFlowColumns::get_memory_size() const {
+	uint64_t size = sizeof(*this) + (uint64_t) localIP_col.capacity() * sizeof(uint32_t) + (uint64_t) remoteIP_col.capacity() * sizeof(uint32_t)
+	      + (uint64_t) localPort_col.capacity() * sizeof(uint16_t) + (uint64_t) remotePort_col.capacity() * sizeof(uint16_t)
+	      + (uint64_t) prot_col.capacity() * sizeof(uint8_t) + (uint64_t) flowtype_col.capacity() * sizeof(uint8_t)
+	      + (uint64_t) dOctets_col.capacity() * sizeof(uint64_t) + (uint64_t) dPkts_col.capacity() * sizeof(uint32_t)
+	      + (uint64_t) startMs_col.capacity() * sizeof(uint64_t);
+	if (dictionary.use_count() == 1)
+		size += dictionary->size() * (sizeof(IPv6_addr) + 2 * sizeof(uint32_t)); // Own dictionary: addresses and id table (half full)
+	return size;
+}
+
+/**
+ *	Get number of addresses of the dictionary (ids are 0 .. ip_count()-1).
+ *
+ *	\return Number of addresses
+ */
+size_t CFlowColumns::ip_count() const {
+	return dictionary->size();
+}
+
+/**
+ *	Get address of an id.
+ *
+ *	\param id Address id
+ *
+ *	\return Address
+ */
+const IPv6_addr & CFlowColumns::get_IP(uint32_t id) const {
+	return dictionary->get_IP(id);
+}
+
+/**
+ *	Get id of an address.
+ *
+ *	\param IP Address
+ *
+ *	\return Id or no_id if the address does not occur in the flows
+ */
+uint32_t CFlowColumns::find_id(const IPv6_addr & IP) const {
+	return dictionary->find_id(IP);
+}
+
+/**
+ *	\return Dictionary of the address ids
+ */
+const CIPDictionary & CFlowColumns::get_dictionary() const {
+	return *dictionary;
+}
+
+/**
+ *	\return Local address ids (size() elements)
+ */
+const uint32_t * CFlowColumns::localIP_ids() const {
+	return localIP_col.empty() ? NULL : &localIP_col[0];
+}
+
+/**
+ *	\return Remote address ids (size() elements)
+ */
+const uint32_t * CFlowColumns::remoteIP_ids() const {
+	return remoteIP_col.empty() ? NULL : &remoteIP_col[0];
+}
+
+/**
+ *	\return Local ports (size() elements)
+ */
+const uint16_t * CFlowColumns::localPorts() const {
+	return localPort_col.empty() ? NULL : &localPort_col[0];
+}
+
+/**
+ *	\return Remote ports (size() elements)
+ */
+const uint16_t * CFlowColumns::remotePorts() const {
+	return remotePort_col.empty() ? NULL : &remotePort_col[0];
+}
+
+/**
+ *	\return Protocols (size() elements)
+ */
+const uint8_t * CFlowColumns::prots() const {
+	return prot_col.empty() ? NULL : &prot_col[0];
+}
+
+/**
+ *	\return Flow types (size() elements)
+ */
+const uint8_t * CFlowColumns::flowtypes() const {
+	return flowtype_col.empty() ? NULL : &flowtype_col[0];
+}
+
+/**
+ *	\return Bytes (size() elements)
+ */
+const uint64_t * CFlowColumns::dOctets() const {
+	return dOctets_col.empty() ? NULL : &dOctets_col[0];
+}
+
+/**
+ *	\return Packets (size() elements)
+ */
+const uint32_t * CFlowColumns::dPkts() const {
+	return dPkts_col.empty() ? NULL : &dPkts_col[0];
+}
+
+/**
+ *	\return Start times in milliseconds since the epoch (size() elements)
+ */
+const uint64_t * CFlowColumns::startMs() const {
+	return startMs_col.empty() ? NULL : &startMs_col[0];
+}
@@ -0,0 +1,65 @@
+#ifndef GFLOWCOLUMNS_H_
+#define GFLOWCOLUMNS_H_
+
+/**
+ *	\file gflowcolumns.h
+ *	\brief Columnar (structure of arrays) view of a flow list.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "cflow.h"
+#include "IPv6_addr.h"
+#include "gipdictionary.h"
+
+/**
+ *	\class	CFlowColumns
+ *	\brief	CFlowColumns holds the members of a range of flows used by scans (role identification,
+ *				filtering) in separate arrays.
+ *
+ *	A scan reading only a few members of each flow then walks sequentially through a few dense
+ *	arrays instead of touching every flow record. IP addresses are replaced by their ids in a
+ *	CIPDictionary: columns built with the same dictionary (e.g. the data set dictionary of CImport)
+ *	share the id space, otherwise the columns build their own. Index i of every column belongs to flow i of the range the columns have
+ *	been built from. The columns are a snapshot: they have to be rebuilt if the flows change.
+ */
+class CFlowColumns {
+	public:
+		static const uint32_t no_id = CIPDictionary::no_id; ///< Returned by find_id() for unknown addresses
+
+		CFlowColumns(CFlowList::const_iterator begin, CFlowList::const_iterator end, boost::shared_ptr<const CIPDictionary> dictionary =
+		      boost::shared_ptr<const CIPDictionary>());
+
+		size_t size() const;
+		uint64_t get_memory_size() const;
+		size_t ip_count() const;
+		const IPv6_addr & get_IP(uint32_t id) const;
+		uint32_t find_id(const IPv6_addr & IP) const;
+		const CIPDictionary & get_dictionary() const;
+
+		const uint32_t * localIP_ids() const;
+		const uint32_t * remoteIP_ids() const;
+		const uint16_t * localPorts() const;
+		const uint16_t * remotePorts() const;
+		const uint8_t * prots() const;
+		const uint8_t * flowtypes() const;
+		const uint64_t * dOctets() const;
+		const uint32_t * dPkts() const;
+		const uint64_t * startMs() const;
+
+	private:
+		boost::shared_ptr<const CIPDictionary> dictionary; ///< Address ids
+		std::vector<uint32_t> localIP_col; ///< Local address ids
+		std::vector<uint32_t> remoteIP_col; ///< Remote address ids
+		std::vector<uint16_t> localPort_col; ///< Local ports
+		std::vector<uint16_t> remotePort_col; ///< Remote ports
+		std::vector<uint8_t> prot_col; ///< Protocols
+		std::vector<uint8_t> flowtype_col; ///< Flow types
+		std::vector<uint64_t> dOctets_col; ///< Bytes
+		std::vector<uint32_t> dPkts_col; ///< Packets
+		std::vector<uint64_t> startMs_col; ///< Start times
+};
+
+#endif /* GFLOWCOLUMNS_H_ */
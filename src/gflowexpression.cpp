@@ -0,0 +1,729 @@
+/**
+ *	\file gflowexpression.cpp
+ *	\brief Flow filter expressions (nfdump-like syntax) compiled for batch evaluation over flow columns.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+#include "gflowexpression.h"
+#include "gutil.h"
+
+using namespace std;
+
+const size_t CFlowExpression::batch_size;
+
+namespace {
+	/**
+	 *	\struct	bits_set
+	 *	\brief	Comparison functor: true if a value has any of the bits of a mask set
+	 */
+	struct bits_set {
+			bool operator()(uint64_t value, uint64_t bits) const {
+				return (value & bits) != 0;
+			}
+	};
+
+	/**
+	 *	Compare a column to a value and store the results as bits (bit b of out[w]: flow w*64+b).
+	 *
+	 *	\param column First value of the batch
+	 *	\param count Number of values
+	 *	\param value Value to compare to
+	 *	\param cmp Comparison functor
+	 *	\param out Bit mask ((count+63)/64 words)
+	 */
+	template<typename T, typename Cmp>
+	void compare_column(const T * column, size_t count, uint64_t value, Cmp cmp, uint64_t * out) {
+		for (size_t w = 0; w * 64 < count; w++) {
+			const T * values = column + w * 64;
+			size_t end = min<size_t>(64, count - w * 64);
+			uint64_t bits = 0;
+			for (size_t b = 0; b < end; b++)
+				bits |= (uint64_t) cmp((uint64_t) values[b], value) << b;
+			out[w] = bits;
+		}
+	}
+
+	/**
+	 *	Check the addresses given by a column of address ids against a prefix set and store the results as bits.
+	 *	Results are memorized per address id, so each address is looked up once per evaluation.
+	 *
+	 *	\param columns Flow columns (address dictionary)
+	 *	\param ids First address id of the batch
+	 *	\param count Number of ids
+	 *	\param nets Prefix set
+	 *	\param table Results per address id (0: not looked up yet, 1: not covered, 2: covered)
+	 *	\param out Bit mask ((count+63)/64 words)
+	 */
+	void lookup_column(const CFlowColumns & columns, const uint32_t * ids, size_t count, const CLocalNets & nets, vector<uint8_t> & table,
+	      uint64_t * out) {
+		for (size_t w = 0; w * 64 < count; w++) {
+			const uint32_t * values = ids + w * 64;
+			size_t end = min<size_t>(64, count - w * 64);
+			uint64_t bits = 0;
+			for (size_t b = 0; b < end; b++) {
+				uint8_t & match = table[values[b]];
+				if (match == 0)
+					match = nets.is_local(columns.get_IP(values[b])) ? 2 : 1;
+				bits |= (uint64_t) (match >> 1) << b;
+			}
+			out[w] = bits;
+		}
+	}
+
+	/**
+	 *	Check the addresses given by a column of address ids against a prefix set and store the results as bits.
+	 *
+	 *	\param columns Flow columns (address dictionary)
+	 *	\param ids First address id of the batch
+	 *	\param count Number of ids
+	 *	\param nets Prefix set
+	 *	\param out Bit mask ((count+63)/64 words)
+	 */
+	void lookup_column(const CFlowColumns & columns, const uint32_t * ids, size_t count, const CLocalNets & nets, uint64_t * out) {
+		for (size_t w = 0; w * 64 < count; w++) {
+			const uint32_t * values = ids + w * 64;
+			size_t end = min<size_t>(64, count - w * 64);
+			uint64_t bits = 0;
+			for (size_t b = 0; b < end; b++)
+				bits |= (uint64_t) nets.is_local(columns.get_IP(values[b])) << b;
+			out[w] = bits;
+		}
+	}
+}
+
+/**
+ *	Compare a column to a value and store the results as bits.
+ *
+ *	\param column First value of the batch
+ *	\param count Number of values
+ *	\param cmp Comparison
+ *	\param value Value to compare to
+ *	\param out Bit mask ((count+63)/64 words)
+ */
+template<typename T>
+void CFlowExpression::compare(const T * column, size_t count, cmp_t cmp, uint64_t value, uint64_t * out) {
+	switch (cmp) {
+		case cmp_eq:
+			compare_column(column, count, value, equal_to<uint64_t> (), out);
+			break;
+		case cmp_ne:
+			compare_column(column, count, value, not_equal_to<uint64_t> (), out);
+			break;
+		case cmp_lt:
+			compare_column(column, count, value, less<uint64_t> (), out);
+			break;
+		case cmp_le:
+			compare_column(column, count, value, less_equal<uint64_t> (), out);
+			break;
+		case cmp_gt:
+			compare_column(column, count, value, greater<uint64_t> (), out);
+			break;
+		case cmp_ge:
+			compare_column(column, count, value, greater_equal<uint64_t> (), out);
+			break;
+	}
+}
+
+//*** CFlowExpression::CParser ************************************************
+
+/**
+ *	\class	CFlowExpression::CParser
+ *	\brief	Recursive descent parser emitting the postfix program of a CFlowExpression
+ */
+class CFlowExpression::CParser {
+	public:
+		CParser(CFlowExpression & expr);
+		void parse();
+
+	private:
+		void tokenize();
+		void parse_or();
+		void parse_and();
+		void parse_unary();
+		void parse_primitive();
+		side_t parse_side();
+		cmp_t parse_cmp();
+		uint64_t parse_number(bool scaled);
+		bool accept(const char * word);
+		const string & next();
+		void error(const string & msg) const;
+		void emit(opcode_t op, uint64_t value = 0);
+
+		CFlowExpression & expr; ///< Expression to compile into
+		vector<string> tokens; ///< Tokens of the source text
+		size_t pos; ///< Current token
+};
+
+/**
+ *	Constructor
+ *
+ *	\param expr Expression holding the source text, receives the program
+ */
+CFlowExpression::CParser::CParser(CFlowExpression & expr) :
+	expr(expr), pos(0) {
+}
+
+/**
+ *	Compile the source text.
+ *
+ *	\exception std::string Errortext
+ */
+void CFlowExpression::CParser::parse() {
+	tokenize();
+	if (tokens.empty())
+		return;
+	parse_or();
+	if (pos != tokens.size())
+		error("unexpected \"" + tokens[pos] + "\"");
+}
+
+/**
+ *	Split the source text into words, parentheses and operators.
+ */
+void CFlowExpression::CParser::tokenize() {
+	static const string op_chars = "<>=!";
+	const string & s = expr.expression;
+	size_t i = 0;
+	while (i < s.size()) {
+		if (isspace((unsigned char) s[i])) {
+			i++;
+		} else if (s[i] == '(' || s[i] == ')') {
+			tokens.push_back(s.substr(i++, 1));
+		} else if (s[i] == '&' || s[i] == '|') {
+			size_t end = s.find_first_not_of(s[i], i);
+			tokens.push_back(s.substr(i, end - i));
+			i = end;
+		} else if (op_chars.find(s[i]) != string::npos) {
+			size_t end = s.find_first_not_of(op_chars, i);
+			tokens.push_back(s.substr(i, end - i));
+			i = end;
+		} else {
+			size_t end = i;
+			while (end < s.size() && !isspace((unsigned char) s[end]) && string("()&|").find(s[end]) == string::npos && op_chars.find(s[end])
+			      == string::npos)
+				end++;
+			string word = s.substr(i, end - i);
+			transform(word.begin(), word.end(), word.begin(), ::tolower);
+			tokens.push_back(word);
+			i = end;
+		}
+	}
+}
+
+/**
+ *	expr: and_expr ("or" and_expr)*
+ */
+void CFlowExpression::CParser::parse_or() {
+	parse_and();
+	while (accept("or") || accept("||")) {
+		parse_and();
+		emit(op_or);
+	}
+}
+
+/**
+ *	and_expr: unary ("and" unary)*
+ */
+void CFlowExpression::CParser::parse_and() {
+	parse_unary();
+	while (accept("and") || accept("&&")) {
+		parse_unary();
+		emit(op_and);
+	}
+}
+
+/**
+ *	unary: "not" unary | "(" expr ")" | primitive
+ */
+void CFlowExpression::CParser::parse_unary() {
+	if (accept("not") || accept("!")) {
+		parse_unary();
+		emit(op_not);
+	} else if (accept("(")) {
+		parse_or();
+		if (!accept(")"))
+			error("missing \")\"");
+	} else {
+		parse_primitive();
+	}
+}
+
+/**
+ *	primitive: see CFlowExpression
+ */
+void CFlowExpression::CParser::parse_primitive() {
+	if (accept("any")) {
+		emit(op_true);
+		return;
+	}
+	if (accept("proto")) {
+		const string & name = next();
+		int prot = util::stringToIpProtocol(name);
+		if (prot < 0)
+			error("unknown protocol \"" + name + "\"");
+		emit(op_prot, prot);
+		return;
+	}
+	if (pos < tokens.size()) {
+		int prot = util::stringToIpProtocol(tokens[pos]);
+		if (prot >= 0 && !isdigit((unsigned char) tokens[pos][0])) {
+			pos++;
+			emit(op_prot, prot);
+			return;
+		}
+	}
+	static const char * flowtype_names[] = { "outflow", "inflow", "uniflow", "biflow", "unibiflow" };
+	static const uint8_t flowtype_bits[] = { outflow, inflow, uniflow, biflow, unibiflow };
+	for (size_t i = 0; i < sizeof(flowtype_bits) / sizeof(flowtype_bits[0]); i++) {
+		if (accept(flowtype_names[i])) {
+			emit(op_flowtype, flowtype_bits[i]);
+			return;
+		}
+	}
+	if (accept("bytes")) {
+		cmp_t cmp = parse_cmp();
+		emit(op_bytes, parse_number(true));
+		expr.program.back().cmp = cmp;
+		return;
+	}
+	if (accept("packets") || accept("pkts")) {
+		cmp_t cmp = parse_cmp();
+		emit(op_packets, parse_number(true));
+		expr.program.back().cmp = cmp;
+		return;
+	}
+
+	side_t side = parse_side();
+	if (accept("port")) {
+		cmp_t cmp = parse_cmp();
+		uint64_t port = parse_number(false);
+		if (port > 65535)
+			error("invalid port " + tokens[pos - 1]);
+		emit(op_port, port);
+		expr.program.back().cmp = cmp;
+	} else if (accept("host") || accept("ip")) {
+		const string & addr = next();
+		IPv6_addr IP;
+		try {
+			IP = addr;
+		} catch (string &) {
+			error("invalid address \"" + addr + "\"");
+		}
+		emit(op_host);
+		expr.program.back().IP = IP;
+	} else if (accept("net")) {
+		const string & prefix = next();
+		CLocalNets net;
+		try {
+			net.add(prefix);
+		} catch (string &) {
+			error("invalid prefix \"" + prefix + "\"");
+		}
+		expr.nets.push_back(net);
+		emit(op_net);
+		expr.program.back().net = expr.nets.size() - 1;
+	} else {
+		error(pos < tokens.size() ? "unexpected \"" + tokens[pos] + "\"" : "unexpected end");
+	}
+	expr.program.back().side = side;
+}
+
+/**
+ *	side: ["local" | "remote" | "src" | "dst"]
+ *
+ *	\return Side (side_any if none given)
+ */
+CFlowExpression::side_t CFlowExpression::CParser::parse_side() {
+	if (accept("local"))
+		return side_local;
+	if (accept("remote"))
+		return side_remote;
+	if (accept("src"))
+		return side_src;
+	if (accept("dst"))
+		return side_dst;
+	return side_any;
+}
+
+/**
+ *	cmp: ["=" | "==" | "eq" | "!=" | "ne" | "<" | "lt" | "<=" | "le" | ">" | "gt" | ">=" | "ge"]
+ *
+ *	\return Comparison (cmp_eq if none given)
+ */
+CFlowExpression::cmp_t CFlowExpression::CParser::parse_cmp() {
+	if (accept("=") || accept("==") || accept("eq"))
+		return cmp_eq;
+	if (accept("!=") || accept("ne"))
+		return cmp_ne;
+	if (accept("<") || accept("lt"))
+		return cmp_lt;
+	if (accept("<=") || accept("le"))
+		return cmp_le;
+	if (accept(">") || accept("gt"))
+		return cmp_gt;
+	if (accept(">=") || accept("ge"))
+		return cmp_ge;
+	return cmp_eq;
+}
+
+/**
+ *	Parse a decimal number.
+ *
+ *	\param scaled Accept a k, M or G suffix (10^3, 10^6, 10^9)
+ *
+ *	\return Number
+ */
+uint64_t CFlowExpression::CParser::parse_number(bool scaled) {
+	const string & word = next();
+	size_t digits = min(word.find_first_not_of("0123456789"), word.size());
+	string suffix = word.substr(digits);
+	if (digits == 0 || digits > 18 || suffix.size() > 1 || (!suffix.empty() && !scaled))
+		error("invalid number \"" + word + "\"");
+	uint64_t number = strtoull(word.c_str(), NULL, 10);
+	if (suffix == "k")
+		number *= 1000;
+	else if (suffix == "m")
+		number *= 1000000;
+	else if (suffix == "g")
+		number *= 1000000000;
+	else if (!suffix.empty())
+		error("invalid number \"" + word + "\"");
+	return number;
+}
+
+/**
+ *	Consume the current token if it equals a word.
+ *
+ *	\param word Word (lower case)
+ *
+ *	\return True if the token has been consumed
+ */
+bool CFlowExpression::CParser::accept(const char * word) {
+	if (pos < tokens.size() && tokens[pos] == word) {
+		pos++;
+		return true;
+	}
+	return false;
+}
+
+/**
+ *	Consume the current token.
+ *
+ *	\return Token
+ *
+ *	\exception std::string Errortext (no token left)
+ */
+const string & CFlowExpression::CParser::next() {
+	if (pos >= tokens.size())
+		error("unexpected end");
+	return tokens[pos++];
+}
+
+/**
+ *	\exception std::string Errortext
+ */
+void CFlowExpression::CParser::error(const string & msg) const {
+	throw "ERROR: filter expression \"" + expr.expression + "\": " + msg + ".";
+}
+
+/**
+ *	Append an instruction to the program.
+ *
+ *	\param op Instruction type
+ *	\param value Instruction value
+ */
+void CFlowExpression::CParser::emit(opcode_t op, uint64_t value) {
+	instr_t instr;
+	instr.op = op;
+	instr.side = side_any;
+	instr.cmp = cmp_eq;
+	instr.value = value;
+	instr.net = 0;
+	expr.program.push_back(instr);
+}
+
+//*** CFlowExpression *********************************************************
+
+/**
+ *	Constructor: empty expression (matches every flow)
+ */
+CFlowExpression::CFlowExpression() :
+	max_depth(0) {
+}
+
+/**
+ *	Constructor: compile an expression.
+ *
+ *	\param expression Source text
+ *
+ *	\exception std::string Errortext
+ */
+CFlowExpression::CFlowExpression(const string & expression) :
+	max_depth(0) {
+	compile(expression);
+}
+
+/**
+ *	Compile an expression, replacing the current one. An empty text matches every flow.
+ *
+ *	\param expression Source text
+ *
+ *	\exception std::string Errortext (the expression is left empty)
+ */
+void CFlowExpression::compile(const string & expression) {
+	this->expression = expression;
+	program.clear();
+	nets.clear();
+	max_depth = 0;
+	try {
+		CParser parser(*this);
+		parser.parse();
+	} catch (string &) {
+		this->expression.clear();
+		program.clear();
+		nets.clear();
+		throw;
+	}
+
+	size_t depth = 0;
+	for (vector<instr_t>::const_iterator it = program.begin(); it != program.end(); ++it) {
+		if (it->op == op_and || it->op == op_or)
+			depth--;
+		else if (it->op != op_not)
+			depth++;
+		max_depth = max(max_depth, depth);
+	}
+}
+
+/**
+ *	\return Source text of the expression
+ */
+const string & CFlowExpression::get_expression() const {
+	return expression;
+}
+
+/**
+ *	\return True if the expression is empty (matches every flow)
+ */
+bool CFlowExpression::matches_all() const {
+	return program.empty();
+}
+
+/**
+ *	Returns the compiled program in postfix order (for debugging)
+ *
+ *	\return string Program
+ */
+string CFlowExpression::toString() const {
+	static const char * sides[] = { "", "local ", "remote ", "src ", "dst " };
+	static const char * cmps[] = { "=", "!=", "<", "<=", ">", ">=" };
+	stringstream ss;
+	for (vector<instr_t>::const_iterator it = program.begin(); it != program.end(); ++it) {
+		if (it != program.begin())
+			ss << ", ";
+		switch (it->op) {
+			case op_true:
+				ss << "any";
+				break;
+			case op_prot:
+				ss << "proto " << it->value;
+				break;
+			case op_flowtype:
+				ss << "flowtype & " << it->value;
+				break;
+			case op_port:
+				ss << sides[it->side] << "port " << cmps[it->cmp] << " " << it->value;
+				break;
+			case op_host:
+				ss << sides[it->side] << "host " << it->IP;
+				break;
+			case op_net:
+				ss << sides[it->side] << "net " << nets[it->net].toString();
+				break;
+			case op_bytes:
+				ss << "bytes " << cmps[it->cmp] << " " << it->value;
+				break;
+			case op_packets:
+				ss << "packets " << cmps[it->cmp] << " " << it->value;
+				break;
+			case op_and:
+				ss << "and";
+				break;
+			case op_or:
+				ss << "or";
+				break;
+			case op_not:
+				ss << "not";
+				break;
+		}
+	}
+	return ss.str();
+}
+
+/**
+ *	Evaluate the expression for all flows of a columnar view.
+ *
+ *	\param columns Flows
+ *	\param mask Bit mask (out): bit i%64 of mask[i/64] is set if flow i matches (see test())
+ */
+void CFlowExpression::evaluate(const CFlowColumns & columns, vector<uint64_t> & mask) const {
+	size_t n = columns.size();
+	mask.assign((n + 63) / 64, 0);
+	if (n == 0)
+		return;
+	if (program.empty()) {
+		fill(mask.begin(), mask.end(), ~(uint64_t) 0);
+	} else {
+		// Memorize prefix matches per address id unless the dictionary is much larger than the flows
+		// (e.g. the columns of a single graphlet sharing the dictionary of the data set)
+		vector<vector<uint8_t> > net_tables(nets.size());
+		if (columns.ip_count() <= 4 * n) {
+			for (size_t i = 0; i < nets.size(); i++)
+				net_tables[i].resize(columns.ip_count());
+		}
+
+		const size_t words = batch_size / 64;
+		vector<uint64_t> stack(max_depth * words);
+		vector<uint64_t> scratch(2 * words);
+		for (size_t first = 0; first < n; first += batch_size) {
+			size_t count = min(batch_size, n - first);
+			size_t count_words = (count + 63) / 64;
+			uint64_t * top = &stack[0]; // next free stack entry
+			for (vector<instr_t>::const_iterator it = program.begin(); it != program.end(); ++it) {
+				switch (it->op) {
+					case op_and: {
+						top -= words;
+						uint64_t * left = top - words;
+						for (size_t w = 0; w < count_words; w++)
+							left[w] &= top[w];
+						break;
+					}
+					case op_or: {
+						top -= words;
+						uint64_t * left = top - words;
+						for (size_t w = 0; w < count_words; w++)
+							left[w] |= top[w];
+						break;
+					}
+					case op_not: {
+						uint64_t * operand = top - words;
+						for (size_t w = 0; w < count_words; w++)
+							operand[w] = ~operand[w];
+						break;
+					}
+					default:
+						run_leaf(*it, columns, net_tables, first, count, top, &scratch[0]);
+						top += words;
+						break;
+				}
+			}
+			copy(stack.begin(), stack.begin() + count_words, mask.begin() + first / 64);
+		}
+	}
+	if (n % 64 != 0)
+		mask.back() &= (~(uint64_t) 0) >> (64 - n % 64);
+}
+
+/**
+ *	Evaluate an address or port condition for one side of the flows of a batch.
+ *
+ *	\param instr Instruction (op_port, op_host or op_net)
+ *	\param columns Flows
+ *	\param net_tables Prefix matches per address id (empty tables: no memorization)
+ *	\param first First flow of the batch
+ *	\param count Number of flows of the batch
+ *	\param remote Evaluate for the remote side (otherwise the local side)
+ *	\param out Bit mask
+ */
+void CFlowExpression::run_side(const instr_t & instr, const CFlowColumns & columns, vector<vector<uint8_t> > & net_tables, size_t first,
+      size_t count, bool remote, uint64_t * out) const {
+	const uint32_t * ids = (remote ? columns.remoteIP_ids() : columns.localIP_ids()) + first;
+	switch (instr.op) {
+		case op_port:
+			compare((remote ? columns.remotePorts() : columns.localPorts()) + first, count, instr.cmp, instr.value, out);
+			break;
+		case op_host: {
+			uint32_t id = columns.find_id(instr.IP);
+			if (id == CFlowColumns::no_id)
+				fill(out, out + (count + 63) / 64, 0);
+			else
+				compare(ids, count, cmp_eq, id, out);
+			break;
+		}
+		case op_net:
+			if (net_tables[instr.net].empty())
+				lookup_column(columns, ids, count, nets[instr.net], out);
+			else
+				lookup_column(columns, ids, count, nets[instr.net], net_tables[instr.net], out);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ *	Evaluate a condition (any instruction except op_and, op_or and op_not) for the flows of a batch.
+ *
+ *	\param instr Instruction
+ *	\param columns Flows
+ *	\param net_tables Prefix matches per address id (empty tables: no memorization)
+ *	\param first First flow of the batch
+ *	\param count Number of flows of the batch
+ *	\param out Bit mask
+ *	\param scratch Temporary bit masks (2 * batch_size / 64 words)
+ */
+void CFlowExpression::run_leaf(const instr_t & instr, const CFlowColumns & columns, vector<vector<uint8_t> > & net_tables, size_t first,
+      size_t count, uint64_t * out, uint64_t * scratch) const {
+	size_t count_words = (count + 63) / 64;
+	switch (instr.op) {
+		case op_true:
+			fill(out, out + count_words, ~(uint64_t) 0);
+			return;
+		case op_prot:
+			compare(columns.prots() + first, count, cmp_eq, instr.value, out);
+			return;
+		case op_flowtype:
+			compare_column(columns.flowtypes() + first, count, instr.value, bits_set(), out);
+			return;
+		case op_bytes:
+			compare(columns.dOctets() + first, count, instr.cmp, instr.value, out);
+			return;
+		case op_packets:
+			compare(columns.dPkts() + first, count, instr.cmp, instr.value, out);
+			return;
+		default:
+			break;
+	}
+
+	// Address and port conditions
+	if (instr.side == side_local) {
+		run_side(instr, columns, net_tables, first, count, false, out);
+		return;
+	}
+	if (instr.side == side_remote) {
+		run_side(instr, columns, net_tables, first, count, true, out);
+		return;
+	}
+	uint64_t * remote = scratch;
+	run_side(instr, columns, net_tables, first, count, false, out);
+	run_side(instr, columns, net_tables, first, count, true, remote);
+	if (instr.side == side_any) {
+		for (size_t w = 0; w < count_words; w++)
+			out[w] |= remote[w];
+		return;
+	}
+
+	// src/dst: the local side is the source of outflows and the destination of inflows, biflows match either side
+	uint64_t * direction = scratch + batch_size / 64;
+	compare_column(columns.flowtypes() + first, count, (instr.side == side_src) ? inflow : outflow, bits_set(), direction);
+	for (size_t w = 0; w < count_words; w++)
+		out[w] &= ~direction[w];
+	compare_column(columns.flowtypes() + first, count, (instr.side == side_src) ? outflow : inflow, bits_set(), direction);
+	for (size_t w = 0; w < count_words; w++)
+		out[w] |= remote[w] & ~direction[w];
+}
@@ -0,0 +1,111 @@
+#ifndef GFLOWEXPRESSION_H_
+#define GFLOWEXPRESSION_H_
+
+/**
+ *	\file gflowexpression.h
+ *	\brief Flow filter expressions (nfdump-like syntax) compiled for batch evaluation over flow columns.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "gflowcolumns.h"
+#include "glocalnets.h"
+
+/**
+ *	\class	CFlowExpression
+ *	\brief	CFlowExpression selects flows by a boolean expression such as
+ *				"proto tcp and dst port 443 and bytes > 1M and not net 10.0.0.0/8".
+ *
+ *	Syntax (keywords are case insensitive):
+ *	- expr: expr "or" expr | expr "and" expr | "not" expr | "(" expr ")" | primitive
+ *				("||", "&&" and "!" are accepted as well; "not" binds stronger than "and", "and" stronger than "or")
+ *	- primitive:
+ *		- "any": every flow
+ *		- "proto" name|number, or just tcp, udp, icmp, icmp6, gre, esp
+ *		- biflow, uniflow, inflow, outflow, unibiflow: flow type
+ *		- [side] "port" [cmp] number
+ *		- [side] "host" address, [side] "net" prefix (CIDR notation)
+ *		- "bytes" [cmp] number, "packets" [cmp] number (numbers may carry a k, M or G suffix: 10^3, 10^6, 10^9)
+ *	- side: "local", "remote", "src", "dst" (default: local or remote)
+ *	- cmp: "=", "==", "!=", "<", "<=", ">", ">=" or "eq", "ne", "lt", "le", "gt", "ge" (default: "=")
+ *
+ *	Flows store a local and a remote side. For "src" and "dst" the side is taken from the flow type:
+ *	the source of an outflow is its local side, the source of an inflow its remote side. Biflows do not record
+ *	which side initiated them, so "src"/"dst" conditions match either side of a biflow.
+ *
+ *	The expression is compiled into a postfix program once. evaluate() runs the program over batches of
+ *	batch_size flows of a CFlowColumns view: each instruction turns one column into a bit mask (one bit per flow)
+ *	or combines masks, so the inner loops are tight loops over dense arrays.
+ */
+class CFlowExpression {
+	public:
+		static const size_t batch_size = 4096; ///< Flows evaluated per instruction pass (multiple of 64)
+
+		CFlowExpression();
+		explicit CFlowExpression(const std::string & expression);
+
+		void compile(const std::string & expression);
+		const std::string & get_expression() const;
+		bool matches_all() const;
+		std::string toString() const;
+
+		void evaluate(const CFlowColumns & columns, std::vector<uint64_t> & mask) const;
+		static bool test(const std::vector<uint64_t> & mask, size_t flow_num);
+
+	private:
+		/// Instruction types
+		enum opcode_t {
+			op_true, op_prot, op_flowtype, op_port, op_host, op_net, op_bytes, op_packets, op_and, op_or, op_not
+		};
+		/// Flow side an address or port condition applies to
+		enum side_t {
+			side_any, side_local, side_remote, side_src, side_dst
+		};
+		/// Comparison of a column value and the instruction value
+		enum cmp_t {
+			cmp_eq, cmp_ne, cmp_lt, cmp_le, cmp_gt, cmp_ge
+		};
+
+		/**
+		 *	\struct	instr_t
+		 *	\brief	Instruction of the postfix program
+		 */
+		struct instr_t {
+				opcode_t op; ///< Instruction type
+				side_t side; ///< Side (op_port, op_host, op_net)
+				cmp_t cmp; ///< Comparison (op_port, op_bytes, op_packets)
+				uint64_t value; ///< Value to compare to (protocol, flow type bits, port, counter)
+				IPv6_addr IP; ///< Address (op_host)
+				size_t net; ///< Index into nets (op_net)
+		};
+
+		class CParser;
+
+		template<typename T>
+		static void compare(const T * column, size_t count, cmp_t cmp, uint64_t value, uint64_t * out);
+		void run_side(const instr_t & instr, const CFlowColumns & columns, std::vector<std::vector<uint8_t> > & net_tables, size_t first,
+		      size_t count, bool remote, uint64_t * out) const;
+		void run_leaf(const instr_t & instr, const CFlowColumns & columns, std::vector<std::vector<uint8_t> > & net_tables,
+		      size_t first, size_t count, uint64_t * out, uint64_t * scratch) const;
+
+		std::string expression; ///< Source text
+		std::vector<instr_t> program; ///< Compiled expression (postfix order)
+		std::vector<CLocalNets> nets; ///< Prefixes of the op_net instructions
+		size_t max_depth; ///< Stack depth needed by the program
+};
+
+/**
+ *	Check the bit of a flow in a mask filled by evaluate().
+ *
+ *	\param mask Bit mask
+ *	\param flow_num Index of the flow
+ *
+ *	\return True if the flow matches the expression
+ */
+inline bool CFlowExpression::test(const std::vector<uint64_t> & mask, size_t flow_num) {
+	return (mask[flow_num / 64] >> (flow_num % 64)) & 1;
+}
+
+#endif /* GFLOWEXPRESSION_H_ */
@@ -0,0 +1,144 @@
+/**
+ *	\file gflowindex.cpp
+ *	\brief Sidecar index (*.hidx) of a flow file, to reopen it without decompressing, sorting and indexing it again.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "gflowindex.h"
+#include "gsnapshot.h"
+#include "lookup3.h"
+
+using namespace std;
+
+const uint32_t CFlowIndex::format_version;
+const size_t CFlowIndex::hash_block_size;
+
+/**
+ *	Hash a memory block into a running 64 bit hash.
+ *
+ *	\param data Data
+ *	\param length Length in bytes
+ *	\param hash Running hash (in/out)
+ */
+static void hash_block(const void * data, size_t length, uint64_t & hash) {
+	uint32_t pc = (uint32_t) hash, pb = (uint32_t) (hash >> 32);
+	hashlittle2(data, length, &pc, &pb);
+	hash = ((uint64_t) pb << 32) | pc;
+}
+
+/**
+ *	Constructor: identify the current state of the flow file.
+ *
+ *	\param in_filename Flow file
+ *	\param parameters Import parameters the index depends on, as text (an index written with other parameters is ignored)
+ *
+ *	\exception std::string Errortext
+ */
+CFlowIndex::CFlowIndex(const string & in_filename, const string & parameters) :
+	in_filename(in_filename), index_filename(get_index_filename(in_filename)) {
+	memset(&identity, 0, sizeof(identity));
+	identity.version = format_version;
+
+	struct stat st;
+	if (stat(in_filename.c_str(), &st) != 0)
+		throw "ERROR: could not stat " + in_filename + ": " + strerror(errno);
+	identity.file_size = st.st_size;
+	identity.mtime_sec = st.st_mtim.tv_sec;
+	identity.mtime_nsec = st.st_mtim.tv_nsec;
+
+	FILE * file = fopen(in_filename.c_str(), "rb");
+	if (file == NULL)
+		throw "ERROR: could not open " + in_filename + ": " + strerror(errno);
+	vector<char> block(hash_block_size);
+	size_t count = fread(&block[0], 1, block.size(), file);
+	hash_block(&block[0], count, identity.file_hash);
+	if (identity.file_size > 2 * hash_block_size) {
+		if (fseeko(file, -(off_t) hash_block_size, SEEK_END) == 0) {
+			count = fread(&block[0], 1, block.size(), file);
+			hash_block(&block[0], count, identity.file_hash);
+		}
+	} else if (identity.file_size > hash_block_size) {
+		count = fread(&block[0], 1, block.size(), file);
+		hash_block(&block[0], count, identity.file_hash);
+	}
+	fclose(file);
+
+	hash_block(parameters.data(), parameters.size(), identity.parameters_hash);
+}
+
+/**
+ *	\return Name of the index file
+ */
+const string & CFlowIndex::get_filename() const {
+	return index_filename;
+}
+
+/**
+ *	Get the name of the index file of a flow file.
+ *
+ *	\param in_filename Flow file
+ *
+ *	\return in_filename + ".hidx"
+ */
+string CFlowIndex::get_index_filename(const string & in_filename) {
+	return in_filename + ".hidx";
+}
+
+/**
+ *	Load the index if it exists and is valid.
+ *
+ *	\param flows Sorted and qualified flows (out)
+ *	\param hosts Host directory (out)
+ *	\param remoteIP_index Reverse remoteIP index (out)
+ *
+ *	\return False if there is no valid index (the output parameters are unchanged then)
+ */
+bool CFlowIndex::load(CFlowList & flows, vector<ChostMetadata> & hosts, vector<int> & remoteIP_index) const {
+	if (access(index_filename.c_str(), F_OK) != 0)
+		return false;
+
+	CFlowList new_flows;
+	vector<ChostMetadata> new_hosts;
+	vector<int> new_index;
+	try {
+		CSnapshotImage image(index_filename);
+		uint64_t count;
+		const void * stored = image.get_section(CSnapshotImage::section_identity, sizeof(identity_t), count);
+		if (count != 1 || memcmp(stored, &identity, sizeof(identity_t)) != 0)
+			return false;
+		image.get_section(CSnapshotImage::section_flows, new_flows);
+		image.get_section(CSnapshotImage::section_hosts, new_hosts);
+		image.get_section(CSnapshotImage::section_remoteIP_index, new_index);
+	} catch (string &) {
+		return false;
+	}
+
+	flows.swap(new_flows);
+	hosts.swap(new_hosts);
+	remoteIP_index.swap(new_index);
+	return true;
+}
+
+/**
+ *	Write the index. The file is written under a temporary name first and renamed when complete,
+ *	so readers never see a partial index.
+ *
+ *	\param flows Sorted and qualified flows
+ *	\param hosts Host directory
+ *	\param remoteIP_index Reverse remoteIP index
+ *
+ *	\exception std::string Errortext
+ */
+void CFlowIndex::save(const CFlowList & flows, const vector<ChostMetadata> & hosts, const vector<int> & remoteIP_index) const {
+	CSnapshotImage image;
+	image.add_section(CSnapshotImage::section_identity, &identity, 1, sizeof(identity_t));
+	image.add_section(CSnapshotImage::section_flows, flows);
+	image.add_section(CSnapshotImage::section_hosts, hosts);
+	image.add_section(CSnapshotImage::section_remoteIP_index, remoteIP_index);
+	image.write(index_filename);
+}
@@ -0,0 +1,64 @@
+#ifndef GFLOWINDEX_H_
+#define GFLOWINDEX_H_
+
+/**
+ *	\file gflowindex.h
+ *	\brief Sidecar index (*.hidx) of a flow file, to reopen it without decompressing, sorting and indexing it again.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "cflow.h"
+#include "gimport.h"
+
+/**
+ *	\class	CFlowIndex
+ *	\brief	CFlowIndex reads and writes the sidecar index of a flow file.
+ *
+ *	The index holds what CImport::read_file() derives from a flow file: the flows sorted and with uniflows
+ *	qualified (unibiflow bits set), the host directory (the index field of a ChostMetadata is the position of the
+ *	first flow of the host in the flow section) and the reverse remoteIP index.
+ *
+ *	An index is valid for one state of the flow file, identified by its size, its modification time and a hash over
+ *	its first and last hash_block_size bytes, and for one set of import parameters (e.g. local networks and import
+ *	predicate, passed as text). The index is a local cache: it uses native byte order and struct layout.
+ *
+ *	The file in_filename + ".hidx" is a CSnapshotImage with the sections section_identity (one identity_t),
+ *	section_flows, section_hosts and section_remoteIP_index.
+ */
+class CFlowIndex {
+	public:
+		static const uint32_t format_version = 2; ///< Incremented on changes of the index contents
+		static const size_t hash_block_size = 1 << 20; ///< Bytes hashed at the start and at the end of the flow file
+
+		CFlowIndex(const std::string & in_filename, const std::string & parameters);
+
+		const std::string & get_filename() const;
+		bool load(CFlowList & flows, std::vector<ChostMetadata> & hosts, std::vector<int> & remoteIP_index) const;
+		void save(const CFlowList & flows, const std::vector<ChostMetadata> & hosts, const std::vector<int> & remoteIP_index) const;
+
+		static std::string get_index_filename(const std::string & in_filename);
+
+	private:
+		/**
+		 *	\struct	identity_t
+		 *	\brief	Identity of flow file and import parameters, stored in the index
+		 */
+		struct identity_t {
+				uint32_t version; ///< format_version
+				uint32_t reserved; ///< 0
+				uint64_t file_size; ///< Size of the flow file
+				int64_t mtime_sec; ///< Modification time of the flow file (seconds)
+				int64_t mtime_nsec; ///< Modification time of the flow file (nanoseconds)
+				uint64_t file_hash; ///< Hash over first and last block of the flow file
+				uint64_t parameters_hash; ///< Hash of the import parameters
+		};
+
+		std::string in_filename; ///< Flow file
+		std::string index_filename; ///< Index file
+		identity_t identity; ///< Identity of flow file and parameters
+};
+
+#endif /* GFLOWINDEX_H_ */
@@ -0,0 +1,234 @@
+/**
+ *	\file gflowpredicate.cpp
+ *	\brief Import-time flow predicate: selects the flows an import filter adds to the flow list.
+ */
+
+#include <limits>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "gflowpredicate.h"
+#include "gutil.h"
+
+using namespace std;
+
+/**
+ *	Constructor: stats_t with all counters cleared
+ */
+CFlowPredicate::stats_t::stats_t() :
+	accepted(0), skipped_prot(0), skipped_local_net(0), skipped_time(0), skipped_port(0) {
+}
+
+/**
+ *	\return Number of skipped flows/records (all conditions)
+ */
+uint64_t CFlowPredicate::stats_t::skipped() const {
+	return skipped_prot + skipped_local_net + skipped_time + skipped_port;
+}
+
+/**
+ *	Add the counters of another stats_t.
+ *
+ *	\param other Counters to add
+ *
+ *	\return This
+ */
+CFlowPredicate::stats_t & CFlowPredicate::stats_t::operator+=(const stats_t & other) {
+	accepted += other.accepted;
+	skipped_prot += other.skipped_prot;
+	skipped_local_net += other.skipped_local_net;
+	skipped_time += other.skipped_time;
+	skipped_port += other.skipped_port;
+	return *this;
+}
+
+/**
+ *	Constructor: predicate without conditions (accepts every flow)
+ */
+CFlowPredicate::CFlowPredicate() :
+	check_prot(false), check_local_net(false), check_time(false), check_port(false), fromMs(0), toMs(numeric_limits<uint64_t>::max()) {
+}
+
+/**
+ *	Accept flows of a protocol (adds to the protocols already accepted).
+ *
+ *	\param prot Protocol number
+ */
+void CFlowPredicate::add_protocol(uint8_t prot) {
+	prots.set(prot);
+	check_prot = true;
+}
+
+/**
+ *	Accept flows of a comma separated list of protocols given by name (tcp, udp, icmp, icmp6, gre, esp)
+ *	or number, e.g. "tcp,udp,47".
+ *
+ *	\param prot_list Protocol list
+ *
+ *	\exception std::string Errortext
+ */
+void CFlowPredicate::add_protocols(const string & prot_list) {
+	vector<string> names;
+	boost::split(names, prot_list, boost::is_any_of(","));
+	for (vector<string>::iterator it = names.begin(); it != names.end(); ++it) {
+		int prot = util::stringToIpProtocol(boost::trim_copy(*it));
+		if (prot < 0)
+			throw "ERROR: unknown protocol \"" + *it + "\".";
+		add_protocol(prot);
+	}
+}
+
+/**
+ *	Accept flows of a local network (adds to the networks already accepted).
+ *
+ *	\param prefix_str Prefix in CIDR notation, e.g. "10.1.2.0/24"
+ *
+ *	\exception std::string Errortext
+ */
+void CFlowPredicate::add_local_net(const string & prefix_str) {
+	local_nets.add(prefix_str);
+	check_local_net = true;
+}
+
+/**
+ *	Accept flows of a set of local networks (replaces the networks accepted so far).
+ *
+ *	\param local_nets Local networks
+ */
+void CFlowPredicate::set_local_nets(const CLocalNets & local_nets) {
+	this->local_nets = local_nets;
+	check_local_net = true;
+}
+
+/**
+ *	Accept flows overlapping a time range.
+ *
+ *	\param fromMs Start of the range in milliseconds since the epoch
+ *	\param toMs End of the range in milliseconds since the epoch (excluded, 0: open end)
+ */
+void CFlowPredicate::set_time_range(uint64_t fromMs, uint64_t toMs) {
+	this->fromMs = fromMs;
+	this->toMs = (toMs == 0) ? numeric_limits<uint64_t>::max() : toMs;
+	check_time = true;
+}
+
+/**
+ *	Accept flows with a local or remote port within a range (adds to the ranges already accepted).
+ *
+ *	\param first First port of the range
+ *	\param last Last port of the range (included)
+ */
+void CFlowPredicate::add_port_range(uint16_t first, uint16_t last) {
+	if (first > last)
+		swap(first, last);
+	port_ranges.push_back(make_pair(first, last));
+	check_port = true;
+}
+
+/**
+ *	Accept flows with a local or remote port within a comma separated list of ports and port ranges,
+ *	e.g. "53,80,8000-8080".
+ *
+ *	\param range_list Port list
+ *
+ *	\exception std::string Errortext
+ */
+void CFlowPredicate::add_port_ranges(const string & range_list) {
+	vector<string> ranges;
+	boost::split(ranges, range_list, boost::is_any_of(","));
+	for (vector<string>::iterator it = ranges.begin(); it != ranges.end(); ++it) {
+		string range = boost::trim_copy(*it);
+		string::size_type dash = range.find('-');
+		try {
+			uint16_t first = boost::lexical_cast<uint16_t>(range.substr(0, dash));
+			uint16_t last = (dash == string::npos) ? first : boost::lexical_cast<uint16_t>(range.substr(dash + 1));
+			add_port_range(first, last);
+		} catch (boost::bad_lexical_cast &) {
+			throw "ERROR: invalid port range \"" + *it + "\".";
+		}
+	}
+}
+
+/**
+ *	\return True if no condition is set
+ */
+bool CFlowPredicate::accepts_all() const {
+	return !check_prot && !check_local_net && !check_time && !check_port;
+}
+
+/**
+ *	Returns a string representation of the conditions
+ *
+ *	\return string Conditions
+ */
+string CFlowPredicate::toString() const {
+	if (accepts_all())
+		return "all flows";
+	stringstream ss;
+	string sep;
+	if (check_prot) {
+		ss << "protocol";
+		for (unsigned int prot = 0; prot < prots.size(); prot++)
+			if (prots[prot])
+				ss << " " << prot;
+		sep = ", ";
+	}
+	if (check_local_net) {
+		ss << sep << "local network " << local_nets.toString();
+		sep = ", ";
+	}
+	if (check_time) {
+		ss << sep << "time " << fromMs << " ms - ";
+		if (toMs != numeric_limits<uint64_t>::max())
+			ss << toMs << " ms";
+		sep = ", ";
+	}
+	if (check_port) {
+		ss << sep << "port";
+		for (vector<pair<uint16_t, uint16_t> >::const_iterator it = port_ranges.begin(); it != port_ranges.end(); ++it) {
+			ss << " " << it->first;
+			if (it->second != it->first)
+				ss << "-" << it->second;
+		}
+	}
+	return ss.str();
+}
+
+/**
+ *	Add counters collected outside the predicate (see accept(const cflow_t &, stats_t &)).
+ *
+ *	\param stats Counters to add
+ */
+void CFlowPredicate::add_stats(const stats_t & stats) {
+	this->stats += stats;
+}
+
+/**
+ *	\return Counters of the flows checked so far
+ */
+const CFlowPredicate::stats_t & CFlowPredicate::get_stats() const {
+	return stats;
+}
+
+/**
+ *	Clear the counters.
+ */
+void CFlowPredicate::reset_stats() {
+	stats = stats_t();
+}
+
+/**
+ *	Check the port condition.
+ *
+ *	\param flow Flow
+ *
+ *	\return True if the local or the remote port lies within one of the port ranges
+ */
+bool CFlowPredicate::match_ports(const cflow_t & flow) const {
+	for (vector<pair<uint16_t, uint16_t> >::const_iterator it = port_ranges.begin(); it != port_ranges.end(); ++it) {
+		if ((flow.localPort >= it->first && flow.localPort <= it->second) || (flow.remotePort >= it->first && flow.remotePort <= it->second))
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,127 @@
+#ifndef GFLOWPREDICATE_H_
+#define GFLOWPREDICATE_H_
+
+/**
+ *	\file gflowpredicate.h
+ *	\brief Import-time flow predicate: selects the flows an import filter adds to the flow list.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <bitset>
+
+#include "cflow.h"
+#include "glocalnets.h"
+
+/**
+ *	\class	CFlowPredicate
+ *	\brief	CFlowPredicate decides whether an imported flow enters the flow list at all.
+ *
+ *	The import filters evaluate the predicate on each flow (or packet/flow record converted to a flow)
+ *	right after its direction has been inferred, before it is stored, merged or sorted. A flow is accepted
+ *	if it fulfills all conditions set:
+ *	- protocol: protocol is one of the given protocols
+ *	- local network: local address is covered by one of the given prefixes
+ *	- time range: flow overlaps the given time range
+ *	- port ranges: local or remote port lies within one of the given ranges
+ *
+ *	A predicate without conditions accepts every flow. Rejected flows are counted by condition.
+ *	Packets and uniflow records are checked one by one before they are merged, so a time range
+ *	cuts flows at its boundaries.
+ */
+class CFlowPredicate {
+	public:
+		/**
+		 *	\struct	stats_t
+		 *	\brief	Counters of accepted and skipped flows
+		 */
+		struct stats_t {
+				uint64_t accepted; ///< Flows/records accepted
+				uint64_t skipped_prot; ///< Flows/records skipped due to their protocol
+				uint64_t skipped_local_net; ///< Flows/records skipped due to their local address
+				uint64_t skipped_time; ///< Flows/records skipped due to their time
+				uint64_t skipped_port; ///< Flows/records skipped due to their ports
+
+				stats_t();
+				uint64_t skipped() const;
+				stats_t & operator+=(const stats_t & other);
+		};
+
+		CFlowPredicate();
+
+		void add_protocol(uint8_t prot);
+		void add_protocols(const std::string & prot_list);
+		void add_local_net(const std::string & prefix_str);
+		void set_local_nets(const CLocalNets & local_nets);
+		void set_time_range(uint64_t fromMs, uint64_t toMs);
+		void add_port_range(uint16_t first, uint16_t last);
+		void add_port_ranges(const std::string & range_list);
+
+		bool accepts_all() const;
+		std::string toString() const;
+
+		bool accept(const cflow_t & flow);
+		bool accept(const cflow_t & flow, stats_t & stats) const;
+		void add_stats(const stats_t & stats);
+		const stats_t & get_stats() const;
+		void reset_stats();
+
+	private:
+		bool match_ports(const cflow_t & flow) const;
+
+		bool check_prot; ///< True if the protocol condition is set
+		bool check_local_net; ///< True if the local network condition is set
+		bool check_time; ///< True if the time range condition is set
+		bool check_port; ///< True if the port condition is set
+		std::bitset<256> prots; ///< Accepted protocols
+		CLocalNets local_nets; ///< Accepted local networks
+		uint64_t fromMs; ///< Start of the time range (milliseconds since the epoch)
+		uint64_t toMs; ///< End of the time range (excluded)
+		std::vector<std::pair<uint16_t, uint16_t> > port_ranges; ///< Accepted port ranges (first, last)
+		stats_t stats; ///< Counters of accept(const cflow_t &) and add_stats()
+};
+
+/**
+ *	Check a flow and count the result in the counters of the predicate (single thread).
+ *
+ *	\param flow Flow (local/remote view)
+ *
+ *	\return True if the flow is accepted
+ */
+inline bool CFlowPredicate::accept(const cflow_t & flow) {
+	return accept(flow, stats);
+}
+
+/**
+ *	Check a flow and count the result in caller supplied counters (e.g. one set per worker thread,
+ *	see add_stats()).
+ *
+ *	\param flow Flow (local/remote view)
+ *	\param stats Counters
+ *
+ *	\return True if the flow is accepted
+ */
+inline bool CFlowPredicate::accept(const cflow_t & flow, stats_t & stats) const {
+	if (check_prot && !prots[flow.prot]) {
+		stats.skipped_prot++;
+		return false;
+	}
+	if (check_local_net && !local_nets.is_local(flow.localIP)) {
+		stats.skipped_local_net++;
+		return false;
+	}
+	if (check_time && (flow.startMs >= toMs || flow.startMs + flow.durationMs < fromMs)) {
+		stats.skipped_time++;
+		return false;
+	}
+	if (check_port && !match_ports(flow)) {
+		stats.skipped_port++;
+		return false;
+	}
+	stats.accepted++;
+	return true;
+}
+
+#endif /* GFLOWPREDICATE_H_ */
@@ -31,18 +31,39 @@ const bool dbg2 = true;
  *
  *	\param	hpg_filename Name of output file for binary graph data
  *	\param	roleMembership Role membership of graphlet
+ *	\param	append Append the graphlet to an existing hpg file (graphlets of several hosts in one file)
  *
  *	\exception string Errormessage
  */
-CGraphlet::CGraphlet(std::string hpg_filename, CRoleMembership & roleMembership) {
-	proleMembership = &roleMembership;
-
+CGraphlet::CGraphlet(std::string hpg_filename, CRoleMembership & roleMembership, bool append) {
 	// Open output file to write hpg graphlet edges to.
-	try {
-		util::open_outfile(outfs, hpg_filename);
-	} catch (string & e) {
-		throw e;
-	}
+	sink = new CHpgFileSink(hpg_filename, append);
+	own_sink = true;
+	init(roleMembership, !append);
+}
+
+/**
+ *	Constructor: pass the edges to a sink instead of writing them to a file.
+ *
+ *	\param	edge_sink Receives the edges of each graphlet finalized (must outlive the graphlet)
+ *	\param	roleMembership Role membership of graphlet
+ *	\param	write_version Start with a version edge (i.e. the first graphlet starts new hpg data)
+ */
+CGraphlet::CGraphlet(CEdgeSink & edge_sink, CRoleMembership & roleMembership, bool write_version) {
+	sink = &edge_sink;
+	own_sink = false;
+	init(roleMembership, write_version);
+}
+
+/**
+ *	Initialize the hash maps of the edges (for the constructors).
+ *
+ *	\param	roleMembership Role membership of graphlet
+ *	\param	write_version Start with a version edge
+ */
+void CGraphlet::init(CRoleMembership & roleMembership, bool write_version) {
+	proleMembership = &roleMembership;
+	this->write_version = write_version;
 
 	totalbytes = 0; // Counts bytes over all flows belonging to a graphlet
 	hostnum = 0;
@@ -117,7 +138,8 @@ CGraphlet::~CGraphlet() {
 	if (hap4nfsen) {
 		delete nodeInfos;
 	}
-	outfs.close();
+	if (own_sink)
+		delete sink;
 }
 
 /**
@@ -622,7 +644,8 @@ void CGraphlet::add_generic_role(CRole::role_t & role, const CRole::role_t& pare
 
 		}
 		remoteEports.push_back(remoteEport);
-		++localEport_id;
+		if (localEport_id + 1 < localEports.size())
+			++localEport_id; // A single local port summary node (gpa_1_n) serves all flows
 		if (lport_rport_association == gpa_n_n) {
 			break; // only one connection between summary nodes -> no need to go through all ips
 		}
@@ -904,25 +927,25 @@ inline uint64_t CGraphlet::getRolnumClients(const uint32_t role_nr, const uint32
 }
 
 /**
- *	Finalize graphlet and write hpg edge data to file.
+ *	Finalize graphlet and pass hpg edge data to the sink (e.g. write it to the hpg file).
  *
  *	\param	graphlet_nr	Number to assign to graphlet finalized
  */
 void CGraphlet::finalize_graphlet(int graphlet_nr) {
-	hpg_field value[3];
-	value[0].reset();
+	hpg_field value[3]; // As in hpg data, value[0] (graphlet number and rank) is left to the sink
 	value[1].reset();
 	value[2].reset();
-	// Put a version info edge right at the begin
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + version;
-	value[1].eightbytevalue.data = 3;
-	value[2].eightbytevalue.data = 0;
-	outfs.write((char *) value, sizeof(value));
+	// Put a version info edge right at the begin of the file
+	if (write_version) {
+		value[1].eightbytevalue.data = 3;
+		value[2].eightbytevalue.data = 0;
+		sink->add_edge(graphlet_nr, version, value[1], value[2]);
+		write_version = false;
+	}
 
 	// localIP_prot
 	// ============
 	rank_t rank = localIP_prot;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	int localIP_prot_count = 0;
 	for (iterIpProt = hm_localIp_prot->begin(); iterIpProt != hm_localIp_prot->end(); iterIpProt++) {
 		value[1].reset();
@@ -930,7 +953,7 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 		HashMapEdge edge = (HashMapEdge) iterIpProt->second;
 		value[1].data = edge.ip; // localIP
 		value[2].eightbytevalue.data = edge.valueA.proto/* & 0xff*/; // prot
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		localIP_prot_count++;
 		//cout<<"[w]value[0].fourbytevalue.data:"<<value[0].fourbytevalue.data<<endl;
 		//cout<<"[w]value[1].fourbytevalue.data:"<<value[1].fourbytevalue.data<<endl;
@@ -940,7 +963,6 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// prot_localPort
 	// ==============
 	rank = prot_localPort;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	int prot_localPort_count = 0;
 	for (iterProtEport = hm_prot_localPort_11->begin(); iterProtEport != hm_prot_localPort_11->end(); iterProtEport++) {
 		value[1].reset();
@@ -948,28 +970,26 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 		HashMapEdge edge = (HashMapEdge) iterProtEport->second;
 		value[1].eightbytevalue.data = edge.valueA.proto; // prot
 		value[2].eightbytevalue.data = edge.valueB.port1; // localPort (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		prot_localPort_count++;
 	}
 
 	// prot_localPortSum
 	// ==============
 	rank = prot_localPortSum;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterProtEport = hm_prot_localPort_1n->begin(); iterProtEport != hm_prot_localPort_1n->end(); iterProtEport++) {
 		value[1].reset();
 		value[2].reset();
 		HashMapEdge edge = (HashMapEdge) iterProtEport->second;
 		value[1].eightbytevalue.data = edge.valueA.proto; // prot
 		value[2].eightbytevalue.data = edge.valueB.port1; // localPort (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		prot_localPort_count++;
 	}
 
 	// localPort_remotePort
 	// ====================
 	rank = localPort_remotePort;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	int localPort_remotePort_count = 0;
 	for (iterEport2 = hm_localPort_remotePort_11->begin(); iterEport2 != hm_localPort_remotePort_11->end(); iterEport2++) {
 		value[1].reset();
@@ -977,21 +997,19 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 		HashMapEdge edge = (HashMapEdge) iterEport2->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // localPort (eport)
 		value[2].eightbytevalue.data = edge.valueC.port2; // remotePort (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].reset();
 		valueE[1].reset();
 		valueE[2].reset();
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
 		iterEport3 = hm_localPort_remotePortE->find(iterEport2->first);
 		if (iterEport3 != hm_localPort_remotePortE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
 			valueE[1].eightbytevalue.data = edge.valueA.bytes; // Bytes
 			valueE[2].eightbytevalue.data = edge.valueB.packets; // Packets
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		} else {
 			cerr << "ERROR: key not found in hm_localPort_remotePortE\n\n";
 		}
@@ -1002,25 +1020,25 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// localPortSum_remotePort
 	// ====================
 	rank = localPortSum_remotePort;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterEport2 = hm_localPort_remotePort_n1->begin(); iterEport2 != hm_localPort_remotePort_n1->end(); iterEport2++) {
 		value[1].reset();
 		value[2].reset();
 		HashMapEdge edge = (HashMapEdge) iterEport2->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // localPort (eport)
 		value[2].eightbytevalue.data = edge.valueC.port2; // remotePort (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_localPort_remotePortE->find(iterEport2->first);
 		if (iterEport3 != hm_localPort_remotePortE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
 			valueE[1].eightbytevalue.data = edge.valueA.bytes; // Bytes
 			valueE[2].eightbytevalue.data = edge.valueB.packets; // Packets
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		} else {
 			cerr << "ERROR: key not found in hm_localPort_remotePortE\n\n";
 		}
@@ -1031,7 +1049,6 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// localPort_remotePortSum
 	// ====================
 	rank = localPort_remotePortSum;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterEport2 = hm_localPort_remotePort_1n->begin(); iterEport2 != hm_localPort_remotePort_1n->end(); iterEport2++) {
 		value[1].reset();
 		value[2].reset();
@@ -1043,18 +1060,19 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 		//uint16_t rn2 = (edge.valueC.port2>>16)%256;
 		//cout<<rn<<"|"<<cl<<"|"<<rn2<<endl;
 		//cout<<edge.valueA.rolnum_clients<<endl;
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_localPort_remotePortE->find(iterEport2->first);
 		if (iterEport3 != hm_localPort_remotePortE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
 			valueE[1].eightbytevalue.data = edge.valueA.bytes; // Bytes
 			valueE[2].eightbytevalue.data = edge.valueB.packets; // Packets
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		} else {
 			cerr << "ERROR: key not found in hm_localPort_remotePortE\n\n";
 		}
@@ -1065,25 +1083,25 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// localPortSum_remotePortSum
 	// ====================
 	rank = localPortSum_remotePortSum;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterEport2 = hm_localPort_remotePort_nn->begin(); iterEport2 != hm_localPort_remotePort_nn->end(); iterEport2++) {
 		value[1].reset();
 		value[2].reset();
 		HashMapEdge edge = (HashMapEdge) iterEport2->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // localPort (eport)
 		value[2].eightbytevalue.data = edge.valueC.port2; // remotePort (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_localPort_remotePortE->find(iterEport2->first);
 		if (iterEport3 != hm_localPort_remotePortE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
 			valueE[1].eightbytevalue.data = edge.valueA.bytes; // Bytes
 			valueE[2].eightbytevalue.data = edge.valueB.packets; // Packets
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		} else {
 			cerr << "ERROR: key not found in hm_localPort_remotePortE\n\n";
 		}
@@ -1094,7 +1112,6 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// remotePort_remoteIp
 	// ===================
 	rank = remotePort_remoteIP;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	int remotePort_remoteIP_count = 0;
 	for (iterEportIp = hm_remotePort_remoteIp_11->begin(); iterEportIp != hm_remotePort_remoteIp_11->end(); iterEportIp++) {
 		value[1].reset();
@@ -1102,11 +1119,12 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 		HashMapEdge edge = (HashMapEdge) iterEportIp->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // remotePort (eport)
 		value[2].data = edge.ip; // remoteIp (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_remotePort_remoteIpE->find(iterEportIp->first);
 		if (iterEport3 != hm_remotePort_remoteIpE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
@@ -1122,7 +1140,7 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 				uint32_t ppf10 = (uint32_t) (10.0 * ppf);
 				valueE[2].eightbytevalue.data = ppf10 | 0x80000000; // Packets
 			}
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		}
 		remotePort_remoteIP_count++;
 	}
@@ -1130,18 +1148,18 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// remotePortSum_remoteIP
 	// ====================
 	rank = remotePortSum_remoteIP;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterEportIp = hm_remotePort_remoteIp_n1->begin(); iterEportIp != hm_remotePort_remoteIp_n1->end(); iterEportIp++) {
 		value[1].reset();
 		value[2].reset();
 		HashMapEdge edge = (HashMapEdge) iterEportIp->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // remotePort (eport)
 		value[2].data = edge.ip; // remoteIp (eport)
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_remotePort_remoteIpE->find(iterEportIp->first);
 		if (iterEport3 != hm_remotePort_remoteIpE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
@@ -1156,7 +1174,7 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 				uint32_t ppf10 = (uint32_t) (10.0 * ppf);
 				valueE[2].eightbytevalue.data = ppf10 | 0x80000000; // Packets
 			}
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		}
 		remotePort_remoteIP_count++;
 	}
@@ -1164,18 +1182,18 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// remotePort_remoteIPsum
 	// ====================
 	rank = remotePort_remoteIPsum;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterEportIp = hm_remotePort_remoteIp_1n->begin(); iterEportIp != hm_remotePort_remoteIp_1n->end(); iterEportIp++) {
 		value[1].reset();
 		value[2].reset();
 		HashMapEdge edge = (HashMapEdge) iterEportIp->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // remotePort (eport)
 		value[2].eightbytevalue.data = edge.valueA.rolnum_clients; // 24bit: role number, 24bit: #clients/peers
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_remotePort_remoteIpE->find(iterEportIp->first);
 		if (iterEport3 != hm_remotePort_remoteIpE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
@@ -1190,7 +1208,7 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 				uint32_t ppf10 = (uint32_t) (10.0 * ppf);
 				valueE[2].eightbytevalue.data = ppf10 | 0x80000000; // Packets
 			}
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		}
 		remotePort_remoteIP_count++;
 	}
@@ -1198,18 +1216,18 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// remotePortSum_remoteIPsum
 	// ====================
 	rank = remotePortSum_remoteIPsum;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
 	for (iterEportIp = hm_remotePort_remoteIp_nn->begin(); iterEportIp != hm_remotePort_remoteIp_nn->end(); iterEportIp++) {
 		value[1].reset();
 		value[2].reset();
 		HashMapEdge edge = (HashMapEdge) iterEportIp->second;
 		value[1].eightbytevalue.data = edge.valueB.port1; // remotePort (eport)
 		value[2].eightbytevalue.data = edge.valueA.rolnum_clients; // 24bit: role number, 24bit: #clients/peers
-		outfs.write((char *) value, sizeof(value));
+		sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 		// Process extra info as an additional edge entry
 		rank_t rankE = edge_label;
 		hpg_field valueE[3];
-		valueE[0].eightbytevalue.data = (graphlet_nr << 4) + rankE;
+		valueE[1].reset();
+		valueE[2].reset();
 		iterEport3 = hm_remotePort_remoteIpE->find(iterEportIp->first);
 		if (iterEport3 != hm_remotePort_remoteIpE->end()) {
 			HashMapEdge edge = (HashMapEdge) iterEport3->second;
@@ -1224,7 +1242,7 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 				uint32_t ppf10 = (uint32_t) (10.0 * ppf);
 				valueE[2].eightbytevalue.data = ppf10 | 0x80000000; // Packets
 			}
-			outfs.write((char *) valueE, sizeof(valueE));
+			sink->add_edge(graphlet_nr, rankE, valueE[1], valueE[2]);
 		}
 		remotePort_remoteIP_count++;
 	}
@@ -1232,11 +1250,13 @@ void CGraphlet::finalize_graphlet(int graphlet_nr) {
 	// Finally, add the pseudo edge for total byte count
 	// =================================================
 	rank = totalBytes;
-	value[0].eightbytevalue.data = (graphlet_nr << 4) + rank;
+	value[1].reset();
+	value[2].reset();
 	value[1].eightbytevalue.data = (uint32_t) (totalbytes >> 32); // High 32 bits
 	value[2].eightbytevalue.data = (uint32_t) (totalbytes & 0xffffffff); // Low 32 bits
-	outfs.write((char *) value, sizeof(value));
+	sink->add_edge(graphlet_nr, rank, value[1], value[2]);
 	totalbytes = 0; // Prepare for next graphlet
+	sink->end_graphlet(graphlet_nr, nodeInfos);
 
 	// Clear hash maps to be prepared for next graphlet
 	// Up to 1000+(?) entries a clear-fill cycle is faster than a dele/new/fill-cycle.
@@ -7,7 +7,7 @@
  *
  *	Transforms flow and role data into graph descriptions.
  *
- *	So far, we only support the binary "hpg" format defined in hpg.h.
+ *	The edges are passed to a CEdgeSink, by default one writing the binary "hpg" format defined in hpg.h.
  *	This format is very space efficient as it was originally introduced
  *	to store a large number of graphlets in a file efficiently.
  */
@@ -25,12 +25,13 @@
 #include "grole.h"
 #include "HashMapE.h"
 #include "gsummarynodeinfo.h"
+#include "gedgesink.h"
 
 /**
  *	\class CGraphlet
  *
  *	\brief Infers graphlet vertex and edge data from single flows or from roles.
- *	Data is stored to a file using the format as defined by hpg.h.
+ *	Data is stored to a file using the format as defined by hpg.h, or passed to an edge sink (see CEdgeSink).
  */
 class CGraphlet {
 	protected:
@@ -39,7 +40,9 @@ class CGraphlet {
 		int * flow_p2p_role;
 		//		prefs_t & prefs; FIXME: needed?
 
-		std::ofstream outfs;
+		CEdgeSink * sink; ///< Receives the edges of the graphlets finalized
+		bool own_sink; ///< Sink created by the constructor (hpg file)
+		bool write_version; ///< Write the version edge (only the first graphlet of a file has one)
 		uint64_t totalbytes; // Counts bytes over all flows belonging to a particular graphlet
 		uint32_t hostnum;
 
@@ -188,13 +191,15 @@ class CGraphlet {
 		graphletHashMap::iterator iterIpProt, iterProtEport, iterEport2, iterEport3, iterHnumIp, iterEportIp;
 
 	public:
-		CGraphlet(std::string hpg_filename, CRoleMembership & roleMembership);
+		CGraphlet(std::string hpg_filename, CRoleMembership & roleMembership, bool append = false);
+		CGraphlet(CEdgeSink & edge_sink, CRoleMembership & roleMembership, bool write_version = true);
 		~CGraphlet();
 		void add_single_flow(const cflow_t & pflow, int role_num, int flow_idx);
 		void add_generic_role(CRole::role_t & role, const CRole::role_t & parent_role, IPv6_addr lastIP, Subflowlist flow_list);
 		void finalize_graphlet(int graphlet_nr);
 		CSummaryNodeInfos* nodeInfos;
 	private:
+		void init(CRoleMembership & roleMembership, bool write_version);
 		static uint8_t flowtype2colorcode(const uint8_t flowtype);
 		static HashMapEdge ipProtoToEdge(const IPv6_addr & ip, const uint32_t proto);
 		static HashMapEdge protoEportToEdge(const uint32_t proto, const uint64_t port);
@@ -0,0 +1,161 @@
+/**
+ *	\file ggraphletcache.cpp
+ *	\brief LRU cache of finished graphlet outputs (DOT and HPG file contents).
+ */
+
+#include "ggraphletcache.h"
+
+using namespace std;
+
+const uint64_t CGraphletCache::default_byte_budget;
+
+/**
+ *	Constructor
+ *
+ *	\param byte_budget Bytes the cached outputs may take
+ */
+CGraphletCache::CGraphletCache(uint64_t byte_budget) :
+	byte_budget(byte_budget), bytes(0), hits(0), misses(0) {
+}
+
+/**
+ *	Look up the outputs of a request and mark them as most recently used.
+ *
+ *	\param key Request
+ *	\param dot DOT file contents (out)
+ *	\param hpg HPG file contents (out)
+ *
+ *	\return True if the outputs were found (dot and hpg are unchanged otherwise)
+ */
+bool CGraphletCache::find(const string & key, string & dot, string & hpg) {
+	boost::shared_ptr<const CSummaryNodeInfos> node_infos;
+	return find(key, dot, hpg, node_infos);
+}
+
+/**
+ *	Look up the outputs of a request and its node infos and mark them as most recently used.
+ *
+ *	\param key Request
+ *	\param dot DOT file contents (out)
+ *	\param hpg HPG file contents (out)
+ *	\param node_infos Node infos of the graphlet (out, NULL if none were inserted)
+ *
+ *	\return True if the outputs were found (dot, hpg and node_infos are unchanged otherwise)
+ */
+bool CGraphletCache::find(const string & key, string & dot, string & hpg, boost::shared_ptr<const CSummaryNodeInfos> & node_infos) {
+	map<string, entryList::iterator>::iterator it = index.find(key);
+	if (it == index.end()) {
+		misses++;
+		return false;
+	}
+	hits++;
+	entries.splice(entries.begin(), entries, it->second);
+	dot = it->second->dot;
+	hpg = it->second->hpg;
+	node_infos = it->second->node_infos;
+	return true;
+}
+
+/**
+ *	Add the outputs of a request (replacing older outputs of the same request). Outputs larger than the
+ *	byte budget are not cached.
+ *
+ *	\param key Request
+ *	\param dot DOT file contents
+ *	\param hpg HPG file contents
+ *	\param node_infos Node infos of the graphlet (NULL: none)
+ */
+void CGraphletCache::insert(const string & key, const string & dot, const string & hpg, boost::shared_ptr<const CSummaryNodeInfos> node_infos) {
+	map<string, entryList::iterator>::iterator it = index.find(key);
+	if (it != index.end()) {
+		bytes -= get_bytes(*it->second);
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	entry_t entry;
+	entry.key = key;
+	entry.dot = dot;
+	entry.hpg = hpg;
+	entry.node_infos = node_infos;
+	if (get_bytes(entry) > byte_budget)
+		return;
+	entries.push_front(entry);
+	index[key] = entries.begin();
+	bytes += get_bytes(entry);
+	evict();
+}
+
+/**
+ *	Drop all cached outputs (the statistics are kept).
+ */
+void CGraphletCache::clear() {
+	entries.clear();
+	index.clear();
+	bytes = 0;
+}
+
+/**
+ *	Set the byte budget, dropping least recently used outputs as needed.
+ *
+ *	\param byte_budget Bytes the cached outputs may take (0: cache nothing)
+ */
+void CGraphletCache::set_byte_budget(uint64_t byte_budget) {
+	this->byte_budget = byte_budget;
+	evict();
+}
+
+/**
+ *	\return Bytes the cached outputs may take
+ */
+uint64_t CGraphletCache::get_byte_budget() const {
+	return byte_budget;
+}
+
+/**
+ *	\return Bytes the cached outputs take (keys and contents)
+ */
+uint64_t CGraphletCache::get_bytes() const {
+	return bytes;
+}
+
+/**
+ *	\return Number of cached requests
+ */
+size_t CGraphletCache::size() const {
+	return entries.size();
+}
+
+/**
+ *	\return Number of find() calls that found the outputs
+ */
+uint64_t CGraphletCache::get_hits() const {
+	return hits;
+}
+
+/**
+ *	\return Number of find() calls that did not find the outputs
+ */
+uint64_t CGraphletCache::get_misses() const {
+	return misses;
+}
+
+/**
+ *	\param entry Cached outputs
+ *
+ *	\return Bytes counted against the byte budget
+ */
+uint64_t CGraphletCache::get_bytes(const entry_t & entry) {
+	return entry.key.size() + entry.dot.size() + entry.hpg.size();
+}
+
+/**
+ *	Drop least recently used outputs until the byte budget is met.
+ */
+void CGraphletCache::evict() {
+	while (bytes > byte_budget && !entries.empty()) {
+		bytes -= get_bytes(entries.back());
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
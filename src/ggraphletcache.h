@@ -0,0 +1,70 @@
+#ifndef GGRAPHLETCACHE_H_
+#define GGRAPHLETCACHE_H_
+
+/**
+ *	\file ggraphletcache.h
+ *	\brief LRU cache of finished graphlet outputs (DOT and HPG file contents).
+ */
+
+#include <stdint.h>
+#include <string>
+#include <list>
+#include <map>
+#include <boost/shared_ptr.hpp>
+
+class CSummaryNodeInfos;
+
+/**
+ *	\class	CGraphletCache
+ *	\brief	CGraphletCache keeps the outputs of graphlet requests, so identical requests skip role inference,
+ *				graphlet building and encoding.
+ *
+ *	The key has to describe everything the outputs depend on: data set, local IP, preferences and desummarized
+ *	roles (see CInterface). The least recently used outputs are dropped when the outputs held exceed the byte budget.
+ *	The node infos of a graphlet (hap4nfsen only) may be kept with its outputs; they are shared with the caller
+ *	and not counted against the budget.
+ */
+class CGraphletCache {
+	public:
+		static const uint64_t default_byte_budget = (uint64_t) 64 << 20; ///< 64 MB
+
+		CGraphletCache(uint64_t byte_budget = default_byte_budget);
+
+		bool find(const std::string & key, std::string & dot, std::string & hpg);
+		bool find(const std::string & key, std::string & dot, std::string & hpg, boost::shared_ptr<const CSummaryNodeInfos> & node_infos);
+		void insert(const std::string & key, const std::string & dot, const std::string & hpg, boost::shared_ptr<const CSummaryNodeInfos> node_infos =
+		      boost::shared_ptr<const CSummaryNodeInfos>());
+		void clear();
+
+		void set_byte_budget(uint64_t byte_budget);
+		uint64_t get_byte_budget() const;
+		uint64_t get_bytes() const;
+		size_t size() const;
+		uint64_t get_hits() const;
+		uint64_t get_misses() const;
+
+	private:
+		/**
+		 *	\struct	entry_t
+		 *	\brief	Cached outputs of one request
+		 */
+		struct entry_t {
+				std::string key; ///< Request
+				std::string dot; ///< DOT file contents
+				std::string hpg; ///< HPG file contents
+				boost::shared_ptr<const CSummaryNodeInfos> node_infos; ///< Node infos of the graphlet (NULL: none)
+		};
+		typedef std::list<entry_t> entryList;
+
+		static uint64_t get_bytes(const entry_t & entry);
+		void evict();
+
+		entryList entries; ///< Outputs, most recently used first
+		std::map<std::string, entryList::iterator> index; ///< Outputs by key
+		uint64_t byte_budget; ///< Bytes the outputs may take
+		uint64_t bytes; ///< Bytes the outputs take
+		uint64_t hits; ///< Requests answered from the cache
+		uint64_t misses; ///< Requests not found
+};
+
+#endif /* GGRAPHLETCACHE_H_ */
@@ -0,0 +1,290 @@
+/**
+ *	\file ggraphletexport.cpp
+ *	\brief Bulk export of the graphlets of an hpg file to dot, JSON or rendered images, on several threads.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "ggraphletexport.h"
+#include "gedgesink.h"
+#include "gsvgsink.h"
+#include "IPv6_addr.h"
+#include "cflow.h"
+
+using namespace std;
+
+/**
+ *	Constructor
+ *
+ *	\param hpgData Data set with metadata (see ChpgData::get_hpgMetadata()), only read by the export
+ *	\param out_dir Existing directory receiving the files
+ *	\param format Output format
+ *	\param extension File name extension (empty: "dot", "json" or "svg", as the format)
+ */
+CGraphletExport::CGraphletExport(ChpgData & hpgData, const std::string & out_dir, format_t format, const std::string & extension) :
+	hpgData(hpgData), out_dir(out_dir), format(format), extension(extension), threads(0), progress(NULL), next(0), done(0), failed(0) {
+	if (this->extension.empty())
+		this->extension = (format == json_format) ? "json" : (format == svg_format) ? "svg" : "dot";
+}
+
+/**
+ *	Set the number of export threads.
+ *
+ *	\param threads Number of threads (0: one per core)
+ */
+void CGraphletExport::set_threads(unsigned int threads) {
+	this->threads = threads;
+}
+
+/**
+ *	Set the renderer of image_format. export_graphlets() creates a renderer per thread, all of them before it starts
+ *	the threads.
+ *
+ *	\param factory Creates a renderer
+ */
+void CGraphletExport::set_renderer(const renderer_factory_t & factory) {
+	renderer_factory = factory;
+}
+
+/**
+ *	Show the progress of export_graphlets() on a stream ("\rExported n of m graphlets.").
+ *
+ *	\param progress Stream (NULL: do not show progress)
+ */
+void CGraphletExport::set_progress(std::ostream * progress) {
+	this->progress = progress;
+}
+
+/**
+ *	Write the graphlets of a range of the metadata list, one file each. Graphlets that cannot be written (e.g. without
+ *	edges) are reported on cerr and counted by get_failed().
+ *
+ *	\param first Position of the first graphlet in the metadata list
+ *	\param last Position of the last graphlet in the metadata list (beyond the end: up to the last graphlet)
+ *
+ *	\return Number of graphlets written
+ *
+ *	\exception std::string Errortext (no renderer for image_format)
+ */
+unsigned int CGraphletExport::export_graphlets(unsigned int first, unsigned int last) {
+	if (format == image_format && renderer_factory.empty())
+		throw string("ERROR: no renderer for graphlet images.");
+
+	graphlets.clear();
+	unsigned int position = 0;
+	for (ChpgMetadata * metadata = hpgData.get_first_graphlet(); metadata != NULL && position <= last; metadata = hpgData.get_next_graphlet(), position++) {
+		if (position >= first)
+			graphlets.push_back(metadata);
+	}
+	next = 0;
+	done = failed = 0;
+	if (graphlets.empty())
+		return 0;
+
+	unsigned int thread_count = threads != 0 ? threads : boost::thread::hardware_concurrency();
+	thread_count = max(1u, min<unsigned int>(thread_count, graphlets.size()));
+
+	// Create the renderers while this is the only thread: renderers may fork() worker processes
+	vector<boost::shared_ptr<CDotRenderer> > renderers(thread_count);
+	if (format == image_format) {
+		try {
+			for (unsigned int i = 0; i < thread_count; i++)
+				renderers[i].reset(renderer_factory());
+		} catch (string & e) {
+			cerr << "ERROR: " << e << endl;
+			// Export with the renderers created so far
+			while (!renderers.empty() && !renderers.back())
+				renderers.pop_back();
+			if (renderers.empty())
+				return 0;
+			thread_count = renderers.size();
+		}
+	}
+
+	boost::thread_group group;
+	for (unsigned int i = 1; i < thread_count; i++)
+		group.create_thread(boost::bind(&CGraphletExport::run, this, renderers[i].get()));
+	run(renderers[0].get());
+	group.join_all();
+	if (progress != NULL)
+		*progress << endl;
+	return done;
+}
+
+/**
+ *	Export thread: write graphlets until all are taken.
+ *
+ *	\param renderer Renderer of this thread (image_format, NULL otherwise)
+ */
+void CGraphletExport::run(CDotRenderer * renderer) {
+	while (true) {
+		const ChpgMetadata * metadata;
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			if (next == graphlets.size())
+				return;
+			metadata = graphlets[next++];
+		}
+		string error;
+		try {
+			export_graphlet(*metadata, renderer);
+		} catch (string & e) {
+			error = e;
+		} catch (const char * e) {
+			error = e;
+		}
+
+		boost::mutex::scoped_lock lock(mutex);
+		if (error.empty()) {
+			done++;
+		} else {
+			failed++;
+			cerr << "ERROR: graphlet " << metadata->graphlet_nr << " not exported: " << error << endl;
+		}
+		unsigned int step = max<unsigned int>(1, graphlets.size() / 100);
+		if (progress != NULL && ((done + failed) % step == 0 || done + failed == graphlets.size()))
+			*progress << "\rExported " << done << " of " << graphlets.size() << " graphlets." << flush;
+	}
+}
+
+/**
+ *	Write a graphlet to "<localIP>.<extension>".
+ *
+ *	\param metadata Graphlet
+ *	\param renderer Renderer (image_format)
+ *
+ *	\exception std::string Errortext
+ */
+void CGraphletExport::export_graphlet(const ChpgMetadata & metadata, CDotRenderer * renderer) {
+	CHpgBufferSink edges;
+	edges.add_version_edge();
+	hpgData.get_graphlet_edges(metadata.index, edges);
+	vector<hpg_field> & data = edges.get_data();
+	if (data.size() < 6 || (rank_t) (data[3].eightbytevalue.data & 0xf) != localIP_prot)
+		throw string("no flows left");
+	string filename = out_dir + "/" + IPv6_addr(data[4].data).toString() + "." + extension;
+
+	stringstream out;
+	if (format == json_format) {
+		write_json(data, out);
+	} else if (format == svg_format) {
+		CSvgSink::write_svg(data, out);
+	} else {
+		ChpgData graphlet(&data[0], data.size() * sizeof(hpg_field));
+		graphlet.hpg2dot(0, out);
+	}
+	if (format == image_format) {
+		renderer->render(out.str(), filename);
+		return;
+	}
+	ofstream file(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	file << out.rdbuf();
+	file.close();
+	if (file.fail())
+		throw "could not write " + filename;
+}
+
+/**
+ *	Quote a string for JSON.
+ */
+static string json_string(const string & text) {
+	string quoted = "\"";
+	for (size_t i = 0; i < text.size(); i++) {
+		if (text[i] == '"' || text[i] == '\\')
+			quoted += '\\';
+		quoted += text[i];
+	}
+	return quoted + "\"";
+}
+
+/**
+ *	Append an edge annotation value (packets, or packets per flow as fixed point value with 1 digit) in JSON.
+ */
+static void write_json_count(ostream & out, const char * name, uint64_t value) {
+	out << ",\"" << name << "\":";
+	if (value >> 31)
+		out << (double) (value & 0x7fffffff) / 10.0;
+	else
+		out << value;
+}
+
+/**
+ *	Write a graphlet as JSON object:
+ *
+ *	{"localIP":"10.0.0.1","bytes":1234,
+ *	 "nodes":[{"id":"k1_...","partition":1,"label":"10.0.0.1","summary":false}, ...],
+ *	 "edges":[{"from":"k1_...","to":"k2_6"}, ..., {"from":"k3_...","to":"k4_...","direction":"both","bytes":1200,"packets":12}, ...,
+ *	          {"from":"k4_...","to":"k5_...","flows":3,"packets_per_flow":4.5}, ...]}
+ *
+ *	Node ids are those of the dot format (see ChpgData::get_node_id()), partitions count from 1 (localIP) to 5 (remoteIP).
+ *	Directions of localPort-remotePort edges are "both", "in" or "out", with "unibiflow":true for uniflows in the presence
+ *	of biflows.
+ *
+ *	\param edges hpg data of the graphlet (3 fields per edge, starting with a version edge)
+ *	\param out Output stream
+ */
+void CGraphletExport::write_json(const std::vector<hpg_field> & edges, std::ostream & out) {
+	stringstream nodes, links;
+	set<string> node_ids;
+	uint64_t bytes = 0;
+	IPv6_addr localIP;
+	rank_t last_rank = version;
+	for (size_t i = 3; i + 2 < edges.size(); i += 3) {
+		rank_t rank = (rank_t) (edges[i].eightbytevalue.data & 0xf);
+		const hpg_field & value1 = edges[i + 1];
+		const hpg_field & value2 = edges[i + 2];
+		if (rank == totalBytes) {
+			bytes = (value1.eightbytevalue.data << 32) + value2.eightbytevalue.data;
+			continue;
+		}
+		if (rank == edge_label) { // Annotates the edge before, still open
+			int partition = ChpgData::get_partition(last_rank);
+			links << ",\"" << (partition == 3 ? "bytes" : "flows") << "\":" << value1.eightbytevalue.data;
+			if (value2.eightbytevalue.data != 0)
+				write_json_count(links, partition == 3 ? "packets" : "packets_per_flow", value2.eightbytevalue.data);
+			continue;
+		}
+		int partition = ChpgData::get_partition(rank);
+		if (partition == 0)
+			continue;
+		if (last_rank != version)
+			links << "},\n";
+		last_rank = rank;
+
+		string from = ChpgData::get_node_id(rank, value1, false), to = ChpgData::get_node_id(rank, value2, true);
+		if (partition == 1 && node_ids.insert(from).second) {
+			localIP = IPv6_addr(value1.data);
+			nodes << (node_ids.size() > 1 ? ",\n" : "") << "{\"id\":" << json_string(from) << ",\"partition\":1,\"label\":" << json_string(localIP.toString())
+			      << ",\"summary\":false}";
+		}
+		if (node_ids.insert(to).second)
+			nodes << (node_ids.size() > 1 ? ",\n" : "") << "{\"id\":" << json_string(to) << ",\"partition\":" << partition + 1 << ",\"label\":"
+			      << json_string(ChpgData::get_node_label(rank, value2)) << ",\"summary\":" << (ChpgData::is_summary_node(rank) ? "true" : "false") << "}";
+
+		links << "{\"from\":" << json_string(from) << ",\"to\":" << json_string(to);
+		if (partition == 3) {
+			uint8_t flowtype = GET_FLOWTYPE(value1.eightbytevalue.data);
+			if (flowtype & biflow)
+				links << ",\"direction\":\"both\"";
+			else if (flowtype & inflow)
+				links << ",\"direction\":\"in\"";
+			else if (flowtype & outflow)
+				links << ",\"direction\":\"out\"";
+			if (flowtype & unibiflow)
+				links << ",\"unibiflow\":true";
+		}
+	}
+	if (last_rank != version)
+		links << "}";
+
+	out << "{\"localIP\":" << json_string(localIP.toString()) << ",\"bytes\":" << bytes << ",\n\"nodes\":[\n" << nodes.str() << "],\n\"edges\":[\n"
+	      << links.str() << "]}\n";
+}
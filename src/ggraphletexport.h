@@ -0,0 +1,108 @@
+#ifndef GGRAPHLETEXPORT_H_
+#define GGRAPHLETEXPORT_H_
+
+/**
+ *	\file ggraphletexport.h
+ *	\brief Bulk export of the graphlets of an hpg file to dot, JSON or rendered images, on several threads.
+ */
+
+#include <stdint.h>
+#include <limits.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "hpg.h"
+#include "ghpgdata.h"
+
+/**
+ *	\class	CDotRenderer
+ *	\brief	Renders graphlets in dot format to image files (e.g. with Graphviz).
+ *
+ *	Each export thread uses its own renderer. All renderers are created by the thread calling
+ *	CGraphletExport::export_graphlets() before the export threads start, so a renderer may fork() worker processes.
+ */
+class CDotRenderer {
+	public:
+		virtual ~CDotRenderer() {
+		}
+
+		/**
+		 *	Render a graphlet.
+		 *
+		 *	\param dot Graphlet in dot format
+		 *	\param filename Image file to write
+		 *
+		 *	\exception std::string Errortext
+		 */
+		virtual void render(const std::string & dot, const std::string & filename) = 0;
+};
+
+/**
+ *	\class	CGraphletExport
+ *	\brief	Writes the graphlets of an hpg data set to one file each, "<localIP>.<format>" in a directory.
+ *
+ *	The graphlets are taken from the metadata of the data set (see ChpgData::get_hpgMetadata()) and transformed by
+ *	several threads sharing the data set.
+ */
+class CGraphletExport {
+	public:
+		/**
+		 *	\enum format_t
+		 *	\brief Output formats
+		 */
+		enum format_t {
+			dot_format, ///< dot (as ChpgData::hpg2dot())
+			json_format, ///< JSON node and edge list
+			svg_format, ///< svg drawn directly from the edges (see CSvgSink)
+			image_format ///< Rendered by a CDotRenderer (see set_renderer())
+		};
+
+		typedef boost::function<CDotRenderer * ()> renderer_factory_t; ///< Creates the renderer of an export thread
+
+		CGraphletExport(ChpgData & hpgData, const std::string & out_dir, format_t format, const std::string & extension = "");
+
+		void set_threads(unsigned int threads);
+		void set_renderer(const renderer_factory_t & factory);
+		void set_progress(std::ostream * progress);
+
+		unsigned int export_graphlets(unsigned int first = 0, unsigned int last = UINT_MAX);
+
+		/// \return Graphlets written so far
+		unsigned int get_done() const {
+			return done;
+		}
+
+		/// \return Graphlets that could not be written
+		unsigned int get_failed() const {
+			return failed;
+		}
+
+		static void write_json(const std::vector<hpg_field> & edges, std::ostream & out);
+
+	private:
+		CGraphletExport(const CGraphletExport &);
+		CGraphletExport & operator=(const CGraphletExport &);
+
+		void run(CDotRenderer * renderer);
+		void export_graphlet(const ChpgMetadata & metadata, CDotRenderer * renderer);
+
+		ChpgData & hpgData; ///< Data set (only read)
+		std::string out_dir; ///< Output directory
+		format_t format; ///< Output format
+		std::string extension; ///< File name extension
+		unsigned int threads; ///< Number of threads (0: one per core)
+		renderer_factory_t renderer_factory; ///< Creates renderers (image_format)
+		std::ostream * progress; ///< Receives the progress (NULL: not shown)
+
+		boost::mutex mutex; ///< Protects the members below
+		std::vector<const ChpgMetadata *> graphlets; ///< Graphlets to export
+		size_t next; ///< Position of the next graphlet to export
+		unsigned int done; ///< Graphlets written
+		unsigned int failed; ///< Graphlets not written
+};
+
+#endif /* GGRAPHLETEXPORT_H_ */
@@ -8,6 +8,7 @@
  */
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <assert.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
@@ -17,6 +18,9 @@
 #include "cflow.h"
 #include "gutil.h"
 #include "gsummarynodeinfo.h"
+#include "gmappedfile.h"
+#include "gedgesink.h"
+#include "ghpgv4.h"
 
 // Use a view where dstPort-->dstIP connections are shown as an additional graph partition
 #define	DSTIP_DOUBLED
@@ -103,14 +107,15 @@ ChpgData::ChpgData() {
 #endif
 	elements = elements_read = rows = graphlet_cnt = 0;
 	hpgdata = NULL;
-	hpgdata_allocated = false;
+	mapped = NULL;
 	show_packet_counts = true;
 	nodeInfos = NULL;
+	v4file = NULL;
 }
 
 /**
- *	Constructor: use actual file size to determine needed memory space
- *	and remember name of file for later.
+ *	Constructor: map the file into memory, nothing is copied. Version 4 files are decoded graphlet by graphlet
+ *	when hpg2dot() is called.
  *
  *	\param filename Name of hpg (host profile graphlet) file (*.hpg)
  *
@@ -121,6 +126,9 @@ ChpgData::ChpgData(const std::string & filename) {
 	int record_size = field_size * 3;
 	fname = filename;
 	next_graphlet = 0;
+	hpgdata = NULL;
+	mapped = NULL;
+	v4file = NULL;
 	int filesize = util::getFileSize(filename);
 	// Obtain file size and derive needed storage space from it
 	if (!util::fileExists(filename) || filesize == 0) {
@@ -129,72 +137,99 @@ ChpgData::ChpgData(const std::string & filename) {
 	} else {
 		cout << "File contains " << filesize << " bytes.\n";
 	}
-	if ((filesize % (record_size)) != 0) { // Do not tolerate incomplete edges
-		string errtext = "file contains incomplete edge data.\n";
-		cerr << "ERROR: " << errtext << endl;
+	if (CHpgV4Reader::is_v4_file(filename)) {
+		// Version 4: sizes and indices as if the edges were version 3 data, after a version edge
+		v4file = new CHpgV4Reader(filename);
+		rows = 1 + v4file->get_rows();
+		elements = 3 * rows;
+		unsigned int index = 3;
+		for (size_t g = 0; g < v4file->get_graphlet_count(); g++) {
+			v4_index.push_back(g == 0 ? 0 : index); // First graphlet starts at the version edge
+			index += 3 * v4file->get_entry(g).rows;
+		}
+	} else {
+		// Sequential: get_hpgMetadata() scans the whole file first
+		mapped = new CMappedFile(filename, CMappedFile::sequential);
+		if ((mapped->size() % (record_size)) != 0) { // Do not tolerate incomplete edges
+			delete mapped;
+			string errtext = "file contains incomplete edge data.\n";
+			cerr << "ERROR: " << errtext << endl;
+			throw errtext;
+		}
+		elements = mapped->size() / field_size;
+		rows = elements / 3;
+		hpgdata = (hpg_field *) mapped->data(); // Read only: hpg data is never modified
+	}
+
+	elements_read = 0;
+	graphlet_cnt = 0;
+	graphlet_version = 0;
+	show_packet_counts = true;
+	nodeInfos = NULL;
+}
+
+/**
+ *	Constructor: use hpg data held in memory (e.g. by a CHpgBufferSink) instead of a file.
+ *
+ *	\param data hpg data (3 fields per edge, starting with a version edge); not copied, must outlive this object
+ *	\param size Size of data in bytes
+ *
+ *	\exception std::string Errormessage
+ */
+ChpgData::ChpgData(hpg_field * data, int size) {
+	if (size == 0 || size % (3 * sizeof(hpg_field)) != 0) {
+		string errtext = "ERROR: hpg data is empty or contains incomplete edge data.\n";
 		throw errtext;
 	}
-	elements = filesize / field_size;
+	next_graphlet = 0;
+	v4file = NULL;
+	mapped = NULL;
+	hpgdata = data;
+	elements = elements_read = size / sizeof(hpg_field);
 	rows = elements / 3;
-
-	hpgdata = new hpg_field[elements];
-	hpgdata_allocated = true;
 	graphlet_cnt = 0;
-	hpgMetadata = new ChpgMetadata*[rows]; // Row count is upper bound on graphlet count
 	graphlet_version = 0;
 	show_packet_counts = true;
 	nodeInfos = NULL;
+
+	rank_t rank = (rank_t) (hpgdata[0].eightbytevalue.data & 0xf);
+	if (rank != version) {
+		string errtext = "ERROR: cannot determine graphlet version from hpg data.\n";
+		throw errtext;
+	}
+	graphlet_version = 3;
 }
 
 /**
  * ChpgData destructor
  */
 ChpgData::~ChpgData() {
-	if (hpgdata != NULL && hpgdata_allocated)
-		delete hpgdata;
-	if (hpgMetadata != NULL) {
-		for (int i = 0; i < graphlet_cnt; i++) {
-			delete hpgMetadata[i];
-		}
-		delete hpgMetadata;
-	}
+	clear_hpgMetadata();
+	delete mapped;
+	delete v4file;
 }
 
 /**
- *	Read hpg file data into memory.
+ *	Make hpg file data available: check the mapped data of a version 3 file. Version 4 files need no
+ *	preparation, their graphlets are decoded by hpg2dot().
  *
  *	\exception std::string Errormessage
  */
 void ChpgData::read_hpg_file() {
-	if (util::getFileSize(fname) == 0) {
+	elements_read = elements;
+	if (v4file != NULL) {
+		graphlet_version = 3;
+		if (dbg)
+			cout << "A total of " << rows - 1 << " rows (edges) of " << v4file->get_graphlet_count() << " graphlets in input file \"" << fname
+			      << "\" (version 4).\n";
+		return;
+	}
+	if (elements == 0) {
 		string error = "ERROR: empty file.";
 		throw error;
 	}
-
-	// Read file data and store it in array "data"
-	ifstream infs;
-	try {
-		util::open_infile(infs, fname);
-	} catch (string & e) {
-		throw e;
-	}
-
-	int j = 0;
-	while (infs.good()) {
-		if (j > elements) {
-			cerr << "ERROR: array \"data\" overflow.\n";
-			break;
-		}
-		infs.read((char *) (&hpgdata[j]), 3 * sizeof(IPv6_addr));
-		j += 3;
-	}
-	infs.close();
-	elements_read = j - 3; // Correct for last increment
 	if (dbg)
-		cout << "A total of " << elements_read << " elements and " << elements_read / 3 << " rows (edges) read from input file \"" << fname << "\".\n";
-
-	if (elements_read != elements)
-		cerr << "ERROR: calculated count of elements and effective caount of elements do not match.\n";
+		cout << "A total of " << elements_read << " elements and " << elements_read / 3 << " rows (edges) mapped from input file \"" << fname << "\".\n";
 
 	rank_t rank = (rank_t) (hpgdata[0].eightbytevalue.data & 0xf);
 	if (rank == version) {
@@ -222,7 +257,6 @@ void ChpgData::read_hpg_memory(hpg_field * memdata, int size) {
 	hpgdata = memdata;
 	elements = elements_read = size / sizeof(hpg_field);
 	rows = elements / 3;
-	hpgMetadata = new ChpgMetadata*[rows]; // Row count is upper bound on graphlet count
 }
 
 /**
@@ -230,6 +264,11 @@ void ChpgData::read_hpg_memory(hpg_field * memdata, int size) {
  *	a later graphlet extraction.
  */
 void ChpgData::get_hpgMetadata() {
+	clear_hpgMetadata();
+	if (v4file != NULL) {
+		get_hpgMetadata4();
+		return;
+	}
 	rank_t rank = (rank_t) (hpgdata[0].eightbytevalue.data & 0xf);
 	if (rank == version) {
 		graphlet_version = 3;
@@ -240,6 +279,36 @@ void ChpgData::get_hpgMetadata() {
 	}
 }
 
+/**
+ *	Delete the metadata of all graphlets.
+ */
+void ChpgData::clear_hpgMetadata() {
+	for (size_t i = 0; i < hpgMetadata.size(); i++)
+		delete hpgMetadata[i];
+	hpgMetadata.clear();
+	graphlet_cnt = 0;
+	next_graphlet = 0;
+}
+
+/**
+ *	Take the metadata from the directory of a version 4 file (no scan needed).
+ */
+void ChpgData::get_hpgMetadata4() {
+	for (graphlet_cnt = 0; graphlet_cnt < (int) v4file->get_graphlet_count(); graphlet_cnt++) {
+		const CHpgV4Reader::entry_t & entry = v4file->get_entry(graphlet_cnt);
+		ChpgMetadata * metadata = new ChpgMetadata();
+		metadata->graphlet_nr = graphlet_cnt; // As for version 3: graphlet counter
+		metadata->edge_count = entry.edge_count;
+		metadata->prot_count = entry.prot_count;
+		metadata->dstIP_cnt = entry.dstIP_cnt;
+		metadata->srcPort_cnt = entry.srcPort_cnt;
+		metadata->dstPort_cnt = entry.dstPort_cnt;
+		metadata->bytesForAllFlows = entry.bytesForAllFlows;
+		metadata->index = v4_index[graphlet_cnt];
+		hpgMetadata.push_back(metadata);
+	}
+}
+
 /**
  *	Graphlet profile data definition (v2):
  *	 Note: we separate port numbers by protocol and by host identity
@@ -271,7 +340,8 @@ void ChpgData::get_hpgMetadata() {
  *	\exception std::string Errormessage
  */
 void ChpgData::get_hpgMetadata3(void) {
-	cout << "INFO: version 3\n\n";
+	if (dbg)
+		cout << "INFO: version 3\n\n";
 
 	rank_t rank = localIP_prot;
 	rank_t last_rank = localIP_prot;
@@ -312,7 +382,7 @@ void ChpgData::get_hpgMetadata3(void) {
 			throw errtext;
 		}
 	}
-	hpgMetadata[0] = new ChpgMetadata();
+	hpgMetadata.push_back(new ChpgMetadata());
 	hpgMetadata[0]->graphlet_nr = graphlet_nr;
 	hpgMetadata[0]->index = 0;
 	int edge_cnt = 1;
@@ -422,7 +492,7 @@ void ChpgData::get_hpgMetadata3(void) {
 				graphlet_cnt++; // One graphlet processed
 				// Prepare for new graphlet
 				edge_cnt = 1;
-				hpgMetadata[graphlet_cnt] = new ChpgMetadata();
+				hpgMetadata.push_back(new ChpgMetadata());
 				//				hpgMetadata[graphlet_cnt]->graphlet_nr = graphlet_nr;
 				hpgMetadata[graphlet_cnt]->graphlet_nr = graphlet_cnt; // Use graphlet counter as it is not restricted to a max of 8192
 				hpgMetadata[graphlet_cnt]->index = i;
@@ -501,6 +571,21 @@ void ChpgData::hpg2dot(int index, std::string & outfilename) {
 	}
 }
 
+/**
+ *	Transform graphlet whose data is contained at "index" in data array "data"
+ *	into DOT format and write DOT data to a stream.
+ *
+ *	\param index Index into array "data". A valid index is a multiple of three.
+ *	\param out Output stream
+ *
+ *	\exception std::string Errormessage
+ */
+void ChpgData::hpg2dot(int index, std::ostream & out) {
+	assert(graphlet_version == 3);
+	// version 3 is the only supported one
+	hpg2dot3(index, out);
+}
+
 /**
  *	Transform graphlet whose data is contained at "index" in data array "data"
  *	into DOT format and store DOT data in a temporary file with name ".g.dot"
@@ -520,6 +605,71 @@ void ChpgData::hpg2dot3(int index, std::string & outfilename) {
 		cerr << "ERROR: " << errtext;
 		throw errtext;
 	}
+	hpg2dot3(index, outfs);
+	outfs.close();
+	if (dbg) {
+		cout << "Successfully written file " << outfilename << endl;
+	}
+}
+
+/**
+ *	Find the graphlet at "index" of a version 4 file.
+ *
+ *	\param index Index of the graphlet (see ChpgMetadata::index)
+ *
+ *	\return Position of the graphlet in the directory of the file
+ *
+ *	\exception std::string Errormessage (no graphlet starts at index)
+ */
+size_t ChpgData::find_graphlet4(int index) {
+	vector<unsigned int>::const_iterator it = lower_bound(v4_index.begin(), v4_index.end(), (unsigned int) index);
+	if (index < 0 || it == v4_index.end() || *it != (unsigned int) index) {
+		stringstream ss;
+		ss << "ERROR: no graphlet starts at index " << index << ".\n";
+		throw ss.str();
+	}
+	return it - v4_index.begin();
+}
+
+/**
+ *	Decode the graphlet at "index" of a version 4 file (index as if it was version 3 data) and
+ *	transform it into DOT format. Only this graphlet is decoded.
+ *
+ *	\param index Index of the graphlet (see ChpgMetadata::index)
+ *	\param outfs Output stream
+ *
+ *	\exception std::string Errormessage
+ */
+void ChpgData::hpg2dot4(int index, std::ostream & outfs) {
+	size_t graphlet = find_graphlet4(index);
+	if (v4file->get_entry(graphlet).rows == 0) // All flows of this host filtered
+		throw "No flows left.";
+
+	CHpgBufferSink edges;
+	edges.add_version_edge();
+	v4file->decode_graphlet(graphlet, edges);
+	vector<hpg_field> & data = edges.get_data();
+	ChpgData decoded(&data[0], data.size() * sizeof(hpg_field));
+	decoded.nodeInfos = nodeInfos;
+	decoded.show_packet_counts = show_packet_counts;
+	decoded.hpg2dot3(0, outfs);
+}
+
+/**
+ *	Transform graphlet whose data is contained at "index" in data array "data"
+ *	into DOT format and write DOT data to a stream.
+ *	Assumes graphlet format v3.
+ *
+ *	\param index Index into array "data". A valid index is a multiple of three.
+ *	\param outfs Output stream
+ *
+ *	\exception std::string Errormessage
+ */
+void ChpgData::hpg2dot3(int index, std::ostream & outfs) {
+	if (v4file != NULL) {
+		hpg2dot4(index, outfs);
+		return;
+	}
 
 	// Write dot header data
 	outfs << "graph G { /* Created by hpg2dot3() */\n" <<
@@ -529,9 +679,8 @@ void ChpgData::hpg2dot3(int index, std::string & outfilename) {
 				"node[shape=ellipse];\n";
 
 	hpg_field * value; // Storage for one graph edge in hpg format
-	index += 3; // Skip version edge
 	value = &hpgdata[index]; // Point to first edge
-	if (getRank(value[0]) == version) {
+	if (getRank(value[0]) == version) { // Only the first graphlet of a file starts with the version edge
 		index += 3; // Skip version edge
 		value = &hpgdata[index]; // Point to first edge
 	}
@@ -557,7 +706,7 @@ void ChpgData::hpg2dot3(int index, std::string & outfilename) {
 	// We expect first edge to have rank=localIP_prot
 	// (must be an edge incident to localIP)
 
-	static int counter_for_unique_subgraphs = 0;
+	int counter_for_unique_subgraphs = 0; // Numbers the rank subgraphs of this dot file
 	if (rank == localIP_prot) {
 		IPv6_addr localIP(value[1].data);
 		// Rank list
@@ -1065,9 +1214,8 @@ void ChpgData::hpg2dot3(int index, std::string & outfilename) {
 			cout << nodeInfos->printNodeInfos();
 		}
 	}
-	outfs.close();
 	if (dbg) {
-		cout << "Successfully written " << i << " edges to file " << outfilename << endl;
+		cout << "Successfully written " << i / 3 << " edges.\n";
 	}
 	if (dbg4) {
 		for (int j = index - 3; j < index + i; j += 3) {
@@ -1076,6 +1224,159 @@ void ChpgData::hpg2dot3(int index, std::string & outfilename) {
 	}
 }
 
+/**
+ *	Pass the edges of the graphlet at "index" to a sink, followed by the end of the graphlet. The edges are those
+ *	hpg2dot() transforms, without version edge. Graphlets of version 4 files are decoded.
+ *	Only reads data of this object: several threads can get graphlets at the same time.
+ *
+ *	\param index Index of the graphlet (see ChpgMetadata::index)
+ *	\param sink Receives the edges
+ *
+ *	\exception std::string Errormessage
+ */
+void ChpgData::get_graphlet_edges(int index, CEdgeSink & sink) {
+	if (v4file != NULL) {
+		size_t graphlet = find_graphlet4(index);
+		v4file->decode_graphlet(graphlet, sink);
+		sink.end_graphlet(v4file->get_entry(graphlet).graphlet_nr, nodeInfos);
+		return;
+	}
+	if (index < 0 || index % 3 != 0 || index >= elements_read) {
+		stringstream ss;
+		ss << "ERROR: no graphlet starts at index " << index << ".\n";
+		throw ss.str();
+	}
+	if (getRank(hpgdata[index]) == version) // Only the first graphlet of a file starts with the version edge
+		index += 3;
+	uint16_t graphlet_nr = index < elements_read ? getGraphletNumber(hpgdata[index]) : 0;
+	for (int i = index; i < elements_read && getGraphletNumber(hpgdata[i]) == graphlet_nr; i += 3)
+		sink.add_edge(graphlet_nr, getRank(hpgdata[i]), hpgdata[i + 1], hpgdata[i + 2]);
+	sink.end_graphlet(graphlet_nr, nodeInfos);
+}
+
+/**
+ *	Get the partition of the left-hand node of a version 3 edge (the right-hand node is in the next one).
+ *
+ *	\param rank Rank of the edge
+ *
+ *	\return Partition: 1 (localIP) .. 4 (remotePort), 0 for edges without nodes (edge_label, totalBytes, version)
+ */
+int ChpgData::get_partition(rank_t rank) {
+	switch (rank) {
+		case localIP_prot:
+			return 1;
+
+		case prot_localPort:
+		case prot_localPortSum:
+			return 2;
+
+		case localPort_remotePort:
+		case localPortSum_remotePort:
+		case localPort_remotePortSum:
+		case localPortSum_remotePortSum:
+			return 3;
+
+		case remotePort_remoteIP:
+		case remotePortSum_remoteIP:
+		case remotePort_remoteIPsum:
+		case remotePortSum_remoteIPsum:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+/**
+ *	Check if the right-hand node of a version 3 edge is a summary node.
+ *
+ *	\param rank Rank of the edge
+ *
+ *	\return True if the node summarizes several ports or hosts (drawn as box)
+ */
+bool ChpgData::is_summary_node(rank_t rank) {
+	switch (rank) {
+		case prot_localPortSum:
+		case localPort_remotePortSum:
+		case localPortSum_remotePortSum:
+		case remotePort_remoteIPsum:
+		case remotePortSum_remoteIPsum:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Get the dot node id of a node of a version 3 edge ("k<partition>_<value>", as written by hpg2dot3()).
+ *
+ *	\param rank Rank of the edge
+ *	\param value Annotation of the node (value 1 for the left-hand node, value 2 for the right-hand node)
+ *	\param right True for the right-hand node
+ *
+ *	\return Node id (unique within the graphlet)
+ */
+std::string ChpgData::get_node_id(rank_t rank, const hpg_field & value, bool right) {
+	int partition = get_partition(rank);
+	stringstream ss;
+	ss << "k" << partition + (right ? 1 : 0) << "_";
+	if ((!right && partition == 1) || (right && partition == 4)) {
+		ss << IPv6_addr(value.data).toNumericString();
+	} else if (!right && partition == 3) { // Suppress flow type
+		ss << ((rank == localPortSum_remotePort || rank == localPortSum_remotePortSum) ? value.eightbytevalue.data : (value.eightbytevalue.data
+		      & LOCAL_EPORT0_MASK));
+	} else if (right && partition == 2) {
+		ss << ((rank == prot_localPortSum) ? value.eightbytevalue.data : (value.eightbytevalue.data & LOCAL_EPORT0_MASK));
+	} else {
+		ss << value.eightbytevalue.data;
+	}
+	return ss.str();
+}
+
+/**
+ *	Get the label of the right-hand node of a version 3 edge, as shown by hpg2dot3().
+ *
+ *	\param rank Rank of the edge
+ *	\param value Annotation of the right-hand node (value 2)
+ *
+ *	\return Label: protocol name, port, IP address or node count of summary nodes ("" if unknown)
+ */
+std::string ChpgData::get_node_label(rank_t rank, const hpg_field & value) {
+	uint64_t node = value.eightbytevalue.data;
+	stringstream ss;
+	switch (rank) {
+		case localIP_prot:
+			ss << util::ipV6ProtocolToString((uint8_t) node);
+			break;
+
+		case prot_localPort:
+		case localPort_remotePort:
+		case localPortSum_remotePort:
+			ss << (uint16_t) (node & 0xffff);
+			break;
+
+		case prot_localPortSum:
+		case localPort_remotePortSum:
+		case localPortSum_remotePortSum:
+			if (getConnectionCount(value) > 0)
+				ss << getConnectionsString(getConnectionCount(value)) << getRoleNrString(getRoleNumber(value));
+			break;
+
+		case remotePort_remoteIP:
+		case remotePortSum_remoteIP:
+			ss << IPv6_addr(value.data);
+			break;
+
+		case remotePort_remoteIPsum:
+		case remotePortSum_remoteIPsum:
+			ss << getHostsString(getConnectionCount(value)) << getRoleNrString(getRoleNumber(value));
+			break;
+
+		default:
+			break;
+	}
+	return ss.str();
+}
+
 /**
  * Formats the connection count
  *
@@ -1245,29 +1546,7 @@ bool ChpgData::partition_changed3(rank_t rank, rank_t last_rank) {
 int ChpgData::rank2partition(rank_t rank) {
 	if (graphlet_version < 3)
 		return rank;
-
-	switch (rank) {
-		case localIP_prot:
-			return 1;
-
-		case prot_localPort:
-		case prot_localPortSum:
-			return 2;
-
-		case localPort_remotePort:
-		case localPortSum_remotePort:
-		case localPort_remotePortSum:
-		case localPortSum_remotePortSum:
-			return 3;
-
-		case remotePort_remoteIP:
-		case remotePortSum_remoteIP:
-		case remotePort_remoteIPsum:
-		case remotePortSum_remoteIPsum:
-			return 4;
-		default:
-			return 0;
-	}
+	return get_partition(rank);
 }
 
 /**
@@ -1308,7 +1587,7 @@ ChpgMetadata * ChpgData::get_next_graphlet() {
  *	\exception std::string Errormessage
  */
 int ChpgData::get_index(unsigned int graphlet_nr) {
-	if (hpgMetadata[graphlet_nr]->graphlet_nr == graphlet_nr) {
+	if (graphlet_nr < hpgMetadata.size() && hpgMetadata[graphlet_nr]->graphlet_nr == graphlet_nr) {
 		// This is a hit if graphlet numbers start at 0 and are ascending (default)
 		if (dbg) {
 			cout << "get_index(): HIT -> graphlet number == line number.\n";
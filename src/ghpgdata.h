@@ -16,12 +16,18 @@
 
 #include <stdlib.h>
 #include <string>
+#include <vector>
+#include <iostream>
 #include <arpa/inet.h>
 
 #include "gutil.h"
 #include "hpg.h"
 #include "gsummarynodeinfo.h"
 
+class CHpgV4Reader;
+class CMappedFile;
+class CEdgeSink;
+
 /**
  *	\struct node_hm_value
  *	\brief Struct for a uint32_t rank and a hpg_field.
@@ -80,6 +86,7 @@ class ChpgData {
 	public:
 		ChpgData();
 		ChpgData(const std::string & filename);
+		ChpgData(hpg_field * data, int size);
 		~ChpgData();
 
 		void read_hpg_file();
@@ -87,7 +94,10 @@ class ChpgData {
 		void get_hpgMetadata(void);
 		int get_num_graphlets();
 		void hpg2dot(int index, std::string & outfilename);
+		void hpg2dot(int index, std::ostream & out);
 		void hpg2dot3(int index, std::string & outfilename);
+		void hpg2dot3(int index, std::ostream & outfs);
+		void get_graphlet_edges(int index, CEdgeSink & sink);
 		ChpgMetadata * get_first_graphlet();
 		ChpgMetadata * get_next_graphlet();
 		int get_index(unsigned int graphlet_nr);
@@ -95,6 +105,12 @@ class ChpgData {
 		void show_edge_data(hpg_field * value);
 		void show_data(int index1, int index2);
 
+		// Nodes of version 3 edges, as shown by hpg2dot3()
+		static int get_partition(rank_t rank);
+		static bool is_summary_node(rank_t rank);
+		static std::string get_node_id(rank_t rank, const hpg_field & value, bool right);
+		static std::string get_node_label(rank_t rank, const hpg_field & value);
+
 		CSummaryNodeInfos* nodeInfos; ///< Storage for nodeid filter (needed by HAP4NfSen)
 
 #ifdef GUI
@@ -108,8 +124,8 @@ class ChpgData {
 		std::string dot_filename; ///< Default dot file name
 		std::string gif_filename; ///< Default gif file name
 		std::string fname; ///< Name for hpg file
-		hpg_field * hpgdata; ///< Array where HPG file data is stored
-		bool hpgdata_allocated; ///< Set true when data has been allocated. This is only the case when cstor with file name has been used)
+		hpg_field * hpgdata; ///< Array of HPG data: mapped version 3 file or data of the caller (NULL for version 4 files)
+		CMappedFile * mapped; ///< Mapped version 3 file (NULL if none)
 		bool show_packet_counts; ///< If true the bytes and packets edge annotations are used
 
 		int elements; ///< Size of array "data" in number of entries
@@ -118,10 +134,16 @@ class ChpgData {
 		int next_graphlet; ///< Auxiliary counter for get_first/next_graphlet functions
 
 		int graphlet_cnt; ///< Count for graphlets
-		ChpgMetadata ** hpgMetadata; ///< Array of ptrs to graphlet metadata objects
+		std::vector<ChpgMetadata *> hpgMetadata; ///< Graphlet metadata objects, one per graphlet
 		int graphlet_version; ///< Graphlet profile format version (1, 2)
+		CHpgV4Reader * v4file; ///< Version 4 file (NULL for version 3 data), graphlets are decoded by hpg2dot()
+		std::vector<unsigned int> v4_index; ///< Index of each graphlet of a version 4 file, as if it was version 3 data
 
 		void get_hpgMetadata3(void);
+		void get_hpgMetadata4(void);
+		void clear_hpgMetadata();
+		size_t find_graphlet4(int index);
+		void hpg2dot4(int index, std::ostream & outfs);
 
 		bool partition_changed3(rank_t rank, rank_t last_rank);
 		int rank2partition(rank_t rank);
@@ -0,0 +1,370 @@
+/**
+ *	\file ghpgv4.cpp
+ *	\brief Compact hpg format (version 4): graphlet directory and varint packed edges.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+
+#include "ghpgv4.h"
+#include "ghpgdata.h"
+
+using namespace std;
+
+const uint32_t CHpgV4Reader::magic;
+const uint32_t CHpgV4Reader::format_version;
+
+/// Bit of the rank byte of an edge: an annotation (edge_label edge) follows
+static const uint8_t label_flag = 0x10;
+
+/**
+ *	\param rank Rank of an edge
+ *
+ *	\return True if value 1 of edges of this rank is an IP address
+ */
+static bool value1_is_IP(uint8_t rank) {
+	return rank == localIP_prot;
+}
+
+/**
+ *	\param rank Rank of an edge
+ *
+ *	\return True if value 2 of edges of this rank is an IP address
+ */
+static bool value2_is_IP(uint8_t rank) {
+	return rank == remotePort_remoteIP || rank == remotePortSum_remoteIP;
+}
+
+static void put_varint(uint64_t value, string & out) {
+	while (value >= 0x80) {
+		out += (char) ((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	out += (char) value;
+}
+
+/**
+ *	Append the difference of a value to the previous one as zigzag varint (small differences of either sign
+ *	take few bytes), and make the value the previous one.
+ */
+static void put_delta(uint64_t value, uint64_t & previous, string & out) {
+	int64_t delta = (int64_t) (value - previous);
+	put_varint(((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63), out);
+	previous = value;
+}
+
+/**
+ *	Append an IP address as count of leading bytes shared with the previous one followed by the other bytes,
+ *	and make it the previous one.
+ */
+static void put_IP(const hpg_field & value, hpg_field & previous, string & out) {
+	size_t shared = 0;
+	while (shared < value.data.size() && value.data[shared] == previous.data[shared])
+		shared++;
+	out += (char) shared;
+	out.append((const char *) value.data.data() + shared, value.data.size() - shared);
+	previous = value;
+}
+
+/**
+ *	\class	CBlockDecoder
+ *	\brief	Reads the values of a graphlet block, checking its bounds.
+ */
+class CBlockDecoder {
+	public:
+		CBlockDecoder(const uint8_t * data, size_t size) :
+			pos(data), end(data + size) {
+		}
+
+		bool at_end() const {
+			return pos == end;
+		}
+
+		uint8_t get_byte() {
+			if (pos == end)
+				throw string("ERROR: hpg graphlet block is truncated or damaged.");
+			return *pos++;
+		}
+
+		uint64_t get_varint() {
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				uint8_t byte = get_byte();
+				value |= (uint64_t) (byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+					return value;
+			}
+			throw string("ERROR: hpg graphlet block is truncated or damaged.");
+		}
+
+		void get_delta(hpg_field & value, uint64_t & previous) {
+			uint64_t zigzag = get_varint();
+			previous += (uint64_t) ((int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1));
+			value.reset();
+			value.eightbytevalue.data = previous;
+		}
+
+		void get_IP(hpg_field & value, hpg_field & previous) {
+			size_t shared = get_byte();
+			if (shared > value.data.size())
+				throw string("ERROR: hpg graphlet block is truncated or damaged.");
+			value = previous;
+			for (size_t i = shared; i < value.data.size(); i++)
+				value.data[i] = get_byte();
+			previous = value;
+		}
+
+	private:
+		const uint8_t * pos; ///< Next byte
+		const uint8_t * end; ///< End of the block
+};
+
+/**
+ *	Constructor: map a version 4 hpg file and check header, directory and block positions.
+ *
+ *	\param filename Name of the file
+ *
+ *	\exception std::string Errortext (not a version 4 hpg file, truncated or damaged)
+ */
+CHpgV4Reader::CHpgV4Reader(const string & filename) :
+	file(new CMappedFile(filename, CMappedFile::random)) {
+	const uint8_t * data = file->data();
+	uint64_t size = file->size();
+
+	header_t header;
+	if (size < sizeof(header))
+		throw "ERROR: " + filename + " is not a version 4 hpg file.";
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != magic || header.version != format_version)
+		throw "ERROR: " + filename + " is not a version 4 hpg file.";
+	if (header.directory_offset < sizeof(header) || header.directory_offset > size || header.graphlet_count != (size
+	      - header.directory_offset) / sizeof(entry_t) || (size - header.directory_offset) % sizeof(entry_t) != 0)
+		throw "ERROR: hpg file " + filename + " is truncated or damaged.";
+
+	directory.resize(header.graphlet_count);
+	if (!directory.empty())
+		memcpy(&directory[0], data + header.directory_offset, directory.size() * sizeof(entry_t));
+	for (vector<entry_t>::const_iterator it = directory.begin(); it != directory.end(); ++it) {
+		if (it->offset < sizeof(header) || it->offset > header.directory_offset || it->size > header.directory_offset - it->offset)
+			throw "ERROR: hpg file " + filename + " is truncated or damaged.";
+	}
+}
+
+/**
+ *	Check if a file is a version 4 hpg file (by its magic).
+ *
+ *	\param filename Name of the file
+ *
+ *	\return True if the file starts like a version 4 hpg file
+ */
+bool CHpgV4Reader::is_v4_file(const string & filename) {
+	ifstream in(filename.c_str(), ios::binary);
+	uint32_t file_magic = 0;
+	in.read((char *) &file_magic, sizeof(file_magic));
+	return in.good() && file_magic == magic;
+}
+
+/**
+ *	\return Edges of all graphlets in version 3 data (including edge_label edges, without version edge)
+ */
+uint64_t CHpgV4Reader::get_rows() const {
+	uint64_t rows = 0;
+	for (vector<entry_t>::const_iterator it = directory.begin(); it != directory.end(); ++it)
+		rows += it->rows;
+	return rows;
+}
+
+/**
+ *	Decode the edges of a graphlet and pass them to a sink, as version 3 edges (annotations as edge_label edges).
+ *	The sink does not receive a version edge and no end_graphlet().
+ *
+ *	\param graphlet Position of the graphlet in the directory
+ *	\param sink Receives the edges
+ *
+ *	\exception std::string Errortext (damaged block)
+ */
+void CHpgV4Reader::decode_graphlet(size_t graphlet, CEdgeSink & sink) const {
+	const entry_t & entry = directory[graphlet];
+	CBlockDecoder block(file->data() + entry.offset, entry.size);
+	hpg_field value1, value2, IP1, IP2, label1, label2;
+	IP1.reset();
+	IP2.reset();
+	uint64_t previous1 = 0, previous2 = 0;
+	while (!block.at_end()) {
+		uint8_t code = block.get_byte();
+		rank_t rank = (rank_t) (code & 0xf);
+		if (value1_is_IP(rank))
+			block.get_IP(value1, IP1);
+		else
+			block.get_delta(value1, previous1);
+		if (value2_is_IP(rank))
+			block.get_IP(value2, IP2);
+		else
+			block.get_delta(value2, previous2);
+		sink.add_edge(entry.graphlet_nr, rank, value1, value2);
+		if (code & label_flag) {
+			label1.reset();
+			label1.eightbytevalue.data = block.get_varint();
+			label2.reset();
+			label2.eightbytevalue.data = block.get_varint();
+			sink.add_edge(entry.graphlet_nr, edge_label, label1, label2);
+		}
+	}
+}
+
+/**
+ *	Constructor: create the file and reserve space for the header.
+ *
+ *	\param filename Name of the file
+ *
+ *	\exception std::string Errortext
+ */
+CHpgV4FileSink::CHpgV4FileSink(const string & filename) :
+	filename(filename), offset(0) {
+	out = fopen(filename.c_str(), "wb");
+	if (out == NULL)
+		throw "ERROR: could not create " + filename + ": " + strerror(errno);
+	CHpgV4Reader::header_t header;
+	memset(&header, 0, sizeof(header));
+	write(&header, sizeof(header));
+}
+
+/**
+ *	Destructor: finish the file if not done yet (errors are reported to cerr).
+ */
+CHpgV4FileSink::~CHpgV4FileSink() {
+	try {
+		finish();
+	} catch (string & e) {
+		cerr << e << endl;
+	}
+}
+
+/**
+ *	Keep an edge of the current graphlet. Version edges are dropped, the header takes their place.
+ *	The edges are kept as graphlet 0: the metadata scan of ChpgData expects a first graphlet numbered 0, and
+ *	the directory entry holds the graphlet number.
+ */
+void CHpgV4FileSink::add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) {
+	if (rank == version)
+		return;
+	if (graphlet.get_data().empty())
+		graphlet.add_version_edge();
+	graphlet.add_edge(0, rank, value1, value2);
+}
+
+/**
+ *	Write the current graphlet as block and add it to the directory.
+ *
+ *	\exception std::string Errortext
+ */
+void CHpgV4FileSink::end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos) {
+	vector<hpg_field> & data = graphlet.get_data();
+	if (data.empty())
+		return;
+	CHpgV4Reader::entry_t entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.graphlet_nr = graphlet_nr;
+	entry.rows = data.size() / 3 - 1;
+	entry.edge_count = entry.rows;
+
+	// Metadata as a reader of version 3 data computes it
+	try {
+		ChpgData hpgData(&data[0], data.size() * sizeof(hpg_field));
+		hpgData.get_hpgMetadata();
+		const ChpgMetadata * metadata = hpgData.get_first_graphlet();
+		if (metadata != NULL) {
+			entry.edge_count = metadata->edge_count;
+			entry.prot_count = metadata->prot_count;
+			entry.dstIP_cnt = metadata->dstIP_cnt;
+			entry.srcPort_cnt = metadata->srcPort_cnt;
+			entry.dstPort_cnt = metadata->dstPort_cnt;
+			entry.bytesForAllFlows = metadata->bytesForAllFlows;
+		}
+	} catch (string &) {
+		// Graphlet without localIP edge (all flows filtered): no metadata
+	}
+
+	string block;
+	encode_graphlet(&data[3], data.size() - 3, block);
+	graphlet.clear();
+	entry.offset = offset;
+	entry.size = block.size();
+	write(block.data(), block.size());
+	directory.push_back(entry);
+}
+
+/**
+ *	Write the directory and the header, and close the file. Further calls do nothing.
+ *
+ *	\exception std::string Errortext
+ */
+void CHpgV4FileSink::finish() {
+	if (out == NULL)
+		return;
+	CHpgV4Reader::header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CHpgV4Reader::magic;
+	header.version = CHpgV4Reader::format_version;
+	header.graphlet_count = directory.size();
+	header.directory_offset = offset;
+	if (!directory.empty())
+		write(&directory[0], directory.size() * sizeof(CHpgV4Reader::entry_t));
+	bool ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+	int error = errno;
+	if (fclose(out) != 0 && ok) {
+		ok = false;
+		error = errno;
+	}
+	out = NULL;
+	if (!ok)
+		throw "ERROR: could not write " + filename + ": " + strerror(error);
+}
+
+/**
+ *	Write data at the end of the file.
+ *
+ *	\exception std::string Errortext
+ */
+void CHpgV4FileSink::write(const void * data, size_t size) {
+	if (out == NULL)
+		throw "ERROR: " + filename + " is already finished.";
+	if (size > 0 && fwrite(data, size, 1, out) != 1)
+		throw "ERROR: could not write " + filename + ": " + strerror(errno);
+	offset += size;
+}
+
+/**
+ *	Encode the edges of a graphlet as block.
+ *
+ *	\param rows Version 3 edges of the graphlet (3 values each), without version edge
+ *	\param row_count Number of values (3 per edge)
+ *	\param block Block (out)
+ */
+void CHpgV4FileSink::encode_graphlet(const hpg_field * rows, size_t row_count, string & block) {
+	hpg_field IP1, IP2;
+	IP1.reset();
+	IP2.reset();
+	uint64_t previous1 = 0, previous2 = 0;
+	for (size_t i = 0; i + 3 <= row_count; i += 3) {
+		uint8_t rank = rows[i].eightbytevalue.data & 0xf;
+		bool labeled = rank != edge_label && i + 6 <= row_count && (rows[i + 3].eightbytevalue.data & 0xf) == edge_label;
+		block += (char) (labeled ? rank | label_flag : rank);
+		if (value1_is_IP(rank))
+			put_IP(rows[i + 1], IP1, block);
+		else
+			put_delta(rows[i + 1].eightbytevalue.data, previous1, block);
+		if (value2_is_IP(rank))
+			put_IP(rows[i + 2], IP2, block);
+		else
+			put_delta(rows[i + 2].eightbytevalue.data, previous2, block);
+		if (labeled) {
+			put_varint(rows[i + 4].eightbytevalue.data, block);
+			put_varint(rows[i + 5].eightbytevalue.data, block);
+			i += 3;
+		}
+	}
+}
@@ -0,0 +1,135 @@
+#ifndef GHPGV4_H_
+#define GHPGV4_H_
+
+/**
+ *	\file ghpgv4.h
+ *	\brief Compact hpg format (version 4): graphlet directory and varint packed edges.
+ *
+ *	Version 3 (see hpg.h) stores each edge as three 16 byte values, each edge annotation as an edge of its own
+ *	and has no index. Version 4 holds the same edges in a fraction of the space and lists the graphlets in a
+ *	directory, so a reader finds any graphlet and its metadata without scanning the file.
+ *
+ *	Layout of a version 4 file:
+ *	- header_t: magic "HPG4", version 4, graphlet count, position of the directory
+ *	- graphlet blocks, one per graphlet
+ *	- directory: one entry_t per graphlet (position and size of the block, edge count, metadata as computed by
+ *	  ChpgData::get_hpgMetadata())
+ *
+ *	A block holds the edges of a graphlet in hpg order, without the version edge. Each edge is stored as
+ *	- 1 byte: rank (bits 3..0), bit 4 set if an edge_label edge follows (annotation of the edge)
+ *	- value 1 and value 2: IP addresses (value 1 of localIP_prot, value 2 of remotePort_remoteIP and
+ *	  remotePortSum_remoteIP) as the count of leading bytes shared with the previous IP address of the block
+ *	  (1 byte) followed by the other bytes. Other values as zigzag varint of the difference to the value at the
+ *	  same position of the previous edge (delta coding).
+ *	- annotation (bit 4 set): its two values as varints
+ *
+ *	Only the low 8 bytes (eightbytevalue) of values other than IP addresses are stored, the high 8 bytes read
+ *	as 0. Like version 3 the format uses native byte order.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "hpg.h"
+#include "gedgesink.h"
+#include "gmappedfile.h"
+
+/**
+ *	\class	CHpgV4Reader
+ *	\brief	Maps a version 4 hpg file and decodes its graphlets.
+ *
+ *	The file is checked when it is opened, so the directory entries and blocks can be used without further checks.
+ */
+class CHpgV4Reader {
+	public:
+		static const uint32_t magic = 0x34475048; ///< "HPG4" (little endian)
+		static const uint32_t format_version = 4;
+
+		/**
+		 *	\struct	header_t
+		 *	\brief	Header of a version 4 file
+		 */
+		struct header_t {
+				uint32_t magic; ///< magic
+				uint32_t version; ///< format_version
+				uint64_t graphlet_count; ///< Entries of the directory
+				uint64_t directory_offset; ///< Position of the directory in the file
+		};
+
+		/**
+		 *	\struct	entry_t
+		 *	\brief	Directory entry of a graphlet
+		 */
+		struct entry_t {
+				uint64_t offset; ///< Position of the block in the file
+				uint64_t bytesForAllFlows; ///< Total byte count of all flows involved
+				uint32_t size; ///< Size of the block in bytes
+				uint32_t graphlet_nr; ///< Graphlet number of the edges (as in version 3 data)
+				uint32_t rows; ///< Edges in version 3 data, including edge_label edges
+				uint32_t edge_count; ///< Metadata: total count of graphlet edges
+				uint32_t prot_count; ///< Metadata: total count of used protocols
+				uint32_t dstIP_cnt; ///< Metadata: total count of used destination IP addresses
+				uint32_t srcPort_cnt; ///< Metadata: total count of used source ports
+				uint32_t dstPort_cnt; ///< Metadata: total count of used destination ports
+		};
+
+		CHpgV4Reader(const std::string & filename);
+
+		static bool is_v4_file(const std::string & filename);
+
+		/// \return Number of graphlets
+		size_t get_graphlet_count() const {
+			return directory.size();
+		}
+
+		/// \return Directory entry of a graphlet (0 .. get_graphlet_count() - 1)
+		const entry_t & get_entry(size_t graphlet) const {
+			return directory[graphlet];
+		}
+
+		uint64_t get_rows() const;
+		void decode_graphlet(size_t graphlet, CEdgeSink & sink) const;
+
+	private:
+		CHpgV4Reader(const CHpgV4Reader &);
+		CHpgV4Reader & operator=(const CHpgV4Reader &);
+
+		boost::scoped_ptr<CMappedFile> file; ///< Mapped file
+		std::vector<entry_t> directory; ///< Directory
+};
+
+/**
+ *	\class	CHpgV4FileSink
+ *	\brief	Writes the edges to a version 4 hpg file.
+ *
+ *	The graphlets are written as they are finalized, the directory by finish() (called by the destructor if needed).
+ */
+class CHpgV4FileSink: public CEdgeSink {
+	public:
+		CHpgV4FileSink(const std::string & filename);
+		~CHpgV4FileSink();
+		void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2);
+		void end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos);
+		void finish();
+
+		static void encode_graphlet(const hpg_field * rows, size_t row_count, std::string & block);
+
+	private:
+		CHpgV4FileSink(const CHpgV4FileSink &);
+		CHpgV4FileSink & operator=(const CHpgV4FileSink &);
+
+		void write(const void * data, size_t size);
+
+		std::string filename; ///< Name of the file
+		FILE * out; ///< File (NULL when finished)
+		uint64_t offset; ///< Bytes written so far
+		CHpgBufferSink graphlet; ///< Edges of the current graphlet, after a version edge
+		std::vector<CHpgV4Reader::entry_t> directory; ///< Entries of the graphlets written
+};
+
+#endif /* GHPGV4_H_ */
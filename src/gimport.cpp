@@ -40,7 +40,12 @@
 #else
 #include <netinet/if_ether.h>	// Ethernet header, ethernet protocol types
 #endif // __linux__
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/once.hpp>
+
 #include "gimport.h"
+#include "ghpgv4.h"
 #include "gimport_config.h"
 #include "heapsort.h"
 #include "hpg.h"
@@ -49,23 +54,26 @@
 #include "HAPviewer.h"
 #include "cflow.h"
 #include "gfilter.h"
+#include "gexternalsort.h"
+#include "gflowindex.h"
+#include "gsnapshot.h"
 
 using namespace std;
 
 #ifdef NDEBUG
-bool debug =false;
-bool debug2=false;
-bool debug3=false;
-bool debug4=false;
-bool debug5=false;
-bool debug6=false;
+const bool debug =false;
+const bool debug2=false;
+const bool debug3=false;
+const bool debug4=false;
+const bool debug5=false;
+const bool debug6=false;
 #else
-bool debug = false;
-bool debug2 = false;
-bool debug3 = true;
-bool debug4 = true;
-bool debug5 = true;
-bool debug6 = true;
+const bool debug = false;
+const bool debug2 = false;
+const bool debug3 = true;
+const bool debug4 = true;
+const bool debug5 = true;
+const bool debug6 = true;
 #endif
 
 /**
@@ -87,12 +95,17 @@ ChostMetadata::ChostMetadata() {
  * \param newprefs Preferences settings
  */
 CImport::CImport(const CFlowList & flowlist, const prefs_t & newprefs) :
-	full_flowlist(flowlist), active_flowlist(full_flowlist.begin(), full_flowlist.end()), prefs(newprefs) {
+	full_flowlist(flowlist), active_flowlist(full_flowlist.begin(), full_flowlist.end()), full_view(full_flowlist), prefs(newprefs) {
 	next_host_idx = full_flowlist.begin();
 
 	use_reverse_index = true;
+	use_index = true;
+	write_index = true;
+	hostMetadata_full = false;
 	hpg_filename = default_hpg_filename; // No input file name to derive hpg file name from
 	next_host = 0;
+	nodeInfos = NULL;
+	prepare_ip_dictionary();
 }
 
 /**
@@ -121,8 +134,19 @@ CImport::CImport(const std::string & in_filename, const std::string & out_filena
 	next_host_idx = full_flowlist.begin();
 	//	flowlist_allocated = false;
 	use_reverse_index = true;
+	use_index = true;
+	write_index = true;
+	hostMetadata_full = false;
 
 	next_host = 0;
+	nodeInfos = NULL;
+}
+
+/**
+ *	Destructor
+ */
+CImport::~CImport() {
+	delete nodeInfos;
 }
 
 /**
@@ -134,21 +158,49 @@ CImport::CImport(const std::string & in_filename, const std::string & out_filena
 void CImport::prepare_reverse_index() {
 	cout << "Preparing index for remote IP-based outside graphlet look-up.\n";
 	// Use 2 auxiliary arrays for sorting
-	vector<IPv6_addr> IPs(full_flowlist.size());
-	remoteIP_index.resize(full_flowlist.size());
-	// Initialize sorting indices
-	// IPs = localIP
+	// IPs = remote address ids (ordered like the addresses)
 	// r_index = index into all_flowlist
-	for (unsigned int j = 0; j < full_flowlist.size(); j++) {
-		IPs[j] = full_flowlist[j].remoteIP;
+	const uint32_t * remoteIP_ids = full_view.columns().remoteIP_ids();
+	vector<uint32_t> IPs(remoteIP_ids, remoteIP_ids + full_flowlist.size());
+	remoteIP_index.resize(full_flowlist.size());
+	for (unsigned int j = 0; j < full_flowlist.size(); j++)
 		remoteIP_index[j] = j;
-	}
 	// Now sort arrays such that IPs have ascending order
 	// ({IP, index} pairs are preserved)
-	heapSort(IPs, remoteIP_index);
+	if (!IPs.empty())
+		heapSort(&IPs[0], &remoteIP_index[0], IPs.size());
 	cout << "Done.\n";
 }
 
+/**
+ *	Assign ids to all addresses of full_flowlist and use them for the columns of active_flowlist
+ *	and full_view.
+ */
+void CImport::prepare_ip_dictionary() {
+	ip_dictionary.reset(new CIPDictionary(full_flowlist.begin(), full_flowlist.end()));
+	active_flowlist.set_dictionary(ip_dictionary);
+	full_view.set_dictionary(ip_dictionary);
+}
+
+/**
+ *	Let active_flowlist and full_view span all of full_flowlist, with new address ids.
+ *
+ *	\param dictionary Address ids of full_flowlist (NULL: build them from full_flowlist)
+ */
+void CImport::reset_views(boost::shared_ptr<const CIPDictionary> dictionary) {
+	active_flowlist.invalidate();
+	active_flowlist.setBegin(full_flowlist.begin());
+	active_flowlist.setEnd(full_flowlist.end());
+	full_view = Subflowlist(full_flowlist);
+	if (dictionary) {
+		ip_dictionary = dictionary;
+		active_flowlist.set_dictionary(ip_dictionary);
+		full_view.set_dictionary(ip_dictionary);
+	} else {
+		prepare_ip_dictionary();
+	}
+}
+
 /**
  *	Prepare all_flowlist.
  *	This includes sorting by ascending order of localIP,
@@ -166,9 +218,11 @@ void CImport::prepare_flowlist() {
 	// a) Sort arrays such that IPs have ascending order
 	sort(full_flowlist.begin(), full_flowlist.end()); // Not necessary on cflow lists but still leave it here as we got way too many unsorted examples
 
-	active_flowlist.invalidate();
-	active_flowlist.setBegin(full_flowlist.begin());
-	active_flowlist.setEnd(full_flowlist.end());
+	reset_views();
+	vector<uint32_t> localIP_ids, remoteIP_ids;
+	localIP_ids.reserve(full_flowlist.size());
+	remoteIP_ids.reserve(full_flowlist.size());
+	ip_dictionary->encode(full_flowlist.begin(), full_flowlist.end(), localIP_ids, remoteIP_ids);
 
 	// b) Perform uniflow qualification
 	// --------------------------------
@@ -185,17 +239,18 @@ void CImport::prepare_flowlist() {
 	cout << "Preparing for qualification of uniflows." << endl;
 
 	int host_pairs = 0;
+	int progress = 0;
 	for (CFlowList::iterator flowiterator = full_flowlist.begin(); flowiterator != full_flowlist.end(); flowiterator++) { // Go through all flows
+		size_t idx = flowiterator - full_flowlist.begin();
 		// Show progress on console
-		static int i = 0;
-		if (((i++ % 100000) == 0) && (i > 0)) {
+		if ((++progress % 100000) == 0) {
 			cout << ".";
 			cout.flush();
 		}
 
 		int biflow_inc = ((flowiterator->flowtype & biflow) != 0) ? 1 : 0;
 
-		FlowHashKeyHostPair hostPairKey((flowiterator->localIP), (flowiterator->remoteIP));
+		FlowHashKeyHostPair hostPairKey(localIP_ids[idx], remoteIP_ids[idx]);
 		FlowHashMapHostPairIterator = flowHmHostPair->find(hostPairKey);
 		if (FlowHashMapHostPairIterator == flowHmHostPair->end()) {
 			// New host pair
@@ -218,8 +273,7 @@ void CImport::prepare_flowlist() {
 	for (CFlowList::iterator flowiterator = full_flowlist.begin(); flowiterator < full_flowlist.end(); flowiterator++) { // Go through all flows
 
 		// Show progress on console
-		static int i = 0;
-		if (((i++ % 100000) == 0) && (i > 0)) {
+		if ((++progress % 100000) == 0) {
 			cout << ".";
 			cout.flush();
 		}
@@ -227,7 +281,8 @@ void CImport::prepare_flowlist() {
 		if ((flowiterator->flowtype & uniflow) != 0) {
 			uniflow_count++;
 
-			FlowHashKeyHostPair hostPairKey((flowiterator->localIP), (flowiterator->remoteIP));
+			size_t idx = flowiterator - full_flowlist.begin();
+			FlowHashKeyHostPair hostPairKey(localIP_ids[idx], remoteIP_ids[idx]);
 			FlowHashMapHostPairIterator = flowHmHostPair->find(hostPairKey);
 			if (FlowHashMapHostPairIterator != flowHmHostPair->end()) {
 				// Host pair found
@@ -297,7 +352,7 @@ bool CImport::set_localIP(IPv6_addr newLocalIP, int host_count) {
 		CFlowList::iterator flowlistIterator_end = flowlistIterator_start;
 		IPv6_addr lastIP = flowlistIterator_end->localIP;
 		unsigned int hc = 0; // Host iterator
-		while (hc < (unsigned int) host_count && flowlistIterator_end != active_flowlist.end()) {
+		while (hc < (unsigned int) host_count && flowlistIterator_end != full_flowlist.end()) {
 			if (flowlistIterator_end->localIP != lastIP) {
 				lastIP = flowlistIterator_end->localIP;
 				hc++;
@@ -326,7 +381,7 @@ bool CImport::set_localIP(IPv6_addr newLocalIP, int host_count) {
 }
 
 /**
- *	Transform flow data (from active_flowlist) of a single local hosts into host profile graphlet data.
+ *	Transform flow data of a single local host into host profile graphlet data.
  *
  *	If configured then transformation also includes role summarization (configurable per role type).
  *
@@ -335,6 +390,18 @@ bool CImport::set_localIP(IPv6_addr newLocalIP, int host_count) {
  *
  *	Result: output file containing graphlet database (= collection of graphlets described in binary form)
  *
+ *	Only reads the data set, so several threads may build graphlets of one CImport at the same time (call
+ *	prepare_columns() first, else each call builds the columns of the full flow list on its own).
+ *
+ *	\param host_flows Flows of the host (see get_host_flowlist())
+ *	\param prefs Summarization and filter settings
+ *	\param desummarized_roles Numbers of the roles not to summarize
+ *	\param sink Receives the edges of the graphlet (see CEdgeSink)
+ *	\param graphlet_nr Number of the graphlet written
+ *	\param write_version Start with a version edge (i.e. the graphlet starts new hpg data)
+ *
+ *	\return Node infos of the graphlet for hpg2dot() (owned by the caller, NULL unless hap4nfsen)
+ *
  *	Overview:
  *
  *	(I) Initialize
@@ -356,16 +423,20 @@ bool CImport::set_localIP(IPv6_addr newLocalIP, int host_count) {
  *		\exception std::string Errorstring
  *
  */
-void CImport::cflow2hpg() {
+CSummaryNodeInfos * CImport::build_graphlet(const Subflowlist & host_flows, const prefs_t & prefs, const desummarizedRoles & desummarized_roles,
+      CEdgeSink & sink, unsigned int graphlet_nr, bool write_version) const {
 	// (I) Initialize
 	// **************
 
 	// Role identifiers needed for summarization:
 	CRoleMembership roleMembership; // Manages groups of hosts having same role membership set
 
-	CClientRole clientRole(active_flowlist, prefs);
-	CServerRole serverRole(active_flowlist, prefs);
-	CP2pRole p2pRole(active_flowlist, prefs);
+	Subflowlist flows(host_flows);
+	flows.columns(); // build the columns once, the roles share them through their copies of flows
+	Subflowlist full_flows(full_view); // Shares the columns of full_view if prepare_columns() has built them
+	CClientRole clientRole(flows, prefs);
+	CServerRole serverRole(flows, prefs);
+	CP2pRole p2pRole(flows, prefs);
 	clientRole.register_rM(roleMembership);
 	serverRole.register_rM(roleMembership);
 	p2pRole.register_rM(roleMembership);
@@ -375,7 +446,7 @@ void CImport::cflow2hpg() {
 	//}
 
 	// For filtering by flow type and protocol
-	CFlowFilter filter(active_flowlist, prefs);
+	CFlowFilter filter(flows, prefs);
 
 	// Summarization by flow type
 	// --------------------------
@@ -392,11 +463,11 @@ void CImport::cflow2hpg() {
 	// Client & server candidate role identification
 	// =============================================
 	// Go through flow list to check for candidate client and server roles.
-	for (unsigned int i = 0; i < getActiveFlowlistSize(); i++) {
+	for (unsigned int i = 0; i < flows.size(); i++) {
 		if (filter.filter_flow(i))
 			continue;
-		//util::printFlow(active_flowlist[i]);
-		if ((active_flowlist[i].flowtype & sum_flow_mask) != 0) {
+		//util::printFlow(flows[i]);
+		if ((flows[i].flowtype & sum_flow_mask) != 0) {
 			clientRole.add_candidate(i);
 			if (prefs.summarize_srv_roles)
 				serverRole.add_candidate(i);
@@ -452,7 +523,7 @@ void CImport::cflow2hpg() {
 	if (prefs.summarize_p2p_roles) {
 
 		// Firstly, construct a list of potential p2p flows
-		for (unsigned int i = 0; i < getActiveFlowlistSize(); i++) {
+		for (unsigned int i = 0; i < flows.size(); i++) {
 			if (filter.filter_flow(i))
 				continue;
 			// Ignore already summarized flows
@@ -469,16 +540,16 @@ void CImport::cflow2hpg() {
 	// Finalize roles
 	// **************
 	const vector<uint32_t>& flow_p2p_role = p2pRole.get_flow_role();
-	vector<uint32_t> single_flow_rolenum(getActiveFlowlistSize());
+	vector<uint32_t> single_flow_rolenum(flows.size());
 
-	for (unsigned int j = 0; j < getActiveFlowlistSize(); j++) {
+	for (unsigned int j = 0; j < flows.size(); j++) {
 		if (filter.filter_flow(j)) {
 			single_flow_rolenum[j] = 0;
 			continue;
 		}
 
 		if (flow_client_role[j] == 0 && flow_server_role[j] == 0 && flow_p2p_role[j] == 0) {
-			single_flow_rolenum[j] = roleMembership.add_single_flow(active_flowlist[j].remoteIP, active_flowlist[j].dPkts);
+			single_flow_rolenum[j] = roleMembership.add_single_flow(flows[j].remoteIP, flows[j].dPkts);
 		} else {
 			single_flow_rolenum[j] = 0;
 		}
@@ -496,9 +567,9 @@ void CImport::cflow2hpg() {
 	}
 
 	// rate all generated roles
-	clientRole.rate_roles(full_flowlist);
-	serverRole.rate_roles(full_flowlist);
-	p2pRole.rate_roles(full_flowlist);
+	clientRole.rate_roles(full_flows);
+	serverRole.rate_roles(full_flows);
+	p2pRole.rate_roles(full_flows);
 
 	// create sub-roles required for part. desummarization for all flow types
 	serverRole.create_sub_roles();
@@ -506,7 +577,8 @@ void CImport::cflow2hpg() {
 	clientRole.create_sub_roles();
 	p2pRole.create_sub_roles();
 
-	calculate_multi_summary_node_desummarizations(roleMembership);
+	desummarizedRoles desummarized_multi_node_roles;
+	calculate_multi_summary_node_desummarizations(roleMembership, desummarized_roles, desummarized_multi_node_roles);
 
 	// (III) Process selected flows to "hpg" graphlet data
 	// ***************************************************
@@ -515,24 +587,17 @@ void CImport::cflow2hpg() {
 	// b) Secondly, add client/server/p2p role summaries as needed to edge information.
 	// c) Finally, create hpg edges from edge information collected.
 
-	CGraphlet * graphlet;
-	try {
-		graphlet = new CGraphlet(hpg_filename, roleMembership);
-	} catch (string & e) {
-		stringstream error;
-		error << "Could not create CGraphlet with this file: " << hpg_filename;
-		throw error.str();
-	}
+	boost::scoped_ptr<CGraphlet> graphlet(new CGraphlet(sink, roleMembership, write_version)); // The sink may throw
 
 	uint32_t filtered_flows = 0;
 	uint32_t summarized_flows = 0;
 
-	IPv6_addr lastIP = active_flowlist[0].localIP; // Get 1. localIP
+	IPv6_addr lastIP = flows[0].localIP; // Get 1. localIP
 	uint32_t i = 0;
 	uint32_t ambiguous_cs_roles_flows = 0;
 	uint32_t ambiguous_cp2p_roles_flows = 0;
 	uint32_t ambiguous_sp2p_roles_flows = 0;
-	while (i < getActiveFlowlistSize()) {
+	while (i < flows.size()) {
 		//
 		// (IIIa) Fetch next flow and update current graphlet data
 		// ******************************************************
@@ -556,9 +621,9 @@ void CImport::cflow2hpg() {
 				bool was_successful;
 				// try to resolve conflict with role rating information. if not possible, try to resolve it the other way round
 				if (clt_rating < srv_rating) {
-					was_successful = srv_role->removeFlow(i, active_flowlist, roleMembership) || client_role->removeFlow(i, active_flowlist, roleMembership);
+					was_successful = srv_role->removeFlow(i, flows, roleMembership) || client_role->removeFlow(i, flows, roleMembership);
 				} else {
-					was_successful = client_role->removeFlow(i, active_flowlist, roleMembership) || srv_role->removeFlow(i, active_flowlist, roleMembership);
+					was_successful = client_role->removeFlow(i, flows, roleMembership) || srv_role->removeFlow(i, flows, roleMembership);
 				}
 				if (!was_successful) {
 					cerr << "role conflict resolution not successful" << endl;
@@ -584,9 +649,9 @@ void CImport::cflow2hpg() {
 				bool was_successful;
 				// try to resolve conflict with role rating information. if not possible, try to resolve it the other way round
 				if (clt_rating < p2p_rating) {
-					was_successful = p2p_role->removeFlow(i, active_flowlist, roleMembership) || client_role->removeFlow(i, active_flowlist, roleMembership);
+					was_successful = p2p_role->removeFlow(i, flows, roleMembership) || client_role->removeFlow(i, flows, roleMembership);
 				} else {
-					was_successful = client_role->removeFlow(i, active_flowlist, roleMembership) || p2p_role->removeFlow(i, active_flowlist, roleMembership);
+					was_successful = client_role->removeFlow(i, flows, roleMembership) || p2p_role->removeFlow(i, flows, roleMembership);
 				}
 				if (!was_successful) {
 					cerr << "role conflict resolution not successful" << endl;
@@ -612,9 +677,9 @@ void CImport::cflow2hpg() {
 				bool was_successful;
 				// try to resolve conflict with role rating information. if not possible, try to resolve it the other way round
 				if (srv_rating < p2p_rating) {
-					was_successful = p2p_role->removeFlow(i, active_flowlist, roleMembership) || srv_role->removeFlow(i, active_flowlist, roleMembership);
+					was_successful = p2p_role->removeFlow(i, flows, roleMembership) || srv_role->removeFlow(i, flows, roleMembership);
 				} else {
-					was_successful = srv_role->removeFlow(i, active_flowlist, roleMembership) || p2p_role->removeFlow(i, active_flowlist, roleMembership);
+					was_successful = srv_role->removeFlow(i, flows, roleMembership) || p2p_role->removeFlow(i, flows, roleMembership);
 				}
 				if (!was_successful) {
 					cerr << "role conflict resolution not successful" << endl;
@@ -635,7 +700,7 @@ void CImport::cflow2hpg() {
 			summarized_flows++;
 		} else {
 			// Add current flow to graphlet: this is an unsummarized flow
-			graphlet->add_single_flow(active_flowlist[i], single_flow_rolenum[i], i);
+			graphlet->add_single_flow(flows[i], single_flow_rolenum[i], i);
 		}
 
 		// Switch to next flow
@@ -654,7 +719,7 @@ void CImport::cflow2hpg() {
 				if (debug2) {
 					cout << "Client role " << c++ << endl;
 				}
-				graphlet->add_generic_role(*(role->getUsedSubRole(desummarizedRolesSet, desummarizedMultiNodeRolesSet)), *role, lastIP, active_flowlist);
+				graphlet->add_generic_role(*(role->getUsedSubRole(desummarized_roles, desummarized_multi_node_roles)), *role, lastIP, flows);
 			}
 			role = clientRole.get_next_role();
 		}
@@ -669,7 +734,7 @@ void CImport::cflow2hpg() {
 				if (debug2) {
 					cout << "Multi-client role " << c++ << endl;
 				}
-				graphlet->add_generic_role(*(role->getUsedSubRole(desummarizedRolesSet, desummarizedMultiNodeRolesSet)), *role, lastIP, active_flowlist);
+				graphlet->add_generic_role(*(role->getUsedSubRole(desummarized_roles, desummarized_multi_node_roles)), *role, lastIP, flows);
 			}
 			role = clientRole.get_next_mrole();
 		}
@@ -684,7 +749,7 @@ void CImport::cflow2hpg() {
 				if (debug2) {
 					cout << "Server role " << c++ << endl;
 				}
-				graphlet->add_generic_role(*(role->getUsedSubRole(desummarizedRolesSet, desummarizedMultiNodeRolesSet)), *role, lastIP, active_flowlist);
+				graphlet->add_generic_role(*(role->getUsedSubRole(desummarized_roles, desummarized_multi_node_roles)), *role, lastIP, flows);
 			}
 			role = serverRole.get_next_role();
 		}
@@ -699,7 +764,7 @@ void CImport::cflow2hpg() {
 				if (debug2) {
 					cout << "P2P role " << c++ << endl;
 				}
-				graphlet->add_generic_role(*(role->getUsedSubRole(desummarizedRolesSet, desummarizedMultiNodeRolesSet)), *role, lastIP, active_flowlist);
+				graphlet->add_generic_role(*(role->getUsedSubRole(desummarized_roles, desummarized_multi_node_roles)), *role, lastIP, flows);
 			}
 			role = p2pRole.get_next_role();
 		}
@@ -710,7 +775,7 @@ void CImport::cflow2hpg() {
 	// ==========================================================
 	// Next flow belongs to new localIP: thus, finalize current host graphlet.
 	//
-	graphlet->finalize_graphlet(0);
+	graphlet->finalize_graphlet(graphlet_nr);
 	// Remember new localIP for change testing
 
 	if (ambiguous_cs_roles_flows > 0)
@@ -722,27 +787,77 @@ void CImport::cflow2hpg() {
 	if (summarized_flows)
 		cout << "Summarized flows: " << summarized_flows << endl;
 	if (filtered_flows)
-		cout << "Filtered flows: " << filtered_flows << " out of " << getActiveFlowlistSize() << " flows." << endl;
+		cout << "Filtered flows: " << filtered_flows << " out of " << flows.size() << " flows." << endl;
+
+	CSummaryNodeInfos * graphlet_nodeInfos = NULL;
+	if (hap4nfsen) {
+		// Take over the node infos of the graphlet, which outlive it for hpg2dot()
+		graphlet_nodeInfos = graphlet->nodeInfos;
+		graphlet->nodeInfos = NULL;
+	}
 
 	if (debug) {
 		desummarizedRoles::const_iterator dri;
 		cout << "desummarized roles:\t";
-		for (dri = desummarizedRolesSet.begin(); dri != desummarizedRolesSet.end(); dri++) {
+		for (dri = desummarized_roles.begin(); dri != desummarized_roles.end(); dri++) {
 			cout << (*dri) << ",";
 		}
 		cout << endl;
 
 		roleMembership.print_multi_members();
 		roleMembership.print_multisummary_rolecount();
-		if (hap4nfsen) {
-			cout << nodeInfos->printNodeInfos() << endl;
+		if (graphlet_nodeInfos != NULL) {
+			cout << graphlet_nodeInfos->printNodeInfos() << endl;
 		}
 	}
 
-	if (hap4nfsen) {
-		nodeInfos = graphlet->nodeInfos;
+	return graphlet_nodeInfos;
+}
+
+/**
+ *	Transform flow data of a single local host into host profile graphlet data and write it to an hpg file
+ *	(see build_graphlet() above).
+ *
+ *	\param host_flows Flows of the host (see get_host_flowlist())
+ *	\param prefs Summarization and filter settings
+ *	\param desummarized_roles Numbers of the roles not to summarize
+ *	\param filename Name of the hpg file written
+ *	\param graphlet_nr Number of the graphlet written
+ *	\param append Append the graphlet to the hpg file instead of replacing its contents
+ *
+ *	\return Node infos of the graphlet for hpg2dot() (owned by the caller, NULL unless hap4nfsen)
+ *
+ *	\exception std::string Errorstring
+ */
+CSummaryNodeInfos * CImport::build_graphlet(const Subflowlist & host_flows, const prefs_t & prefs, const desummarizedRoles & desummarized_roles,
+      const string & filename, unsigned int graphlet_nr, bool append) const {
+	CHpgFileSink * sink;
+	try {
+		sink = new CHpgFileSink(filename, append);
+	} catch (string & e) {
+		stringstream error;
+		error << "Could not create CGraphlet with this file: " << filename;
+		throw error.str();
 	}
-	delete graphlet;
+	boost::scoped_ptr<CHpgFileSink> file_sink(sink);
+	return build_graphlet(host_flows, prefs, desummarized_roles, *file_sink, graphlet_nr, !append);
+}
+
+/**
+ *	Transform flow data (from active_flowlist) of a single local hosts into host profile graphlet data, using
+ *	prefs, the desummarized roles and hpg_filename of this CImport (see build_graphlet()). The node infos of the
+ *	graphlet are kept in nodeInfos.
+ *
+ *	\param graphlet_nr Number of the graphlet written
+ *	\param append Append the graphlet to the hpg file instead of replacing its contents
+ *
+ *	\exception std::string Errorstring
+ */
+void CImport::cflow2hpg(unsigned int graphlet_nr, bool append) {
+	prepare_columns(); // Kept across graphlets
+	CSummaryNodeInfos * graphlet_nodeInfos = build_graphlet(active_flowlist, prefs, desummarizedRolesSet, hpg_filename, graphlet_nr, append);
+	delete nodeInfos;
+	nodeInfos = graphlet_nodeInfos;
 }
 
 /**
@@ -778,20 +893,22 @@ void CImport::add_desummarized_roles(const desummarizedRoles & role_set) {
  */
 void CImport::clear_desummarized_roles() {
 	desummarizedRolesSet.clear();
-	desummarizedMultiNodeRolesSet.clear();
 }
 
 /**
  *	Calculates which multi-summary nodes have to be desummarized
  *
  *	\param roleMembership Holds the membership of the cflows
+ *	\param desummarized_roles Numbers of the desummarized roles and multi-summary nodes
+ *	\param multi_node_roles Roles of the desummarized multi-summary nodes (out)
  */
-void CImport::calculate_multi_summary_node_desummarizations(CRoleMembership & roleMembership) {
+void CImport::calculate_multi_summary_node_desummarizations(CRoleMembership & roleMembership, const desummarizedRoles & desummarized_roles,
+      desummarizedRoles & multi_node_roles) {
 	const uint32_t MULTI_SUM_NODE_MASK = 0x00f00000; // value is only 24 bit
 	const uint32_t MULTI_SUM_NODE_SHIFT = 23; // 24 bit-1 bit
 
 	set<int> multi_sum_node_ids;
-	for (desummarizedRoles::const_iterator role_iter = desummarizedRolesSet.begin(); role_iter != desummarizedRolesSet.end(); ++role_iter) {
+	for (desummarizedRoles::const_iterator role_iter = desummarized_roles.begin(); role_iter != desummarized_roles.end(); ++role_iter) {
 		roleNumber role = *role_iter;
 		if (((role & MULTI_SUM_NODE_MASK) >> MULTI_SUM_NODE_SHIFT) == 1) { // role is a multi summary node id
 			cout << "[1]" << role << endl;
@@ -815,7 +932,7 @@ void CImport::calculate_multi_summary_node_desummarizations(CRoleMembership & ro
 			cout << util::bin2hexstring(&roles, 16) << endl;
 			for (boost::array<uint16_t, 8>::const_iterator role_iter = roles.begin(); role_iter != roles.end(); ++role_iter) {
 				cout << "contains role: " << (*role_iter) << endl;
-				desummarizedMultiNodeRolesSet.insert(*role_iter); // store values so they can later be used in getUsedSubRole
+				multi_node_roles.insert(*role_iter); // store values so they can later be used in getUsedSubRole
 			}
 		}
 	}
@@ -825,6 +942,11 @@ void CImport::calculate_multi_summary_node_desummarizations(CRoleMembership & ro
  *	Get host metadata from "flowlist" and store it in "hostMetadata".
  */
 void CImport::get_hostMetadata() {
+	if (hostMetadata_full && getActiveFlowlistSize() == full_flowlist.size()) {
+		// Already prepared (or loaded from the index) for the full flowlist
+		next_host = 0;
+		return;
+	}
 	// Scan flow list and assemble for each localIP the metadata
 	assert(getActiveFlowlistSize() > 0);
 	IPv6_addr lastIP = active_flowlist[0].localIP; // Get 1. localIP
@@ -847,7 +969,7 @@ void CImport::get_hostMetadata() {
 	int host_index = -1;
 	while (it != active_flowlist.end()) {
 		// Check if host data is complete
-		if (it->localIP != hostMetadata[host_index].IP || it == active_flowlist.begin()) {
+		if (it == active_flowlist.begin() || it->localIP != hostMetadata[host_index].IP) {
 			host_index++;
 			hostMetadata[host_index].IP = it->localIP;
 			hostMetadata[host_index].graphlet_number = host_index;
@@ -880,6 +1002,7 @@ void CImport::get_hostMetadata() {
 		it++;
 	}
 
+	hostMetadata_full = getActiveFlowlistSize() == full_flowlist.size();
 	next_host = 0;
 	cout << "\nMetadata for " << host_index + 1 << " local hosts prepared.\n";
 }
@@ -918,6 +1041,58 @@ const ChostMetadata & CImport::get_next_host_metadata() {
 	throw "invalid access behind the last element of hostMetadata";
 }
 
+/**
+ *	Get the metadata of all hosts prepared by get_hostMetadata(). Unlike get_first/next_host_metadata()
+ *	this does not change the object, so concurrent readers may use it.
+ *
+ *	\return Host metadata (ascending IP order)
+ */
+const vector<ChostMetadata> & CImport::get_host_metadata() const {
+	return hostMetadata;
+}
+
+/**
+ *	Look up the metadata of a host prepared by get_hostMetadata() (binary search, does not change the object).
+ *
+ *	\param IP Local IP address of host
+ *
+ *	\return Host metadata, or NULL if the host has no flows
+ */
+const ChostMetadata * CImport::find_host_metadata(const IPv6_addr & IP) const {
+	size_t lo = 0, hi = hostMetadata.size();
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (hostMetadata[mid].IP < IP)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < hostMetadata.size() && hostMetadata[lo].IP == IP)
+		return &hostMetadata[lo];
+	return NULL;
+}
+
+/**
+ *	Get the flows of a host, for build_graphlet(). Their columns use the address ids of the full flow list.
+ *
+ *	\param host Host metadata (see get_host_metadata())
+ *
+ *	\return Subflowlist Flows of the host
+ */
+Subflowlist CImport::get_host_flowlist(const ChostMetadata & host) const {
+	Subflowlist flows = get_flow(host.index, host.flow_count);
+	flows.set_dictionary(ip_dictionary);
+	return flows;
+}
+
+/**
+ *	Build the columns of the full flow list now instead of on the first graphlet. Graphlets built by
+ *	build_graphlet() share them afterwards, so call it once before building graphlets from several threads.
+ */
+void CImport::prepare_columns() {
+	full_view.columns();
+}
+
 /**
  *	Get a list of flows
  *
@@ -1024,6 +1199,15 @@ std::string CImport::get_hpg_filename() const {
 	return hpg_filename;
 }
 
+/**
+ *	Set the hpg filename written by cflow2hpg()
+ *
+ *	\param filename Name of the hpg file
+ */
+void CImport::set_hpg_filename(const std::string & filename) {
+	hpg_filename = filename;
+}
+
 /**
  *	Return the input filename in use
  *
@@ -1042,6 +1226,28 @@ int CImport::get_flow_count() const {
 	return full_flowlist.size();
 }
 
+/**
+ *	Estimate the memory held by the loaded data set: flow list, reverse index, host metadata, address dictionary
+ *	and the columns of the full flow list (if prepared).
+ *
+ *	\return Bytes
+ */
+uint64_t CImport::get_memory_size() const {
+	uint64_t size = sizeof(*this) + (uint64_t) full_flowlist.capacity() * sizeof(cflow_t) + (uint64_t) remoteIP_index.capacity() * sizeof(int)
+	      + (uint64_t) hostMetadata.capacity() * sizeof(ChostMetadata) + full_view.get_columns_memory_size();
+	if (ip_dictionary)
+		size += ip_dictionary->size() * (sizeof(IPv6_addr) + 2 * sizeof(uint32_t)); // Addresses and id table (half full)
+	return size;
+}
+
+/**
+ *	Configure inputfilters on first use (see initInputfilters()). Threads may call it concurrently.
+ */
+void CImport::load_inputfilters() {
+	static boost::once_flag once = BOOST_ONCE_INIT;
+	boost::call_once(once, &CImport::initInputfilters);
+}
+
 /**
  *	Return true if there is a gfilter which can read the supplied file
  *
@@ -1052,8 +1258,9 @@ int CImport::get_flow_count() const {
 bool CImport::acceptForImport(const string & in_filename) {
 	std::vector<GFilter *>::iterator importfilterIterator;
 
-	if (inputfilters.empty())
-		initInputfilters();
+	if (is_snapshot_filename(in_filename))
+		return true;
+	load_inputfilters();
 
 	for (importfilterIterator = inputfilters.begin(); importfilterIterator != inputfilters.end(); importfilterIterator++) {
 		if ((*importfilterIterator)->acceptFileForReading(in_filename))
@@ -1062,6 +1269,32 @@ bool CImport::acceptForImport(const string & in_filename) {
 	return false;
 }
 
+/**
+ *	Describe the import parameters that determine the flows read from a file, as text. Two imports of an
+ *	unchanged file with the same description give the same flows (used to validate indexes and caches).
+ *	Local networks are only part of it if the file format infers flow directions (see GFilter::usesLocalNets()).
+ *
+ *	\param in_filename File to import
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate
+ *
+ *	\return Parameter description
+ */
+string CImport::get_import_parameters(const string & in_filename, const CLocalNets & local_nets, const CFlowPredicate & predicate) {
+	if (is_snapshot_filename(in_filename))
+		return ""; // Prepared data set, parameters do not apply
+	load_inputfilters();
+
+	bool uses_local_nets = true;
+	for (std::vector<GFilter *>::iterator it = inputfilters.begin(); it != inputfilters.end(); it++) {
+		if ((*it)->acceptFileForReading(in_filename)) {
+			uses_local_nets = (*it)->usesLocalNets();
+			break;
+		}
+	}
+	return (uses_local_nets ? local_nets.toString() : string()) + "\n" + predicate.toString();
+}
+
 /**
  *	Return true if there is a gfilter which can write to the supplied file
  *
@@ -1072,8 +1305,7 @@ bool CImport::acceptForImport(const string & in_filename) {
 bool CImport::acceptForExport(const string & out_filename) {
 	std::vector<GFilter *>::iterator importfilterIterator;
 
-	if (inputfilters.empty())
-		initInputfilters();
+	load_inputfilters();
 
 	for (importfilterIterator = inputfilters.begin(); importfilterIterator != inputfilters.end(); importfilterIterator++) {
 		if ((*importfilterIterator)->acceptFileForWriting(out_filename))
@@ -1095,8 +1327,7 @@ bool CImport::acceptForExport(const string & out_filename) {
 void CImport::write_file(std::string out_filename, const Subflowlist & subflowlist, bool appendIfExisting) {
 	std::vector<GFilter *>::iterator filterIterator;
 
-	if (inputfilters.empty())
-		initInputfilters();
+	load_inputfilters();
 
 	for (filterIterator = inputfilters.begin(); filterIterator != inputfilters.end(); filterIterator++) {
 		if ((*filterIterator)->acceptFileForWriting(out_filename)) {
@@ -1133,8 +1364,7 @@ void CImport::write_file(std::string out_filename, const CFlowList & flowlist, b
 std::string CImport::getFormatName(std::string & in_filename) {
 	std::vector<GFilter *>::iterator importfilterIterator;
 
-	if (inputfilters.empty())
-		initInputfilters();
+	load_inputfilters();
 
 	for (importfilterIterator = inputfilters.begin(); importfilterIterator != inputfilters.end(); importfilterIterator++) {
 		if ((*importfilterIterator)->acceptFileForReading(in_filename))
@@ -1152,8 +1382,7 @@ vector<std::string> CImport::getAllFormatNames() {
 	std::vector<GFilter *>::iterator importfilterIterator;
 	vector<string> allTypeNames;
 
-	if (inputfilters.empty())
-		initInputfilters();
+	load_inputfilters();
 
 	for (importfilterIterator = inputfilters.begin(); importfilterIterator != inputfilters.end(); importfilterIterator++)
 		allTypeNames.push_back((*importfilterIterator)->getFormatName());
@@ -1171,8 +1400,7 @@ vector<std::string> CImport::getAllHumanReadablePatterns() {
 	std::vector<GFilter *>::iterator importfilterIterator;
 	vector<string> allTypeNames;
 
-	if (inputfilters.empty())
-		initInputfilters();
+	load_inputfilters();
 
 	for (importfilterIterator = inputfilters.begin(); importfilterIterator != inputfilters.end(); importfilterIterator++)
 		allTypeNames.push_back((*importfilterIterator)->getHumanReadablePattern());
@@ -1221,22 +1449,78 @@ std::string CImport::getFormatNamesAsString() {
  * \exception string Errortext
  */
 void CImport::read_file(const IPv6_addr & local_net, const IPv6_addr & netmask) {
-	if (inputfilters.empty())
-		initInputfilters();
+	read_file(CLocalNets(local_net, netmask));
+}
+
+/**
+ *	Reads the (previously) set filename into memory
+ *
+ *	If a valid sidecar index (see CFlowIndex) exists for the file and the given parameters, the prepared flow list,
+ *	the host metadata and the reverse index are loaded from it instead. Otherwise the index is written after the
+ *	import (failing to write it is not an error). See set_use_index() and set_write_index().
+ *
+ *	A snapshot (see is_snapshot_filename()) is loaded with load_snapshot(), the parameters do not apply then.
+ *
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate: flows not accepted are skipped by the import filter (see get_import_stats())
+ *
+ * \pre one of the installed GFilter supports the given file
+ *
+ * \exception string Errortext
+ */
+void CImport::read_file(const CLocalNets & local_nets, const CFlowPredicate & predicate) {
+	if (is_snapshot_filename(in_filename)) {
+		load_snapshot(in_filename);
+		return;
+	}
+	load_inputfilters();
+	import_predicate = predicate;
+	import_predicate.reset_stats();
+	hostMetadata_full = false;
+
+	boost::scoped_ptr<CFlowIndex> index;
+	if (use_index) {
+		try {
+			index.reset(new CFlowIndex(in_filename, get_import_parameters(in_filename, local_nets, predicate)));
+			if (index->load(full_flowlist, hostMetadata, remoteIP_index)) {
+				cout << "Loaded " << full_flowlist.size() << " flows of " << hostMetadata.size() << " hosts from index " << index->get_filename()
+				      << ".\n";
+				reset_views();
+				hostMetadata_full = true;
+				next_host = 0;
+				return;
+			}
+		} catch (string & e) {
+			cerr << "WARNING: not using an index: " << e << endl;
+			index.reset();
+		}
+	}
 
 	std::vector<GFilter *>::iterator importfilterIterator;
 
 	for (importfilterIterator = inputfilters.begin(); importfilterIterator != inputfilters.end(); importfilterIterator++) {
 		if ((*importfilterIterator)->acceptFileForReading(in_filename)) {
 			try {
-				(*importfilterIterator)->read_file(in_filename, full_flowlist, local_net, netmask, false);
+				(*importfilterIterator)->read_file(in_filename, full_flowlist, local_nets, import_predicate, false);
 			} catch (string & e) {
 				throw e;
 			}
 			catch (...) {
 				throw string("Unkown error while importing");
 			}
+			print_import_stats();
 			prepare_flowlist();
+			if (index && write_index) {
+				if (!full_flowlist.empty())
+					get_hostMetadata();
+				hostMetadata_full = true;
+				try {
+					index->save(full_flowlist, hostMetadata, remoteIP_index);
+					cout << "Wrote index " << index->get_filename() << ".\n";
+				} catch (string & e) {
+					cerr << "WARNING: " << e << endl;
+				}
+			}
 			return;
 		}
 	}
@@ -1244,6 +1528,234 @@ void CImport::read_file(const IPv6_addr & local_net, const IPv6_addr & netmask)
 	throw "no usable importfilter found";
 }
 
+/**
+ *	Print the counters of the import predicate (if it skips anything at all).
+ */
+void CImport::print_import_stats() const {
+	if (import_predicate.accepts_all())
+		return;
+	const CFlowPredicate::stats_t & stats = import_predicate.get_stats();
+	cout << "*** Import predicate (" << import_predicate.toString() << ") skipped " << stats.skipped() << " of " << stats.accepted
+	      + stats.skipped() << " flows/records (protocol: " << stats.skipped_prot << ", local network: " << stats.skipped_local_net
+	      << ", time: " << stats.skipped_time << ", port: " << stats.skipped_port << ").\n";
+}
+
+/**
+ *	Out-of-core transformation of the (previously) set input file into a graph database holding one graphlet
+ *	per local host, for flow files larger than the available memory.
+ *
+ *	The flows are streamed into a CExternalSort, which sorts them in runs of at most memory_budget bytes spilled
+ *	to tmp_dir and merges the runs. The merged flows are then processed host by host: only the flows of one
+ *	local host are held in memory at a time, uniflows are qualified (see qualify_uniflows()) and the graphlet of
+ *	the host is appended to the hpg file (graphlet numbers 0, 1, ... in ascending order of localIP).
+ *
+ *	As a consequence, roles are rated on the flows of their own host only, while cflow2hpg() after read_file()
+ *	rates them on all loaded flows. No flow list is kept: get_flow() etc. do not work afterwards.
+ *
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param memory_budget Bytes of flows to keep in memory for sorting
+ *	\param tmp_dir Directory for the sorted runs (empty: $TMPDIR or /tmp)
+ *	\param predicate Import predicate: flows not accepted are skipped by the import filter
+ *	\param hpg_version Format of the hpg file: 3 (see hpg.h) or 4 (compact, with graphlet directory, see ghpgv4.h)
+ *
+ *	\return Number of graphlets written
+ *
+ *	\exception std::string Errortext
+ */
+unsigned int CImport::cflow2hpg_database(const CLocalNets & local_nets, uint64_t memory_budget, const std::string & tmp_dir,
+      const CFlowPredicate & predicate, unsigned int hpg_version) {
+	if (hpg_version != 3 && hpg_version != 4) {
+		stringstream error;
+		error << "ERROR: unsupported hpg version " << hpg_version << " (use 3 or 4).";
+		throw error.str();
+	}
+
+	load_inputfilters();
+	import_predicate = predicate;
+	import_predicate.reset_stats();
+
+	GFilter * importfilter = NULL;
+	for (std::vector<GFilter *>::iterator it = inputfilters.begin(); it != inputfilters.end() && importfilter == NULL; it++) {
+		if ((*it)->acceptFileForReading(in_filename))
+			importfilter = *it;
+	}
+	if (importfilter == NULL)
+		throw string("no usable importfilter found");
+
+	// (1) Import and sort within the memory budget
+	CExternalSort sorter(memory_budget, tmp_dir);
+	try {
+		importfilter->read_file(in_filename, sorter, local_nets, import_predicate);
+	} catch (string & e) {
+		throw e;
+	}
+	catch (...) {
+		throw string("Unkown error while importing");
+	}
+	print_import_stats();
+	sorter.finish();
+	cout << "Sorted " << sorter.size() << " flows (" << sorter.get_run_count() << " runs, " << sorter.get_spilled_bytes() / (1024 * 1024)
+	      << " MB spilled).\n";
+
+	// (2) Transform the flows host by host (no flows: empty graph database)
+	boost::scoped_ptr<CEdgeSink> sink;
+	if (hpg_version == 4)
+		sink.reset(new CHpgV4FileSink(hpg_filename));
+	else
+		sink.reset(new CHpgFileSink(hpg_filename));
+	unsigned int graphlet_nr = 0;
+	uint64_t unibiflow_count = 0;
+	while (sorter.next_host(full_flowlist)) {
+		unibiflow_count += qualify_uniflows(full_flowlist.begin(), full_flowlist.end());
+		reset_views();
+		prepare_columns();
+		CSummaryNodeInfos * graphlet_nodeInfos = build_graphlet(active_flowlist, prefs, desummarizedRolesSet, *sink, graphlet_nr, graphlet_nr == 0);
+		delete nodeInfos;
+		nodeInfos = graphlet_nodeInfos;
+		graphlet_nr++;
+	}
+	sink->finish();
+
+	CFlowList().swap(full_flowlist);
+	reset_views();
+	cout << "Done (qualified " << unibiflow_count << " uniflows, wrote " << graphlet_nr << " graphlets to " << hpg_filename << ").\n";
+	return graphlet_nr;
+}
+
+/**
+ *	Qualify uniflows exchanged between host pairs that also exchange biflows (flow type unibiflow).
+ *	Unlike prepare_flowlist() this needs no hash map: the flows have to be sorted (see cflow_t::operator<),
+ *	so the flows of a host pair are adjacent.
+ *
+ *	\param begin First flow
+ *	\param end Behind last flow
+ *
+ *	\return Number of uniflows qualified
+ */
+unsigned int CImport::qualify_uniflows(CFlowList::iterator begin, CFlowList::iterator end) {
+	unsigned int unibiflow_count = 0;
+	CFlowList::iterator pair_begin = begin;
+	while (pair_begin != end) {
+		CFlowList::iterator pair_end = pair_begin;
+		bool has_biflow = false;
+		while (pair_end != end && pair_end->localIP == pair_begin->localIP && pair_end->remoteIP == pair_begin->remoteIP) {
+			if ((pair_end->flowtype & biflow) != 0)
+				has_biflow = true;
+			++pair_end;
+		}
+		if (has_biflow) {
+			for (CFlowList::iterator it = pair_begin; it != pair_end; ++it) {
+				if ((it->flowtype & uniflow) != 0) {
+					it->flowtype |= unibiflow;
+					unibiflow_count++;
+				}
+			}
+		}
+		pair_begin = pair_end;
+	}
+	return unibiflow_count;
+}
+
+/**
+ *	Get the counters of the import predicate of the last read_file().
+ *
+ *	\return Accepted and skipped flows/records
+ */
+const CFlowPredicate::stats_t & CImport::get_import_stats() const {
+	return import_predicate.get_stats();
+}
+
+/**
+ *	Enable or disable the sidecar index (*.hidx) of read_file().
+ *
+ *	\param use_index TRUE to load a valid index instead of importing the file, and to write the index after an import
+ */
+void CImport::set_use_index(bool use_index) {
+	this->use_index = use_index;
+}
+
+/**
+ *	Enable or disable writing the sidecar index after an import. Callers importing with parameters of a single
+ *	request should not fill the disk with an index per request; they may still load an existing index.
+ *
+ *	\param write_index TRUE to write the index after an import (if set_use_index() enables the index)
+ */
+void CImport::set_write_index(bool write_index) {
+	this->write_index = write_index;
+}
+
+/**
+ *	Check if a file name denotes a dataset snapshot (ends in ".hsnap").
+ *
+ *	\param filename File name
+ *
+ *	\return True for snapshot file names
+ */
+bool CImport::is_snapshot_filename(const string & filename) {
+	static const string suffix = ".hsnap";
+	return filename.size() > suffix.size() && filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ *	Save the loaded dataset as a snapshot (see CSnapshotImage): the sorted and qualified flow list, the reverse
+ *	remoteIP index, the host metadata (if prepared for the full flow list) and the address dictionary.
+ *	load_snapshot() resumes from it without importing, sorting or indexing again.
+ *
+ *	\param filename Snapshot file (should end in ".hsnap", see is_snapshot_filename())
+ *
+ *	\exception std::string Errortext
+ */
+void CImport::save_snapshot(const string & filename) const {
+	vector<char> name(in_filename.begin(), in_filename.end());
+	vector<ChostMetadata> no_hosts;
+	vector<IPv6_addr> no_ips;
+	CSnapshotImage image;
+	image.add_section(CSnapshotImage::section_in_filename, name);
+	image.add_section(CSnapshotImage::section_flows, full_flowlist);
+	image.add_section(CSnapshotImage::section_hosts, hostMetadata_full ? hostMetadata : no_hosts);
+	image.add_section(CSnapshotImage::section_remoteIP_index, remoteIP_index);
+	image.add_section(CSnapshotImage::section_ip_dictionary, ip_dictionary ? ip_dictionary->get_IPs() : no_ips);
+	image.write(filename);
+	cout << "Wrote snapshot " << filename << " of " << full_flowlist.size() << " flows.\n";
+}
+
+/**
+ *	Load a snapshot written by save_snapshot(), replacing the loaded dataset. The image is memory mapped and its
+ *	sections are copied into the flow list, the reverse index and the host metadata; the address dictionary is
+ *	taken over as well, so nothing is sorted or hashed except the distinct addresses.
+ *
+ *	\param filename Snapshot file
+ *
+ *	\exception std::string Errortext (no snapshot, written by an incompatible build, damaged)
+ */
+void CImport::load_snapshot(const string & filename) {
+	CFlowList flows;
+	vector<ChostMetadata> hosts;
+	vector<int> rindex;
+	vector<IPv6_addr> ips;
+	vector<char> name;
+	{
+		CSnapshotImage image(filename);
+		image.get_section(CSnapshotImage::section_in_filename, name);
+		image.get_section(CSnapshotImage::section_flows, flows);
+		image.get_section(CSnapshotImage::section_hosts, hosts);
+		image.get_section(CSnapshotImage::section_remoteIP_index, rindex);
+		image.get_section(CSnapshotImage::section_ip_dictionary, ips);
+	}
+	if ((!rindex.empty() && rindex.size() != flows.size()) || (flows.empty() != ips.empty()))
+		throw "ERROR: snapshot " + filename + " is inconsistent.";
+
+	full_flowlist.swap(flows);
+	remoteIP_index.swap(rindex);
+	hostMetadata.swap(hosts);
+	reset_views(boost::shared_ptr<const CIPDictionary>(new CIPDictionary(ips)));
+	if (use_reverse_index && remoteIP_index.size() != full_flowlist.size())
+		prepare_reverse_index(); // Saved from a flow list that was not prepared
+	hostMetadata_full = !hostMetadata.empty() || full_flowlist.empty();
+	next_host = 0;
+	cout << "Loaded " << full_flowlist.size() << " flows of " << string(name.begin(), name.end()) << " from snapshot " << filename << ".\n";
+}
+
 /**
  *	Disables the remote-IP lookup
  */
@@ -29,6 +29,10 @@
 
 #include "grole.h"
 #include "gfilter.h"
+#include "gipdictionary.h"
+#include "gflowcolumns.h"
+#include "glocalnets.h"
+#include "gflowpredicate.h"
 
 // ******************************************************************************************
 
@@ -65,11 +69,11 @@ typedef HashKeyIPv6_5T flowHashKey;
 typedef hash_map<HashKeyIPv6_5T, cflow_t *, HashFunction<HashKeyIPv6_5T> , HashFunction<HashKeyIPv6_5T> > flowHashMap;
 
 // For lookup of all traffic between a host pair: to identify unibiflow property
-// key = 2-tuple {IP1, IP2}
+// key = 2-tuple {IP1 id, IP2 id}
 // data = sample id
 //
-typedef HashKeyIPv6Pair FlowHashKeyHostPair;
-typedef hash_map<HashKeyIPv6Pair, int, HashFunction<HashKeyIPv6Pair> , HashFunction<HashKeyIPv6Pair> > FlowHashMapHostPair;
+typedef HashKeyIdPair FlowHashKeyHostPair;
+typedef hash_map<HashKeyIdPair, int, HashFunction<HashKeyIdPair> , HashFunction<HashKeyIdPair> > FlowHashMapHostPair;
 
 /**
  *	\class CImport
@@ -82,9 +86,12 @@ class CImport {
 		static bool acceptForImport(const std::string & in_filename);
 		static bool acceptForExport(const std::string & out_filename);
 		void read_file(const IPv6_addr & local_net = IPv6_addr(), const IPv6_addr & netmask = IPv6_addr());
+		void read_file(const CLocalNets & local_nets, const CFlowPredicate & predicate = CFlowPredicate());
+		const CFlowPredicate::stats_t & get_import_stats() const;
 		void write_file(std::string out_filename, const CFlowList & flowlist, bool appendIfExisting);
 		void write_file(std::string out_filename, const Subflowlist & subflowlist, bool appendIfExisting);
 		static std::string getFormatName(std::string & in_filename);
+		static std::string get_import_parameters(const std::string & in_filename, const CLocalNets & local_nets, const CFlowPredicate & predicate);
 		static std::vector<std::string> getAllFormatNames();
 		static std::vector<std::string> getAllHumanReadablePatterns();
 		static std::ostream & printAllTypeNames(std::ostream & os);
@@ -93,12 +100,26 @@ class CImport {
 
 	private:
 		static std::vector<GFilter *> inputfilters; ///< Holds all enabled GFilter as configured
+		static void load_inputfilters();
 
 	public:
 		CImport(const std::string & in_filename, const std::string & out_filename, const prefs_t & prefs);
 		CImport(const CFlowList & _flowlist, const prefs_t & newprefs);
-
-		void cflow2hpg();
+		~CImport();
+
+		void cflow2hpg(unsigned int graphlet_nr = 0, bool append = false);
+		CSummaryNodeInfos * build_graphlet(const Subflowlist & host_flows, const prefs_t & prefs, const desummarizedRoles & desummarized_roles,
+		      const std::string & filename, unsigned int graphlet_nr = 0, bool append = false) const;
+		CSummaryNodeInfos * build_graphlet(const Subflowlist & host_flows, const prefs_t & prefs, const desummarizedRoles & desummarized_roles,
+		      CEdgeSink & sink, unsigned int graphlet_nr = 0, bool write_version = true) const;
+		unsigned int cflow2hpg_database(const CLocalNets & local_nets, uint64_t memory_budget, const std::string & tmp_dir = "",
+		      const CFlowPredicate & predicate = CFlowPredicate(), unsigned int hpg_version = 3);
+		static unsigned int qualify_uniflows(CFlowList::iterator begin, CFlowList::iterator end);
+
+		// Dataset snapshots (*.hsnap)
+		void save_snapshot(const std::string & filename) const;
+		void load_snapshot(const std::string & filename);
+		static bool is_snapshot_filename(const std::string & filename);
 
 		// Flow helper functions
 		void print_flowlist(unsigned int linecount);
@@ -108,8 +129,11 @@ class CImport {
 		const CFlowList get_outside_graphlet_flows(IPv6_addr remoteIP);
 
 		int get_flow_count() const;
+		uint64_t get_memory_size() const;
 
 		void set_no_reverse_index();
+		void set_use_index(bool use_index);
+		void set_write_index(bool write_index);
 
 		bool set_localIP(IPv6_addr IP, int host_count);
 		const desummarizedRoles get_desummarized_roles();
@@ -121,10 +145,15 @@ class CImport {
 		void get_hostMetadata(void);
 		const ChostMetadata & get_first_host_metadata();
 		const ChostMetadata & get_next_host_metadata();
+		const std::vector<ChostMetadata> & get_host_metadata() const;
+		const ChostMetadata * find_host_metadata(const IPv6_addr & IP) const;
+		Subflowlist get_host_flowlist(const ChostMetadata & host) const;
+		void prepare_columns();
 		std::string get_hpg_filename() const;
+		void set_hpg_filename(const std::string & filename);
 		std::string get_in_filename() const;
 
-		CSummaryNodeInfos * nodeInfos; ///< Storage for nodeinfos
+		CSummaryNodeInfos * nodeInfos; ///< Storage for nodeinfos of the last graphlet built by cflow2hpg() (owned)
 
 		Subflowlist getActiveFlowlist();
 		void invalidate();
@@ -145,6 +174,9 @@ class CImport {
 		// "full flowlist": as loaded from file; "active_flowlist": as used for transformations
 		CFlowList full_flowlist; ///< Flowlist containg all loaded localIPs ("full flowlist")
 		Subflowlist active_flowlist; ///< Flowlist containg a part of all loaded localIPs ("active flowlist")
+		Subflowlist full_view; ///< Full flowlist as Subflowlist, keeps its columns across graphlets
+		boost::shared_ptr<const CIPDictionary> ip_dictionary; ///< Address ids of full_flowlist, shared by all views
+		CFlowPredicate import_predicate; ///< Predicate of the last import, holds its skip counters
 		Subflowlist::const_iterator next_host_idx; ///< Flowlist iterator of first flow of next host
 
 		Subflowlist::size_type getActiveFlowlistSize() {
@@ -152,17 +184,23 @@ class CImport {
 		}
 		std::vector<int> remoteIP_index; ///< Index into flowlist for sorted remoteIPs
 		bool use_reverse_index; ///< TRUE if a reverse index is needed (default:TRUE)
+		bool use_index; ///< TRUE if read_file() loads and writes the sidecar index (default: TRUE)
+		bool write_index; ///< TRUE if read_file() writes the sidecar index after an import (default: TRUE)
 
 		std::vector<ChostMetadata> hostMetadata; ///< Vector of metadata objects
+		bool hostMetadata_full; ///< TRUE if hostMetadata describes all of full_flowlist (e.g. as loaded from the index)
 		int next_host; ///< Auxiliary counter for get_first/next_host functions
 
 		const prefs_t & prefs; ///< Preferences settings
 
 	private:
 		desummarizedRoles desummarizedRolesSet; ///< set of rolenumbers which should not be summarized
-		desummarizedRoles desummarizedMultiNodeRolesSet; ///< set of multirolenumbers which should not be summarized
 		void prepare_flowlist();
-		void calculate_multi_summary_node_desummarizations(CRoleMembership & roleMembership);
+		void reset_views(boost::shared_ptr<const CIPDictionary> dictionary = boost::shared_ptr<const CIPDictionary>());
+		void print_import_stats() const;
+		void prepare_ip_dictionary();
+		static void calculate_multi_summary_node_desummarizations(CRoleMembership & roleMembership, const desummarizedRoles & desummarized_roles,
+		      desummarizedRoles & multi_node_roles);
 
 	protected:
 		void prepare_reverse_index();
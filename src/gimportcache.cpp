@@ -0,0 +1,239 @@
+/**
+ *	\file gimportcache.cpp
+ *	\brief Cache of loaded data sets, to answer repeated requests on the same input file without importing it again.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <sstream>
+
+#include "gimportcache.h"
+
+using namespace std;
+
+const uint64_t CImportCache::default_memory_limit;
+
+/**
+ *	Constructor
+ *
+ *	\param prefs Preferences passed to the CImport objects (has to outlive the cache)
+ *	\param memory_limit Bytes the cached data sets may take
+ */
+CImportCache::CImportCache(const prefs_t & prefs, uint64_t memory_limit) :
+	prefs(prefs), memory_limit(memory_limit), memory_size(0), hits(0), misses(0), write_index(false) {
+}
+
+/**
+ *	Destructor: deletes all cached data sets
+ */
+CImportCache::~CImportCache() {
+	clear();
+}
+
+/**
+ *	Get the data set of an input file, importing it if it is not cached or the file has changed since.
+ *
+ *	The returned object stays valid until the next call of get() or clear(). Callers may change its
+ *	active flow list and desummarized roles, but not its full flow list. Host metadata and flow columns are
+ *	best prepared by get() (prepare_hosts), so the memory they take is accounted for at once.
+ *
+ *	\param in_filename Input file
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate
+ *	\param use_index Load the sidecar index of the input file, write it if enabled by set_write_index() (see CImport::set_use_index())
+ *	\param use_reverse_index Prepare the reverse remoteIP index (see CImport::set_no_reverse_index())
+ *	\param prepare_hosts Reset the active flow list to all flows and prepare the metadata of all hosts and the
+ *		columns of the full flow list (see CImport::get_hostMetadata() and CImport::prepare_columns())
+ *
+ *	\return Data set
+ *
+ *	\exception std::string Errortext
+ */
+CImport * CImportCache::get(const string & in_filename, const CLocalNets & local_nets, const CFlowPredicate & predicate, bool use_index,
+      bool use_reverse_index, bool prepare_hosts) {
+	struct stat st;
+	if (stat(in_filename.c_str(), &st) != 0)
+		throw "ERROR: could not stat " + in_filename + ": " + strerror(errno);
+	string parameters = CImport::get_import_parameters(in_filename, local_nets, predicate);
+
+	for (list<entry_t>::iterator it = entries.begin(); it != entries.end(); ++it) {
+		if (it->in_filename != in_filename || it->parameters != parameters || (use_reverse_index && !it->use_reverse_index))
+			continue;
+		if (it->file_size != (uint64_t) st.st_size || it->mtime_sec != st.st_mtim.tv_sec || it->mtime_nsec != st.st_mtim.tv_nsec) {
+			erase(it); // Outdated
+			break;
+		}
+		hits++;
+		entries.splice(entries.begin(), entries, it);
+		if (prepare_hosts)
+			prepare(it->import);
+		measure(entries.begin());
+		evict(entries.begin());
+		return it->import;
+	}
+
+	misses++;
+	CImport * import = new CImport(in_filename, in_filename + ".hpg", prefs);
+	try {
+		import->set_use_index(use_index);
+		import->set_write_index(write_index);
+		if (!use_reverse_index)
+			import->set_no_reverse_index();
+		import->read_file(local_nets, predicate);
+		if (prepare_hosts)
+			prepare(import);
+	} catch (...) {
+		delete import;
+		throw;
+	}
+
+	entry_t entry;
+	entry.import = import;
+	entry.in_filename = in_filename;
+	entry.file_size = st.st_size;
+	entry.mtime_sec = st.st_mtim.tv_sec;
+	entry.mtime_nsec = st.st_mtim.tv_nsec;
+	entry.parameters = parameters;
+	entry.use_reverse_index = use_reverse_index;
+	entry.memory_size = 0;
+	entries.push_front(entry);
+	measure(entries.begin());
+	evict(entries.begin());
+	return import;
+}
+
+/**
+ *	Delete all cached data sets.
+ */
+void CImportCache::clear() {
+	while (!entries.empty())
+		erase(entries.begin());
+}
+
+/**
+ *	Describe the data set an import of an input file gives, as text: file name, size, modification time and import
+ *	parameters. Imports with the same identity give the same flows.
+ *
+ *	\param in_filename Input file
+ *	\param local_nets Local networks used to infer flow directions
+ *	\param predicate Import predicate
+ *
+ *	\return Identity
+ *
+ *	\exception std::string Errortext (file does not exist)
+ */
+string CImportCache::get_identity(const string & in_filename, const CLocalNets & local_nets, const CFlowPredicate & predicate) {
+	struct stat st;
+	if (stat(in_filename.c_str(), &st) != 0)
+		throw "ERROR: could not stat " + in_filename + ": " + strerror(errno);
+	stringstream identity;
+	identity << in_filename << "\n" << st.st_size << "\n" << st.st_mtim.tv_sec << "." << st.st_mtim.tv_nsec << "\n"
+	      << CImport::get_import_parameters(in_filename, local_nets, predicate);
+	return identity.str();
+}
+
+/**
+ *	Set the memory limit. Data sets are evicted on the next get().
+ *
+ *	\param memory_limit Bytes the cached data sets may take (0: keep the last data set only)
+ */
+void CImportCache::set_memory_limit(uint64_t memory_limit) {
+	this->memory_limit = memory_limit;
+}
+
+/**
+ *	Let imports of get() write the sidecar index of the input file (see CImport::set_write_index()).
+ *
+ *	\param write_index True to write the index (default: false, an existing index is only loaded)
+ */
+void CImportCache::set_write_index(bool write_index) {
+	this->write_index = write_index;
+}
+
+/**
+ *	\return Bytes the cached data sets may take
+ */
+uint64_t CImportCache::get_memory_limit() const {
+	return memory_limit;
+}
+
+/**
+ *	\return Bytes the cached data sets take
+ */
+uint64_t CImportCache::get_memory_size() const {
+	return memory_size;
+}
+
+/**
+ *	\return Number of cached data sets
+ */
+size_t CImportCache::size() const {
+	return entries.size();
+}
+
+/**
+ *	\return Number of requests answered from the cache
+ */
+uint64_t CImportCache::get_hits() const {
+	return hits;
+}
+
+/**
+ *	\return Number of requests that imported the input file
+ */
+uint64_t CImportCache::get_misses() const {
+	return misses;
+}
+
+/**
+ *	Prepare the host metadata of all hosts and the columns of the full flow list of a data set.
+ *
+ *	\param import Data set
+ */
+void CImportCache::prepare(CImport * import) {
+	import->set_localIP(IPv6_addr(), -1);
+	if (import->get_flow_count() > 0)
+		import->get_hostMetadata();
+	import->prepare_columns();
+}
+
+/**
+ *	Update the memory accounted for a data set, which grows when host metadata or flow columns are prepared.
+ *
+ *	\param it Data set
+ */
+void CImportCache::measure(list<entry_t>::iterator it) {
+	memory_size -= it->memory_size;
+	it->memory_size = it->import->get_memory_size();
+	memory_size += it->memory_size;
+}
+
+/**
+ *	Delete least recently used data sets until the memory limit is met.
+ *
+ *	\param keep Data set not to delete
+ */
+void CImportCache::evict(list<entry_t>::iterator keep) {
+	list<entry_t>::iterator it = entries.end();
+	while (memory_size > memory_limit && it != entries.begin()) {
+		--it;
+		if (it == keep)
+			continue;
+		cout << "Evicting cached data set of " << it->in_filename << " (" << it->memory_size / 1024 << " kB).\n";
+		list<entry_t>::iterator victim = it++;
+		erase(victim);
+	}
+}
+
+/**
+ *	Delete a cached data set.
+ *
+ *	\param it Data set
+ */
+void CImportCache::erase(list<entry_t>::iterator it) {
+	memory_size -= it->memory_size;
+	delete it->import;
+	entries.erase(it);
+}
@@ -0,0 +1,80 @@
+#ifndef GIMPORTCACHE_H_
+#define GIMPORTCACHE_H_
+
+/**
+ *	\file gimportcache.h
+ *	\brief Cache of loaded data sets, to answer repeated requests on the same input file without importing it again.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <list>
+
+#include "gimport.h"
+
+/**
+ *	\class	CImportCache
+ *	\brief	CImportCache keeps imported data sets (CImport objects after read_file()) for reuse.
+ *
+ *	A data set is identified by the input file name, the size and modification time of the file and the import
+ *	parameters (see CImport::get_import_parameters()). A changed file is imported again. When the data sets held
+ *	take more memory than the memory limit (see CImport::get_memory_size()), the least recently used ones are
+ *	deleted; the data set returned last is kept even if it exceeds the limit on its own. Data sets are measured
+ *	again on every get(), after the host metadata and flow columns asked for have been prepared.
+ *
+ *	All cached CImport objects share one prefs_t object, which the caller may change between requests.
+ */
+class CImportCache {
+	public:
+		static const uint64_t default_memory_limit = (uint64_t) 1 << 30; ///< 1 GB
+
+		CImportCache(const prefs_t & prefs, uint64_t memory_limit = default_memory_limit);
+		~CImportCache();
+
+		CImport * get(const std::string & in_filename, const CLocalNets & local_nets, const CFlowPredicate & predicate, bool use_index = true,
+		      bool use_reverse_index = true, bool prepare_hosts = false);
+		void clear();
+		static std::string get_identity(const std::string & in_filename, const CLocalNets & local_nets, const CFlowPredicate & predicate);
+
+		void set_memory_limit(uint64_t memory_limit);
+		void set_write_index(bool write_index);
+		uint64_t get_memory_limit() const;
+		uint64_t get_memory_size() const;
+		size_t size() const;
+		uint64_t get_hits() const;
+		uint64_t get_misses() const;
+
+	private:
+		CImportCache(const CImportCache &);
+		CImportCache & operator=(const CImportCache &);
+
+		/**
+		 *	\struct	entry_t
+		 *	\brief	Cached data set
+		 */
+		struct entry_t {
+				CImport * import; ///< Data set (owned)
+				std::string in_filename; ///< Input file
+				uint64_t file_size; ///< Size of the input file when imported
+				int64_t mtime_sec; ///< Modification time of the input file when imported (seconds)
+				int64_t mtime_nsec; ///< Modification time of the input file when imported (nanoseconds)
+				std::string parameters; ///< Import parameters
+				bool use_reverse_index; ///< Reverse remoteIP index prepared
+				uint64_t memory_size; ///< Memory held by the data set (bytes)
+		};
+
+		static void prepare(CImport * import);
+		void measure(std::list<entry_t>::iterator it);
+		void evict(std::list<entry_t>::iterator keep);
+		void erase(std::list<entry_t>::iterator it);
+
+		const prefs_t & prefs; ///< Preferences shared by all data sets
+		std::list<entry_t> entries; ///< Data sets, most recently used first
+		uint64_t memory_limit; ///< Bytes the data sets may take
+		uint64_t memory_size; ///< Bytes the data sets take
+		uint64_t hits; ///< Requests answered from the cache
+		uint64_t misses; ///< Requests that imported the file
+		bool write_index; ///< Imports write the sidecar index of the input file (default: false)
+};
+
+#endif /* GIMPORTCACHE_H_ */
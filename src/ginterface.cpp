@@ -7,8 +7,14 @@
 #include <unistd.h>
 #include <netinet/in_systm.h>
 #include <sys/socket.h>
+#include <fstream>
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "ginterface.h"
+#include "gflowexpression.h"
 #include "gutil.h"
 
 using namespace std;
@@ -24,19 +30,46 @@ const bool debug2 = false;
 /**
  *	Constructor: default
  */
-CInterface::CInterface() {
+CInterface::CInterface() :
+	local_nets(IPv6_addr(), IPv6_addr()), import_cache(prefs) {
 	flowImport = NULL;
-	hpgData = NULL;
 	nodeInfos = NULL;
+	use_index = true;
+	write_index = false;
+	batch_threads = 0;
 }
 
 /**
  *	Destructor: clean up heap if needed
  */
 CInterface::~CInterface() {
-	if (hap4nfsen && nodeInfos != NULL) {
-		delete nodeInfos;
-	}
+	delete flowImport;
+	delete nodeInfos;
+}
+
+/**
+ *	Replace the node infos of the last graphlet.
+ *
+ *	\param node_infos Node infos (taken over, NULL: none)
+ */
+void CInterface::set_node_infos(CSummaryNodeInfos * node_infos) {
+	delete nodeInfos;
+	nodeInfos = node_infos;
+}
+
+/**
+ *	Replace a file by the given contents.
+ *
+ *	\param filename Name of the file
+ *	\param contents File contents
+ *
+ *	\return True if the file could be written
+ */
+static bool write_contents(const string & filename, const string & contents) {
+	ofstream out(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	out.write(contents.data(), contents.size());
+	out.close();
+	return !out.fail();
 }
 
 /**
@@ -56,74 +89,36 @@ bool CInterface::handle_binary_import(std::string & in_filename, std::string & o
 		delete flowImport;
 		flowImport = NULL;
 	}
+	set_node_infos(NULL);
 
-	IPv6_addr local_net = localIP;
-	IPv6_addr netmask = IPv6_addr::getNetmask(128);
-
-	// Derive output from input file name and initialize import.
+	// Get memory-based flowlist of the traffic data, imported by an earlier call or now
+	CImport * import;
 	try {
-		flowImport = new CImport(in_filename, out_filename, prefs);
-		flowImport->set_desummarized_roles(desum_role_nums);
-		flowImport->set_no_reverse_index(); // Only needed for HAPviewer operation
-	} catch (string & errtext) {
-		// Upon failed open on filename given
-		cerr << errtext << endl;
-		return false;
-	}
-
-	// Import traffic data to memory-based flowlist.
-	try {
-		flowImport->read_file(localIP, netmask);
+		import = import_cache.get(in_filename, local_nets, import_predicate, use_index, false); // Reverse index only needed for HAPviewer operation
 	} catch (string & errtext) {
 		// Upon failed open on filename given
 		cerr << errtext << endl;
 		return false;
 	}
+	import->set_hpg_filename(out_filename);
+	import->set_desummarized_roles(desum_role_nums);
 
 	if (debug2)
-		flowImport->print_flowlist(100);
+		import->print_flowlist(100);
 
 	// Create HPG file from memory-based flowlist
-	if (!flowImport->set_localIP(localIP, host_count))
+	if (!import->set_localIP(localIP, host_count))
 		return false;
 
 	try {
-		flowImport->cflow2hpg();
+		import->cflow2hpg();
 	}
 	catch(string & e) {
 		cerr << e << endl;
 		return false;
 	}
-	nodeInfos = flowImport->nodeInfos;
-
-	return true;
-}
-
-/**
- *	Process a binary graphlet description to a text description using dot format.
- *
- *	\param	in_filename	Name of binary graph data file (of file type hpg)
- *	\param	out_filename Name of graph data output file (of file type dot)
- */
-bool CInterface::handle_hpg_import(std::string & in_filename, std::string & out_filename) {
-	// Dismiss old hpg model (if any)
-	if (hpgData != NULL) {
-		delete hpgData;
-		hpgData = NULL;
-	}
-
-	// Read hpg data into memory and extract metadata
-	try {
-		hpgData = new ChpgData(in_filename);
-		hpgData->read_hpg_file();
-		hpgData->nodeInfos = nodeInfos;
-		hpgData->hpg2dot(0, out_filename);
-	} catch (string & errtext) {
-		// Upon failed open on filename given
-		cerr << "ERROR during processing of file " << in_filename << endl;
-		cerr << errtext << endl;
-		return false;
-	}
+	set_node_infos(import->nodeInfos); // Taken over: the cached data set may be evicted by the next request
+	import->nodeInfos = NULL;
 
 	return true;
 }
@@ -139,6 +134,8 @@ bool CInterface::handle_hpg_import(std::string & in_filename, std::string & out_
  *	\return	bool				True if hpg creation ended successfully
  */
 bool CInterface::handle_get_graphlet(std::string & in_filename, std::string & hpg_filename, std::string & dot_filename, std::string IP_str) {
+	set_node_infos(NULL);
+
 	// Get binary representation of IP addresss
 	IPv6_addr localIP;
 	try {
@@ -152,12 +149,83 @@ bool CInterface::handle_get_graphlet(std::string & in_filename, std::string & hp
 
 	//if (debug)
 	cout << "localIP = " << localIP << endl;
-	bool ok;
-	ok = handle_binary_import(in_filename, hpg_filename, localIP, 1);
 
-	if (ok)
-		return handle_hpg_import(hpg_filename, dot_filename);
-	return false;
+	// Outputs of an identical earlier request are served from the graphlet cache
+	string key;
+	try {
+		key = get_graphlet_key(in_filename, localIP);
+	} catch (string & e) {
+		cerr << e << endl;
+		return false;
+	}
+	string dot, hpg;
+	boost::shared_ptr<const CSummaryNodeInfos> cached_nodeInfos;
+	if (graphlet_cache.find(key, dot, hpg, cached_nodeInfos)) {
+		set_node_infos(cached_nodeInfos ? new CSummaryNodeInfos(*cached_nodeInfos) : NULL);
+		if (debug)
+			cout << "Graphlet of " << localIP << " found in cache.\n";
+		if (write_contents(hpg_filename, hpg) && write_contents(dot_filename, dot))
+			return true;
+		cerr << "ERROR: could not write " << dot_filename << " or " << hpg_filename << endl;
+		return false;
+	}
+
+	// Build the graphlet and transform it to dot format in memory
+	try {
+		CImport * import = import_cache.get(in_filename, local_nets, import_predicate, use_index, false, true); // Reverse index only needed for HAPviewer operation
+		const ChostMetadata * host = import->find_host_metadata(localIP);
+		if (host == NULL) {
+			cerr << "ERROR: no flows found for requested IP.\n";
+			return false;
+		}
+		CHpgBufferSink edges;
+		set_node_infos(import->build_graphlet(import->get_host_flowlist(*host), prefs, desum_role_nums, edges));
+		vector<hpg_field> & data = edges.get_data();
+		if (data.empty())
+			throw string("ERROR: no graphlet edges built for requested IP.");
+		ChpgData hpgData(&data[0], data.size() * sizeof(hpg_field));
+		hpgData.nodeInfos = nodeInfos;
+		stringstream out;
+		hpgData.hpg2dot(0, out);
+		dot = out.str();
+		hpg = edges.get_contents();
+	} catch (string & errtext) {
+		set_node_infos(NULL);
+		cerr << errtext << endl;
+		return false;
+	}
+
+	if (!write_contents(hpg_filename, hpg) || !write_contents(dot_filename, dot)) {
+		cerr << "ERROR: could not write " << dot_filename << " or " << hpg_filename << endl;
+		return false;
+	}
+	graphlet_cache.insert(key, dot, hpg, boost::shared_ptr<const CSummaryNodeInfos>(nodeInfos ? new CSummaryNodeInfos(*nodeInfos) : NULL));
+	return true;
+}
+
+/**
+ *	Describe everything the graphlet of a host depends on, as key for the graphlet cache: data set (see
+ *	CImportCache::get_identity()), local IP, summarization and filter preferences and desummarized roles.
+ *
+ *	\param in_filename Name of traffic data input file
+ *	\param localIP IP address of host
+ *
+ *	\return Key
+ *
+ *	\exception std::string Errortext (input file does not exist)
+ */
+string CInterface::get_graphlet_key(const string & in_filename, const IPv6_addr & localIP) const {
+	stringstream key;
+	key << CImportCache::get_identity(in_filename, local_nets, import_predicate) << "\n";
+	key << localIP << "\n";
+	key << prefs.summarize_clt_roles << prefs.summarize_multclt_roles << prefs.summarize_srv_roles << prefs.summarize_p2p_roles;
+	key << prefs.summarize_biflows << prefs.summarize_uniflows;
+	key << prefs.filter_biflows << prefs.filter_uniflows << prefs.filter_unprod_inflows << prefs.filter_unprod_outflows;
+	key << prefs.filter_TCP << prefs.filter_UDP << prefs.filter_ICMP << prefs.filter_OTHER << "\n";
+	key << prefs.filter_expression << "\n";
+	for (desummarizedRoles::const_iterator it = desum_role_nums.begin(); it != desum_role_nums.end(); ++it)
+		key << *it << ",";
+	return key.str();
 }
 
 /**
@@ -171,11 +239,89 @@ bool CInterface::handle_get_graphlet(std::string & in_filename, std::string & hp
  *	\param	summarize_flags	Configuration flags for summarization
  *	\param	filter_flags		Configuration flags for filtering
  *	\param	desum_role_nums	role numbers to be desummarized
+ *	\param	filter_expression	Flows not matching this expression are filtered (see CFlowExpression; empty: none)
  *
  *	\return	bool TRUE if dot file has been successfully prepared, FALSE otherwise
  */
 bool CInterface::get_graphlet(std::string in_filename, std::string & dot_filename, std::string IP_str, summarize_flags_t summarize_flags,
-      filter_flags_t filter_flags, const desummarizedRoles & desum_role_numbers) {
+      filter_flags_t filter_flags, const desummarizedRoles & desum_role_numbers, const std::string & filter_expression) {
+	try {
+		CFlowExpression expression(filter_expression);
+		if (debug && !expression.matches_all())
+			cout << "Filter expression compiled to: " << expression.toString() << endl;
+	} catch (string & e) {
+		cerr << e << endl;
+		return false;
+	}
+	prefs = make_prefs(summarize_flags, filter_flags, filter_expression);
+	if (debug)
+		prefs.show_prefs();
+
+	string hpg_filename = in_filename + ".hpg";
+
+	bool ok = false;
+
+	desum_role_nums = desum_role_numbers;
+
+	ok = handle_get_graphlet(in_filename, hpg_filename, dot_filename, IP_str);
+
+	return ok;
+}
+
+/**
+ *	Build the graphlet of a host and pass its edges and node infos to a sink instead of writing hpg and dot files,
+ *	e.g. to transform it to dot format in memory (see CDotSink) or to store it in a database of the caller.
+ *	Preferences and desummarized roles apply to this call only; the graphlet cache is not used.
+ *
+ *	\param	in_filename			Name of a traffic data file
+ *	\param	sink					Receives the edges and node infos of the graphlet
+ *	\param	IP_str				Dotted IP address of host for which graphlet has to be prepared
+ *	\param	summarize_flags	Configuration flags for summarization
+ *	\param	filter_flags		Configuration flags for filtering
+ *	\param	desum_role_nums	role numbers to be desummarized
+ *	\param	filter_expression	Flows not matching this expression are filtered (see CFlowExpression; empty: none)
+ *
+ *	\return	bool TRUE if the graphlet has been passed to the sink, FALSE otherwise
+ */
+bool CInterface::get_graphlet(std::string in_filename, CEdgeSink & sink, std::string IP_str, summarize_flags_t summarize_flags,
+      filter_flags_t filter_flags, const desummarizedRoles & desum_role_numbers, const std::string & filter_expression) {
+	set_node_infos(NULL);
+	IPv6_addr localIP;
+	try {
+		CFlowExpression expression(filter_expression);
+		localIP = IP_str;
+	} catch (string & e) {
+		cerr << e << endl;
+		return false;
+	}
+
+	try {
+		CImport * import = import_cache.get(in_filename, local_nets, import_predicate, use_index, false, true);
+		const ChostMetadata * host = import->find_host_metadata(localIP);
+		if (host == NULL) {
+			cerr << "ERROR: no flows found for requested IP.\n";
+			return false;
+		}
+		set_node_infos(import->build_graphlet(import->get_host_flowlist(*host), make_prefs(summarize_flags, filter_flags, filter_expression),
+		      desum_role_numbers, sink));
+	} catch (string & e) {
+		cerr << e << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *	Translate the flags of get_graphlet() into preferences.
+ *
+ *	\param	summarize_flags	Configuration flags for summarization
+ *	\param	filter_flags		Configuration flags for filtering
+ *	\param	filter_expression	Flows not matching this expression are filtered (see CFlowExpression; empty: none)
+ *
+ *	\return Preferences
+ */
+prefs_t CInterface::make_prefs(summarize_flags_t summarize_flags, filter_flags_t filter_flags, const std::string & filter_expression) {
+	prefs_t prefs;
 	// Set summarization options
 	if (summarize_flags & summarize_client_roles) {
 		prefs.summarize_clt_roles = true;
@@ -233,18 +379,175 @@ bool CInterface::get_graphlet(std::string in_filename, std::string & dot_filenam
 	}
 	prefs.filter_unprod_inflows = false;
 	prefs.filter_unprod_outflows = false;
-	if (debug)
-		prefs.show_prefs();
+	prefs.filter_expression = filter_expression;
+	return prefs;
+}
 
-	string hpg_filename = in_filename + ".hpg";
+/**
+ *	\struct batch_t
+ *	\brief Shared state of the threads building the graphlets of CInterface::get_graphlets()
+ */
+struct batch_t {
+		const CImport * import; ///< Data set (only read)
+		std::vector<const ChostMetadata *> hosts; ///< Hosts to build graphlets of
+		prefs_t prefs; ///< Preferences of all graphlets
+		desummarizedRoles roles; ///< Desummarized roles of all graphlets
+		CInterface::graphlet_callback_t callback; ///< Receives the graphlets
+		boost::mutex mutex; ///< Protects next and built, serializes the callbacks
+		size_t next; ///< Index of the next host to build
+		unsigned int built; ///< Graphlets passed to the callback
+};
 
-	bool ok = false;
+/**
+ *	Build the graphlet of a host in dot format.
+ *
+ *	\param batch Batch
+ *	\param host Host
+ *
+ *	\return Graphlet in dot format
+ *
+ *	\exception std::string Errortext
+ */
+static string build_batch_graphlet(const batch_t & batch, const ChostMetadata & host) {
+	stringstream dot;
+	CDotSink sink(dot);
+	boost::scoped_ptr<CSummaryNodeInfos> nodeInfos(batch.import->build_graphlet(batch.import->get_host_flowlist(host), batch.prefs, batch.roles, sink));
+	return dot.str();
+}
 
-	desum_role_nums.insert(desum_role_numbers.begin(), desum_role_numbers.end());
+/**
+ *	Batch thread: build graphlets until all hosts are taken.
+ *
+ *	\param batch Batch
+ */
+static void run_batch(batch_t * batch) {
+	while (true) {
+		const ChostMetadata * host;
+		{
+			boost::mutex::scoped_lock lock(batch->mutex);
+			if (batch->next == batch->hosts.size())
+				return;
+			host = batch->hosts[batch->next++];
+		}
+		try {
+			string dot = build_batch_graphlet(*batch, *host);
+			boost::mutex::scoped_lock lock(batch->mutex);
+			batch->callback(host->IP, dot);
+			batch->built++;
+		} catch (string & e) {
+			boost::mutex::scoped_lock lock(batch->mutex);
+			cerr << "ERROR: no graphlet of " << host->IP << ": " << e << endl;
+		}
+	}
+}
 
-	ok = handle_get_graphlet(in_filename, hpg_filename, dot_filename, IP_str);
+/**
+ *	Write a graphlet of write_graphlets() to "<IP>.dot" in a directory.
+ *
+ *	\param out_dir Directory
+ *	\param IP Host
+ *	\param dot Graphlet in dot format
+ *
+ *	\exception std::string Errortext
+ */
+static void write_graphlet_file(const string & out_dir, const IPv6_addr & IP, const string & dot) {
+	string filename = out_dir + "/" + IP.toString() + ".dot";
+	if (!write_contents(filename, dot))
+		throw "could not write " + filename;
+}
 
-	return ok;
+/**
+ *	Build the graphlets of many hosts of a traffic data input file at once. The hosts are selected in a single pass
+ *	over the host list of the data set and built by several threads (see set_batch_threads()), sharing the data set.
+ *
+ *	The data set is imported (or taken from the cache) with the local networks of the site (see set_local_nets()), as
+ *	get_graphlet() does. The graphlet cache is not used.
+ *
+ *	\param	in_filename			Name of a traffic data file
+ *	\param	hosts					IP addresses and prefixes (e.g. "10.0.0.0/24") of the hosts; hosts without flows are skipped
+ *	\param	summarize_flags	Configuration flags for summarization
+ *	\param	filter_flags		Configuration flags for filtering
+ *	\param	desum_role_nums	role numbers to be desummarized
+ *	\param	callback				Receives each graphlet (one call at a time, in no particular order). It may throw a
+ *										std::string to report that it failed to process the graphlet.
+ *	\param	filter_expression	Flows not matching this expression are filtered (see CFlowExpression; empty: none)
+ *
+ *	\return	Number of graphlets passed to the callback (and processed by it)
+ */
+unsigned int CInterface::get_graphlets(std::string in_filename, const std::vector<std::string> & hosts, summarize_flags_t summarize_flags,
+      filter_flags_t filter_flags, const desummarizedRoles & desum_role_numbers, const graphlet_callback_t & callback,
+      const std::string & filter_expression) {
+	set_node_infos(NULL); // Node infos of the batch graphlets are passed to the sinks only
+	batch_t batch;
+	CLocalNets selection;
+	try {
+		for (vector<string>::const_iterator it = hosts.begin(); it != hosts.end(); ++it)
+			selection.add(*it);
+		CFlowExpression expression(filter_expression);
+	} catch (string & e) {
+		cerr << e << endl;
+		return 0;
+	}
+	batch.prefs = make_prefs(summarize_flags, filter_flags, filter_expression);
+	batch.roles = desum_role_numbers;
+	batch.callback = callback;
+	batch.next = 0;
+	batch.built = 0;
+
+	// Get memory-based flowlist of the traffic data, imported by an earlier call or now
+	CImport * import;
+	try {
+		import = import_cache.get(in_filename, local_nets, import_predicate, use_index, false, true); // Reverse index only needed for HAPviewer operation
+	} catch (string & errtext) {
+		cerr << errtext << endl;
+		return 0;
+	}
+	batch.import = import;
+
+	// Select the hosts in one pass over the host list
+	const vector<ChostMetadata> & all_hosts = import->get_host_metadata();
+	for (vector<ChostMetadata>::const_iterator it = all_hosts.begin(); it != all_hosts.end(); ++it)
+		if (selection.is_local(it->IP))
+			batch.hosts.push_back(&*it);
+	if (debug)
+		cout << "Building " << batch.hosts.size() << " graphlets of " << all_hosts.size() << " hosts.\n";
+
+	unsigned int threads = batch_threads != 0 ? batch_threads : boost::thread::hardware_concurrency();
+	threads = max(1u, min<unsigned int>(threads, batch.hosts.size()));
+	boost::thread_group group;
+	for (unsigned int i = 1; i < threads; i++)
+		group.create_thread(boost::bind(&run_batch, &batch));
+	run_batch(&batch);
+	group.join_all();
+	return batch.built;
+}
+
+/**
+ *	Build the graphlets of many hosts like get_graphlets() and write each to "<IP>.dot" in a directory.
+ *
+ *	\param	in_filename			Name of a traffic data file
+ *	\param	hosts					IP addresses and prefixes (e.g. "10.0.0.0/24") of the hosts; hosts without flows are skipped
+ *	\param	summarize_flags	Configuration flags for summarization
+ *	\param	filter_flags		Configuration flags for filtering
+ *	\param	desum_role_nums	role numbers to be desummarized
+ *	\param	out_dir				Existing directory for the dot files
+ *	\param	filter_expression	Flows not matching this expression are filtered (see CFlowExpression; empty: none)
+ *
+ *	\return	Number of dot files written
+ */
+unsigned int CInterface::write_graphlets(std::string in_filename, const std::vector<std::string> & hosts, summarize_flags_t summarize_flags,
+      filter_flags_t filter_flags, const desummarizedRoles & desum_role_numbers, const std::string & out_dir, const std::string & filter_expression) {
+	return get_graphlets(in_filename, hosts, summarize_flags, filter_flags, desum_role_numbers, boost::bind(&write_graphlet_file, out_dir, _1, _2),
+	      filter_expression);
+}
+
+/**
+ *	Set the number of threads building the graphlets of get_graphlets() and write_graphlets().
+ *
+ *	\param threads Threads (0: one per processor core, default)
+ */
+void CInterface::set_batch_threads(unsigned int threads) {
+	batch_threads = threads;
 }
 
 /**
@@ -277,3 +580,143 @@ bool CInterface::get_hpg_file(string in_filename, std::string & hpg_filename, IP
 	return ok;
 }
 
+/**
+ *	Create a graph database holding the graphlets of all local hosts of a traffic input file, using a bounded
+ *	amount of memory (see CImport::cflow2hpg_database()). Suited for input files larger than the memory.
+ *
+ *	\param	in_filename Name of a traffic input file
+ *	\param	hpg_filename Name of HPG binary graph data output file
+ *	\param	local_nets Local networks used to infer flow directions (not used for cflow files)
+ *	\param	memory_budget Bytes of flows to keep in memory for sorting
+ *	\param	tmp_dir Directory for temporary sorted runs (empty: $TMPDIR or /tmp)
+ *	\param	hpg_version Format of the hpg file: 3 or 4 (compact, see ghpgv4.h)
+ *
+ *	\return	bool TRUE if conversion was successful
+ */
+bool CInterface::get_hpg_database(string in_filename, const std::string & hpg_filename, const CLocalNets & local_nets, uint64_t memory_budget,
+      const std::string & tmp_dir, unsigned int hpg_version) {
+	if (flowImport != NULL) {
+		delete flowImport;
+		flowImport = NULL;
+	}
+
+	try {
+		flowImport = new CImport(in_filename, hpg_filename, prefs);
+		flowImport->set_desummarized_roles(desum_role_nums);
+		flowImport->cflow2hpg_database(local_nets, memory_budget, tmp_dir, import_predicate, hpg_version);
+	} catch (string & errtext) {
+		cerr << errtext << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ *	Import a traffic input file and save the prepared dataset as a snapshot (see CImport::save_snapshot()). Passing
+ *	the snapshot as input file to get_graphlet() or opening it in the GUI resumes from it without importing again.
+ *
+ *	\param	in_filename Name of a traffic input file
+ *	\param	snapshot_filename Name of the snapshot file (*.hsnap)
+ *	\param	local_nets Local networks used to infer flow directions (not used for cflow files)
+ *
+ *	\return	bool TRUE if the snapshot was written
+ */
+bool CInterface::save_snapshot(string in_filename, const std::string & snapshot_filename, const CLocalNets & local_nets) {
+	if (flowImport != NULL) {
+		delete flowImport;
+		flowImport = NULL;
+	}
+
+	try {
+		flowImport = new CImport(in_filename, "", prefs);
+		flowImport->set_use_index(use_index);
+		flowImport->set_write_index(write_index);
+		flowImport->read_file(local_nets, import_predicate);
+		if (flowImport->get_flow_count() > 0)
+			flowImport->get_hostMetadata();
+		flowImport->save_snapshot(snapshot_filename);
+	} catch (string & errtext) {
+		cerr << errtext << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ *	Restrict the flows imported by get_graphlet(), get_hpg_file() and get_hpg_database(). Skipping flows at import time
+ *	saves memory and sorting time, but roles are rated on the imported flows only.
+ *
+ *	\param predicate Import predicate
+ */
+void CInterface::set_import_predicate(const CFlowPredicate & predicate) {
+	import_predicate = predicate;
+}
+
+/**
+ *	Set the local networks of the site, used to infer flow directions when get_graphlet(), get_graphlets() and
+ *	get_hpg_file() import formats without them (e.g. nfdump, pcap). All requests on an input file share its
+ *	imported data set, whatever host they ask for.
+ *
+ *	\param local_nets Local networks (default: every address is local)
+ */
+void CInterface::set_local_nets(const CLocalNets & local_nets) {
+	this->local_nets = local_nets;
+}
+
+/**
+ *	Set the memory the data sets kept for later get_graphlet() and get_hpg_file() calls may take. A call on an input
+ *	file (with the same import parameters) that is still cached and unchanged skips the import.
+ *
+ *	\param memory_limit Bytes (default: CImportCache::default_memory_limit; 0: keep the last data set only)
+ */
+void CInterface::set_cache_memory_limit(uint64_t memory_limit) {
+	import_cache.set_memory_limit(memory_limit);
+}
+
+/**
+ *	Release all data sets and graphlet outputs kept for later calls.
+ */
+void CInterface::clear_cache() {
+	import_cache.clear();
+	graphlet_cache.clear();
+}
+
+/**
+ *	Set the memory the graphlet outputs kept for later get_graphlet() calls may take. An identical call (same
+ *	unchanged input file, host, flags, filter expression and desummarized roles) then skips the graphlet building.
+ *
+ *	\param byte_budget Bytes (default: CGraphletCache::default_byte_budget; 0: cache no outputs)
+ */
+void CInterface::set_graphlet_cache_budget(uint64_t byte_budget) {
+	graphlet_cache.set_byte_budget(byte_budget);
+}
+
+/**
+ *	\return Graphlet output cache (for its statistics)
+ */
+const CGraphletCache & CInterface::get_graphlet_cache() const {
+	return graphlet_cache;
+}
+
+/**
+ *	Enable or disable the sidecar index (*.hidx) beside input files of get_graphlet() and get_hpg_file():
+ *	a valid index replaces decompression, sorting and indexing of an unchanged input file (see CFlowIndex).
+ *
+ *	\param use_index True to load the index (default), and to write it if enabled by set_write_index()
+ */
+void CInterface::set_use_index(bool use_index) {
+	this->use_index = use_index;
+}
+
+/**
+ *	Write the sidecar index beside input files after an import. Off by default: a library call should not
+ *	leave files beside its input unless the caller wants later runs to reuse them.
+ *
+ *	\param write_index True to write the index (default: false)
+ */
+void CInterface::set_write_index(bool write_index) {
+	this->write_index = write_index;
+	import_cache.set_write_index(write_index);
+}
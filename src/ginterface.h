@@ -8,8 +8,12 @@
  */
 
 #include <string>
+#include <vector>
+#include <boost/function.hpp>
 
 #include "gimport.h"
+#include "gimportcache.h"
+#include "ggraphletcache.h"
 #include "ghpgdata.h"
 #include "grole.h"
 
@@ -20,8 +24,14 @@
 class CInterface {
 	private:
 		CImport * flowImport; ///< Ref to data for HOST list model
-		ChpgData * hpgData; ///< Data for HPG model
 		prefs_t prefs; ///< Preferences settings
+		CFlowPredicate import_predicate; ///< Flows to import (default: all)
+		CLocalNets local_nets; ///< Local networks used to infer flow directions of imports (default: every address is local)
+		bool use_index; ///< Use the sidecar index of input files (default: true)
+		bool write_index; ///< Write the sidecar index of input files after an import (default: false)
+		CImportCache import_cache; ///< Data sets loaded by get_graphlet() and get_hpg_file(), reused by later calls
+		CGraphletCache graphlet_cache; ///< Outputs of get_graphlet(), reused by identical later calls
+		unsigned int batch_threads; ///< Threads building the graphlets of get_graphlets() (0: one per processor core)
 
 	public:
 		CInterface();
@@ -36,15 +46,43 @@ class CInterface {
 			filter_biflows = 1, filter_uniflows = 2, filter_tcp = 4, filter_udp = 8, filter_icmp = 16, filter_other = 32
 		};
 
+		/**
+		 *	\typedef graphlet_callback_t
+		 *	\brief Receives a graphlet built by get_graphlets(): IP of the host and graphlet in dot format
+		 */
+		typedef boost::function<void(const IPv6_addr &, const std::string &)> graphlet_callback_t;
+
 		bool get_graphlet(std::string in_filename, std::string & outfile, std::string IP_str, summarize_flags_t summarize_flags, filter_flags_t filter_flags,
-		      const std::set<uint32_t> & desum_role_nums);
+		      const std::set<uint32_t> & desum_role_nums, const std::string & filter_expression = "");
+		bool get_graphlet(std::string in_filename, CEdgeSink & sink, std::string IP_str, summarize_flags_t summarize_flags, filter_flags_t filter_flags,
+		      const std::set<uint32_t> & desum_role_nums, const std::string & filter_expression = "");
+		unsigned int get_graphlets(std::string in_filename, const std::vector<std::string> & hosts, summarize_flags_t summarize_flags,
+		      filter_flags_t filter_flags, const std::set<uint32_t> & desum_role_nums, const graphlet_callback_t & callback,
+		      const std::string & filter_expression = "");
+		unsigned int write_graphlets(std::string in_filename, const std::vector<std::string> & hosts, summarize_flags_t summarize_flags,
+		      filter_flags_t filter_flags, const std::set<uint32_t> & desum_role_nums, const std::string & out_dir,
+		      const std::string & filter_expression = "");
+		void set_batch_threads(unsigned int threads);
+		static prefs_t make_prefs(summarize_flags_t summarize_flags, filter_flags_t filter_flags, const std::string & filter_expression = "");
 		bool get_hpg_file(std::string in_filename, std::string & outfile, IPv6_addr localIP, int host_count);
+		bool get_hpg_database(std::string in_filename, const std::string & hpg_filename, const CLocalNets & local_nets, uint64_t memory_budget,
+		      const std::string & tmp_dir = "", unsigned int hpg_version = 3);
+		bool save_snapshot(std::string in_filename, const std::string & snapshot_filename, const CLocalNets & local_nets);
+		void set_import_predicate(const CFlowPredicate & predicate);
+		void set_local_nets(const CLocalNets & local_nets);
+		void set_use_index(bool use_index);
+		void set_write_index(bool write_index);
+		void set_cache_memory_limit(uint64_t memory_limit);
+		void clear_cache();
+		void set_graphlet_cache_budget(uint64_t byte_budget);
+		const CGraphletCache & get_graphlet_cache() const;
 
 	private:
 		bool handle_get_graphlet(std::string & in_filename, std::string & hpg_filename, std::string & dot_filename, std::string IP_str);
-		bool handle_hpg_import(std::string & in_filename, std::string & out_filename);
+		std::string get_graphlet_key(const std::string & in_filename, const IPv6_addr & localIP) const;
 		bool handle_binary_import(std::string & in_filename, std::string & out_filename, IPv6_addr localIP, int host_count);
-		CSummaryNodeInfos* nodeInfos; ///< Storage for nodeid filter (needed by HAP4NfSen)
+		void set_node_infos(CSummaryNodeInfos * node_infos);
+		CSummaryNodeInfos* nodeInfos; ///< Storage for nodeid filter of the last graphlet (needed by HAP4NfSen, owned)
 		desummarizedRoles desum_role_nums; ///< Desummarized role number
 };
 
@@ -0,0 +1,128 @@
+/**
+ *	\file gipdictionary.cpp
+ *	\brief Dictionary mapping the IP addresses of a flow list to 32 bit ids.
+ */
+
+#include <cassert>
+#include <algorithm>
+
+#include "gipdictionary.h"
+#include "lookup3.h"
+
+using namespace std;
+
+const uint32_t CIPDictionary::no_id;
+
+/**
+ *	Constructor: assign ids to all local and remote addresses of a range of flows.
+ *
+ *	\param begin First flow
+ *	\param end Behind last flow
+ */
+CIPDictionary::CIPDictionary(CFlowList::const_iterator begin, CFlowList::const_iterator end) {
+	// Collect addresses: local addresses of sorted flow lists come in runs, only add each run once
+	ips.reserve(end - begin);
+	for (CFlowList::const_iterator it = begin; it != end; ++it) {
+		if (it == begin || it->localIP != (it - 1)->localIP)
+			ips.push_back(it->localIP);
+		ips.push_back(it->remoteIP);
+	}
+	sort(ips.begin(), ips.end());
+	ips.erase(unique(ips.begin(), ips.end()), ips.end());
+
+	prepare_slots();
+}
+
+/**
+ *	Constructor: use a given address table, e.g. one saved with a snapshot (see get_IPs()).
+ *
+ *	\param ips Distinct addresses in ascending order (address of id 0 first)
+ */
+CIPDictionary::CIPDictionary(const vector<IPv6_addr> & ips) :
+	ips(ips) {
+	prepare_slots();
+}
+
+/**
+ *	Fill the id table from ips. The table is kept at most half full, so probe sequences stay short.
+ */
+void CIPDictionary::prepare_slots() {
+	size_t size = 16;
+	while (size < 2 * ips.size())
+		size *= 2;
+	slots.assign(size, no_id);
+	slot_mask = size - 1;
+	for (uint32_t id = 0; id < ips.size(); id++) {
+		uint32_t slot = hashlittle(ips[id].data(), ips[id].size(), 0) & slot_mask;
+		while (slots[slot] != no_id)
+			slot = (slot + 1) & slot_mask;
+		slots[slot] = id;
+	}
+}
+
+/**
+ *	Get number of distinct addresses (ids are 0 .. size()-1).
+ *
+ *	\return Number of addresses
+ */
+size_t CIPDictionary::size() const {
+	return ips.size();
+}
+
+/**
+ *	Get id of an address.
+ *
+ *	\param IP Address
+ *
+ *	\return Id or no_id if the address does not occur in the flows
+ */
+uint32_t CIPDictionary::find_id(const IPv6_addr & IP) const {
+	for (uint32_t slot = hashlittle(IP.data(), IP.size(), 0) & slot_mask;; slot = (slot + 1) & slot_mask) {
+		uint32_t id = slots[slot];
+		if (id == no_id || ips[id] == IP)
+			return id;
+	}
+}
+
+/**
+ *	Get address of an id.
+ *
+ *	\param id Address id
+ *
+ *	\return Address
+ */
+const IPv6_addr & CIPDictionary::get_IP(uint32_t id) const {
+	assert(id < ips.size());
+	return ips[id];
+}
+
+/**
+ *	Get the address table.
+ *
+ *	\return Addresses by id (ascending)
+ */
+const vector<IPv6_addr> & CIPDictionary::get_IPs() const {
+	return ips;
+}
+
+/**
+ *	Append the local and remote address ids of a range of flows. All addresses have to be part of the dictionary.
+ *
+ *	\param begin First flow
+ *	\param end Behind last flow
+ *	\param localIP_ids Receives the local address ids
+ *	\param remoteIP_ids Receives the remote address ids
+ */
+void CIPDictionary::encode(CFlowList::const_iterator begin, CFlowList::const_iterator end, vector<uint32_t> & localIP_ids,
+      vector<uint32_t> & remoteIP_ids) const {
+	// Flow lists are sorted by local address: only look up the local address when it changes
+	uint32_t local_id = no_id;
+	for (CFlowList::const_iterator it = begin; it != end; ++it) {
+		if (it == begin || it->localIP != (it - 1)->localIP)
+			local_id = find_id(it->localIP);
+		uint32_t remote_id = find_id(it->remoteIP);
+		assert(local_id != no_id && remote_id != no_id);
+		localIP_ids.push_back(local_id);
+		remoteIP_ids.push_back(remote_id);
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef GIPDICTIONARY_H_
+#define GIPDICTIONARY_H_
+
+/**
+ *	\file gipdictionary.h
+ *	\brief Dictionary mapping the IP addresses of a flow list to 32 bit ids.
+ */
+
+#include <stdint.h>
+#include <vector>
+
+#include "cflow.h"
+#include "IPv6_addr.h"
+
+/**
+ *	\class	CIPDictionary
+ *	\brief	CIPDictionary assigns each distinct local or remote address of a flow list a 32 bit id.
+ *
+ *	The dictionary is built once per loaded data set. Ids are dense (0 .. size()-1) and assigned in
+ *	ascending address order, so comparing ids gives the same order as comparing the addresses. Keys
+ *	and comparisons on ids are integer operations instead of 16 byte copies and compares.
+ */
+class CIPDictionary {
+	public:
+		static const uint32_t no_id = 0xffffffff; ///< Returned by find_id() for unknown addresses
+
+		CIPDictionary(CFlowList::const_iterator begin, CFlowList::const_iterator end);
+		CIPDictionary(const std::vector<IPv6_addr> & ips);
+
+		size_t size() const;
+		uint32_t find_id(const IPv6_addr & IP) const;
+		const IPv6_addr & get_IP(uint32_t id) const;
+		const std::vector<IPv6_addr> & get_IPs() const;
+		void encode(CFlowList::const_iterator begin, CFlowList::const_iterator end, std::vector<uint32_t> & localIP_ids,
+		      std::vector<uint32_t> & remoteIP_ids) const;
+
+	private:
+		void prepare_slots();
+
+		std::vector<IPv6_addr> ips; ///< Address by id (ascending)
+		std::vector<uint32_t> slots; ///< Id by address: open addressing table indexed by address hash (no_id: empty slot)
+		uint32_t slot_mask; ///< slots.size() - 1 (size is a power of two)
+};
+
+#endif /* GIPDICTIONARY_H_ */
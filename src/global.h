@@ -6,6 +6,7 @@
  */
 
 #include <iostream>
+#include <string>
 
 /**
  *	\class	prefs_t
@@ -29,6 +30,7 @@ class prefs_t {
 		bool filter_UDP; ///< True when UDP flows should be filtered
 		bool filter_ICMP; ///< True when ICMP flows should be filtered
 		bool filter_OTHER; ///< True when OTHER flows should be filtered
+		std::string filter_expression; ///< Flows not matching this expression are filtered (see CFlowExpression; empty: none)
 
 		bool warn_oversized_graphlet; ///< True when user should be warned before oversized graphlets
 
@@ -75,6 +77,7 @@ class prefs_t {
 			std::cout << "filter_UDP:              " << (filter_UDP ? "true" : "false") << std::endl;
 			std::cout << "filter_ICMP:             " << (filter_ICMP ? "true" : "false") << std::endl;
 			std::cout << "filter_OTHER:            " << (filter_OTHER ? "true" : "false") << std::endl;
+			std::cout << "filter_expression:       " << filter_expression << std::endl;
 			std::cout << std::endl;
 			std::cout << "warn_oversized_graphlet: " << (warn_oversized_graphlet ? "true" : "false") << std::endl;
 		}
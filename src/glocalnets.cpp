@@ -0,0 +1,295 @@
+/**
+ *	\file glocalnets.cpp
+ *	\brief Set of local network prefixes with longest prefix match lookup.
+ */
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <arpa/inet.h>
+#include <boost/lexical_cast.hpp>
+
+#include "glocalnets.h"
+
+using namespace std;
+
+const int CLocalNets::no_match;
+const unsigned int CLocalNets::stride;
+
+/**
+ *	Constructor: empty set, no address is local
+ */
+CLocalNets::CLocalNets() {
+	clear();
+}
+
+/**
+ *	Constructor: single local network given by address and netmask (as used by the import filters so far).
+ *	The prefix length is the number of leading one bits of the netmask; an all zero netmask makes every
+ *	address local.
+ *
+ *	\param local_net Local network address
+ *	\param netmask Network mask for local network address
+ */
+CLocalNets::CLocalNets(const IPv6_addr & local_net, const IPv6_addr & netmask) {
+	clear();
+	unsigned int length = 0;
+	for (IPv6_addr::const_iterator it = netmask.begin(); it != netmask.end() && *it == 0xff; ++it)
+		length += 8;
+	if (length < 128) {
+		for (unsigned char b = netmask[length / 8]; b & 0x80; b <<= 1)
+			length++;
+	}
+	add(local_net, length);
+}
+
+/**
+ *	Remove all prefixes.
+ */
+void CLocalNets::clear() {
+	prefixes.clear();
+	entries.clear();
+	lengths.clear();
+	default_match = no_match;
+	ipv4_node = 0;
+	ipv4_match = no_match;
+	new_node(); // root
+}
+
+/**
+ *	Append an empty node.
+ *
+ *	\return Index of the node
+ */
+uint32_t CLocalNets::new_node() {
+	uint32_t node = entries.size() / stride;
+	entry_t empty;
+	empty.child = 0;
+	empty.match = no_match;
+	entries.resize(entries.size() + stride, empty);
+	lengths.resize(lengths.size() + stride, 0);
+	return node;
+}
+
+/**
+ *	Add a prefix. Host bits of the network address are ignored.
+ *
+ *	\param net Network address
+ *	\param length Prefix length in bits (0..128, IPv4 prefixes IPv4-mapped i.e. 96..128)
+ *
+ *	\return Index of the prefix (index of the existing prefix if it has been added before)
+ *
+ *	\exception std::string Errortext
+ */
+int CLocalNets::add(const IPv6_addr & net, unsigned int length) {
+	if (length > 128) {
+		stringstream errormsg;
+		errormsg << "ERROR: invalid prefix length " << length << " for " << net << " (valid: 0..128).";
+		throw errormsg.str();
+	}
+	prefix_t prefix;
+	prefix.net = net;
+	prefix.length = length;
+	for (unsigned int i = (length + 7) / 8; i < 16; i++)
+		prefix.net[i] = 0;
+	if (length % 8)
+		prefix.net[length / 8] &= (unsigned char) (0xff << (8 - length % 8));
+
+	for (size_t i = 0; i < prefixes.size(); i++) {
+		if (prefixes[i].length == prefix.length && prefixes[i].net == prefix.net)
+			return i;
+	}
+	int index = prefixes.size();
+	prefixes.push_back(prefix);
+
+	if (length == 0) {
+		default_match = index;
+	} else {
+		// Walk down to the node in which the prefix ends, creating nodes on the way
+		unsigned int level = (length - 1) / 8;
+		uint32_t node = 0;
+		for (unsigned int depth = 0; depth < level; depth++) {
+			size_t e = node * stride + prefix.net[depth];
+			if (entries[e].child == 0) {
+				uint32_t child = new_node();
+				entries[e].child = child;
+			}
+			node = entries[e].child;
+		}
+		// Expand the prefix to all entries covered by its last bits, longer prefixes take precedence
+		unsigned int bits = length - level * 8;
+		unsigned int first = prefix.net[level];
+		unsigned int count = 1 << (8 - bits);
+		for (unsigned int i = first; i < first + count; i++) {
+			size_t e = node * stride + i;
+			if (lengths[e] <= length) {
+				entries[e].match = index;
+				lengths[e] = length + 1;
+			}
+		}
+	}
+	update_ipv4_start();
+	return index;
+}
+
+/**
+ *	Add a prefix given as string, e.g. "10.0.0.0/8" or "2001:db8::/32". An address without prefix length
+ *	is a single host (/32 resp. /128).
+ *
+ *	\param prefix_str Prefix in CIDR notation
+ *
+ *	\return Index of the prefix
+ *
+ *	\exception std::string Errortext
+ */
+int CLocalNets::add(const string & prefix_str) {
+	string addr_str = prefix_str;
+	string length_str;
+	string::size_type slash = prefix_str.find('/');
+	if (slash != string::npos) {
+		addr_str = prefix_str.substr(0, slash);
+		length_str = prefix_str.substr(slash + 1);
+	}
+
+	IPv6_addr net;
+	unsigned int max_length;
+	struct in_addr addr4;
+	struct in6_addr addr6;
+	if (inet_pton(AF_INET, addr_str.c_str(), &addr4) == 1) {
+		net = IPv6_addr(ntohl(addr4.s_addr));
+		max_length = 32;
+	} else if (inet_pton(AF_INET6, addr_str.c_str(), &addr6) == 1) {
+		net = IPv6_addr(addr6);
+		max_length = 128;
+	} else {
+		throw "ERROR: invalid network address in prefix \"" + prefix_str + "\".";
+	}
+
+	unsigned int length = max_length;
+	if (slash != string::npos) {
+		try {
+			length = boost::lexical_cast<unsigned int>(length_str);
+		} catch (boost::bad_lexical_cast &) {
+			throw "ERROR: invalid prefix length in prefix \"" + prefix_str + "\".";
+		}
+		if (length > max_length)
+			throw "ERROR: prefix length out of range in prefix \"" + prefix_str + "\".";
+	}
+	return add(net, (max_length == 32) ? length + 96 : length);
+}
+
+/**
+ *	Add the prefixes listed in a file: one prefix in CIDR notation per line, text following a '#'
+ *	is a comment, empty lines are ignored.
+ *
+ *	\param filename Name of the prefix file
+ *
+ *	\exception std::string Errortext
+ */
+void CLocalNets::load(const string & filename) {
+	ifstream infile(filename.c_str());
+	if (!infile)
+		throw "ERROR: could not open local network file \"" + filename + "\".";
+
+	string line;
+	unsigned int line_number = 0;
+	while (getline(infile, line)) {
+		line_number++;
+		string::size_type comment = line.find('#');
+		if (comment != string::npos)
+			line.erase(comment);
+		string::size_type first = line.find_first_not_of(" \t\r");
+		if (first == string::npos)
+			continue;
+		string::size_type last = line.find_last_not_of(" \t\r");
+		try {
+			add(line.substr(first, last - first + 1));
+		} catch (string & errtext) {
+			stringstream errormsg;
+			errormsg << filename << ":" << line_number << ": " << errtext;
+			throw errormsg.str();
+		}
+	}
+}
+
+/**
+ *	Get number of prefixes.
+ *
+ *	\return Number of prefixes
+ */
+size_t CLocalNets::size() const {
+	return prefixes.size();
+}
+
+/**
+ *	Check for an empty set.
+ *
+ *	\return True if no prefix has been added
+ */
+bool CLocalNets::empty() const {
+	return prefixes.empty();
+}
+
+/**
+ *	Get a prefix.
+ *
+ *	\param index Index of the prefix (as returned by add() and lookup())
+ *
+ *	\return Prefix
+ */
+const CLocalNets::prefix_t & CLocalNets::get_prefix(int index) const {
+	assert(index >= 0 && (size_t) index < prefixes.size());
+	return prefixes[index];
+}
+
+/**
+ *	Returns a string representation of all prefixes (comma separated CIDR notation).
+ *
+ *	\return string Prefixes
+ */
+string CLocalNets::toString() const {
+	stringstream ss;
+	for (vector<prefix_t>::const_iterator it = prefixes.begin(); it != prefixes.end(); ++it) {
+		if (it != prefixes.begin())
+			ss << ", ";
+		bool ipv4 = it->net.isIPv4() && it->length >= 96;
+		ss << it->net << "/" << (ipv4 ? it->length - 96 : it->length);
+	}
+	return ss.str();
+}
+
+/**
+ *	Look up a batch of addresses. Consecutive lookups of the same address (e.g. the local address of
+ *	flows sorted by local address) reuse the previous result.
+ *
+ *	\param IPs Addresses
+ *	\param count Number of addresses
+ *	\param matches Receives the index of the longest matching prefix or no_match for each address
+ */
+void CLocalNets::lookup(const IPv6_addr * IPs, size_t count, int * matches) const {
+	for (size_t i = 0; i < count; i++) {
+		if (i > 0 && IPs[i] == IPs[i - 1])
+			matches[i] = matches[i - 1];
+		else
+			matches[i] = lookup(IPs[i]);
+	}
+}
+
+/**
+ *	Update the start node of IPv4 lookups: walk ::ffff:0:0/96 from the root.
+ */
+void CLocalNets::update_ipv4_start() {
+	IPv6_addr ipv4_net((uint32_t) 0);
+	ipv4_match = default_match;
+	uint32_t node = 0;
+	for (unsigned int depth = 0; depth < 12; depth++) {
+		const entry_t & e = entries[node * stride + ipv4_net[depth]];
+		if (e.match != no_match)
+			ipv4_match = e.match;
+		node = e.child;
+		if (node == 0)
+			break;
+	}
+	ipv4_node = node;
+}
@@ -0,0 +1,121 @@
+#ifndef GLOCALNETS_H_
+#define GLOCALNETS_H_
+
+/**
+ *	\file glocalnets.h
+ *	\brief Set of local network prefixes with longest prefix match lookup.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "IPv6_addr.h"
+
+/**
+ *	\class	CLocalNets
+ *	\brief	CLocalNets holds the prefixes of the local network(s) and classifies addresses as local or remote.
+ *
+ *	The prefixes are stored in a multibit trie with a stride of 8 bits: each node is a table of 256
+ *	entries indexed by one address byte. Prefixes not ending on a byte boundary are expanded to all
+ *	entries they cover, an entry keeps the longest prefix ending in its node. A lookup thus takes one
+ *	table access per address byte and stops at the first entry without child. IPv4(-mapped) addresses
+ *	start at the node of ::ffff:0:0/96, i.e. they need at most 4 table accesses.
+ *
+ *	IPv4 prefixes are stored IPv4-mapped (prefix length + 96), like the addresses.
+ */
+class CLocalNets {
+	public:
+		static const int no_match = -1; ///< Returned by lookup() for addresses not covered by any prefix
+
+		/**
+		 *	\struct	prefix_t
+		 *	\brief	A network prefix
+		 */
+		struct prefix_t {
+				IPv6_addr net; ///< Network address (host bits cleared)
+				uint8_t length; ///< Prefix length in bits (0..128, IPv4 prefixes are IPv4-mapped)
+		};
+
+		CLocalNets();
+		CLocalNets(const IPv6_addr & local_net, const IPv6_addr & netmask);
+
+		int add(const IPv6_addr & net, unsigned int length);
+		int add(const std::string & prefix_str);
+		void load(const std::string & filename);
+		void clear();
+
+		size_t size() const;
+		bool empty() const;
+		const prefix_t & get_prefix(int index) const;
+		std::string toString() const;
+
+		int lookup(const IPv6_addr & IP) const;
+		void lookup(const IPv6_addr * IPs, size_t count, int * matches) const;
+		bool is_local(const IPv6_addr & IP) const;
+
+	private:
+		/**
+		 *	\struct	entry_t
+		 *	\brief	Trie node entry
+		 */
+		struct entry_t {
+				uint32_t child; ///< Node of the next address byte (0: none, node 0 is the root)
+				int32_t match; ///< Longest prefix ending within this node covering the entry, or no_match
+		};
+
+		static const unsigned int stride = 256; ///< Entries per node
+
+		uint32_t new_node();
+		void update_ipv4_start();
+
+		std::vector<prefix_t> prefixes; ///< Prefixes in the order they have been added
+		std::vector<entry_t> entries; ///< Nodes, node n occupies entries n*stride .. (n+1)*stride-1
+		std::vector<uint8_t> lengths; ///< Prefix length + 1 of the match of each entry (0: none), used by add()
+		int default_match; ///< Prefix of length 0 or no_match
+		uint32_t ipv4_node; ///< Node reached by ::ffff:0:0/96 (0: path ends before)
+		int ipv4_match; ///< Longest prefix covering ::ffff:0:0/96 or no_match
+};
+
+/**
+ *	Look up a single address: follow the trie byte by byte.
+ *
+ *	\param IP Address
+ *
+ *	\return Index of the longest prefix covering the address, or no_match
+ */
+inline int CLocalNets::lookup(const IPv6_addr & IP) const {
+	const unsigned char * a = IP.begin();
+	int best = default_match;
+	uint32_t node = 0;
+	unsigned int depth = 0;
+	if (IP.isIPv4()) {
+		best = ipv4_match;
+		if (ipv4_node == 0)
+			return best;
+		node = ipv4_node;
+		depth = 12;
+	}
+	for (; depth < 16; depth++) {
+		const entry_t & e = entries[node * stride + a[depth]];
+		if (e.match != no_match)
+			best = e.match;
+		if (e.child == 0)
+			break;
+		node = e.child;
+	}
+	return best;
+}
+
+/**
+ *	Check whether an address belongs to a local network.
+ *
+ *	\param IP Address
+ *
+ *	\return True if any prefix covers the address
+ */
+inline bool CLocalNets::is_local(const IPv6_addr & IP) const {
+	return lookup(IP) != no_match;
+}
+
+#endif /* GLOCALNETS_H_ */
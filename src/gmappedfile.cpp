@@ -0,0 +1,86 @@
+/**
+ *	\file gmappedfile.cpp
+ *	\brief Read-only memory mapping of whole files.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include "gmappedfile.h"
+
+using namespace std;
+
+/**
+ *	Constructor: open and map file
+ *
+ *	\param filename File to map
+ *	\param pattern Expected access pattern
+ *
+ *	\exception std::string Errormessage
+ */
+CMappedFile::CMappedFile(const std::string & filename, access_pattern_t pattern) :
+	filename(filename), fd(-1), base(NULL), length(0) {
+	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw "Could not open file " + filename + ": " + strerror(errno);
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		string errtext = "Could not stat file " + filename + ": " + strerror(errno);
+		close(fd);
+		throw errtext;
+	}
+	length = st.st_size;
+	if (length == 0)
+		return; // mmap() refuses empty mappings
+
+	void * p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) {
+		string errtext = "Could not map file " + filename + ": " + strerror(errno);
+		close(fd);
+		throw errtext;
+	}
+	base = (uint8_t *) p;
+	madvise(base, length, (pattern == sequential) ? MADV_SEQUENTIAL : MADV_RANDOM);
+}
+
+/**
+ *	Destructor: unmap and close file
+ */
+CMappedFile::~CMappedFile() {
+	if (base != NULL)
+		munmap(base, length);
+	if (fd >= 0)
+		close(fd);
+}
+
+/**
+ *	Get start of mapped file contents.
+ *
+ *	\return Pointer to first byte (NULL for empty files)
+ */
+const uint8_t * CMappedFile::data() const {
+	return base;
+}
+
+/**
+ *	Get size of mapped file.
+ *
+ *	\return Size in bytes
+ */
+size_t CMappedFile::size() const {
+	return length;
+}
+
+/**
+ *	Get name of mapped file.
+ *
+ *	\return Filename
+ */
+const std::string & CMappedFile::get_filename() const {
+	return filename;
+}
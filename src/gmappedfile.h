@@ -0,0 +1,46 @@
+#ifndef GMAPPEDFILE_H_
+#define GMAPPEDFILE_H_
+
+/**
+ *	\file gmappedfile.h
+ *	\brief Read-only memory mapping of whole files.
+ */
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ *	\class	CMappedFile
+ *	\brief	CMappedFile maps a file read-only into memory for zero-copy parsing.
+ *				The mapping is released when the object is destroyed.
+ */
+class CMappedFile {
+	public:
+		/**
+		 *	\enum access_pattern_t
+		 *	\brief Expected access pattern, passed on to the kernel as a paging hint
+		 */
+		enum access_pattern_t {
+			sequential, ///< File is read front to back once
+			random ///< File is accessed at random offsets
+		};
+
+		CMappedFile(const std::string & filename, access_pattern_t pattern = sequential);
+		~CMappedFile();
+
+		const uint8_t * data() const;
+		size_t size() const;
+		const std::string & get_filename() const;
+
+	private:
+		CMappedFile(const CMappedFile &);
+		CMappedFile & operator=(const CMappedFile &);
+
+		std::string filename; ///< Name of the mapped file
+		int fd; ///< File descriptor
+		uint8_t * base; ///< Start of mapping (NULL for empty files)
+		size_t length; ///< Size of mapping in bytes
+};
+
+#endif /* GMAPPEDFILE_H_ */
@@ -0,0 +1,106 @@
+#ifndef GRINGBUFFER_H_
+#define GRINGBUFFER_H_
+
+/**
+ *	\file gringbuffer.h
+ *	\brief Lock-free single producer/single consumer ring buffer.
+ */
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ *	\class	CRingBuffer
+ *	\brief	CRingBuffer passes items from exactly one producer thread to exactly one consumer thread
+ *				without locking.
+ *
+ *	The producer only writes the tail index, the consumer only writes the head index. Both indices
+ *	count up forever and are masked to address a slot; the capacity is rounded up to a power of two.
+ *	Memory barriers make sure a slot is completely written before it is published and completely
+ *	read before it is released.
+ */
+template<typename T>
+class CRingBuffer {
+	public:
+		/**
+		 *	Constructor
+		 *
+		 *	\param min_capacity Minimal number of items the buffer can hold
+		 */
+		explicit CRingBuffer(size_t min_capacity) :
+			head(0), tail(0) {
+			size_t capacity = 1;
+			while (capacity < min_capacity)
+				capacity <<= 1;
+			slots.resize(capacity);
+			mask = capacity - 1;
+		}
+
+		/**
+		 *	Append an item (producer only).
+		 *
+		 *	\param item Item to append
+		 *
+		 *	\return False if the buffer is full (item is not appended)
+		 */
+		bool push(const T & item) {
+			size_t t = tail;
+			if (t - head == slots.size())
+				return false;
+			__sync_synchronize(); // slot has been released by the consumer
+			slots[t & mask] = item;
+			__sync_synchronize(); // publish slot before the new tail
+			tail = t + 1;
+			return true;
+		}
+
+		/**
+		 *	Remove the oldest item (consumer only).
+		 *
+		 *	\param item Receives the removed item
+		 *
+		 *	\return False if the buffer is empty
+		 */
+		bool pop(T & item) {
+			size_t h = head;
+			if (h == tail)
+				return false;
+			__sync_synchronize(); // slot has been published by the producer
+			item = slots[h & mask];
+			__sync_synchronize(); // release slot after it has been read
+			head = h + 1;
+			return true;
+		}
+
+		/**
+		 *	Get the number of items currently buffered (a snapshot when called concurrently).
+		 *
+		 *	\return Number of items
+		 */
+		size_t size() const {
+			return tail - head;
+		}
+
+		/**
+		 *	Get the number of items the buffer can hold.
+		 *
+		 *	\return Capacity
+		 */
+		size_t capacity() const {
+			return slots.size();
+		}
+
+	private:
+		CRingBuffer(const CRingBuffer &);
+		CRingBuffer & operator=(const CRingBuffer &);
+
+		std::vector<T> slots; ///< Item storage
+		size_t mask; ///< Capacity - 1
+		char pad0[64]; ///< Keep the indices on cache lines of their own
+		volatile size_t head; ///< Next slot to read (written by consumer)
+		char pad1[64];
+		volatile size_t tail; ///< Next slot to write (written by producer)
+		char pad2[64];
+};
+
+#endif /* GRINGBUFFER_H_ */
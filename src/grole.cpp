@@ -18,18 +18,19 @@
 
 #include "gutil.h"
 #include "grole.h"
+#include "gflowcolumns.h"
 
 using namespace std;
 
 #ifdef NDEBUG
-static bool debug =false;
-static bool debug2=false; // Show multiclient details
-static bool debug3=false;// Show client/server/p2p role details
+const bool debug =false;
+const bool debug2=false; // Show multiclient details
+const bool debug3=false;// Show client/server/p2p role details
 //static bool debug4=true;	// Report on particular role number
 #else
-static bool debug = true;
-static bool debug2 = true; // Show multiclient details
-static bool debug3 = false; // Show client/server/p2p role details
+const bool debug = true;
+const bool debug2 = true; // Show multiclient details
+const bool debug3 = false; // Show client/server/p2p role details
 //static bool debug4=true;	// Report on particular role number
 #endif
 
@@ -59,7 +60,7 @@ CRole::CRole(Subflowlist flow_list, const prefs_t & prefs) :
  * \param full_flowlist Flowlist containing all available data
  * \param sub_flowlist Flowlist containing all flows used in the current graphlets
  */
-void CRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist) {
+void CRole::rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist) {
 	assert(false);
 	// only used for sub-classes
 }
@@ -69,7 +70,7 @@ void CRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Subflo
  *
  * \param full_flowlist Flowlist containing all available data
  */
-void CRole::rate_roles(const CFlowList& full_flowlist) {
+void CRole::rate_roles(const Subflowlist& full_flowlist) {
 	assert(false);
 	// only used for sub-classes
 }
@@ -94,7 +95,7 @@ float CRole::getRating(const int role_id) {
  * \param full_flowlist Flowlist containing all available data
  * \param sub_flowlist Flowlist containing all flows used in the current graphlets
  */
-void CP2pRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist) {
+void CP2pRole::rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist) {
 	uint32_t flowlist_size = role.flow_set->size();
 	// check if flows can be removed from role without violating the rules for the minimum number of members
 	if (flowlist_size==p2p_threshold) { // cannot remove any flows
@@ -104,36 +105,44 @@ void CP2pRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Sub
 
 	// calculate flow rating
 	uint32_t flow_counter = flowlist_size;
-	// step 1: prepare "filters" used to identify candidates
-	bool local_ip_set = false; // helps to avoid unnecessary copying of the local ip address
-	set<IPv6_addr> remote_ips;
-	IPv6_addr local_ip;
+	// step 1: prepare "filters" used to identify candidates (address ids of the full flowlist columns)
+	const CFlowColumns & columns = full_flowlist.columns();
+	uint32_t local_id = CFlowColumns::no_id;
+	vector<bool> remote_ips(columns.ip_count(), false);
 	uint32_t protocol = role.prot;
 	for (set<int>::const_iterator it = role.flow_set->begin(); it != role.flow_set->end(); it++) {
-		if (!local_ip_set) {
-			local_ip = sub_flowlist[*it].localIP;
-			local_ip_set = true;
-		}
-		remote_ips.insert(sub_flowlist[*it].remoteIP);
-	}
+		if (local_id == CFlowColumns::no_id) {
+			local_id = columns.find_id(sub_flowlist[*it].localIP);
+		}
+		uint32_t remote_id = columns.find_id(sub_flowlist[*it].remoteIP);
+		if (remote_id != CFlowColumns::no_id)
+			remote_ips[remote_id] = true;
+	}
+	const uint32_t * localIPs = columns.localIP_ids();
+	const uint32_t * remoteIPs = columns.remoteIP_ids();
+	const uint16_t * localPorts = columns.localPorts();
+	const uint16_t * remotePorts = columns.remotePorts();
+	const uint8_t * prots = columns.prots();
+	size_t size = columns.size();
 		// step 1.1 calculate client candidates with high role number
 		// generate candidates
 		p2pClientCandidateHashMap client_candidates;
-		for (Subflowlist::const_iterator it = full_flowlist.begin(); it != full_flowlist.end(); it++) {
+		for (size_t i = 0; i < size; i++) {
 			// flow is not a candidate because it..
-			if (it->localIP == local_ip || // ..is part of the graphlet
-					it->prot != protocol || // ..uses another protocol
-					remote_ips.find(it->remoteIP) == remote_ips.end()) { // ..communicates with other remote IPs(== is not in the role's remote ip set)
+			if (localIPs[i] == local_id || // ..is part of the graphlet
+					prots[i] != protocol || // ..uses another protocol
+					!remote_ips[remoteIPs[i]]) { // ..communicates with other remote IPs(== is not in the role's remote ip set)
 				continue;
 			}
-			HashKeyIPv6_5T_2 client_key(it->localIP, it->remoteIP, it->prot, it->localPort, it->flowtype);
+			const cflow_t * flow = &full_flowlist[i];
+			HashKeyIPv6_5T_2 client_key(flow->localIP, flow->remoteIP, flow->prot, flow->localPort, flow->flowtype);
 			p2pClientCandidateHashMap::iterator candidate_set = client_candidates.find(client_key);
 			if (candidate_set == client_candidates.end()) { // entry does not exist => create
 				set<const cflow_t*> candidates;
-				candidates.insert(&(*it));
+				candidates.insert(flow);
 				client_candidates[client_key] = candidates;
 			} else { // entry exists => update
-				candidate_set->second.insert(&(*it));
+				candidate_set->second.insert(flow);
 			}
 		}
 		// accept candidates with remote_port
@@ -150,17 +159,17 @@ void CP2pRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Sub
 		}
 
 	// step 2: find flows outside of the current graphlet, that would share the role
-	for (vector<cflow_t>::const_iterator it = full_flowlist.begin(); it != full_flowlist.end(); it++) {
+	for (size_t i = 0; i < size; i++) {
 		// flow is not counted because it..
-		if (it->localIP == local_ip || // ..already is
-				(it->remotePort < p2p_port_threshold && it->localPort < p2p_port_threshold) || // ..has both port numbers < p2p_port_threshold
-					it->prot != protocol || // ..uses another protocol
-					remote_ips.find(it->remoteIP) == remote_ips.end()) { // ..communicates with other remote IPs(== is not in the role's remote ip set)
+		if (localIPs[i] == local_id || // ..already is
+				(remotePorts[i] < p2p_port_threshold && localPorts[i] < p2p_port_threshold) || // ..has both port numbers < p2p_port_threshold
+					prots[i] != protocol || // ..uses another protocol
+					!remote_ips[remoteIPs[i]]) { // ..communicates with other remote IPs(== is not in the role's remote ip set)
 			continue;
 		}
 		// check if the candidate flows match the p2p criteria
-		bool high_ports = (it->remotePort >= p2p_port_threshold && it->localPort >= p2p_port_threshold);
-		bool client_high_service = accepted_client_candidates.find(&(*it)) != accepted_client_candidates.end();
+		bool high_ports = (remotePorts[i] >= p2p_port_threshold && localPorts[i] >= p2p_port_threshold);
+		bool client_high_service = accepted_client_candidates.find(&full_flowlist[i]) != accepted_client_candidates.end();
 		// hosts using both protocols are automatically included by the normal candidate generation&prining process
 		if (high_ports ||
 				client_high_service) {
@@ -179,7 +188,7 @@ void CP2pRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Sub
  *
  * \param full_flowlist Flowlist containing all available data
  */
-void CP2pRole::rate_roles(const CFlowList& full_flowlist) {
+void CP2pRole::rate_roles(const Subflowlist& full_flowlist) {
 	for (p2pRoleHashMap::iterator it = hm_p2p_role->begin(); it != hm_p2p_role->end(); it++) {
 		if ((it->second)->role_num == 0) { // skip invalid roles
 			continue;
@@ -212,7 +221,7 @@ float CP2pRole::getRating(const int role_id) {
  * \param full_flowlist Flowlist containing all available data
  * \param sub_flowlist Flowlist containing all flows used in the current graphlets
  */
-void CServerRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist) {
+void CServerRole::rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist) {
 	role.rating = role.flows/((float)flow_rate_threshold); // all instances of the server role are already included in this graphlet => no need to check the rest of the flowlist
 	if (role.flow_set->size()==server_threshold) { // cannot remove any flows
 		role.rating = 1;
@@ -225,7 +234,7 @@ void CServerRole::rate_role(role_t& role, const CFlowList& full_flowlist, const
  *
  * \param full_flowlist Flowlist containing all available data
  */
-void CServerRole::rate_roles(const CFlowList& full_flowlist) {
+void CServerRole::rate_roles(const Subflowlist& full_flowlist) {
 	for (srvRoleHashMap::iterator it = hm_server_role->begin(); it != hm_server_role->end(); it++) {
 		if ((it->second)->role_num == 0) { // skip invalid roles
 			continue;
@@ -258,7 +267,7 @@ float CServerRole::getRating(const int role_id) {
  * \param full_flowlist Flowlist containing all available data
  * \param sub_flowlist Flowlist containing all flows used in the current graphlets
  */
-void CClientRole::rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist) {
+void CClientRole::rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist) {
 	char role_type = role.role_type;
 	uint32_t flowlist_size = role.flow_set->size();
 	// check if flows can be removed from role without violating the rules for the minimum number of members
@@ -270,10 +279,10 @@ void CClientRole::rate_role(role_t& role, const CFlowList& full_flowlist, const
 
 	// calculate flow rating
 	uint32_t flow_counter = 0;
-	// step 1: prepare "filters" used to identify candidates
-	bool local_ip_set = false; // helps to avoid unnecessary copying of the local ip address
-	set<IPv6_addr> remote_ips;
-	IPv6_addr local_ip;
+	// step 1: prepare "filters" used to identify candidates (address ids of the full flowlist columns)
+	const CFlowColumns & columns = full_flowlist.columns();
+	uint32_t local_id = CFlowColumns::no_id;
+	vector<bool> remote_ips(columns.ip_count(), false);
 	uint32_t protocol = role.prot;
 	uint16_t remote_port = role.remotePort;
 	set<int> flow_set;
@@ -286,20 +295,26 @@ void CClientRole::rate_role(role_t& role, const CFlowList& full_flowlist, const
 	}
 	flow_counter = flow_set.size();
 	for (set<int>::const_iterator it = flow_set.begin(); it != flow_set.end(); it++) {
-		if (!local_ip_set) {
-			local_ip = sub_flowlist[*it].localIP;
-			local_ip_set = true;
+		if (local_id == CFlowColumns::no_id) {
+			local_id = columns.find_id(sub_flowlist[*it].localIP);
 		}
-		remote_ips.insert(sub_flowlist[*it].remoteIP);
+		uint32_t remote_id = columns.find_id(sub_flowlist[*it].remoteIP);
+		if (remote_id != CFlowColumns::no_id)
+			remote_ips[remote_id] = true;
 	}
 
 	// step 2: find flows outside of the current graphlet, that would share the role
-	for (vector<cflow_t>::const_iterator it = full_flowlist.begin(); it != full_flowlist.end(); it++) {
+	const uint32_t * localIPs = columns.localIP_ids();
+	const uint32_t * remoteIPs = columns.remoteIP_ids();
+	const uint16_t * remotePorts = columns.remotePorts();
+	const uint8_t * prots = columns.prots();
+	size_t size = columns.size();
+	for (size_t i = 0; i < size; i++) {
 		// flow is not counted because it..
-		if (it->localIP == local_ip || // ..already is
-				it->remotePort != remote_port || // ..uses the wrong remote port
-				it->prot != protocol || // ..uses another protocol
-				remote_ips.find(it->remoteIP) == remote_ips.end()) { // ..communicates with other remote IPs(== is not in the role's remote ip set)
+		if (localIPs[i] == local_id || // ..already is
+				remotePorts[i] != remote_port || // ..uses the wrong remote port
+				prots[i] != protocol || // ..uses another protocol
+				!remote_ips[remoteIPs[i]]) { // ..communicates with other remote IPs(== is not in the role's remote ip set)
 			continue;
 		}
 		// role candidate outside current graphlet found => increment counter
@@ -315,7 +330,7 @@ void CClientRole::rate_role(role_t& role, const CFlowList& full_flowlist, const
  *
  * \param full_flowlist Flowlist containing all available data
  */
-void CClientRole::rate_roles(const CFlowList& full_flowlist) {
+void CClientRole::rate_roles(const Subflowlist& full_flowlist) {
 	for (cltRoleHashMap::iterator it = hm_client_role->begin(); it != hm_client_role->end(); it++) {
 		if ((it->second)->role_num == 0) { // skip invalid roles
 			continue;
@@ -1238,17 +1253,19 @@ bool CClientRole::add_candidate(int i) {
 	// Here we implement client role summarization step 1
 	// --------------------------------------------------
 
-	IPv6_addr remoteIP = flowlist[i].remoteIP;
-	uint16_t remotePort = flowlist[i].remotePort;
-	uint8_t prot = flowlist[i].prot;
-	uint64_t bytes = flowlist[i].dOctets;
-	uint32_t packets = flowlist[i].dPkts;
-	uint8_t flowtype = flowlist[i].flowtype;
+	const CFlowColumns & columns = flowlist.columns();
+	uint32_t remoteIP_id = columns.remoteIP_ids()[i];
+	const IPv6_addr & remoteIP = columns.get_IP(remoteIP_id);
+	uint16_t remotePort = columns.remotePorts()[i];
+	uint8_t prot = columns.prots()[i];
+	uint64_t bytes = columns.dOctets()[i];
+	uint32_t packets = columns.dPkts()[i];
+	uint8_t flowtype = columns.flowtypes()[i];
 
 	//
 	// Store candidate role
 	// --------------------
-	cltRoleHashKey mykey(remoteIP, prot, remotePort, flowtype);
+	cltRoleHashKey mykey(remoteIP_id, prot, remotePort, flowtype);
 	cltRoleHashMap::iterator citer = hm_client_role->find(mykey);
 	int cur_role_num = 0;
 	int cur_flows = 1;
@@ -1342,7 +1359,7 @@ void CClientRole::check_multiclient(const vector<uint32_t> & flow_server_role, c
 			cout << "mc-role: added client role: " << crole->role_num << " with " << crole->flows << " flows\n";
 		}
 		uint8_t prot = (uint8_t) crole->prot;
-		cltRoleHashKey mykey(IPv6_addr(), prot, (crole->remotePort), (crole->flowtype));
+		cltRoleHashKey mykey(CFlowColumns::no_id, prot, (crole->remotePort), (crole->flowtype));
 		cltRoleHashMap::iterator citer = hm_multiclient_role->find(mykey);
 		int cur_role_num = 0;
 		if (citer == hm_multiclient_role->end()) {
@@ -1378,7 +1395,7 @@ void CClientRole::check_multiclient(const vector<uint32_t> & flow_server_role, c
 			if (debug2) {
 				cout << "mc-role: added single flow: " << j << endl;
 			}
-			cltRoleHashKey mykey(IPv6_addr(), (flowlist[j].prot), (flowlist[j].remotePort), (flowlist[j].flowtype));
+			cltRoleHashKey mykey(CFlowColumns::no_id, (flowlist[j].prot), (flowlist[j].remotePort), (flowlist[j].flowtype));
 			cltRoleHashMap::iterator citer = hm_multiclient_role->find(mykey);
 			int cur_role_num = 0;
 			int cur_packets = 0;
@@ -1499,8 +1516,6 @@ void CClientRole::cleanConsumedClientRoles() {
  *	\return role
  */
 CRole::role_t * CClientRole::get_next_role() {
-	static cltRoleHashMap::iterator role_it;
-
 	if (first) {
 		role_it = hm_client_role->begin();
 		first = false;
@@ -1531,8 +1546,6 @@ CRole::role_t * CClientRole::get_next_role() {
  *	\return role
  */
 CRole::role_t * CClientRole::get_next_mrole() {
-	static cltRoleHashMap::iterator mrole_it;
-
 	if (first2) {
 		mrole_it = hm_multiclient_role->begin();
 		first2 = false;
@@ -1624,13 +1637,13 @@ void CServerRole::register_rM(CRoleMembership & roleMembership) {
 bool CServerRole::add_candidate(int i) {
 	// Here we implement server role summarization step 1
 	// --------------------------------------------------
-	//uint32_t localIP	= flowlist[i].localIP;
-	uint16_t localPort = flowlist[i].localPort;
-	IPv6_addr remoteIP = flowlist[i].remoteIP;
-	uint8_t prot = flowlist[i].prot;
-	uint64_t bytes = flowlist[i].dOctets;
-	uint32_t packets = flowlist[i].dPkts;
-	uint8_t flowtype = flowlist[i].flowtype;
+	const CFlowColumns & columns = flowlist.columns();
+	uint16_t localPort = columns.localPorts()[i];
+	const IPv6_addr & remoteIP = columns.get_IP(columns.remoteIP_ids()[i]);
+	uint8_t prot = columns.prots()[i];
+	uint64_t bytes = columns.dOctets()[i];
+	uint32_t packets = columns.dPkts()[i];
+	uint8_t flowtype = columns.flowtypes()[i];
 
 	uint32_t ftype = (uint32_t) flowtype;
 	srvRoleHashKey mykey(IPv6_addr(ftype), prot, localPort);
@@ -1724,8 +1737,6 @@ void CServerRole::prune_candidates() {
  *	\return role
  */
 CRole::role_t * CServerRole::get_next_role() {
-	static srvRoleHashMap::iterator role_it;
-
 	if (first) {
 		role_it = hm_server_role->begin();
 		first = false;
@@ -1832,14 +1843,15 @@ void CP2pRole::register_rM(CRoleMembership & roleMembership) {
 
 bool CP2pRole::add_candidate(int i) {
 	// Check if protocol is tcp or udp and skip flow if not
-	uint8_t prot = flowlist[i].prot;
+	const CFlowColumns & columns = flowlist.columns();
+	uint8_t prot = columns.prots()[i];
 	if (prot != IPPROTO_TCP && prot != IPPROTO_UDP
 		) return false;
 	// Add as a candidate flow
 	p2p_candidate_flows.insert(i);
 
 	// Remember per remote IP protocol usage
-	IPv6_addr remoteIP = flowlist[i].remoteIP;
+	const IPv6_addr & remoteIP = columns.get_IP(columns.remoteIP_ids()[i]);
 	CRole::remoteIpHashKey rmkey(remoteIP);
 	CRole::remoteIpHashMap::iterator it = hm_remote_IP_p2p->find(rmkey);
 	if (it == hm_remote_IP_p2p->end()) {
@@ -2102,8 +2114,6 @@ void CP2pRole::cleanConsumedClientRoles(CClientRole& clientRole) {
  *	\return role
  */
 CRole::role_t * CP2pRole::get_next_role() {
-	static p2pRoleHashMap::iterator role_it;
-
 	if (first) {
 		role_it = hm_p2p_role->begin();
 		first = false;
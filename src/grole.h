@@ -210,7 +210,7 @@ class CRole {
 		virtual CRole::role_t * get_next_role() {
 			return NULL;
 		}
-		const vector<uint32_t> & get_flow_role() {
+		const std::vector<uint32_t> & get_flow_role() {
 			return flow_role;
 		}
 		void set_flow_role_value(const uint32_t index, const uint32_t value) {
@@ -220,7 +220,7 @@ class CRole {
 			return role_count;
 		}
 		virtual void create_sub_roles();
-		virtual void rate_roles(const CFlowList& full_flowlist);
+		virtual void rate_roles(const Subflowlist& full_flowlist);
 		virtual float getRating(const int role_id);
 		virtual role_t* getRole(const int role_id);
 
@@ -228,7 +228,7 @@ class CRole {
 		virtual void create_pseudo_roles(role_t & role, CRoleMembership & membership);
 
 	private:
-		virtual void rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist);
+		virtual void rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist);
 };
 
 //********************************************************************************
@@ -315,17 +315,19 @@ class CRoleMembership {
  */
 class CClientRole: public CRole {
 	public:
-		typedef HashKeyIPv6_4T cltRoleHashKey; // key = 4-tuple {IP, prot, port, flowtype}
+		typedef HashKeyId_4T cltRoleHashKey; // key = 4-tuple {IP id, prot, port, flowtype}
 
-		// key = { remoteIP, prot, remotePort, flowtype }
+		// key = { remoteIP id (of flowlist.columns()), prot, remotePort, flowtype }
 		// data = role object reference
-		typedef hash_map<HashKeyIPv6_4T, role_t *, HashFunction<HashKeyIPv6_4T> , HashFunction<HashKeyIPv6_4T> > cltRoleHashMap;
+		typedef hash_map<HashKeyId_4T, role_t *, HashFunction<HashKeyId_4T> , HashFunction<HashKeyId_4T> > cltRoleHashMap;
 
 	private:
 		cltRoleHashMap * hm_client_role;
 		CRoleMembership * proleMembership;
 		cltRoleHashMap * hm_multiclient_role;
-		virtual void rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist);
+		cltRoleHashMap::iterator role_it; // Position of get_next_role()
+		cltRoleHashMap::iterator mrole_it; // Position of get_next_mrole()
+		virtual void rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist);
 		static const uint32_t client_threshold = flow_threshold_client;
 		static const uint32_t multi_client_threshold = flow_threshold_multi_client;
 	public:
@@ -336,7 +338,7 @@ class CClientRole: public CRole {
 
 		bool add_candidate(int flow_num);
 		void prune_candidates();
-		void check_multiclient(const vector<uint32_t> & flow_server_role, const CFlowFilter & filter, bool summ_srv_roles);
+		void check_multiclient(const std::vector<uint32_t> & flow_server_role, const CFlowFilter & filter, bool summ_srv_roles);
 		CRole::role_t * get_next_mrole();
 		CRole::role_t * get_next_role();
 		cltRoleHashMap * get_hm_client_role() {
@@ -346,7 +348,7 @@ class CClientRole: public CRole {
 			return hm_multiclient_role;
 		}
 		virtual void create_sub_roles();
-		virtual void rate_roles(const CFlowList& full_flowlist);
+		virtual void rate_roles(const Subflowlist& full_flowlist);
 		virtual float getRating(const int role_id);
 		virtual role_t* getRole(const int role_id);
 		void cleanConsumedClientRoles();
@@ -368,8 +370,9 @@ class CServerRole: public CRole {
 
 	private:
 		srvRoleHashMap * hm_server_role;
+		srvRoleHashMap::iterator role_it; // Position of get_next_role()
 		CRoleMembership * proleMembership;
-		virtual void rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist);
+		virtual void rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist);
 		static const uint32_t server_threshold = flow_threshold_server;
 	public:
 		CServerRole(Subflowlist flowlist, const prefs_t & prefs);
@@ -384,7 +387,7 @@ class CServerRole: public CRole {
 			return hm_server_role;
 		}
 		virtual void create_sub_roles();
-		virtual void rate_roles(const CFlowList& full_flowlist);
+		virtual void rate_roles(const Subflowlist& full_flowlist);
 		virtual float getRating(const int role_id);
 		virtual role_t* getRole(const int role_id);
 };
@@ -406,11 +409,12 @@ class CP2pRole: public CRole {
 
 	private:
 		CP2pRole::p2pRoleHashMap * hm_p2p_role;
+		CP2pRole::p2pRoleHashMap::iterator role_it; // Position of get_next_role()
 		CRole::remoteIpHashMap * hm_remote_IP_p2p;
 		int cand_flow_num;
 		CRoleMembership * proleMembership;
 		std::set<int> p2p_candidate_flows;
-		virtual void rate_role(role_t& role, const CFlowList& full_flowlist, const Subflowlist& sub_flowlist);
+		virtual void rate_role(role_t& role, const Subflowlist& full_flowlist, const Subflowlist& sub_flowlist);
 		static const uint32_t p2p_threshold = flow_threshold_p2p;
 		static const uint16_t p2p_port_threshold = 1024;
 		static const uint32_t client_threshold = flow_threshold_client;
@@ -426,7 +430,7 @@ class CP2pRole: public CRole {
 			return cand_flow_num;
 		}
 		virtual void create_sub_roles();
-		virtual void rate_roles(const CFlowList& full_flowlist);
+		virtual void rate_roles(const Subflowlist& full_flowlist);
 		virtual float getRating(const int role_id);
 		virtual role_t* getRole(const int role_id);
 		void cleanConsumedClientRoles(CClientRole & clientRole);
@@ -0,0 +1,687 @@
+/**
+ *	\file gserver.cpp
+ *	\brief Graphlet server answering host list, flow list and graphlet requests over a Unix domain socket.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "gserver.h"
+#include "gimportcache.h"
+#include "ginterface.h"
+#include "gflowexpression.h"
+#include "ghpgdata.h"
+
+using namespace std;
+
+const uint64_t CGraphletServer::default_dataset_memory_limit;
+
+static const int poll_timeout_ms = 100; ///< Granularity for noticing stop()
+static const size_t max_request_length = 65536; ///< Longest request line accepted
+
+/**
+ *	Fill a Unix domain socket address.
+ *
+ *	\param path Socket file
+ *	\param addr Address (out)
+ *
+ *	\exception std::string Errortext (path too long)
+ */
+static void make_address(const string & path, struct sockaddr_un & addr) {
+	memset(&addr, 0, sizeof(addr));
+	if (path.empty() || path.size() >= sizeof(addr.sun_path))
+		throw "Invalid socket path: " + path;
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+}
+
+/**
+ *	Write all of a buffer to a socket.
+ *
+ *	\param fd Socket
+ *	\param data Buffer
+ *
+ *	\return True if all bytes were written
+ */
+static bool write_all(int fd, const string & data) {
+	size_t pos = 0;
+	while (pos < data.size()) {
+		ssize_t n = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		pos += n;
+	}
+	return true;
+}
+
+/**
+ *	Constructor: create the socket file and listen on it. A socket file left by a server that is no longer
+ *	running is replaced.
+ *
+ *	\param socket_path Socket file
+ *	\param local_nets Local networks used to infer flow directions when loading data sets
+ *	\param threads Worker threads (0: one per processor core)
+ *
+ *	\exception std::string Errortext
+ */
+CGraphletServer::CGraphletServer(const string & socket_path, const CLocalNets & local_nets, unsigned int threads) :
+	sock(-1), socket_path(socket_path), local_nets(local_nets), threads(threads), write_index(false), idle_timeout_ms(default_idle_timeout_ms), acceptor(NULL),
+	running(false), dataset_memory_limit(default_dataset_memory_limit), dataset_memory_size(0), dataset_clock(0) {
+	if (this->threads == 0)
+		this->threads = max(1u, boost::thread::hardware_concurrency());
+
+	struct sockaddr_un addr;
+	make_address(socket_path, addr);
+	int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe >= 0) {
+		bool in_use = connect(probe, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+		close(probe);
+		if (in_use)
+			throw "Another server is listening on " + socket_path;
+	}
+	struct stat st;
+	if (lstat(socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(socket_path.c_str());
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0)
+		throw string("Could not create socket: ") + strerror(errno);
+	if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(sock, SOMAXCONN) != 0) {
+		string errtext = "Could not listen on " + socket_path + ": " + strerror(errno);
+		close(sock);
+		throw errtext;
+	}
+}
+
+/**
+ *	Destructor: stop threads, close and remove the socket
+ */
+CGraphletServer::~CGraphletServer() {
+	stop();
+	close(sock);
+	unlink(socket_path.c_str());
+}
+
+/**
+ *	Set the memory the finished graphlets kept for repeated requests may take.
+ *
+ *	\param byte_budget Bytes (default: CGraphletCache::default_byte_budget; 0: cache no graphlets)
+ */
+void CGraphletServer::set_graphlet_cache_budget(uint64_t byte_budget) {
+	boost::mutex::scoped_lock lock(cache_mutex);
+	graphlet_cache.set_byte_budget(byte_budget);
+}
+
+/**
+ *	Set the memory the loaded data sets may take. The least recently used data sets are dropped on the next load
+ *	when they take more; the data set loaded last is kept even if it exceeds the limit on its own.
+ *
+ *	\param memory_limit Bytes (default: default_dataset_memory_limit; 0: keep the last data set only)
+ */
+void CGraphletServer::set_dataset_memory_limit(uint64_t memory_limit) {
+	boost::mutex::scoped_lock lock(datasets_mutex);
+	dataset_memory_limit = memory_limit;
+}
+
+/**
+ *	Let loading a data set write the sidecar index (*.hidx) beside its file, for faster loading by later server
+ *	runs (see CImport::set_write_index()). An existing index is loaded either way. Call before start().
+ *
+ *	\param write_index True to write the index (default: false)
+ */
+void CGraphletServer::set_write_index(bool write_index) {
+	this->write_index = write_index;
+}
+
+/**
+ *	Set how long a connection may wait for its next request. Each connection keeps a worker thread while open,
+ *	so idle clients would otherwise block the server. Call before start().
+ *
+ *	\param timeout_ms Milliseconds (default: default_idle_timeout_ms; 0: never close idle connections)
+ */
+void CGraphletServer::set_idle_timeout(unsigned int timeout_ms) {
+	idle_timeout_ms = timeout_ms;
+}
+
+/**
+ *	Start acceptor and worker threads.
+ */
+void CGraphletServer::start() {
+	if (running)
+		return;
+	running = true;
+	for (unsigned int i = 0; i < threads; i++)
+		workers.create_thread(boost::bind(&CGraphletServer::worker_loop, this));
+	acceptor = new boost::thread(boost::bind(&CGraphletServer::accept_loop, this));
+}
+
+/**
+ *	Stop acceptor and worker threads. Requests being processed are finished first, queued connections are closed.
+ */
+void CGraphletServer::stop() {
+	if (!running)
+		return;
+	{
+		boost::mutex::scoped_lock lock(queue_mutex);
+		running = false;
+		queue_ready.notify_all();
+	}
+	acceptor->join();
+	delete acceptor;
+	acceptor = NULL;
+	workers.join_all();
+	while (!connections.empty()) {
+		close(connections.front());
+		connections.pop_front();
+	}
+}
+
+/**
+ *	\return Socket file
+ */
+const string & CGraphletServer::get_socket_path() const {
+	return socket_path;
+}
+
+/**
+ *	Get current counters.
+ *
+ *	\return Counters
+ */
+CGraphletServer::stats_t CGraphletServer::get_stats() const {
+	boost::mutex::scoped_lock lock(stats_mutex);
+	return stats;
+}
+
+/**
+ *	Client side: send a request to a server and wait for the response.
+ *
+ *	\param socket_path Socket file of the server
+ *	\param request_line Request (see CGraphletServer)
+ *	\param time_us Server processing time in microseconds (out, may be NULL)
+ *
+ *	\return Response body
+ *
+ *	\exception std::string Errortext (connection failed or error response)
+ */
+string CGraphletServer::request(const string & socket_path, const string & request_line, uint64_t * time_us) {
+	struct sockaddr_un addr;
+	make_address(socket_path, addr);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		throw string("Could not create socket: ") + strerror(errno);
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+		string errtext = "Could not connect to " + socket_path + ": " + strerror(errno);
+		close(fd);
+		throw errtext;
+	}
+	if (!write_all(fd, request_line + "\n")) {
+		close(fd);
+		throw "Could not send request to " + socket_path;
+	}
+	shutdown(fd, SHUT_WR);
+
+	string response;
+	char buffer[65536];
+	ssize_t n;
+	while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			break;
+		response.append(buffer, n);
+	}
+	close(fd);
+
+	size_t eol = response.find('\n');
+	if (eol == string::npos)
+		throw "Incomplete response from " + socket_path;
+	istringstream status(response.substr(0, eol));
+	string word;
+	uint64_t length = 0, us = 0;
+	status >> word;
+	if (word == "OK")
+		status >> length >> us;
+	else if (word == "ERROR")
+		status >> us;
+	if (time_us != NULL)
+		*time_us = us;
+	if (word == "ERROR") {
+		string message;
+		getline(status >> ws, message);
+		throw message;
+	}
+	if (word != "OK" || response.size() - eol - 1 != length)
+		throw "Invalid response from " + socket_path;
+	return response.substr(eol + 1);
+}
+
+/**
+ *	\return False once stop() has been called
+ */
+bool CGraphletServer::is_running() {
+	boost::mutex::scoped_lock lock(queue_mutex);
+	return running;
+}
+
+/**
+ *	Acceptor thread: pass accepted connections on to the workers.
+ */
+void CGraphletServer::accept_loop() {
+	while (is_running()) {
+		struct pollfd pfd;
+		pfd.fd = sock;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, poll_timeout_ms) <= 0)
+			continue;
+		int fd = accept(sock, NULL, NULL);
+		if (fd < 0)
+			continue;
+		{
+			boost::mutex::scoped_lock lock(stats_mutex);
+			stats.connections++;
+		}
+		boost::mutex::scoped_lock lock(queue_mutex);
+		connections.push_back(fd);
+		queue_ready.notify_one();
+	}
+}
+
+/**
+ *	Worker thread: serve queued connections one after another.
+ */
+void CGraphletServer::worker_loop() {
+	while (true) {
+		int fd;
+		{
+			boost::mutex::scoped_lock lock(queue_mutex);
+			while (running && connections.empty())
+				queue_ready.wait(lock);
+			if (!running)
+				return;
+			fd = connections.front();
+			connections.pop_front();
+		}
+		serve(fd);
+	}
+}
+
+/**
+ *	Answer the requests of a connection until the client closes it, it is idle for longer than the idle timeout
+ *	or the server stops.
+ *
+ *	\param fd Connection
+ */
+void CGraphletServer::serve(int fd) {
+	string buffer;
+	unsigned int idle_ms = 0; // Since the last data received
+	while (is_running()) {
+		size_t eol = buffer.find('\n');
+		if (eol == string::npos) {
+			if (buffer.size() > max_request_length)
+				break;
+			struct pollfd pfd;
+			pfd.fd = fd;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			int rc = poll(&pfd, 1, poll_timeout_ms);
+			if (rc < 0 && errno != EINTR)
+				break;
+			if (rc == 0) {
+				idle_ms += poll_timeout_ms;
+				if (idle_timeout_ms != 0 && idle_ms >= idle_timeout_ms)
+					break;
+			}
+			if (rc <= 0)
+				continue;
+			char chunk[4096];
+			ssize_t n = read(fd, chunk, sizeof(chunk));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				break;
+			idle_ms = 0;
+			buffer.append(chunk, n);
+			continue;
+		}
+		string line = buffer.substr(0, eol);
+		buffer.erase(0, eol + 1);
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		string body, errtext;
+		bool ok = false;
+		try {
+			body = handle(line);
+			ok = true;
+		} catch (string & e) {
+			errtext = e;
+		} catch (const char * e) {
+			errtext = e;
+		} catch (std::exception & e) {
+			errtext = e.what();
+		}
+		uint64_t us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+
+		stringstream response;
+		if (ok) {
+			response << "OK " << body.size() << " " << us << "\n" << body;
+		} else {
+			replace(errtext.begin(), errtext.end(), '\n', ' ');
+			response << "ERROR " << us << " " << errtext << "\n";
+		}
+		{
+			boost::mutex::scoped_lock lock(stats_mutex);
+			stats.requests++;
+			if (!ok)
+				stats.errors++;
+		}
+		if (!write_all(fd, response.str()))
+			break;
+	}
+	close(fd);
+}
+
+/**
+ *	Answer a request.
+ *
+ *	\param line Request
+ *
+ *	\return Response body
+ *
+ *	\exception std::string Errortext
+ */
+string CGraphletServer::handle(const string & line) {
+	string head = line, expression;
+	size_t expr_pos = line.find(" expr=");
+	if (expr_pos != string::npos) {
+		head = line.substr(0, expr_pos);
+		expression = line.substr(expr_pos + 6);
+	}
+	vector<string> args;
+	istringstream words(head);
+	string word;
+	while (words >> word)
+		args.push_back(word);
+
+	if (args.empty())
+		throw string("Empty request");
+	if (args[0] == "graphlet")
+		return handle_graphlet(args, expression);
+	if (expr_pos != string::npos)
+		throw "Request " + args[0] + " takes no filter expression";
+	if (args[0] == "hosts")
+		return handle_hosts(args);
+	if (args[0] == "flows")
+		return handle_flows(args);
+	if (args[0] == "stats")
+		return handle_stats();
+	throw "Unknown request: " + args[0];
+}
+
+/**
+ *	Answer a host list request: "hosts FILE".
+ *
+ *	\param args Request words
+ *
+ *	\return Host list
+ *
+ *	\exception std::string Errortext
+ */
+string CGraphletServer::handle_hosts(const vector<string> & args) {
+	if (args.size() != 2)
+		throw string("Usage: hosts FILE");
+	boost::shared_ptr<dataset_t> dataset = get_dataset(args[1]);
+
+	stringstream out;
+	const vector<ChostMetadata> & hosts = dataset->import->get_host_metadata();
+	for (vector<ChostMetadata>::const_iterator it = hosts.begin(); it != hosts.end(); ++it)
+		out << it->IP << "\t" << it->flow_count << "\t" << it->uniflow_count << "\t" << it->prot_count << "\t" << it->packet_count << "\t"
+		      << it->bytesForAllFlows << "\n";
+	return out.str();
+}
+
+/**
+ *	Answer a flow list request: "flows FILE IP".
+ *
+ *	\param args Request words
+ *
+ *	\return Flow list
+ *
+ *	\exception std::string Errortext
+ */
+string CGraphletServer::handle_flows(const vector<string> & args) {
+	if (args.size() != 3)
+		throw string("Usage: flows FILE IP");
+	IPv6_addr IP(args[2]);
+	boost::shared_ptr<dataset_t> dataset = get_dataset(args[1]);
+
+	const ChostMetadata * host = dataset->import->find_host_metadata(IP);
+	if (host == NULL)
+		throw "No flows of host " + args[2] + " in " + args[1];
+	stringstream out;
+	Subflowlist flows = dataset->import->get_flow(host->index, host->flow_count);
+	for (Subflowlist::const_iterator it = flows.begin(); it != flows.end(); ++it)
+		out << it->localPort << "\t" << it->remoteIP << "\t" << it->remotePort << "\t" << (int) it->prot << "\t" << (int) it->flowtype << "\t"
+		      << it->startMs << "\t" << it->durationMs << "\t" << it->dPkts << "\t" << it->dOctets << "\n";
+	return out.str();
+}
+
+/**
+ *	Answer a graphlet request: "graphlet FILE IP [summarize=N] [filter=N] [roles=R1,R2,...] [expr=EXPRESSION]".
+ *
+ *	\param args Request words (without the expression)
+ *	\param expression Filter expression (empty: none)
+ *
+ *	\return Graphlet in dot format
+ *
+ *	\exception std::string Errortext
+ */
+string CGraphletServer::handle_graphlet(const vector<string> & args, const string & expression) {
+	if (args.size() < 3)
+		throw string("Usage: graphlet FILE IP [summarize=N] [filter=N] [roles=R1,R2,...] [expr=EXPRESSION]");
+	IPv6_addr IP(args[2]);
+	unsigned int summarize_flags = CInterface::summarize_all, filter_flags = 0;
+	desummarizedRoles roles;
+	for (size_t i = 3; i < args.size(); i++) {
+		size_t eq = args[i].find('=');
+		string name = args[i].substr(0, eq), value = eq == string::npos ? "" : args[i].substr(eq + 1);
+		if (name == "summarize" && !value.empty()) {
+			summarize_flags = strtoul(value.c_str(), NULL, 0);
+		} else if (name == "filter" && !value.empty()) {
+			filter_flags = strtoul(value.c_str(), NULL, 0);
+		} else if (name == "roles") {
+			istringstream numbers(value);
+			string number;
+			while (getline(numbers, number, ','))
+				if (!number.empty())
+					roles.insert(strtoul(number.c_str(), NULL, 0));
+		} else {
+			throw "Invalid graphlet option: " + args[i];
+		}
+	}
+	CFlowExpression check(expression); // Reject syntax errors before building
+
+	boost::shared_ptr<dataset_t> dataset = get_dataset(args[1]);
+	const ChostMetadata * host = dataset->import->find_host_metadata(IP);
+	if (host == NULL)
+		throw "No flows of host " + args[2] + " in " + args[1];
+
+	stringstream key;
+	key << dataset->identity << "\n" << IP << "\n" << summarize_flags << " " << filter_flags << "\n" << expression << "\n";
+	for (desummarizedRoles::const_iterator it = roles.begin(); it != roles.end(); ++it)
+		key << *it << ",";
+	string dot, hpg;
+	{
+		boost::mutex::scoped_lock lock(cache_mutex);
+		while (building.count(key.str()) > 0) // Wait for the same graphlet built by another request
+			graphlet_built.wait(lock);
+		if (graphlet_cache.find(key.str(), dot, hpg)) {
+			boost::mutex::scoped_lock stats_lock(stats_mutex);
+			stats.graphlets_cached++;
+			return dot;
+		}
+		building.insert(key.str());
+	}
+
+	prefs_t graphlet_prefs = CInterface::make_prefs((CInterface::summarize_flags_t) summarize_flags, (CInterface::filter_flags_t) filter_flags,
+	      expression);
+
+	try {
+		const CImport & import = *dataset->import;
+		CHpgBufferSink edges;
+		boost::scoped_ptr<CSummaryNodeInfos> nodeInfos(import.build_graphlet(import.get_host_flowlist(*host), graphlet_prefs, roles, edges));
+		vector<hpg_field> & data = edges.get_data();
+		if (data.empty())
+			throw "No graphlet edges of host " + args[2];
+		ChpgData hpgData(&data[0], data.size() * sizeof(hpg_field));
+		hpgData.nodeInfos = nodeInfos.get();
+		stringstream out;
+		hpgData.hpg2dot(0, out);
+		dot = out.str();
+		hpg = edges.get_contents();
+	} catch (...) {
+		boost::mutex::scoped_lock lock(cache_mutex);
+		building.erase(key.str());
+		graphlet_built.notify_all();
+		throw;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(cache_mutex);
+		graphlet_cache.insert(key.str(), dot, hpg);
+		building.erase(key.str());
+		graphlet_built.notify_all();
+	}
+
+	boost::mutex::scoped_lock stats_lock(stats_mutex);
+	stats.graphlets_built++;
+	return dot;
+}
+
+/**
+ *	Answer a counter request: "stats".
+ *
+ *	\return Counters, one "name value" line each
+ */
+string CGraphletServer::handle_stats() {
+	stringstream out;
+	{
+		boost::mutex::scoped_lock lock(stats_mutex);
+		out << "connections\t" << stats.connections << "\n";
+		out << "requests\t" << stats.requests << "\n";
+		out << "errors\t" << stats.errors << "\n";
+		out << "datasets_loaded\t" << stats.datasets_loaded << "\n";
+		out << "datasets_evicted\t" << stats.datasets_evicted << "\n";
+		out << "graphlets_built\t" << stats.graphlets_built << "\n";
+		out << "graphlets_cached\t" << stats.graphlets_cached << "\n";
+	}
+	{
+		boost::mutex::scoped_lock lock(datasets_mutex);
+		out << "datasets\t" << datasets.size() << "\n";
+		out << "dataset_bytes\t" << dataset_memory_size << "\n";
+	}
+	boost::mutex::scoped_lock lock(cache_mutex);
+	out << "cache_entries\t" << graphlet_cache.size() << "\n";
+	out << "cache_bytes\t" << graphlet_cache.get_bytes() << "\n";
+	return out.str();
+}
+
+/**
+ *	Get the data set of a file, loading it if it is not loaded yet or the file has changed since. A replaced data
+ *	set is deleted when the last request using it finishes.
+ *
+ *	\param filename Input file
+ *
+ *	\return Data set (host metadata prepared for all hosts)
+ *
+ *	\exception std::string Errortext
+ */
+boost::shared_ptr<CGraphletServer::dataset_t> CGraphletServer::get_dataset(const string & filename) {
+	string identity = CImportCache::get_identity(filename, local_nets, CFlowPredicate());
+	{
+		boost::mutex::scoped_lock lock(datasets_mutex);
+		while (loading.count(filename) > 0) // Wait for the same file loaded by another request
+			dataset_loaded.wait(lock);
+		map<string, boost::shared_ptr<dataset_t> >::const_iterator it = datasets.find(filename);
+		if (it != datasets.end() && it->second->identity == identity) {
+			it->second->last_used = ++dataset_clock;
+			return it->second;
+		}
+		loading.insert(filename);
+	}
+
+	// Load without the lock: requests for other data sets go on
+	boost::shared_ptr<dataset_t> dataset(new dataset_t);
+	dataset->identity = identity;
+	try {
+		CImport * import = new CImport(filename, filename + ".hpg", prefs);
+		dataset->import.reset(import);
+		import->set_no_reverse_index(); // Reverse index only needed for HAPviewer operation
+		import->set_write_index(write_index);
+		import->read_file(local_nets);
+		import->set_localIP(IPv6_addr(), -1);
+		import->get_hostMetadata();
+		import->prepare_columns(); // Shared by the graphlets
+		dataset->memory_size = import->get_memory_size();
+	} catch (...) {
+		boost::mutex::scoped_lock lock(datasets_mutex);
+		loading.erase(filename);
+		dataset_loaded.notify_all();
+		throw;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(datasets_mutex);
+		map<string, boost::shared_ptr<dataset_t> >::iterator it = datasets.find(filename);
+		if (it != datasets.end()) // Outdated
+			dataset_memory_size -= it->second->memory_size;
+		dataset->last_used = ++dataset_clock;
+		datasets[filename] = dataset;
+		dataset_memory_size += dataset->memory_size;
+		evict_datasets(filename);
+		loading.erase(filename);
+		dataset_loaded.notify_all();
+	}
+
+	boost::mutex::scoped_lock stats_lock(stats_mutex);
+	stats.datasets_loaded++;
+	return dataset;
+}
+
+/**
+ *	Drop least recently used data sets until the data set memory limit is met. Requests still using a dropped
+ *	data set keep it until they finish. Call with datasets_mutex held.
+ *
+ *	\param keep File name of the data set not to drop
+ */
+void CGraphletServer::evict_datasets(const string & keep) {
+	while (dataset_memory_size > dataset_memory_limit) {
+		map<string, boost::shared_ptr<dataset_t> >::iterator victim = datasets.end();
+		for (map<string, boost::shared_ptr<dataset_t> >::iterator it = datasets.begin(); it != datasets.end(); ++it)
+			if (it->first != keep && (victim == datasets.end() || it->second->last_used < victim->second->last_used))
+				victim = it;
+		if (victim == datasets.end())
+			return;
+		cout << "Dropping data set of " << victim->first << " (" << victim->second->memory_size / 1024 << " kB).\n";
+		dataset_memory_size -= victim->second->memory_size;
+		datasets.erase(victim);
+		boost::mutex::scoped_lock stats_lock(stats_mutex);
+		stats.datasets_evicted++;
+	}
+}
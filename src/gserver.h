@@ -0,0 +1,148 @@
+#ifndef GSERVER_H_
+#define GSERVER_H_
+
+/**
+ *	\file gserver.h
+ *	\brief Graphlet server answering host list, flow list and graphlet requests over a Unix domain socket.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "global.h"
+#include "gimport.h"
+#include "glocalnets.h"
+#include "ggraphletcache.h"
+
+/**
+ *	\class	CGraphletServer
+ *	\brief	CGraphletServer keeps data sets in memory and answers requests of local clients, so a client does
+ *				not have to load a file for each graphlet.
+ *
+ *	Requests are text lines, answered by a status line and a body. A connection may carry any number of requests:
+ *
+ *	- hosts FILE: host list, one line per host: IP, flows, uniflows, protocols, packets, bytes
+ *	- flows FILE IP: flows of a host, one line per flow: local port, remote IP, remote port, protocol, flow type,
+ *	  start (ms), duration (ms), packets, bytes
+ *	- graphlet FILE IP [summarize=N] [filter=N] [roles=R1,R2,...] [expr=EXPRESSION]: graphlet in dot format. N are
+ *	  CInterface::summarize_flags_t and CInterface::filter_flags_t values (default: summarize all, filter none), the
+ *	  expression (see CFlowExpression) extends to the end of the line.
+ *	- stats: server counters
+ *
+ *	Fields are separated by tabs. The status line is "OK <body length> <microseconds>" or
+ *	"ERROR <microseconds> <message>"; the time covers the processing of the request by the server.
+ *
+ *	An acceptor thread passes connections to a pool of worker threads; a connection idle for longer than the idle
+ *	timeout is closed to free its worker. A data set is loaded on its first request and loaded again when its file
+ *	changes (file names must not contain blanks). Requests for a file being loaded wait for it, requests for other
+ *	files go on. When the data sets take more memory than the data set limit, the least recently used ones are
+ *	dropped; a dropped data set is deleted when the last request using it finishes. Requests only read the data sets,
+ *	so all of them run concurrently, graphlets included (see CImport::build_graphlet()). Finished graphlets are kept
+ *	in a CGraphletCache; concurrent requests for the same graphlet wait for the first one to build it.
+ */
+class CGraphletServer {
+	public:
+		/**
+		 *	\struct	stats_t
+		 *	\brief	Server counters
+		 */
+		struct stats_t {
+				uint64_t connections; ///< Connections accepted
+				uint64_t requests; ///< Requests answered
+				uint64_t errors; ///< Requests answered with an error
+				uint64_t datasets_loaded; ///< Data sets loaded (including reloads of changed files)
+				uint64_t datasets_evicted; ///< Data sets dropped to meet the data set memory limit
+				uint64_t graphlets_built; ///< Graphlets built
+				uint64_t graphlets_cached; ///< Graphlets served from the graphlet cache
+				stats_t() :
+					connections(0), requests(0), errors(0), datasets_loaded(0), datasets_evicted(0), graphlets_built(0), graphlets_cached(0) {
+				}
+		};
+
+		static const unsigned int default_idle_timeout_ms = 60000; ///< 1 minute
+		static const uint64_t default_dataset_memory_limit = (uint64_t) 1 << 30; ///< 1 GB
+
+		CGraphletServer(const std::string & socket_path, const CLocalNets & local_nets, unsigned int threads = 0);
+		~CGraphletServer();
+
+		void set_graphlet_cache_budget(uint64_t byte_budget);
+		void set_dataset_memory_limit(uint64_t memory_limit);
+		void set_write_index(bool write_index);
+		void set_idle_timeout(unsigned int timeout_ms);
+
+		void start();
+		void stop();
+		const std::string & get_socket_path() const;
+		stats_t get_stats() const;
+
+		static std::string request(const std::string & socket_path, const std::string & request_line, uint64_t * time_us = NULL);
+
+	private:
+		CGraphletServer(const CGraphletServer &);
+		CGraphletServer & operator=(const CGraphletServer &);
+
+		/**
+		 *	\struct	dataset_t
+		 *	\brief	Loaded data set, shared by the requests using it
+		 */
+		struct dataset_t {
+				boost::scoped_ptr<const CImport> import; ///< Flows and host metadata of the full flow list (not changed once loaded)
+				std::string identity; ///< File identity when loaded (see CImportCache::get_identity())
+				uint64_t memory_size; ///< Memory held by the data set (see CImport::get_memory_size())
+				uint64_t last_used; ///< Value of dataset_clock when last requested
+		};
+
+		bool is_running();
+		void accept_loop();
+		void worker_loop();
+		void serve(int fd);
+		std::string handle(const std::string & line);
+		std::string handle_hosts(const std::vector<std::string> & args);
+		std::string handle_flows(const std::vector<std::string> & args);
+		std::string handle_graphlet(const std::vector<std::string> & args, const std::string & expression);
+		std::string handle_stats();
+		boost::shared_ptr<dataset_t> get_dataset(const std::string & filename);
+		void evict_datasets(const std::string & keep);
+
+		int sock; ///< Listening socket
+		std::string socket_path; ///< Socket file
+		CLocalNets local_nets; ///< Local networks used to infer flow directions
+		unsigned int threads; ///< Worker threads
+		bool write_index; ///< Loading a data set writes the sidecar index of its file (default: false)
+		unsigned int idle_timeout_ms; ///< Connections without a request for this long are closed (0: never)
+
+		boost::thread * acceptor; ///< Acceptor thread
+		boost::thread_group workers; ///< Worker threads
+		bool running; ///< Cleared to stop the threads
+
+		boost::mutex queue_mutex; ///< Protects connections and running
+		boost::condition_variable queue_ready; ///< Signalled when a connection is queued or the server stops
+		std::deque<int> connections; ///< Accepted connections waiting for a worker
+
+		boost::mutex datasets_mutex; ///< Protects datasets, loading and the data set memory counters
+		std::map<std::string, boost::shared_ptr<dataset_t> > datasets; ///< Data sets by file name
+		uint64_t dataset_memory_limit; ///< Bytes the data sets may take
+		uint64_t dataset_memory_size; ///< Bytes the data sets take
+		uint64_t dataset_clock; ///< Counts data set requests, orders the data sets by last use
+		std::set<std::string> loading; ///< File names of the data sets being loaded
+		boost::condition_variable dataset_loaded; ///< Signalled when a data set load finishes
+
+		prefs_t prefs; ///< Preferences of the data sets (graphlets use the preferences of their request)
+
+		boost::mutex cache_mutex; ///< Protects graphlet_cache and building
+		CGraphletCache graphlet_cache; ///< Finished graphlets
+		std::set<std::string> building; ///< Cache keys of the graphlets being built
+		boost::condition_variable graphlet_built; ///< Signalled when a graphlet build finishes
+
+		mutable boost::mutex stats_mutex; ///< Protects stats
+		stats_t stats; ///< Counters
+};
+
+#endif /* GSERVER_H_ */
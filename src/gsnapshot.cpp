@@ -0,0 +1,175 @@
+/**
+ *	\file gsnapshot.cpp
+ *	\brief Versioned binary image of typed sections, laid out to be memory mapped.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "gsnapshot.h"
+
+using namespace std;
+
+const uint32_t CSnapshotImage::magic;
+const uint32_t CSnapshotImage::format_version;
+const size_t CSnapshotImage::alignment;
+
+/**
+ *	Constructor: empty image for writing
+ */
+CSnapshotImage::CSnapshotImage() {
+}
+
+/**
+ *	Constructor: map and check an image file for reading
+ *
+ *	\param filename Image file
+ *
+ *	\exception std::string Errortext (file missing, not an image, other version or damaged)
+ */
+CSnapshotImage::CSnapshotImage(const string & filename) :
+	file(new CMappedFile(filename, CMappedFile::sequential)) {
+	const uint8_t * data = file->data();
+	uint64_t size = file->size();
+
+	header_t header;
+	if (size < sizeof(header))
+		throw "ERROR: " + filename + " is not a snapshot image.";
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != magic)
+		throw "ERROR: " + filename + " is not a snapshot image.";
+	if (header.version != format_version)
+		throw "ERROR: " + filename + " has an unsupported snapshot image version.";
+	if (header.file_size != size || header.section_count > (size - sizeof(header)) / sizeof(section_t))
+		throw "ERROR: snapshot image " + filename + " is truncated or damaged.";
+
+	sections.resize(header.section_count);
+	if (!sections.empty())
+		memcpy(&sections[0], data + sizeof(header), sections.size() * sizeof(section_t));
+	for (vector<section_t>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+		if (it->offset % alignment != 0 || it->offset > size || it->element_size == 0 || it->count > (size - it->offset) / it->element_size)
+			throw "ERROR: snapshot image " + filename + " is truncated or damaged.";
+	}
+}
+
+/**
+ *	Add a section to the image. The data is not copied: it has to stay unchanged until write().
+ *
+ *	\param id Section id (see section_id_t)
+ *	\param data First element
+ *	\param count Number of elements
+ *	\param element_size Size of an element in bytes
+ *
+ *	\exception std::string Errortext (image is mapped or section exists)
+ */
+void CSnapshotImage::add_section(uint32_t id, const void * data, uint64_t count, uint32_t element_size) {
+	if (file)
+		throw string("ERROR: CSnapshotImage::add_section() called on a mapped image.");
+	if (find(id) != NULL)
+		throw string("ERROR: CSnapshotImage::add_section() called twice for a section.");
+	section_t section;
+	section.id = id;
+	section.element_size = element_size;
+	section.count = count;
+	section.offset = 0; // Assigned by write()
+	sections.push_back(section);
+	section_data.push_back(data);
+}
+
+/**
+ *	Write the image. The file is written under a temporary name first and renamed when complete,
+ *	so readers never map a partial image.
+ *
+ *	\param filename Image file
+ *
+ *	\exception std::string Errortext
+ */
+void CSnapshotImage::write(const string & filename) const {
+	// Assign aligned offsets
+	vector<section_t> table(sections);
+	uint64_t offset = sizeof(header_t) + table.size() * sizeof(section_t);
+	for (vector<section_t>::iterator it = table.begin(); it != table.end(); ++it) {
+		offset = (offset + alignment - 1) / alignment * alignment;
+		it->offset = offset;
+		offset += it->count * it->element_size;
+	}
+	header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = magic;
+	header.version = format_version;
+	header.section_count = table.size();
+	header.file_size = offset;
+
+	string tmp_filename = filename + ".tmp";
+	FILE * out = fopen(tmp_filename.c_str(), "wb");
+	if (out == NULL)
+		throw "ERROR: could not create snapshot image " + tmp_filename + ": " + strerror(errno);
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+	ok = ok && (table.empty() || fwrite(&table[0], sizeof(section_t), table.size(), out) == table.size());
+	uint64_t pos = sizeof(header_t) + table.size() * sizeof(section_t);
+	static const char padding[alignment] = { 0 };
+	for (size_t i = 0; ok && i < table.size(); i++) {
+		size_t pad = table[i].offset - pos;
+		uint64_t bytes = table[i].count * table[i].element_size;
+		ok = (pad == 0 || fwrite(padding, 1, pad, out) == pad) && (bytes == 0 || fwrite(section_data[i], 1, bytes, out) == bytes);
+		pos = table[i].offset + bytes;
+	}
+	int error = errno;
+	if (fclose(out) != 0 && ok) {
+		ok = false;
+		error = errno;
+	}
+	if (!ok || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+		if (ok)
+			error = errno;
+		unlink(tmp_filename.c_str());
+		throw "ERROR: could not write snapshot image " + filename + ": " + strerror(error);
+	}
+}
+
+/**
+ *	\param id Section id
+ *
+ *	\return True if the image has the section
+ */
+bool CSnapshotImage::has_section(uint32_t id) const {
+	return find(id) != NULL;
+}
+
+/**
+ *	Get a section of the mapped image. The data stays valid as long as the image object exists.
+ *
+ *	\param id Section id
+ *	\param element_size Expected size of an element in bytes
+ *	\param count Number of elements (out)
+ *
+ *	\return First element (NULL for empty sections)
+ *
+ *	\exception std::string Errortext (image not mapped, section missing or element size differs)
+ */
+const void * CSnapshotImage::get_section(uint32_t id, uint32_t element_size, uint64_t & count) const {
+	if (!file)
+		throw string("ERROR: CSnapshotImage::get_section() called on an image which is not mapped.");
+	const section_t * section = find(id);
+	if (section == NULL)
+		throw "ERROR: snapshot image " + file->get_filename() + " lacks a section.";
+	if (section->element_size != element_size)
+		throw "ERROR: snapshot image " + file->get_filename() + " was written by an incompatible build.";
+	count = section->count;
+	return (count == 0) ? NULL : file->data() + section->offset;
+}
+
+/**
+ *	\param id Section id
+ *
+ *	\return Entry of the section table (NULL if there is no such section)
+ */
+const CSnapshotImage::section_t * CSnapshotImage::find(uint32_t id) const {
+	for (vector<section_t>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+		if (it->id == id)
+			return &*it;
+	}
+	return NULL;
+}
@@ -0,0 +1,121 @@
+#ifndef GSNAPSHOT_H_
+#define GSNAPSHOT_H_
+
+/**
+ *	\file gsnapshot.h
+ *	\brief Versioned binary image of typed sections, laid out to be memory mapped.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "gmappedfile.h"
+
+/**
+ *	\class	CSnapshotImage
+ *	\brief	CSnapshotImage writes and maps binary images made of arrays of plain structs (sections).
+ *
+ *	An image is either built for writing (default constructor, add_section(), write()) or mapped read-only from
+ *	a file (constructor taking a file name). A mapped image is checked completely when it is opened, so the
+ *	pointers returned by get_section() can be used without further checks.
+ *
+ *	Layout of an image file:
+ *	- header_t
+ *	- section_count section_t (section table)
+ *	- section data, each section starting at a multiple of alignment bytes
+ *
+ *	Images use native byte order and struct layout: the section table records the element size of each section,
+ *	which get_section() checks against the reading build. Images are meant as local caches, not for exchange.
+ */
+class CSnapshotImage {
+	public:
+		static const uint32_t magic = 0x50414e53; ///< "SNAP" (little endian)
+		static const uint32_t format_version = 1; ///< Incremented on layout changes
+		static const size_t alignment = 64; ///< Alignment of the sections in the file (cache line)
+
+		/**
+		 *	\enum section_id_t
+		 *	\brief Ids of the sections used by HAPviewer images
+		 */
+		enum section_id_t {
+			section_identity = 1, ///< CFlowIndex: identity of the flow file and import parameters
+			section_in_filename = 2, ///< CImport: name of the imported flow file (chars)
+			section_flows = 3, ///< CImport: sorted and qualified flows (cflow_t)
+			section_hosts = 4, ///< CImport: host directory (ChostMetadata)
+			section_remoteIP_index = 5, ///< CImport: reverse remoteIP index (int)
+			section_ip_dictionary = 6 ///< CImport: distinct addresses in ascending order (IPv6_addr)
+		};
+
+		CSnapshotImage();
+		CSnapshotImage(const std::string & filename);
+
+		void add_section(uint32_t id, const void * data, uint64_t count, uint32_t element_size);
+		template<typename T> void add_section(uint32_t id, const std::vector<T> & elements);
+		void write(const std::string & filename) const;
+
+		bool has_section(uint32_t id) const;
+		const void * get_section(uint32_t id, uint32_t element_size, uint64_t & count) const;
+		template<typename T> void get_section(uint32_t id, std::vector<T> & elements) const;
+
+	private:
+		CSnapshotImage(const CSnapshotImage &);
+		CSnapshotImage & operator=(const CSnapshotImage &);
+
+		/**
+		 *	\struct	header_t
+		 *	\brief	Header of an image file
+		 */
+		struct header_t {
+				uint32_t magic; ///< magic
+				uint32_t version; ///< format_version
+				uint64_t section_count; ///< Entries of the section table
+				uint64_t file_size; ///< Size of the image file (detects truncation)
+		};
+
+		/**
+		 *	\struct	section_t
+		 *	\brief	Entry of the section table
+		 */
+		struct section_t {
+				uint32_t id; ///< Section id (see section_id_t)
+				uint32_t element_size; ///< sizeof() of an element
+				uint64_t count; ///< Number of elements
+				uint64_t offset; ///< Position of the first element in the file
+		};
+
+		const section_t * find(uint32_t id) const;
+
+		std::vector<section_t> sections; ///< Section table
+		std::vector<const void *> section_data; ///< Data of the sections added (writing only)
+		boost::scoped_ptr<CMappedFile> file; ///< Mapped image (reading only)
+};
+
+/**
+ *	Add an array section to the image. The elements are not copied: they have to stay unchanged until write().
+ *
+ *	\param id Section id
+ *	\param elements Elements
+ */
+template<typename T> void CSnapshotImage::add_section(uint32_t id, const std::vector<T> & elements) {
+	add_section(id, elements.empty() ? NULL : &elements[0], elements.size(), sizeof(T));
+}
+
+/**
+ *	Copy an array section out of the mapped image.
+ *
+ *	\param id Section id
+ *	\param elements Elements (out)
+ *
+ *	\exception std::string Errortext (section missing or element size differs)
+ */
+template<typename T> void CSnapshotImage::get_section(uint32_t id, std::vector<T> & elements) const {
+	uint64_t count;
+	const T * data = static_cast<const T *> (get_section(id, sizeof(T), count));
+	elements.assign(data, data + count);
+}
+
+#endif /* GSNAPSHOT_H_ */
@@ -0,0 +1,296 @@
+/**
+ *	\file gsvgsink.cpp
+ *	\brief Draws graphlets as svg images directly from their edges, without Graphviz.
+ */
+
+#include <string>
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+#include "gsvgsink.h"
+#include "ghpgdata.h"
+#include "IPv6_addr.h"
+#include "cflow.h"
+
+using namespace std;
+
+namespace {
+	const int columns = 5; ///< localIP, protocol, localPort, remotePort, remoteIP
+	const char * column_names[columns] = { "localIP", "protocol", "localPort", "remotePort", "remoteIP" };
+	const double row_height = 34; ///< Vertical distance of the nodes of a column
+	const double node_height = 26; ///< Height of nodes
+	const double char_width = 7.5; ///< Mean width of a character of node labels
+	const double column_gap = 110; ///< Horizontal space between the widest nodes of neighbouring columns (edge labels)
+	const double margin = 20; ///< Space around the image
+	const double header_height = 30; ///< Height of the column names
+
+	/// Node of the image
+	struct svg_node {
+		string label; ///< Text of the node
+		bool summary; ///< Summary node (box) or not (ellipse)
+		int column; ///< Column of the node
+		double half_width; ///< Half width of the node
+		double row; ///< Row of the node within its column
+		double key; ///< Mean row of the neighbours in the column to the left (sort key)
+	};
+
+	/// Edge of the image
+	struct svg_edge {
+		size_t from; ///< Left-hand node
+		size_t to; ///< Right-hand node
+		const char * color; ///< Line color
+		bool bold; ///< Thick line
+		bool arrow_start; ///< Arrow pointing to the left-hand node
+		bool arrow_end; ///< Arrow pointing to the right-hand node
+		string label; ///< Annotation (bytes(packets) or flows(packets/flow))
+	};
+
+	/// Orders the nodes of a column by sort key
+	struct by_key {
+		const vector<svg_node> & nodes;
+		by_key(const vector<svg_node> & nodes) :
+			nodes(nodes) {
+		}
+		bool operator()(size_t a, size_t b) const {
+			return nodes[a].key < nodes[b].key;
+		}
+	};
+}
+
+/**
+ *	Escape a text for svg.
+ */
+static string xml_string(const string & text) {
+	string escaped;
+	for (size_t i = 0; i < text.size(); i++) {
+		switch (text[i]) {
+			case '&':
+				escaped += "&amp;";
+				break;
+			case '<':
+				escaped += "&lt;";
+				break;
+			case '>':
+				escaped += "&gt;";
+				break;
+			case '"':
+				escaped += "&quot;";
+				break;
+			default:
+				escaped += text[i];
+		}
+	}
+	return escaped;
+}
+
+/**
+ *	Constructor
+ *
+ *	\param out Stream receiving an svg image ("<svg ...>...</svg>") per graphlet
+ */
+CSvgSink::CSvgSink(ostream & out) :
+	out(out) {
+}
+
+/**
+ *	Keep an edge of the current graphlet. Version edges are dropped.
+ */
+void CSvgSink::add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) {
+	if (rank != version)
+		graphlet.add_edge(graphlet_nr, rank, value1, value2);
+}
+
+/**
+ *	Draw the current graphlet.
+ *
+ *	\exception std::string Errortext
+ */
+void CSvgSink::end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos) {
+	vector<hpg_field> & data = graphlet.get_data();
+	if (data.empty())
+		return;
+	try {
+		write_svg(data, out);
+	} catch (...) {
+		graphlet.clear();
+		throw;
+	}
+	graphlet.clear();
+}
+
+/**
+ *	Draw a graphlet as svg image.
+ *
+ *	\param edges hpg data of the graphlet (3 fields per edge, version edges are skipped)
+ *	\param out Output stream
+ *
+ *	\exception std::string Errortext (graphlet without edges)
+ */
+void CSvgSink::write_svg(const std::vector<hpg_field> & edges, std::ostream & out) {
+	// 1. Collect nodes and edges
+	// **************************
+	vector<svg_node> nodes;
+	vector<svg_edge> lines;
+	vector<size_t> column[columns]; // Nodes of each column
+	map<string, size_t> node_ids; // Dot node id to node
+	string localIP;
+	int last_partition = 0;
+	for (size_t i = 0; i + 2 < edges.size(); i += 3) {
+		rank_t rank = (rank_t) (edges[i].eightbytevalue.data & 0xf);
+		const hpg_field & value1 = edges[i + 1];
+		const hpg_field & value2 = edges[i + 2];
+		if (rank == edge_label) { // Annotates the edge before
+			if (lines.empty() || last_partition < 3)
+				continue;
+			stringstream ss;
+			ss << value1.eightbytevalue.data;
+			if (value2.eightbytevalue.data >> 31) // Fixed point value with 1 digit behind decimal point
+				ss << "(" << (double) (value2.eightbytevalue.data & 0x7fffffff) / 10.0 << ")";
+			else if (value2.eightbytevalue.data != 0)
+				ss << "(" << value2.eightbytevalue.data << ")";
+			lines.back().label = ss.str();
+			continue;
+		}
+		int partition = ChpgData::get_partition(rank);
+		if (partition == 0) // version, totalBytes
+			continue;
+		last_partition = partition;
+
+		size_t ends[2];
+		for (int right = 0; right < 2; right++) {
+			string id = ChpgData::get_node_id(rank, right ? value2 : value1, right != 0);
+			map<string, size_t>::iterator it = node_ids.find(id);
+			if (it != node_ids.end()) {
+				ends[right] = it->second;
+				continue;
+			}
+			svg_node node;
+			if (right) {
+				node.label = ChpgData::get_node_label(rank, value2);
+				node.summary = ChpgData::is_summary_node(rank);
+			} else {
+				node.label = IPv6_addr(value1.data).toString(); // Only the localIP is first seen as left-hand node
+				node.summary = false;
+				if (localIP.empty())
+					localIP = node.label;
+			}
+			node.half_width = max(node.label.size() * char_width / 2 + 12, node_height);
+			node.column = partition - 1 + right;
+			node.row = node.key = 0;
+			ends[right] = nodes.size();
+			node_ids[id] = nodes.size();
+			column[node.column].push_back(nodes.size());
+			nodes.push_back(node);
+		}
+
+		svg_edge line;
+		line.from = ends[0];
+		line.to = ends[1];
+		line.color = "black";
+		line.bold = line.arrow_start = line.arrow_end = false;
+		if (partition == 3) { // Flow direction, as hpg2dot()
+			uint8_t flowtype = GET_FLOWTYPE(value1.eightbytevalue.data);
+			line.color = (flowtype == biflow) ? "black" : (flowtype & unibiflow) ? "green" : "red";
+			line.bold = (flowtype == biflow);
+			line.arrow_start = (flowtype & (biflow | inflow)) != 0;
+			line.arrow_end = (flowtype & (biflow | outflow)) != 0;
+		} else if (partition == 4) {
+			int color = GET_COLORCODE(value1.eightbytevalue.data);
+			line.color = (color == 1) ? "red" : (color == 2) ? "green" : "black";
+		}
+		lines.push_back(line);
+	}
+	if (lines.empty())
+		throw string("no flows left");
+
+	// 2. Layout: sort each column by the mean row of the left-hand neighbours
+	// ***********************************************************************
+	size_t max_rows = 0;
+	double x[columns], max_half_width[columns];
+	for (int c = 0; c < columns; c++) {
+		if (c > 0) {
+			vector<double> sum(nodes.size(), 0), count(nodes.size(), 0);
+			for (size_t e = 0; e < lines.size(); e++) {
+				sum[lines[e].to] += nodes[lines[e].from].row;
+				count[lines[e].to]++;
+			}
+			for (size_t n = 0; n < column[c].size(); n++)
+				nodes[column[c][n]].key = sum[column[c][n]] / max(1.0, count[column[c][n]]);
+			stable_sort(column[c].begin(), column[c].end(), by_key(nodes));
+		}
+		max_half_width[c] = node_height;
+		for (size_t n = 0; n < column[c].size(); n++) {
+			nodes[column[c][n]].row = n;
+			max_half_width[c] = max(max_half_width[c], nodes[column[c][n]].half_width);
+		}
+		max_rows = max(max_rows, column[c].size());
+		x[c] = (c == 0) ? margin + max_half_width[c] : x[c - 1] + max_half_width[c - 1] + column_gap + max_half_width[c];
+	}
+	// Center the columns vertically
+	for (int c = 0; c < columns; c++) {
+		for (size_t n = 0; n < column[c].size(); n++)
+			nodes[column[c][n]].row += (max_rows - column[c].size()) / 2.0;
+	}
+	double width = x[columns - 1] + max_half_width[columns - 1] + margin;
+	double height = 2 * margin + header_height + max_rows * row_height;
+	double top = margin + header_height + row_height / 2;
+
+	// 3. Draw
+	// *******
+	out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+	      << "\" viewBox=\"0 0 " << width << " " << height << "\" font-family=\"Arial\" font-size=\"14\">\n" << "<title>" << xml_string(localIP)
+	      << "</title>\n<defs>\n";
+	const char * colors[] = { "black", "red", "green" };
+	for (int i = 0; i < 3; i++)
+		out << "<marker id=\"arrow-" << colors[i] << "\" viewBox=\"0 0 10 10\" refX=\"10\" refY=\"5\" markerWidth=\"8\" markerHeight=\"8\" "
+		      << "orient=\"auto-start-reverse\"><path d=\"M0,0L10,5L0,10z\" fill=\"" << colors[i] << "\"/></marker>\n";
+	out << "</defs>\n<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+
+	// Column names and edge annotation captions
+	out << "<g font-size=\"16\" text-anchor=\"middle\">\n";
+	for (int c = 0; c < columns; c++)
+		out << "<text x=\"" << x[c] << "\" y=\"" << margin + 16 << "\">" << column_names[c] << "</text>\n";
+	out << "<text x=\"" << (x[2] + x[3]) / 2 << "\" y=\"" << margin + 16 << "\" font-size=\"12\" fill=\"gray\">B(pkts)</text>\n";
+	out << "<text x=\"" << (x[3] + x[4]) / 2 << "\" y=\"" << margin + 16 << "\" font-size=\"12\" fill=\"gray\">fl.(p./fl.)</text>\n</g>\n";
+
+	// Edges between the borders of their nodes
+	out << "<g fill=\"none\">\n";
+	stringstream labels;
+	for (size_t e = 0; e < lines.size(); e++) {
+		const svg_edge & line = lines[e];
+		const svg_node & from = nodes[line.from];
+		const svg_node & to = nodes[line.to];
+		int c = from.column;
+		double x1 = x[c] + from.half_width, y1 = top + from.row * row_height;
+		double x2 = x[c + 1] - to.half_width, y2 = top + to.row * row_height;
+		out << "<line x1=\"" << x1 << "\" y1=\"" << y1 << "\" x2=\"" << x2 << "\" y2=\"" << y2 << "\" stroke=\"" << line.color << "\"";
+		if (line.bold)
+			out << " stroke-width=\"2\"";
+		if (line.arrow_start)
+			out << " marker-start=\"url(#arrow-" << line.color << ")\"";
+		if (line.arrow_end)
+			out << " marker-end=\"url(#arrow-" << line.color << ")\"";
+		out << "/>\n";
+		if (!line.label.empty())
+			labels << "<text x=\"" << (x1 + x2) / 2 << "\" y=\"" << (y1 + y2) / 2 - 3 << "\">" << xml_string(line.label) << "</text>\n";
+	}
+	out << "</g>\n<g font-size=\"11\" text-anchor=\"middle\">\n" << labels.str() << "</g>\n";
+
+	// Nodes: ellipses, summary nodes as bold boxes
+	out << "<g text-anchor=\"middle\" dominant-baseline=\"central\">\n";
+	for (int c = 0; c < columns; c++) {
+		for (size_t n = 0; n < column[c].size(); n++) {
+			const svg_node & node = nodes[column[c][n]];
+			double y = top + node.row * row_height;
+			if (node.summary)
+				out << "<rect x=\"" << x[c] - node.half_width << "\" y=\"" << y - node_height / 2 << "\" width=\"" << 2 * node.half_width << "\" height=\""
+				      << node_height << "\" fill=\"white\" stroke=\"black\" stroke-width=\"2\"/>\n";
+			else
+				out << "<ellipse cx=\"" << x[c] << "\" cy=\"" << y << "\" rx=\"" << node.half_width << "\" ry=\"" << node_height / 2
+				      << "\" fill=\"white\" stroke=\"black\"/>\n";
+			out << "<text x=\"" << x[c] << "\" y=\"" << y << "\">" << xml_string(node.label) << "</text>\n";
+		}
+	}
+	out << "</g>\n</svg>\n";
+}
@@ -0,0 +1,37 @@
+#ifndef GSVGSINK_H_
+#define GSVGSINK_H_
+
+/**
+ *	\file gsvgsink.h
+ *	\brief Draws graphlets as svg images directly from their edges, without Graphviz.
+ */
+
+#include <ostream>
+#include <vector>
+
+#include "hpg.h"
+#include "gedgesink.h"
+
+/**
+ *	\class	CSvgSink
+ *	\brief	Draws each graphlet as svg image and writes it to a stream.
+ *
+ *	A graphlet always has the five columns localIP, protocol, localPort, remotePort and remoteIP, so no general graph
+ *	layout is needed: each partition is a column, the nodes of a column are sorted by the mean row of their neighbours
+ *	in the column to the left (few crossing edges), and edges are straight lines. Nodes, summary node boxes, edge
+ *	colors and edge labels follow the dot data of ChpgData::hpg2dot().
+ */
+class CSvgSink: public CEdgeSink {
+	public:
+		CSvgSink(std::ostream & out);
+		void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2);
+		void end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos);
+
+		static void write_svg(const std::vector<hpg_field> & edges, std::ostream & out);
+
+	private:
+		std::ostream & out; ///< Receives the svg images
+		CHpgBufferSink graphlet; ///< Edges of the current graphlet
+};
+
+#endif /* GSVGSINK_H_ */
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <string>
 #include <iomanip>
+#include <vector>
 #include <math.h>
 
 #include "gutil.h"
@@ -35,15 +36,16 @@ using namespace std;
 namespace util {
 
 	/**
-	 *	Open file for output. Discard any contents if it already exists.
+	 *	Open file for output. Discard any contents if it already exists, unless append is set.
 	 *
 	 *	\param outfs output stream (out)
 	 *	\param ofname name of output file (out)
+	 *	\param append Append to the existing contents instead of discarding them
 	 *
 	 *	\exception string Errormessage
 	 */
-	void open_outfile(ofstream & outfs, string ofname) {
-		outfs.open(ofname.c_str(), ios::out | ios::trunc | ios_base::binary);
+	void open_outfile(ofstream & outfs, string ofname, bool append) {
+		outfs.open(ofname.c_str(), ios::out | (append ? ios::app : ios::trunc) | ios_base::binary);
 		if (outfs.fail()) {
 			string error = "ERROR: Opening output file " + ofname + " failed.";
 			throw error;
@@ -149,6 +151,21 @@ namespace util {
 		return addr;
 	}
 
+	/**
+	 * \brief Names of all IP protocol numbers, for numbers ipV6ProtocolToString() does not know
+	 *
+	 * \return vector Name "prot<number>" for each number
+	 */
+	static vector<string> unknown_protocol_names() {
+		vector<string> names;
+		for (int prot = 0; prot < 256; prot++) {
+			char protoname[20];
+			snprintf(protoname, 20, "prot%d", prot);
+			names.push_back(protoname);
+		}
+		return names;
+	}
+
 	/**
 	 * \brief Returns the IP protocol as string. E.g. UDP, TCP, ...
 	 *
@@ -188,13 +205,55 @@ namespace util {
 				static const string ipip = "IPIP";
 				return ipip;
 			default:
-				static char protoname[20];
-				snprintf(protoname, 20, "prot%d", prot);
-				static const string unknown(protoname);
-				return unknown;
+				static const vector<string> unknown = unknown_protocol_names();
+				return unknown[prot];
 		}
 	}
 
+	/**
+	 * \brief Returns the IP protocol number of a protocol name (tcp, udp, icmp, icmp6, gre, esp) or number.
+	 *
+	 * \param name Protocol name (case insensitive) or number
+	 * \return int IP protocol number, -1 if name is neither a known protocol name nor a number up to 255
+	 */
+	int stringToIpProtocol(const string & name) {
+		string lower(name);
+		transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+		if (lower == "tcp")
+			return IPPROTO_TCP;
+		if (lower == "udp")
+			return IPPROTO_UDP;
+		if (lower == "icmp")
+			return IPPROTO_ICMP;
+		if (lower == "icmp6")
+			return IPPROTO_ICMPV6;
+		// IPPROTO_GRE and IPPROTO_ESP are not defined on all platforms
+		if (lower == "gre")
+			return 47;
+		if (lower == "esp")
+			return 50;
+		if (lower.empty() || lower.size() > 3 || lower.find_first_not_of("0123456789") != string::npos)
+			return -1;
+		int prot = atoi(lower.c_str());
+		return (prot > 255) ? -1 : prot;
+	}
+
+	/**
+	 * \brief Descriptive texts of all flow direction type values, for values print_flowtype() does not know
+	 *
+	 * \return vector Text for each value
+	 */
+	static vector<string> unexpected_flowtype_names() {
+		vector<string> names;
+		for (int dir = 0; dir < 256; dir++) {
+			string dirX = "?flow?(  )";
+			dirX[7] = 0x30 + dir / 10;
+			dirX[8] = 0x30 + dir % 10;
+			names.push_back(dirX);
+		}
+		return names;
+	}
+
 	/**
 	 * \brief Returns the flow direction type as descriptive text
 	 *
@@ -235,12 +294,8 @@ namespace util {
 				return dir12;
 
 			default:
-				static string dirX = "?flow?(  )"; // Unexpected value
-				char msd = 0x30 + dir / 10;
-				char lsd = 0x30 + dir % 10;
-				dirX[7] = msd;
-				dirX[8] = lsd;
-				return dirX;
+				static const vector<string> dirX = unexpected_flowtype_names(); // Unexpected values
+				return dirX[dir];
 		}
 	}
 
@@ -261,10 +316,8 @@ namespace util {
 		localtime_r(&tt, &ts);
 
 		// IP addresses
-		static string local;
-		static string remote;
-		local = record.localIP.toString();
-		remote = record.remoteIP.toString();
+		string local = record.localIP.toString();
+		string remote = record.remoteIP.toString();
 
 		char dir1[] = "outflow(1)"; // Choice of flow types
 		char dir2[] = "inflow (2)";
@@ -382,9 +435,10 @@ namespace util {
 	 *	\return Unix seconds
 	 */
 	int utime3(const char * timestring) {
-		static struct tm tm;
-		static time_t t;
+		struct tm tm;
+		time_t t;
 
+		memset(&tm, 0, sizeof(tm));
 		if (strptime(timestring, "%Y%m%d.%H%M", &tm) == NULL) {
 			cerr << "\nERROR in strptime(): invalid date/time string = " << timestring << "\n\n";
 			exit(1);
@@ -411,7 +465,6 @@ namespace util {
 	 *
 	 *	If required then leading spaces are added.
 	 *	Number is formatted by groups of three digits separated by single quotes.
-	 *	Note: this function is not reentrant (due to local static variable)
 	 *
 	 *	\param 	x to be formatted
 	 *	\param 	fieldsize Minimum field size to use.
@@ -445,8 +498,7 @@ namespace util {
 			}
 		}
 
-		static string s;
-		s.clear();
+		string s;
 		for (int i = 0; i < numspaces; i++)
 			s += " ";
 		if (numsigns > 0) {
@@ -491,7 +543,6 @@ namespace util {
 	 *
 	 *	If required then leading spaces are added.
 	 *	Number is formatted by groups of three digits separated by single quotes.
-	 *	Note: this function is not reentrant (due to local static variable)
 	 *
 	 *	\param 	x to be formatted
 	 *	\param 	fieldsize Minimum field size to use.
@@ -525,8 +576,7 @@ namespace util {
 			}
 		}
 
-		static string s;
-		s.clear();
+		string s;
 		for (int i = 0; i < numspaces; i++)
 			s += " ";
 		if (numsigns > 0) {
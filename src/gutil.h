@@ -19,7 +19,7 @@
 #include "cflow.h"
 
 namespace util {
-	void open_outfile(std::ofstream & outfs, std::string ofname);
+	void open_outfile(std::ofstream & outfs, std::string ofname, bool append = false);
 	void open_infile(std::ifstream & infs, std::string ifname);
 	uint64_t getFileSize(std::string in_filename);
 	bool fileExists(std::string in_filename);
@@ -28,6 +28,7 @@ namespace util {
 	IPv6_addr ipV6NfDumpToIpV6(const uint64_t * ipv6_parts);
 	IPv6_addr ipV6IpfixToIpV6(const in6_addr & ipv6_ipfix);
 	const std::string & ipV6ProtocolToString(uint8_t prot);
+	int stringToIpProtocol(const std::string & name);
 	const std::string & print_flowtype(uint8_t dir);
 	void record2String(const cflow_t & record, char * out);
 	void record2StringShort(const cflow_t & record, char * out);
@@ -8,6 +8,7 @@
 #include "glistview_hpg.h"
 #include "gmodel.h"
 #include "ghpgdata.h"
+#include "gflowexpression.h"
 #include "IPv6_addr.h"
 
 #include <gtkmm/stock.h>
@@ -139,10 +140,16 @@ CGetNetwork::CGetNetwork() :
 	m_Entry_prefix.set_width_chars(3);
 	m_Hbox_prefix.pack_start(m_Entry_prefix, Gtk::PACK_SHRINK);
 
+	m_Label3.set_text("or prefix file: ");
+	m_Hbox_prefix_file.pack_start(m_Label3, Gtk::PACK_SHRINK);
+	m_Entry_prefix_file.set_text("");
+	m_Hbox_prefix_file.pack_start(m_Entry_prefix_file, Gtk::PACK_SHRINK);
+
 	m_Button_GetNetwork.signal_clicked().connect(sigc::mem_fun(*this, &CGetNetwork::on_button_get_network));
 	m_Vbox.add(m_Hbox_IP);
 
 	m_Vbox.add(m_Hbox_prefix);
+	m_Vbox.add(m_Hbox_prefix_file);
 	m_Vbox.pack_start(m_Button_GetNetwork, Gtk::PACK_EXPAND_PADDING);
 
 	add(m_Vbox);
@@ -162,6 +169,7 @@ CGetNetwork::CGetNetwork() :
 void CGetNetwork::unhide() {
 	m_Entry_IP.set_text(local_net.toString());
 	m_Entry_prefix.set_text(netmask_text);
+	m_Entry_prefix_file.set_text(prefix_file_text);
 	show_all_children();
 	set_keep_above(true);
 	set_modal(true);
@@ -170,26 +178,34 @@ void CGetNetwork::unhide() {
 }
 
 /**
- *	Get an IP and the netmask
+ *	Get an IP and the prefix length, or the local prefixes from a file
  */
 void CGetNetwork::on_button_get_network() {
-	IPv6_addr netmask_tmp;
+	CLocalNets local_nets;
 	try {
-		local_net = (string) m_Entry_IP.get_text();
-		netmask_text = m_Entry_prefix.get_text();
-		uint32_t prefix = boost::lexical_cast<uint32_t>(netmask_text);
-		// Add 96 bits if user enters an IPv4 address and the according hostmask
-		if (prefix <= 32 && local_net.isIPv4()) {
-			prefix += 96;
+		prefix_file_text = m_Entry_prefix_file.get_text();
+		if (!prefix_file_text.empty()) {
+			local_nets.load(prefix_file_text);
+		} else {
+			local_net = (string) m_Entry_IP.get_text();
+			netmask_text = m_Entry_prefix.get_text();
+			uint32_t prefix = boost::lexical_cast<uint32_t>(netmask_text);
+			// Add 96 bits if user enters an IPv4 address and the according hostmask
+			if (prefix <= 32 && local_net.isIPv4()) {
+				prefix += 96;
+			}
+			local_nets.add(local_net, prefix);
 		}
-		netmask_tmp = IPv6_addr::getNetmask(prefix);
+	} catch (string & errtext) {
+		cerr << errtext << endl;
+		return;
 	} catch (...) {
 		cerr << "Invalid input" << endl;
 		return;
 	}
 	hide();
 
-	signal_get_network(local_net, netmask_tmp);
+	signal_get_network(local_nets);
 }
 
 //*** CPreferences ************************************************************
@@ -200,7 +216,7 @@ CPreferences::CPreferences() :
 	m_button_sum_biflows("summarize biflows"), m_button_sum_uniflows("summarize uniflows"), m_button_filter_biflows("filter biflows"),
 	      m_button_filter_uniflows("filter uniflows"), m_button_filter_unprod_inflows("filter unproductive inflows"),
 	      m_button_filter_unprod_outflows("filter unproductive outflows"), m_button_filter_TCP("filter TCP flows"), m_button_filter_UDP("filter UDP flows"),
-	      m_button_filter_ICMP("filter ICMP flows"), m_button_filter_OTHER("filter OTHER flows"),
+	      m_button_filter_ICMP("filter ICMP flows"), m_button_filter_OTHER("filter OTHER flows"), m_Label_filter_expression("show only flows matching: "),
 	      m_button_warn_oversized_graphlet("warn before oversized graphlets"), m_Button_ok("Okay") {
 	set_title("Preferences");
 	set_border_width(10);
@@ -262,6 +278,11 @@ CPreferences::CPreferences() :
 	m_button_filter_OTHER.signal_clicked().connect(sigc::mem_fun(*this, &CPreferences::on_button_filter_OTHER_clicked));
 	m_Vbox.pack_start(m_button_filter_OTHER, Gtk::PACK_SHRINK);
 
+	m_Hbox_filter_expression.pack_start(m_Label_filter_expression, Gtk::PACK_SHRINK);
+	m_Entry_filter_expression.set_text("");
+	m_Hbox_filter_expression.pack_start(m_Entry_filter_expression, Gtk::PACK_EXPAND_WIDGET);
+	m_Vbox.pack_start(m_Hbox_filter_expression, Gtk::PACK_SHRINK);
+
 	m_Vbox.add(m_separator3);
 
 	m_button_warn_oversized_graphlet.signal_clicked().connect(sigc::mem_fun(*this, &CPreferences::on_button_warn_oversized_graphlet_clicked));
@@ -380,6 +401,13 @@ void CPreferences::on_button_warn_oversized_graphlet_clicked() {
  * Updates the preferences to the actually selected one from the GUI
  */
 void CPreferences::on_button_pref_ok() {
+	string filter_expression = m_Entry_filter_expression.get_text();
+	try {
+		CFlowExpression expression(filter_expression);
+	} catch (string & errtext) {
+		cerr << errtext << endl;
+		return;
+	}
 	hide();
 	if (dbg2)
 		cout << "Button pref ok pressed.\n";
@@ -394,6 +422,7 @@ void CPreferences::on_button_pref_ok() {
 	prefs.filter_UDP = m_button_filter_UDP.get_active();
 	prefs.filter_ICMP = m_button_filter_ICMP.get_active();
 	prefs.filter_OTHER = m_button_filter_OTHER.get_active();
+	prefs.filter_expression = filter_expression;
 	prefs.warn_oversized_graphlet = m_button_warn_oversized_graphlet.get_active();
 
 	signal_preferences(prefs);
@@ -412,6 +441,7 @@ CView::CView(char *argv[]) :
 	rinitialized = false;
 	hpgData = NULL;
 	flowImport = NULL;
+	local_nets = CLocalNets(IPv6_addr(), IPv6_addr()); // every address is local until a network has been entered
 	hpgModel = NULL;
 	hostModel = NULL;
 	xpos = ypos = 0;
@@ -641,6 +671,11 @@ void CView::on_menu_file_open() {
 	filter_dot.set_name("DOT files");
 	filter_dot.add_pattern("*.dot");
 	dialog.add_filter(filter_dot);
+
+	Gtk::FileFilter filter_snapshot;
+	filter_snapshot.set_name("Snapshots");
+	filter_snapshot.add_pattern("*.hsnap");
+	dialog.add_filter(filter_snapshot);
 //
 //	Gtk::FileFilter filter_gif;
 //	filter_gif.set_name("GIF files");
@@ -692,10 +727,11 @@ void CView::on_menu_file_open() {
 					handle_hpgMetadataview(import_filename);
 					show_all_children();
 				}
-			} else if (CImport::getFormatName(import_filename) == "cflow4" || CImport::getFormatName(import_filename) == "cflow6") {
+			} else if (CImport::is_snapshot_filename(import_filename) || CImport::getFormatName(import_filename) == "cflow4"
+			      || CImport::getFormatName(import_filename) == "cflow6") {
 				//
-				// gz (g'zipped binary cflow_t) file
-				// *******************************
+				// gz (g'zipped binary cflow_t) file or snapshot (*.hsnap) of a previous import
+				// ****************************************************************************
 				// Check if found string is really at end of filename
 				string hpg_filename = "temp.hpg";
 				bool ok;
@@ -779,6 +815,7 @@ void CView::on_menu_file_save() {
 			// - save DOT file of graphlet if a *.dot file name is given
 			// - save GIF file of graphlet if a *.gif file name is given
 			// - save flow list of graphlet to cflow_t binary file if a *.gz file name is given
+			// - save loaded data set as snapshot if a *.hsnap file name is given
 
 			// Check if file name ends in ".gif"
 			pos = filename2.rfind(".gif");
@@ -859,6 +896,20 @@ void CView::on_menu_file_save() {
 				break;
 			}
 
+			// Save loaded data set as snapshot if a *.hsnap file name is given
+			if (CImport::is_snapshot_filename(filename2)) {
+				if (flowImport == NULL) {
+					handle_failure("There is no loaded flow data to save as snapshot");
+				} else {
+					try {
+						flowImport->save_snapshot(filename2);
+					} catch (string & errtext) {
+						handle_failure(errtext);
+					}
+				}
+				break;
+			}
+
 			// Check if file name ends in ".gz"
 			pos = filename2.rfind(".gz");
 			if (pos != string::npos) {
@@ -1147,23 +1198,18 @@ void CView::handle_new_rolnum(uint32_t rolnum) {
 }
 
 /**
- * Imports from a file to a CFlowList, using the submitted IP and netmask
+ * Imports from a file to a CFlowList, using the submitted local networks
  *
- * @param IP IP
- * @param netmask Netmask
+ * @param local_nets Local networks
  */
-void CView::handle_get_network(IPv6_addr IP, IPv6_addr netmask) {
+void CView::handle_get_network(CLocalNets local_nets) {
 	if (dbg2)
 		cout << "Handler for get network triggered:\n";
 
-	this->netmask = netmask;
+	this->local_nets = local_nets;
 	handle_list_cleared();
 
-	local_net = IP;
-	cout << "Netmask is: " << hex << netmask << dec << endl;
-	cout << "Network address was: " << local_net << endl;
-	local_net = local_net & netmask;
-	cout << "Network address is: " << local_net << endl;
+	cout << "Local networks are: " << local_nets.toString() << endl;
 
 	// Now we are ready to import data from file
 	string hpg_filename = "temp.hpg"; // FIXME: store this on a central point
@@ -1273,6 +1319,7 @@ void CView::handle_preferences(const prefs_t & newprefs) {
 	prefs.filter_UDP = newprefs.filter_UDP;
 	prefs.filter_ICMP = newprefs.filter_ICMP;
 	prefs.filter_OTHER = newprefs.filter_OTHER;
+	prefs.filter_expression = newprefs.filter_expression;
 	prefs.warn_oversized_graphlet = newprefs.warn_oversized_graphlet;
 	if (dbg)
 		cout << "Preferences set.\n";
@@ -1782,7 +1829,7 @@ bool CView::handle_binary_import(std::string in_filename, string & out_filename)
 	if (flowImport->acceptForImport(in_filename)) {
 		flowImport = new CImport(in_filename, out_filename, prefs);
 		try {
-			flowImport->read_file(local_net, netmask);
+			flowImport->read_file(local_nets);
 		} catch (string & errtext) {
 			// Upon failed open on filename given
 			throw errtext;
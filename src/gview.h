@@ -16,6 +16,7 @@
 #include "gimport.h"
 #include "global.h"
 #include "IPv6_addr.h"
+#include "glocalnets.h"
 
 //*** CGotoGraphlet ***************************************************************
 
@@ -65,6 +66,7 @@ class CGotoIP: public Gtk::Window {
  *	network address prefix value. This information is needed to determine the 
  *	local group of IP addresses in pcap data as pcap files do not store the 
  *	network address and netmask/address prefix of the capture interface.
+ *	Alternatively, a file listing several local prefixes can be given.
  */
 class CGetNetwork: public Gtk::Window {
 	public:
@@ -72,7 +74,7 @@ class CGetNetwork: public Gtk::Window {
 		CGetNetwork();
 		void unhide();
 		virtual void on_button_get_network();
-		sigc::signal<void, IPv6_addr, IPv6_addr> signal_get_network;
+		sigc::signal<void, CLocalNets> signal_get_network;
 
 	protected:
 
@@ -84,12 +86,17 @@ class CGetNetwork: public Gtk::Window {
 		Gtk::Entry m_Entry_prefix;
 		Gtk::HBox m_Hbox_prefix;
 
+		Gtk::Label m_Label3;
+		Gtk::Entry m_Entry_prefix_file;
+		Gtk::HBox m_Hbox_prefix_file;
+
 		Gtk::VBox m_Vbox;
 		Gtk::Button m_Button_GetNetwork;
 
 		// Network address/prefix for pcap import
 		IPv6_addr local_net;
 		Glib::ustring netmask_text;
+		Glib::ustring prefix_file_text;
 
 };
 
@@ -132,6 +139,10 @@ class CPreferences: public Gtk::Window {
 		Gtk::CheckButton m_button_filter_ICMP;
 		Gtk::CheckButton m_button_filter_OTHER;
 
+		Gtk::Label m_Label_filter_expression;
+		Gtk::Entry m_Entry_filter_expression;
+		Gtk::HBox m_Hbox_filter_expression;
+
 		Gtk::CheckButton m_button_warn_oversized_graphlet;
 
 		Gtk::Button m_Button_ok;
@@ -197,7 +208,7 @@ class CView: public Gtk::Window {
 		void handle_goto_graphlet(int graphlet);
 		void handle_goto_IP(IPv6_addr IP);
 		void handle_new_rolnum(uint32_t rolnum);
-		void handle_get_network(IPv6_addr IP, IPv6_addr netmask);
+		void handle_get_network(CLocalNets local_nets);
 
 		// Child widgets
 		// *************
@@ -222,10 +233,9 @@ class CView: public Gtk::Window {
 		CGetNetwork m_get_network;
 		CPreferences m_preferences;
 
-		// Network address/prefix for pcap import
-		// **************************************
-		IPv6_addr local_net;
-		IPv6_addr netmask;
+		// Local networks for pcap import
+		// ******************************
+		CLocalNets local_nets;
 
 		// Metadata list views & data
 		// **************************
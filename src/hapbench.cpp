@@ -0,0 +1,597 @@
+/**
+ *	\file hapbench.cpp
+ *	\brief Throughput benchmarks for the HAPviewer library.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <netinet/in.h>		// IP protocol type definitions
+#include <boost/program_options.hpp>
+#include <stdint.h>
+
+#include "cflow.h"
+#include "IPv6_addr.h"
+#include "gflowassembler.h"
+#include "glocalnets.h"
+#include "gflowcolumns.h"
+#include "gflowexpression.h"
+#include "gimport.h"
+#include "global.h"
+#ifdef HAPBENCH_ARGUS
+#include "gfilter_argus.h"
+#endif
+
+using namespace std;
+
+/**
+ *	\struct	bench_options_t
+ *	\brief	Parameters shared by all benchmarks
+ */
+struct bench_options_t {
+	unsigned int flows; ///< Number of distinct flows (5-tuples)
+	unsigned int packets; ///< Packets per flow
+	unsigned int threads; ///< Worker threads
+	unsigned int repeat; ///< Number of runs (best run is reported)
+	unsigned int hosts; ///< Number of local hosts
+	unsigned int host_flows; ///< Flows per local host
+	std::string input; ///< Input file for file based benchmarks
+	std::string expression; ///< Filter expression (filter)
+};
+
+/**
+ *	Get current time.
+ *
+ *	\return Seconds since the epoch (microsecond resolution)
+ */
+static double now() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ *	Print a throughput figure.
+ *
+ *	\param what Name of the counted items
+ *	\param count Number of items processed
+ *	\param seconds Elapsed time
+ */
+static void print_rate(const string & what, uint64_t count, double seconds) {
+	cout << "  " << setw(10) << count << " " << what << " in " << fixed << setprecision(3) << seconds << " s: " << setprecision(0)
+	      << (seconds > 0 ? count / seconds : 0) << " " << what << "/s" << endl;
+}
+
+/**
+ *	Benchmark CFlowAssembler: feeds synthetic packets of interleaved TCP connections (both directions)
+ *	and reports packets/s and assembled flows/s.
+ *
+ *	\param opts Benchmark parameters
+ */
+static void bench_assembler(const bench_options_t & opts) {
+	IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+	IPv6_addr netmask(IPv6_addr::getNetmask(104));
+
+	// Prepare packets in advance so that only the assembler is measured
+	vector<CFlowAssembler::record_t> packets;
+	packets.reserve((size_t) opts.flows * opts.packets);
+	uint64_t baseMs = 1300000000000ULL;
+	for (unsigned int p = 0; p < opts.packets; p++) {
+		for (unsigned int f = 0; f < opts.flows; f++) {
+			CFlowAssembler::record_t rec;
+			IPv6_addr local(0x0a000000 + (f % 65536));
+			IPv6_addr remote(0xc0000000 + f / 65536);
+			uint16_t localPort = 1024 + f % 60000;
+			if (p % 2 == 0) {
+				rec.srcIP = local;
+				rec.dstIP = remote;
+				rec.srcPort = localPort;
+				rec.dstPort = 80;
+			} else {
+				rec.srcIP = remote;
+				rec.dstIP = local;
+				rec.srcPort = 80;
+				rec.dstPort = localPort;
+			}
+			rec.prot = IPPROTO_TCP;
+			rec.startMs = rec.endMs = baseMs + 10 * p;
+			rec.dOctets = 40 + (f % 1400);
+			rec.dPkts = 1;
+			packets.push_back(rec);
+		}
+	}
+
+	cout << "assembler: " << opts.flows << " flows x " << opts.packets << " packets, " << opts.threads << " thread(s)" << endl;
+	double best = 0;
+	CFlowAssembler::stats_t stats;
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		CFlowList flowlist;
+		double start = now();
+		CFlowAssembler assembler(flowlist, local_net, netmask, opts.threads);
+		for (vector<CFlowAssembler::record_t>::const_iterator it = packets.begin(); it != packets.end(); ++it)
+			assembler.add_record(*it);
+		assembler.flush();
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best) {
+			best = elapsed;
+			stats = assembler.get_stats();
+		}
+	}
+	print_rate("packets", stats.packets, best);
+	print_rate("flows", stats.flows, best);
+}
+
+/**
+ *	Benchmark role inference (CImport::cflow2hpg): builds a sorted flow list of local hosts acting as
+ *	servers, clients and peers and creates the graphlet of every host. Reports flows/s and hosts/s.
+ *
+ *	\param opts Benchmark parameters
+ *
+ *	\exception std::string Errortext
+ */
+static void bench_roles(const bench_options_t & opts) {
+	unsigned int hosts = opts.hosts > 0 ? opts.hosts : 1;
+	unsigned int per_host = opts.host_flows > 0 ? opts.host_flows : 1;
+	uint64_t baseMs = 1300000000000ULL;
+
+	CFlowList flowlist;
+	flowlist.reserve((size_t) hosts * per_host);
+	for (unsigned int h = 0; h < hosts; h++) {
+		IPv6_addr local(0x0a000000 + h);
+		for (unsigned int f = 0; f < per_host; f++) {
+			IPv6_addr remote(0xc0000000 + (f * 7919) % 4096); // remotes shared by several roles
+			switch (f % 3) {
+				case 0: // local web server
+					flowlist.push_back(cflow_t(local, 80, remote, 1024 + f % 60000, IPPROTO_TCP, biflow, baseMs + f, 100, 1500, 4));
+					break;
+				case 1: // local client of few services
+					flowlist.push_back(cflow_t(local, 1024 + f % 60000, remote, (f % 2) ? 443 : 53, (f % 2) ? IPPROTO_TCP : IPPROTO_UDP, biflow, baseMs + f,
+					      50, 800, 2));
+					break;
+				default: // peer to peer
+					flowlist.push_back(cflow_t(local, 6881 + f % 5, remote, 20000 + f % 40000, IPPROTO_UDP, (f % 6 == 2) ? outflow : biflow, baseMs + f,
+					      10, 200, 1));
+					break;
+			}
+		}
+	}
+	sort(flowlist.begin(), flowlist.end());
+
+	prefs_t prefs;
+	string hpg_filename = "/tmp/hapbench_roles.hpg";
+	cout << "roles: " << hosts << " hosts x " << per_host << " flows (sizeof(cflow_t) = " << sizeof(cflow_t) << ")" << endl;
+	double best = 0;
+	ofstream devnull("/dev/null");
+	streambuf * coutbuf = cout.rdbuf(devnull.rdbuf()); // graphlet creation is chatty
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		CImport import(flowlist, prefs);
+		import.set_hpg_filename(hpg_filename);
+		double start = now();
+		for (unsigned int h = 0; h < hosts; h++) {
+			import.set_localIP(IPv6_addr(), -1); // search in full flow list
+			if (!import.set_localIP(IPv6_addr(0x0a000000 + h), 1)) {
+				cout.rdbuf(coutbuf);
+				throw string("host missing in flow list");
+			}
+			import.cflow2hpg();
+		}
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best)
+			best = elapsed;
+	}
+	cout.rdbuf(coutbuf);
+	unlink(hpg_filename.c_str());
+	print_rate("flows", flowlist.size(), best);
+	print_rate("hosts", hosts, best);
+}
+
+/**
+ *	Benchmark IPv6_addr: sorting, comparison, masking (local network test), IPv4 test and hashing
+ *	of a mix of IPv4 (75 %) and IPv6 addresses. Reports operations/s of each.
+ *
+ *	\param opts Benchmark parameters
+ */
+static void bench_ipaddr(const bench_options_t & opts) {
+	unsigned int count = opts.flows > 1 ? opts.flows : 2;
+	const unsigned int passes = 50;
+	IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+	IPv6_addr netmask(IPv6_addr::getNetmask(104));
+
+	vector<IPv6_addr> addrs;
+	addrs.reserve(count);
+	uint32_t seed = 12345;
+	for (unsigned int i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		if (i % 4 != 3) {
+			addrs.push_back(IPv6_addr(((i % 2) ? 0x0a000000 : 0xc0000000) + (seed >> 8)));
+		} else {
+			IPv6_addr addr(string("2001:db8::"));
+			for (int b = 8; b < 16; b++)
+				addr[b] = (seed >> b) & 0xff;
+			addrs.push_back(addr);
+		}
+	}
+
+	cout << "ipaddr: " << count << " addresses, " << passes << " passes" << endl;
+	double best_sort = 0, best_cmp = 0, best_mask = 0, best_v4 = 0, best_hash = 0;
+	uint64_t sink = 0;
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		vector<IPv6_addr> sorted(addrs);
+		double start = now();
+		sort(sorted.begin(), sorted.end());
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best_sort)
+			best_sort = elapsed;
+
+		start = now();
+		for (unsigned int p = 0; p < passes; p++)
+			for (unsigned int i = 1; i < count; i++)
+				sink += (addrs[i - 1] < addrs[i]) + (addrs[i - 1] == addrs[i]);
+		elapsed = now() - start;
+		if (r == 0 || elapsed < best_cmp)
+			best_cmp = elapsed;
+
+		start = now();
+		for (unsigned int p = 0; p < passes; p++)
+			for (unsigned int i = 0; i < count; i++)
+				sink += (addrs[i] & netmask) == local_net;
+		elapsed = now() - start;
+		if (r == 0 || elapsed < best_mask)
+			best_mask = elapsed;
+
+		start = now();
+		for (unsigned int p = 0; p < passes; p++)
+			for (unsigned int i = 0; i < count; i++)
+				sink += addrs[i].isIPv4();
+		elapsed = now() - start;
+		if (r == 0 || elapsed < best_v4)
+			best_v4 = elapsed;
+
+		start = now();
+		for (unsigned int p = 0; p < passes; p++)
+			for (unsigned int i = 0; i < count; i++)
+				sink += addrs[i].get24bitHash();
+		elapsed = now() - start;
+		if (r == 0 || elapsed < best_hash)
+			best_hash = elapsed;
+	}
+	print_rate("sorted", count, best_sort);
+	print_rate("compares", 2 * (uint64_t) passes * (count - 1), best_cmp);
+	print_rate("masks", (uint64_t) passes * count, best_mask);
+	print_rate("IPv4 tests", (uint64_t) passes * count, best_v4);
+	print_rate("hashes", (uint64_t) passes * count, best_hash);
+	if (sink == 0)
+		cout << endl; // keeps the loops from being optimized away
+}
+
+/**
+ *	Benchmark CLocalNets: classifies a mix of IPv4 (75 %) and IPv6 addresses against 64 random local prefixes
+ *	(48 IPv4 prefixes of /8 to /28, 16 IPv6 prefixes of /32 to /64). Reports lookups/s of single and
+ *	batch lookups.
+ *
+ *	\param opts Benchmark parameters
+ */
+static void bench_localnets(const bench_options_t & opts) {
+	unsigned int count = opts.flows > 0 ? opts.flows : 1;
+	const unsigned int passes = 50;
+
+	CLocalNets local_nets;
+	uint32_t seed = 4711;
+	for (unsigned int i = 0; i < 64; i++) {
+		seed = seed * 1103515245 + 12345;
+		if (i < 48) {
+			local_nets.add(IPv6_addr(seed), 96 + 8 + i % 21);
+		} else {
+			IPv6_addr net(string("2001:db8::"));
+			net[4] = seed >> 24;
+			net[5] = seed >> 16;
+			local_nets.add(net, 32 + (i % 5) * 8);
+		}
+	}
+
+	vector<IPv6_addr> addrs;
+	addrs.reserve(count);
+	for (unsigned int i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		if (i % 4 != 3) {
+			// Every other address inside a local prefix
+			const CLocalNets::prefix_t & prefix = local_nets.get_prefix(seed % 48);
+			IPv6_addr addr(seed);
+			if (i % 2)
+				for (unsigned int b = 12; b < prefix.length / 8; b++)
+					addr[b] = prefix.net[b];
+			addrs.push_back(addr);
+		} else {
+			IPv6_addr addr(local_nets.get_prefix(48 + seed % 16).net);
+			for (int b = 8; b < 16; b++)
+				addr[b] = (seed >> b) & 0xff;
+			addrs.push_back(addr);
+		}
+	}
+	vector<int> matches(count);
+
+	cout << "localnets: " << count << " addresses, " << local_nets.size() << " prefixes, " << passes << " passes" << endl;
+	double best_single = 0, best_batch = 0;
+	uint64_t sink = 0;
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		double start = now();
+		for (unsigned int p = 0; p < passes; p++)
+			for (unsigned int i = 0; i < count; i++)
+				sink += local_nets.is_local(addrs[i]);
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best_single)
+			best_single = elapsed;
+
+		start = now();
+		for (unsigned int p = 0; p < passes; p++) {
+			local_nets.lookup(&addrs[0], count, &matches[0]);
+			sink += matches[p % count];
+		}
+		elapsed = now() - start;
+		if (r == 0 || elapsed < best_batch)
+			best_batch = elapsed;
+	}
+	uint64_t local = 0;
+	for (unsigned int i = 0; i < count; i++)
+		local += matches[i] != CLocalNets::no_match;
+	cout << "  " << local << " of " << count << " addresses are local" << endl;
+	print_rate("lookups", (uint64_t) passes * count, best_single);
+	print_rate("batch lookups", (uint64_t) passes * count, best_batch);
+	if (sink == 0)
+		cout << endl; // keeps the loops from being optimized away
+}
+
+/**
+ *	Benchmark CFlowExpression: evaluates a filter expression over a synthetic flow list of 75 % TCP,
+ *	random ports, addresses and byte counts. Reports flows/s of the compilation into the columnar view and of
+ *	the batch evaluation.
+ *
+ *	\param opts Benchmark parameters
+ *
+ *	\exception std::string Errortext (invalid expression)
+ */
+static void bench_filter(const bench_options_t & opts) {
+	unsigned int count = opts.flows > 0 ? opts.flows : 1;
+	const unsigned int passes = 20;
+	CFlowExpression expression(opts.expression);
+
+	CFlowList flows;
+	flows.reserve(count);
+	uint32_t seed = 815;
+	for (unsigned int i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		IPv6_addr localIP(((i % 2) ? 0x0a000000 : 0xc0a80000) + (seed >> 20));
+		IPv6_addr remoteIP(0x50000000 + (seed >> 4));
+		uint16_t remotePort = (seed % 4 == 0) ? 443 : (seed >> 16);
+		uint8_t prot = (seed % 4 != 3) ? IPPROTO_TCP : IPPROTO_UDP;
+		uint8_t flowtype = (i % 3 == 0) ? biflow : ((i % 3 == 1) ? outflow : inflow);
+		flows.push_back(cflow_t(localIP, seed >> 8, remoteIP, remotePort, prot, flowtype, i, 10, (seed >> 4) % 4000000, 1 + seed % 100));
+	}
+
+	cout << "filter: " << count << " flows, \"" << opts.expression << "\", " << passes << " passes" << endl;
+	cout << "  program: " << expression.toString() << endl;
+	double best_columns = 0, best_eval = 0;
+	uint64_t matches = 0;
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		double start = now();
+		CFlowColumns columns(flows.begin(), flows.end());
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best_columns)
+			best_columns = elapsed;
+
+		vector<uint64_t> mask;
+		start = now();
+		for (unsigned int p = 0; p < passes; p++)
+			expression.evaluate(columns, mask);
+		elapsed = now() - start;
+		if (r == 0 || elapsed < best_eval)
+			best_eval = elapsed;
+
+		matches = 0;
+		for (size_t i = 0; i < count; i++)
+			matches += CFlowExpression::test(mask, i);
+	}
+	cout << "  " << matches << " of " << count << " flows match" << endl;
+	print_rate("flows (columns)", count, best_columns);
+	print_rate("flows (evaluated)", (uint64_t) passes * count, best_eval);
+}
+
+/**
+ *	Benchmark dataset snapshots: writes random flows to a cflow file, imports it (without sidecar index) and saves
+ *	a snapshot of the import, then reports the time of the import and of resuming from the snapshot.
+ *
+ *	\param opts Benchmark parameters
+ *
+ *	\exception std::string Errortext
+ */
+static void bench_snapshot(const bench_options_t & opts) {
+	unsigned int count = opts.flows > 0 ? opts.flows : 1;
+	CFlowList flows;
+	flows.reserve(count);
+	uint32_t seed = 4711;
+	for (unsigned int i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		IPv6_addr localIP(0x0a000000 + (seed >> 8) % (opts.hosts > 0 ? opts.hosts : 1));
+		IPv6_addr remoteIP(0x50000000 + (seed >> 12));
+		uint8_t flowtype = (i % 3 == 0) ? biflow : ((i % 3 == 1) ? outflow : inflow);
+		flows.push_back(cflow_t(localIP, seed >> 16, remoteIP, 80, IPPROTO_TCP, flowtype, i, 10, (seed >> 4) % 4000000, 1 + seed % 100));
+	}
+
+	const char * env = getenv("TMPDIR");
+	string dir = (env != NULL && *env != '\0') ? env : "/tmp";
+	string flow_filename = dir + "/hapbench_snapshot.gz";
+	string snapshot_filename = dir + "/hapbench_snapshot.hsnap";
+	prefs_t prefs;
+	{
+		CImport writer(flows, prefs);
+		writer.write_file(flow_filename, flows, false);
+	}
+	CFlowList().swap(flows);
+
+	cout << "snapshot: " << count << " flows" << endl;
+	double best_import = 0, best_load = 0;
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		double start = now();
+		{
+			CImport import(flow_filename, "", prefs);
+			import.set_use_index(false);
+			import.read_file();
+			import.get_hostMetadata();
+			double elapsed = now() - start;
+			if (r == 0 || elapsed < best_import)
+				best_import = elapsed;
+			if (r == 0)
+				import.save_snapshot(snapshot_filename);
+		}
+
+		start = now();
+		CImport resumed(CFlowList(), prefs);
+		resumed.load_snapshot(snapshot_filename);
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best_load)
+			best_load = elapsed;
+	}
+	unlink(flow_filename.c_str());
+	unlink(snapshot_filename.c_str());
+	print_rate("flows (import)", count, best_import);
+	print_rate("flows (snapshot)", count, best_load);
+}
+
+#ifdef HAPBENCH_ARGUS
+/**
+ *	Benchmark GFilter_argus: imports an argus file with the native decoder and through ra
+ *	(if available) and reports flows/s of both.
+ *
+ *	\param opts Benchmark parameters
+ *
+ *	\exception std::string Errortext
+ */
+static void bench_argus(const bench_options_t & opts) {
+	IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+	IPv6_addr netmask(IPv6_addr::getNetmask(104));
+	GFilter_argus filter;
+
+	cout << "argus: " << opts.input << endl;
+	if (!GFilter_argus::is_native_file(opts.input))
+		throw opts.input + " is not an uncompressed Argus 3 file";
+
+	double best = 0;
+	size_t flows = 0;
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		CFlowList flowlist;
+		double start = now();
+		filter.read_file_native(opts.input, flowlist, CLocalNets(local_net, netmask));
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best)
+			best = elapsed;
+		flows = flowlist.size();
+	}
+	cout << " native:" << endl;
+	print_rate("flows", flows, best);
+
+	if (!GFilter_argus::is_ra_available()) {
+		cout << " ra: not available" << endl;
+		return;
+	}
+	for (unsigned int r = 0; r < opts.repeat; r++) {
+		CFlowList flowlist;
+		double start = now();
+		filter.read_file_ra(opts.input, flowlist, CLocalNets(local_net, netmask));
+		double elapsed = now() - start;
+		if (r == 0 || elapsed < best)
+			best = elapsed;
+		flows = flowlist.size();
+	}
+	cout << " ra:" << endl;
+	print_rate("flows", flows, best);
+}
+#endif
+
+int main(int argc, char * argv[]) {
+	// 1. Process command line
+	// ***********************
+	boost::program_options::variables_map variablesMap;
+	boost::program_options::options_description desc("Allowed options");
+
+	bench_options_t opts;
+	string bench;
+
+	try {
+		desc.add_options()
+				("bench,b", boost::program_options::value<string>(&bench)->default_value("all"), "Benchmark to run (all, assembler, roles, ipaddr, localnets, filter, snapshot, argus)")
+				("flows,f", boost::program_options::value<unsigned int>(&opts.flows)->default_value(100000), "Number of distinct flows (addresses for ipaddr, localnets)")
+				("packets,p", boost::program_options::value<unsigned int>(&opts.packets)->default_value(10), "Packets per flow")
+				("threads,t", boost::program_options::value<unsigned int>(&opts.threads)->default_value(CFlowAssembler::get_default_threads()), "Worker threads")
+				("hosts", boost::program_options::value<unsigned int>(&opts.hosts)->default_value(20), "Number of local hosts (roles)")
+				("host-flows", boost::program_options::value<unsigned int>(&opts.host_flows)->default_value(1000), "Flows per local host (roles)")
+				("repeat,r", boost::program_options::value<unsigned int>(&opts.repeat)->default_value(3), "Number of runs, the best one is reported")
+				("input,i", boost::program_options::value<string>(&opts.input), "Input file for file based benchmarks (argus)")
+				("expr,e", boost::program_options::value<string>(&opts.expression)->default_value("proto tcp and dst port 443 and bytes > 1M and not net 10.0.0.0/8"), "Filter expression (filter)")
+				("help,h", "show this help message");
+
+		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), variablesMap);
+		boost::program_options::notify(variablesMap);
+	} catch (std::exception & e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	if (variablesMap.count("help")) {
+		cerr << desc;
+		exit(0);
+	}
+	if (opts.repeat == 0)
+		opts.repeat = 1;
+
+	// 2. Run benchmarks
+	// *****************
+	bool found = false;
+	try {
+		if (bench == "all" || bench == "assembler") {
+			bench_assembler(opts);
+			found = true;
+		}
+		if (bench == "all" || bench == "roles") {
+			bench_roles(opts);
+			found = true;
+		}
+		if (bench == "all" || bench == "ipaddr") {
+			bench_ipaddr(opts);
+			found = true;
+		}
+		if (bench == "all" || bench == "localnets") {
+			bench_localnets(opts);
+			found = true;
+		}
+		if (bench == "all" || bench == "filter") {
+			bench_filter(opts);
+			found = true;
+		}
+		if (bench == "all" || bench == "snapshot") {
+			bench_snapshot(opts);
+			found = true;
+		}
+#ifdef HAPBENCH_ARGUS
+		if (bench == "argus" || (bench == "all" && !opts.input.empty())) {
+			if (opts.input.empty())
+				throw string("argus benchmark requires an input file (--input)");
+			bench_argus(opts);
+			found = true;
+		}
+#endif
+	} catch (string & e) {
+		cerr << "ERROR: " << e << endl;
+		exit(1);
+	}
+
+	if (!found) {
+		cerr << "Unknown benchmark: " << bench << endl << desc;
+		exit(1);
+	}
+	return 0;
+}
@@ -0,0 +1,206 @@
+/**
+ *	\file hapcollect.cpp
+ *	\brief Live NetFlow v9/IPFIX collector printing the host list and writing graphlets as flows arrive.
+ *
+ *	With --replay the tool acts as test sender instead: it sends each IPFIX message of a file as UDP
+ *	datagram to a running collector.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <boost/program_options.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <stdint.h>
+
+#include "IPv6_addr.h"
+#include "global.h"
+#include "gcollector.h"
+#include "gexportdecoder.h"
+#include "gmappedfile.h"
+#include "ghpgdata.h"
+#include "HAPviewer.h"
+
+using namespace std;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/**
+ *	Signal handler for SIGINT/SIGTERM
+ */
+static void request_stop(int) {
+	stop_requested = 1;
+}
+
+/**
+ *	Print the host list of a snapshot and convert the graphlet of the selected host to dot.
+ *
+ *	\param snapshot Collector state
+ *	\param dot_filename Dot output file (empty: no conversion)
+ */
+static void print_snapshot(const CCollector::snapshot_t & snapshot, const string & dot_filename) {
+	cout << "*** " << snapshot.stats.datagrams << " datagrams, " << snapshot.stats.records << " records (" << snapshot.stats.dropped_records
+	      << " dropped), " << snapshot.stats.flows << " flows, " << snapshot.stats.hosts << " hosts" << endl;
+	for (vector<ChostMetadata>::const_iterator it = snapshot.hosts.begin(); it != snapshot.hosts.end(); ++it)
+		cout << "  " << setw(40) << left << it->IP.toString() << right << " flows: " << setw(8) << it->flow_count << " uniflows: " << setw(8)
+		      << it->uniflow_count << " bytes: " << it->bytesForAllFlows << endl;
+
+	if (snapshot.graphlet_ready) {
+		cout << "  graphlet of " << snapshot.selected_host << " written to " << snapshot.hpg_filename << endl;
+		if (!dot_filename.empty()) {
+			try {
+				ChpgData hpgData(snapshot.hpg_filename);
+				hpgData.read_hpg_file();
+				string outfile = dot_filename;
+				hpgData.hpg2dot(0, outfile);
+			} catch (string & e) {
+				cerr << "ERROR: " << e << endl;
+			}
+		}
+	}
+}
+
+/**
+ *	Send all IPFIX messages of a file as UDP datagrams.
+ *
+ *	\param filename IPFIX file
+ *	\param target Collector address as host:port
+ *	\param rate Messages per second (0: as fast as possible)
+ *
+ *	\exception std::string Errortext
+ */
+static void replay(const string & filename, const string & target, unsigned int rate) {
+	size_t colon = target.rfind(':');
+	if (colon == string::npos)
+		throw "Target has to be given as host:port: " + target;
+	string host = target.substr(0, colon);
+	string service = target.substr(colon + 1);
+	if (host.size() >= 2 && host[0] == '[' && host[host.size() - 1] == ']')
+		host = host.substr(1, host.size() - 2);
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	struct addrinfo * res;
+	int rc = getaddrinfo(host.c_str(), service.c_str(), &hints, &res);
+	if (rc != 0)
+		throw "Could not resolve " + target + ": " + gai_strerror(rc);
+	int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	if (sock < 0) {
+		freeaddrinfo(res);
+		throw string("Could not create UDP socket: ") + strerror(errno);
+	}
+
+	CMappedFile file(filename);
+	const uint8_t * data = file.data();
+	size_t size = file.size();
+	size_t pos = 0;
+	uint64_t messages = 0;
+	while (pos + CExportDecoder::ipfix_header_length <= size && !stop_requested) {
+		size_t length = (data[pos + 2] << 8) | data[pos + 3];
+		if (CExportDecoder::get_version(data + pos, size - pos) != CExportDecoder::ipfix_version || length < CExportDecoder::ipfix_header_length
+		      || length > size - pos) {
+			cerr << "WARNING: " << filename << " is truncated or corrupt at offset " << pos << ".\n";
+			break;
+		}
+		if (sendto(sock, data + pos, length, 0, res->ai_addr, res->ai_addrlen) < 0)
+			cerr << "WARNING: send failed: " << strerror(errno) << endl;
+		messages++;
+		pos += length;
+		if (rate > 0)
+			boost::this_thread::sleep(boost::posix_time::microseconds(1000000 / rate));
+	}
+	freeaddrinfo(res);
+	close(sock);
+	cout << "*** Sent " << messages << " messages to " << target << endl;
+}
+
+int main(int argc, char * argv[]) {
+	// 1. Process command line
+	// ***********************
+	boost::program_options::variables_map variablesMap;
+	boost::program_options::options_description desc("Allowed options");
+
+	unsigned int port, interval, window, rate;
+	string localnet_str, localnets_filename, host_str, hpg_filename, dot_filename, replay_filename, target;
+	int prefix;
+
+	try {
+		desc.add_options()
+				("port,p", boost::program_options::value<unsigned int>(&port)->default_value(4739), "UDP port to listen on")
+				("localnet,l", boost::program_options::value<string>(&localnet_str)->default_value("0.0.0.0"), "Local network address")
+				("prefix,n", boost::program_options::value<int>(&prefix)->default_value(0), "Local network prefix length")
+				("localnets,L", boost::program_options::value<string>(&localnets_filename), "File listing the local network prefixes (one per line, e.g. 10.0.0.0/8), replaces --localnet/--prefix")
+				("interval,i", boost::program_options::value<unsigned int>(&interval)->default_value(CCollector::default_interval), "Seconds between updates")
+				("window,w", boost::program_options::value<unsigned int>(&window)->default_value(CCollector::default_window), "Only keep flows of the last seconds (0: keep all, memory grows without bound)")
+				("host,s", boost::program_options::value<string>(&host_str), "Local host whose graphlet is written with each update")
+				("hpg,g", boost::program_options::value<string>(&hpg_filename)->default_value(default_hpg_filename), "Graphlet output file")
+				("dot,d", boost::program_options::value<string>(&dot_filename), "Also convert the graphlet to this dot file")
+				("replay,r", boost::program_options::value<string>(&replay_filename), "Send the messages of this IPFIX file instead of collecting")
+				("target,t", boost::program_options::value<string>(&target)->default_value("127.0.0.1:4739"), "Collector address for --replay (host:port)")
+				("rate", boost::program_options::value<unsigned int>(&rate)->default_value(0), "Messages per second for --replay (0: unlimited)")
+				("help,h", "show this help message");
+
+		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), variablesMap);
+		boost::program_options::notify(variablesMap);
+	} catch (std::exception & e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	if (variablesMap.count("help")) {
+		cerr << desc;
+		exit(0);
+	}
+
+	signal(SIGINT, request_stop);
+	signal(SIGTERM, request_stop);
+
+	try {
+		if (variablesMap.count("replay")) {
+			replay(replay_filename, target, rate);
+			return 0;
+		}
+
+		// 2. Run collector until interrupted
+		// **********************************
+		CLocalNets local_nets;
+		if (variablesMap.count("localnets")) {
+			local_nets.load(localnets_filename);
+		} else {
+			IPv6_addr local_net(localnet_str);
+			int max_prefix = local_net.isIPv4() ? 32 : 128;
+			if (prefix < 0 || prefix > max_prefix) {
+				cerr << "Error: invalid prefix length " << prefix << endl;
+				exit(1);
+			}
+			local_nets.add(local_net, local_net.isIPv4() ? 96 + prefix : prefix);
+		}
+
+		prefs_t prefs;
+		CCollector collector(port, local_nets, prefs, interval);
+		collector.set_window(window);
+		collector.set_hpg_filename(hpg_filename);
+		if (variablesMap.count("host"))
+			collector.select_host(IPv6_addr(host_str));
+		collector.set_update_callback(boost::bind(&print_snapshot, _1, dot_filename));
+
+		cout << "*** Listening on UDP port " << collector.get_port() << " (local networks " << local_nets.toString() << ")" << endl;
+		collector.start();
+		while (!stop_requested)
+			boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+		collector.stop();
+	} catch (string & e) {
+		cerr << "ERROR: " << e << endl;
+		return 1;
+	}
+	return 0;
+}
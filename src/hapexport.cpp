@@ -0,0 +1,241 @@
+/**
+ *	\file hapexport.cpp
+ *	\brief Headless bulk export of all graphlets of an hpg file to dot, JSON or svg files, on all cores.
+ *
+ *	svg images are drawn by CSvgSink, without Graphviz. Other image formats, and svg with --graphviz, are
+ *	rendered by Graphviz when hapexport is built with it, in a worker process per export thread.
+ */
+
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#ifdef HAPEXPORT_GVC
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <boost/bind.hpp>
+#include <gvc.h>
+#endif
+
+#include "ghpgdata.h"
+#include "ggraphletexport.h"
+
+using namespace std;
+
+#ifdef HAPEXPORT_GVC
+/**
+ *	Send a buffer completely (without SIGPIPE if the peer is gone).
+ *
+ *	\return True if sent
+ */
+static bool send_all(int fd, const void * data, size_t length) {
+	const char * p = (const char *) data;
+	while (length > 0) {
+		ssize_t n = send(fd, p, length, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		length -= n;
+	}
+	return true;
+}
+
+/**
+ *	Receive a buffer completely.
+ *
+ *	\return True if received, false on end of file or error
+ */
+static bool recv_all(int fd, void * data, size_t length) {
+	char * p = (char *) data;
+	while (length > 0) {
+		ssize_t n = recv(fd, p, length, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		length -= n;
+	}
+	return true;
+}
+
+/**
+ *	\class	CGvcRenderer
+ *	\brief	Renders graphlets with Graphviz in a worker process per export thread.
+ *
+ *	The graph parser and the layout of Graphviz keep global state and cannot run on several threads of a process.
+ *	Each renderer forks a worker process with its own Graphviz context, so the export threads render in parallel.
+ *	CGraphletExport creates all renderers before it starts the export threads, so fork() is called while the
+ *	process has a single thread.
+ *	A request is the lengths of file name and dot graph (two uint32_t) followed by both, the reply is a status byte.
+ */
+class CGvcRenderer: public CDotRenderer {
+	public:
+		CGvcRenderer(const string & format) :
+			format(format) {
+			int fds[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+				throw string("could not create a socket pair for a Graphviz worker: ") + strerror(errno);
+			worker = fork();
+			if (worker == -1) {
+				close(fds[0]);
+				close(fds[1]);
+				throw string("could not start a Graphviz worker: ") + strerror(errno);
+			}
+			if (worker == 0) {
+				// Keep no descriptors of other workers open: their renderers wait for them to see end of file
+				for (int fd = 3, max_fd = sysconf(_SC_OPEN_MAX); fd < max_fd; fd++)
+					if (fd != fds[1])
+						close(fd);
+				_exit(serve(fds[1]));
+			}
+			close(fds[1]);
+			sock = fds[0];
+		}
+
+		~CGvcRenderer() {
+			close(sock); // The worker exits on end of file
+			waitpid(worker, NULL, 0);
+		}
+
+		static CDotRenderer * create(const string & format) {
+			return new CGvcRenderer(format);
+		}
+
+		void render(const string & dot, const string & filename) {
+			uint32_t lengths[2] = { (uint32_t) filename.size(), (uint32_t) dot.size() };
+			char status;
+			if (!send_all(sock, lengths, sizeof(lengths)) || !send_all(sock, filename.data(), filename.size()) || !send_all(sock, dot.data(), dot.size())
+			      || !recv_all(sock, &status, 1))
+				throw "Graphviz worker terminated while rendering " + filename;
+			if (status == not_a_graph)
+				throw "not a useable dot graph for " + filename;
+			if (status == render_failed)
+				throw "could not render " + filename;
+		}
+
+	private:
+		enum status_t {
+			rendered, not_a_graph, render_failed
+		};
+
+		/**
+		 *	Worker process: render requests until the renderer closes the socket.
+		 *
+		 *	\param fd Socket to the renderer
+		 *
+		 *	\return Exit code
+		 */
+		int serve(int fd) {
+			GVC_t * gvc = gvContext();
+			if (gvc == NULL)
+				return 1;
+			uint32_t lengths[2];
+			while (recv_all(fd, lengths, sizeof(lengths))) {
+				string filename(lengths[0], '\0');
+				vector<char> dot(lengths[1] + 1, '\0');
+				if ((lengths[0] > 0 && !recv_all(fd, &filename[0], lengths[0])) || (lengths[1] > 0 && !recv_all(fd, &dot[0], lengths[1])))
+					break;
+				char status = not_a_graph;
+				graph_t * g = agmemread(&dot[0]);
+				if (g != NULL) {
+					gvLayout(gvc, g, (char *) "dot");
+					int ret = gvRenderFilename(gvc, g, (char *) format.c_str(), (char *) filename.c_str());
+					gvFreeLayout(gvc, g);
+					agclose(g);
+					status = (ret == -1) ? render_failed : rendered;
+				}
+				if (!send_all(fd, &status, 1))
+					break;
+			}
+			gvFreeContext(gvc);
+			return 0;
+		}
+
+		string format; ///< Graphviz output format
+		int sock; ///< Socket to the worker process
+		pid_t worker; ///< Worker process
+};
+#endif
+
+int main(int argc, char * argv[]) {
+	// 1. Process command line
+	// ***********************
+	boost::program_options::variables_map variablesMap;
+	boost::program_options::options_description desc("Allowed options");
+
+	string hpg_filename, out_dir, format_str;
+	unsigned int threads, first, last;
+
+	try {
+		desc.add_options()
+				("input,i", boost::program_options::value<string>(&hpg_filename), "hpg file (version 3 or 4)")
+				("out-dir,o", boost::program_options::value<string>(&out_dir)->default_value("."), "Existing directory receiving one file per graphlet")
+				("format,f", boost::program_options::value<string>(&format_str)->default_value("dot"), "Output format: dot, json, svg or an image format of Graphviz (e.g. png)")
+				("graphviz,g", "render svg with Graphviz instead of drawing it directly")
+				("threads,t", boost::program_options::value<unsigned int>(&threads)->default_value(0), "Export threads (0: one per core)")
+				("first", boost::program_options::value<unsigned int>(&first)->default_value(0), "Position of the first graphlet to export")
+				("last", boost::program_options::value<unsigned int>(&last)->default_value(UINT_MAX), "Position of the last graphlet to export")
+				("quiet,q", "do not show the progress")
+				("help,h", "show this help message");
+
+		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), variablesMap);
+		boost::program_options::notify(variablesMap);
+	} catch (std::exception & e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	if (variablesMap.count("help") || !variablesMap.count("input")) {
+		cerr << desc;
+		exit(variablesMap.count("help") ? 0 : 1);
+	}
+
+	// 2. Export the graphlets
+	// ***********************
+	try {
+		CGraphletExport::format_t format = CGraphletExport::image_format;
+		if (format_str == "dot")
+			format = CGraphletExport::dot_format;
+		else if (format_str == "json")
+			format = CGraphletExport::json_format;
+		else if (format_str == "svg" && !variablesMap.count("graphviz"))
+			format = CGraphletExport::svg_format;
+#ifndef HAPEXPORT_GVC
+		else
+			throw "format " + format_str + " needs Graphviz, hapexport was built without it";
+#endif
+
+		ChpgData hpgData(hpg_filename);
+		hpgData.read_hpg_file();
+		hpgData.get_hpgMetadata();
+
+		CGraphletExport exporter(hpgData, out_dir, format, format_str);
+		exporter.set_threads(threads);
+#ifdef HAPEXPORT_GVC
+		exporter.set_renderer(boost::bind(&CGvcRenderer::create, format_str));
+#endif
+		if (!variablesMap.count("quiet"))
+			exporter.set_progress(&cerr);
+
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		exporter.export_graphlets(first, last);
+		double seconds = (boost::posix_time::microsec_clock::universal_time() - start).total_milliseconds() / 1000.0;
+		cout << "*** Exported " << exporter.get_done() << " graphlets (" << exporter.get_failed() << " failed) in " << seconds << " s" << endl;
+		if (exporter.get_failed() != 0)
+			return 2;
+	} catch (string & e) {
+		cerr << "ERROR: " << e << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <set>
+#include <vector>
 #include <boost/program_options.hpp>
 #include <stdint.h>
 
@@ -59,6 +60,28 @@ int main(int argc, char * argv[]) {
 				("sump2proles", "Summarize peer 2 peer roles")
 				("summulticlientroles", "Summarize multiclient roles (default: summarize all roles)")
 
+				("import-prot", boost::program_options::value<string>(), "Import only flows of these protocols (e.g. tcp,udp,47)")
+				("import-net", boost::program_options::value<vector<string> >(), "Import only flows of local hosts within this prefix (repeatable)")
+				("import-ports", boost::program_options::value<string>(), "Import only flows with a port in this list (e.g. 53,80,8000-8080)")
+				("import-from", boost::program_options::value<uint64_t>(), "Import only flows ending after this time (ms since the epoch)")
+				("import-to", boost::program_options::value<uint64_t>(), "Import only flows starting before this time (ms since the epoch)")
+
+				("filter", boost::program_options::value<string>(), "Filter flows not matching this expression (e.g. \"proto tcp and dst port 443 and bytes > 1M and not net 10.0.0.0/8\")")
+
+				("no-index", "Neither load nor write the sidecar index (.hidx) of the input file")
+				("write-index", "Write the sidecar index (.hidx) of the input file for later runs")
+				("save-snapshot", boost::program_options::value<string>(), "Save the imported data set to this snapshot file (*.hsnap) instead of a dot file (no ip needed); snapshots are accepted as input file")
+
+				("hpg-db", boost::program_options::value<string>(), "Write the graphlets of all hosts to this hpg file instead of a dot file (out-of-core, no ip needed)")
+				("memory", boost::program_options::value<uint64_t>()->default_value(1024), "Memory budget in MB for sorting flows (--hpg-db)")
+				("hpg-version", boost::program_options::value<unsigned int>()->default_value(3), "Format of the --hpg-db file: 3, or 4 (compact, with graphlet directory)")
+				("tmp-dir", boost::program_options::value<string>(), "Directory for temporary sorted runs (--hpg-db, default: $TMPDIR or /tmp)")
+				("local-net", boost::program_options::value<vector<string> >(), "Local network prefix for formats without flow directions (repeatable, default: every address is local)")
+
+				("batch", boost::program_options::value<vector<string> >(), "Write the graphlets of all hosts with this IP or within this prefix to --out-dir instead of a single dot file (repeatable, no ip needed)")
+				("out-dir", boost::program_options::value<string>()->default_value("."), "Directory for the <IP>.dot files of --batch")
+				("threads", boost::program_options::value<unsigned int>()->default_value(0), "Threads building the graphlets of --batch (0: one per processor core)")
+
 				("help,h", "show this help message")
 			;
 
@@ -85,12 +108,13 @@ int main(int argc, char * argv[]) {
 		exit(1);
 	}
 
-	if (!variablesMap.count("ip")) {
+	if (!variablesMap.count("ip") && !variablesMap.count("hpg-db") && !variablesMap.count("save-snapshot") && !variablesMap.count("batch")) {
 		cerr << desc;
 		exit(1);
 	}
 
-	IP_str = variablesMap["ip"].as<string>();
+	if (variablesMap.count("ip"))
+		IP_str = variablesMap["ip"].as<string>();
 	string in_filename = variablesMap["inputfile"].as<string>();
 	filter_up_to_rolenum = variablesMap["rolenum"].as<unsigned int>();
 
@@ -171,7 +195,84 @@ int main(int argc, char * argv[]) {
 	for(unsigned int i = 0; i < filter_up_to_rolenum; i++)
 			role_nums.insert(i);
 
-	bool ok = libif.get_graphlet(in_filename, outfilename, IP_str, sum_flags, filters, role_nums);
+	try {
+		CFlowPredicate predicate;
+		if (variablesMap.count("import-prot"))
+			predicate.add_protocols(variablesMap["import-prot"].as<string>());
+		if (variablesMap.count("import-net")) {
+			const vector<string> & nets = variablesMap["import-net"].as<vector<string> >();
+			for (vector<string>::const_iterator it = nets.begin(); it != nets.end(); ++it)
+				predicate.add_local_net(*it);
+		}
+		if (variablesMap.count("import-ports"))
+			predicate.add_port_ranges(variablesMap["import-ports"].as<string>());
+		if (variablesMap.count("import-from") || variablesMap.count("import-to"))
+			predicate.set_time_range(variablesMap.count("import-from") ? variablesMap["import-from"].as<uint64_t>() : 0,
+			      variablesMap.count("import-to") ? variablesMap["import-to"].as<uint64_t>() : 0);
+		libif.set_import_predicate(predicate);
+	} catch (string & e) {
+		cerr << e << endl;
+		exit(1);
+	}
+
+	CLocalNets local_nets;
+	try {
+		if (variablesMap.count("local-net")) {
+			const vector<string> & nets = variablesMap["local-net"].as<vector<string> >();
+			for (vector<string>::const_iterator it = nets.begin(); it != nets.end(); ++it)
+				local_nets.add(*it);
+			libif.set_local_nets(local_nets);
+		}
+	} catch (string & e) {
+		cerr << e << endl;
+		exit(1);
+	}
+
+	if (variablesMap.count("hpg-db")) {
+		string hpg_filename = variablesMap["hpg-db"].as<string>();
+		string tmp_dir = variablesMap.count("tmp-dir") ? variablesMap["tmp-dir"].as<string>() : "";
+		if (!libif.get_hpg_database(in_filename, hpg_filename, local_nets, variablesMap["memory"].as<uint64_t>() * 1024 * 1024, tmp_dir,
+		      variablesMap["hpg-version"].as<unsigned int>())) {
+			cerr << "ERROR: could not create a graph database from input data.\n";
+			return 1;
+		}
+		cout << "Successfully created file " << hpg_filename << endl;
+		return 0;
+	}
+
+	if (variablesMap.count("no-index"))
+		libif.set_use_index(false);
+	if (variablesMap.count("write-index"))
+		libif.set_write_index(true);
+
+	if (variablesMap.count("save-snapshot")) {
+		string snapshot_filename = variablesMap["save-snapshot"].as<string>();
+		if (!libif.save_snapshot(in_filename, snapshot_filename, local_nets)) {
+			cerr << "ERROR: could not save a snapshot of the input data.\n";
+			return 1;
+		}
+		cout << "Successfully created file " << snapshot_filename << endl;
+		return 0;
+	}
+
+	string filter_expression;
+	if (variablesMap.count("filter"))
+		filter_expression = variablesMap["filter"].as<string>();
+
+	if (variablesMap.count("batch")) {
+		string out_dir = variablesMap["out-dir"].as<string>();
+		libif.set_batch_threads(variablesMap["threads"].as<unsigned int>());
+		unsigned int written = libif.write_graphlets(in_filename, variablesMap["batch"].as<vector<string> >(), sum_flags, filters, role_nums, out_dir,
+		      filter_expression);
+		if (written == 0) {
+			cerr << "ERROR: could not create any dot file from input data.\n";
+			return 1;
+		}
+		cout << "Successfully created " << written << " files in " << out_dir << endl;
+		return 0;
+	}
+
+	bool ok = libif.get_graphlet(in_filename, outfilename, IP_str, sum_flags, filters, role_nums, filter_expression);
 
 	if (!ok) {
 		cerr << "ERROR: could not create a dot file from input data.\n";
@@ -0,0 +1,116 @@
+/**
+ *	\file hapserver.cpp
+ *	\brief Graphlet server keeping data sets in memory and answering requests over a Unix domain socket.
+ *
+ *	With --request the tool acts as client instead: it sends a single request to a running server and
+ *	prints the response body (see CGraphletServer for the requests).
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <boost/program_options.hpp>
+#include <boost/thread.hpp>
+#include <stdint.h>
+
+#include "IPv6_addr.h"
+#include "glocalnets.h"
+#include "gserver.h"
+
+using namespace std;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/**
+ *	Signal handler for SIGINT/SIGTERM
+ */
+static void request_stop(int) {
+	stop_requested = 1;
+}
+
+int main(int argc, char * argv[]) {
+	// 1. Process command line
+	// ***********************
+	boost::program_options::variables_map variablesMap;
+	boost::program_options::options_description desc("Allowed options");
+
+	unsigned int threads, idle_timeout;
+	uint64_t cache_mb, dataset_mb;
+	string socket_path, localnet_str, localnets_filename, request_line;
+	vector<string> preload;
+	int prefix;
+
+	try {
+		desc.add_options()
+				("socket,S", boost::program_options::value<string>(&socket_path)->default_value("/tmp/hapserver.sock"), "Unix domain socket to listen on (or to connect to with --request)")
+				("threads,j", boost::program_options::value<unsigned int>(&threads)->default_value(0), "Worker threads (0: one per processor core)")
+				("idle-timeout", boost::program_options::value<unsigned int>(&idle_timeout)->default_value(CGraphletServer::default_idle_timeout_ms / 1000), "Seconds a connection may wait for its next request (0: no limit)")
+				("localnet,l", boost::program_options::value<string>(&localnet_str)->default_value("0.0.0.0"), "Local network address")
+				("prefix,n", boost::program_options::value<int>(&prefix)->default_value(0), "Local network prefix length")
+				("localnets,L", boost::program_options::value<string>(&localnets_filename), "File listing the local network prefixes (one per line, e.g. 10.0.0.0/8), replaces --localnet/--prefix")
+				("cache-mb", boost::program_options::value<uint64_t>(&cache_mb)->default_value(CGraphletCache::default_byte_budget >> 20), "Megabytes of finished graphlets kept for repeated requests")
+				("dataset-mb", boost::program_options::value<uint64_t>(&dataset_mb)->default_value(CGraphletServer::default_dataset_memory_limit >> 20), "Megabytes of loaded data sets kept in memory, least recently used ones are dropped beyond")
+				("write-index", "Write the sidecar index (.hidx) beside loaded files, for faster loading by later runs")
+				("preload,p", boost::program_options::value<vector<string> >(&preload), "Load this data set at startup (may be repeated)")
+				("request,r", boost::program_options::value<string>(&request_line), "Send this request to a running server and print the response")
+				("help,h", "show this help message");
+
+		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), variablesMap);
+		boost::program_options::notify(variablesMap);
+	} catch (std::exception & e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	if (variablesMap.count("help")) {
+		cerr << desc;
+		cerr << "\nRequests: hosts FILE | flows FILE IP | graphlet FILE IP [summarize=N] [filter=N] [roles=R1,R2,...] [expr=EXPRESSION] | stats\n";
+		exit(0);
+	}
+
+	try {
+		if (variablesMap.count("request")) {
+			uint64_t time_us = 0;
+			cout << CGraphletServer::request(socket_path, request_line, &time_us);
+			cerr << "*** Answered in " << time_us << " us" << endl;
+			return 0;
+		}
+
+		signal(SIGINT, request_stop);
+		signal(SIGTERM, request_stop);
+
+		// 2. Run server until interrupted
+		// *******************************
+		CLocalNets local_nets;
+		if (variablesMap.count("localnets")) {
+			local_nets.load(localnets_filename);
+		} else {
+			IPv6_addr local_net(localnet_str);
+			int max_prefix = local_net.isIPv4() ? 32 : 128;
+			if (prefix < 0 || prefix > max_prefix) {
+				cerr << "Error: invalid prefix length " << prefix << endl;
+				exit(1);
+			}
+			local_nets.add(local_net, local_net.isIPv4() ? 96 + prefix : prefix);
+		}
+
+		CGraphletServer server(socket_path, local_nets, threads);
+		server.set_graphlet_cache_budget(cache_mb << 20);
+		server.set_dataset_memory_limit(dataset_mb << 20);
+		server.set_write_index(variablesMap.count("write-index") > 0);
+		server.set_idle_timeout(idle_timeout * 1000);
+
+		server.start();
+		for (vector<string>::const_iterator it = preload.begin(); it != preload.end(); ++it)
+			CGraphletServer::request(socket_path, "hosts " + *it); // Loads the data set
+		cout << "*** Listening on " << socket_path << " (local networks " << local_nets.toString() << ")" << endl;
+		while (!stop_requested)
+			boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+		server.stop();
+	} catch (string & e) {
+		cerr << "ERROR: " << e << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -108,8 +108,7 @@
 
  gfilter_argus.cpp/.h :	Class to read argus files
 
- gfilter_ipfix_vx5ipfix_bi.cpp/.h :
- gfilter_ipfix.cpp/.h :	Example IPFIX file reader. Code based on a template for IPv4 uniflows and biflows.
+ gfilter_ipfix.cpp/.h :	IPFIX file reader for IPv4/IPv6 uniflows and RFC 5103 biflows
 
  gfilter_nfdump_gnfdump.cpp/.h :
  gfilter_nfdump.cpp/.h : 	Contains needed code from nfdump tool set to import flows from nfdump files
@@ -13,9 +13,21 @@ void HashKeyIPv6Pair_HashKeyIPv4Pair() {
 	ASSERT_EQUAL(*(IPv6_addr*)(&hkp.getkey()[16]), b);
 }
 
+void HashKeyId_4T_distinct() {
+	HashFunction<HashKeyId_4T> hf;
+	HashKeyId_4T k1(7, 6, 80, 4), k2(7, 6, 80, 4), k3(7, 6, 443, 4), k4(8, 6, 80, 4);
+	ASSERT(hf(k1, k2));
+	ASSERT_EQUAL(hf(k1), hf(k2));
+	ASSERT(!hf(k1, k3));
+	ASSERT(!hf(k1, k4));
+	HashFunction<HashKeyIdPair> hp;
+	ASSERT(!hp(HashKeyIdPair(1, 2), HashKeyIdPair(2, 1)));
+}
+
 void runSuite() {
 	cute::suite s;
 	s.push_back(CUTE(HashKeyIPv6Pair_HashKeyIPv4Pair));
+	s.push_back(CUTE(HashKeyId_4T_distinct));
 	cute::ide_listener lis;
 	cute::makeRunner(lis)(s, "hash_map");
 }
@@ -3,6 +3,7 @@
 #include "ide_listener.h"
 #include "cute_runner.h"
 #include "cflow.h"
+#include "gflowcolumns.h"
 #include "gutil.h"
 
 void isUnion() {
@@ -25,12 +26,105 @@ void subflowlist_size() {
 	ASSERT_EQUAL(list2.size(), sublist2.size());
 }
 
-void cflow_t_is_cflow6() {
+void cflow_t_is_cflow_mem() {
 	cflow_t current_CF;
-	// cflow_t is typedef for cflow6. Update test if this changes
+	// cflow_t is typedef for cflow_mem (stored as cflow6). Update test if this changes
 	ASSERT_EQUAL(current_CF.magic, CFLOW_6_MAGIC_NUMBER);
-	ASSERT_EQUAL(typeid(cflow_t), typeid(cflow6));
-	ASSERT_EQUAL(typeid(cflow_t), typeid(cflow6));
+	ASSERT_EQUAL(typeid(cflow_t), typeid(cflow_mem));
+}
+
+void cflow_mem_offsets() {
+	cflow_mem cflow;
+	// Every member naturally aligned
+	ASSERT_EQUAL(0, ((char*)&cflow.startMs - (char*)&cflow) % sizeof(cflow.startMs));
+	ASSERT_EQUAL(0, ((char*)&cflow.dOctets - (char*)&cflow) % sizeof(cflow.dOctets));
+	ASSERT_EQUAL(0, ((char*)&cflow.durationMs - (char*)&cflow) % sizeof(cflow.durationMs));
+	ASSERT_EQUAL(0, ((char*)&cflow.dPkts - (char*)&cflow) % sizeof(cflow.dPkts));
+	ASSERT_EQUAL(0, ((char*)&cflow.localPort - (char*)&cflow) % sizeof(cflow.localPort));
+	ASSERT_EQUAL(0, ((char*)&cflow.remotePort - (char*)&cflow) % sizeof(cflow.remotePort));
+	ASSERT_EQUAL(0, ((char*)&cflow.localAS - (char*)&cflow) % sizeof(cflow.localAS));
+	ASSERT_EQUAL(0, ((char*)&cflow.remoteAS - (char*)&cflow) % sizeof(cflow.remoteAS));
+	ASSERT_EQUAL(0, __alignof__(cflow_mem) % 8);
+	// Members used by role identification within the first 64 bytes
+	ASSERT((char*)&cflow.remoteIP + sizeof(cflow.remoteIP) - (char*)&cflow <= 64);
+	ASSERT((char*)&cflow.flowtype - (char*)&cflow < 64);
+	ASSERT_EQUAL(72, sizeof(cflow_mem));
+}
+
+void cflow6_conversion() {
+	cflow_mem flow(IPv6_addr(0x0a000001), 80, IPv6_addr("2001:db8::1"), 40000, 6, 4, 1300000000123ULL, 250, 123456789012ULL, 42);
+	flow.tos_flags = 0x10;
+	flow.localAS = 65001;
+	flow.remoteAS = 65002;
+	cflow6 disk(flow);
+	ASSERT_EQUAL(flow.magic, disk.magic);
+	cflow_mem back(disk);
+	ASSERT_EQUAL(flow.localIP, back.localIP);
+	ASSERT_EQUAL(flow.remoteIP, back.remoteIP);
+	ASSERT_EQUAL(flow.localPort, back.localPort);
+	ASSERT_EQUAL(flow.remotePort, back.remotePort);
+	ASSERT_EQUAL(flow.prot, back.prot);
+	ASSERT_EQUAL(flow.flowtype, back.flowtype);
+	ASSERT_EQUAL(flow.tos_flags, back.tos_flags);
+	ASSERT_EQUAL(flow.startMs, back.startMs);
+	ASSERT_EQUAL(flow.durationMs, back.durationMs);
+	ASSERT_EQUAL(flow.dOctets, back.dOctets);
+	ASSERT_EQUAL(flow.dPkts, back.dPkts);
+	ASSERT_EQUAL(flow.localAS, back.localAS);
+	ASSERT_EQUAL(flow.remoteAS, back.remoteAS);
+}
+
+void subflowlist_columns() {
+	CFlowList list;
+	list.push_back(cflow_t(IPv6_addr(0x0a000001), 80, IPv6_addr(0xc0a80001), 40000, 6, 4, 1000, 10, 500, 5));
+	list.push_back(cflow_t(IPv6_addr(0x0a000001), 443, IPv6_addr(0xc0a80002), 40001, 6, 4, 2000, 10, 600, 6));
+	list.push_back(cflow_t(IPv6_addr(0x0a000002), 53, IPv6_addr(0x0a000001), 40002, 17, 2, 3000, 10, 700, 7));
+	Subflowlist sublist(list);
+	const CFlowColumns & columns = sublist.columns();
+	ASSERT_EQUAL(3, columns.size());
+	ASSERT_EQUAL(4, columns.ip_count()); // local and remote addresses share the ids
+	ASSERT_EQUAL(columns.localIP_ids()[0], columns.localIP_ids()[1]);
+	ASSERT_EQUAL(columns.localIP_ids()[0], columns.remoteIP_ids()[2]);
+	ASSERT_EQUAL(IPv6_addr(0xc0a80002), columns.get_IP(columns.remoteIP_ids()[1]));
+	ASSERT_EQUAL(CFlowColumns::no_id, columns.find_id(IPv6_addr(0x0a000003)));
+	ASSERT_EQUAL(443, columns.localPorts()[1]);
+	ASSERT_EQUAL(40002, columns.remotePorts()[2]);
+	ASSERT_EQUAL(17, columns.prots()[2]);
+	ASSERT_EQUAL(2, columns.flowtypes()[2]);
+	ASSERT_EQUAL(600, columns.dOctets()[1]);
+	ASSERT_EQUAL(7, columns.dPkts()[2]);
+	ASSERT_EQUAL(3000, columns.startMs()[2]);
+
+	// Copies share the columns, a narrower view builds its own
+	Subflowlist copy(sublist);
+	ASSERT_EQUAL(&columns, &copy.columns());
+	Subflowlist tail(list.begin() + 1, list.end());
+	ASSERT_EQUAL(2, tail.columns().size());
+	ASSERT_EQUAL(3, sublist.columns().size());
+}
+
+void ip_dictionary() {
+	CFlowList list;
+	list.push_back(cflow_t(IPv6_addr(0x0a000001), 80, IPv6_addr("2001:db8::1"), 40000, 6, 4));
+	list.push_back(cflow_t(IPv6_addr(0x0a000001), 443, IPv6_addr(0xc0a80002), 40001, 6, 4));
+	list.push_back(cflow_t(IPv6_addr(0x0a000002), 53, IPv6_addr(0x0a000001), 40002, 17, 2));
+	boost::shared_ptr<const CIPDictionary> dictionary(new CIPDictionary(list.begin(), list.end()));
+	ASSERT_EQUAL(4, dictionary->size());
+	// Ids follow the address order
+	for (uint32_t id = 1; id < dictionary->size(); id++)
+		ASSERT(dictionary->get_IP(id - 1) < dictionary->get_IP(id));
+	ASSERT_EQUAL(IPv6_addr(0xc0a80002), dictionary->get_IP(dictionary->find_id(IPv6_addr(0xc0a80002))));
+	ASSERT_EQUAL(CIPDictionary::no_id, dictionary->find_id(IPv6_addr(0x0a000003)));
+
+	// Views given the same dictionary share the ids
+	Subflowlist head(list.begin(), list.begin() + 1);
+	Subflowlist tail(list.begin() + 1, list.end());
+	head.set_dictionary(dictionary);
+	tail.set_dictionary(dictionary);
+	ASSERT_EQUAL(4, tail.columns().ip_count());
+	ASSERT_EQUAL(head.columns().localIP_ids()[0], tail.columns().localIP_ids()[0]);
+	ASSERT_EQUAL(head.columns().localIP_ids()[0], tail.columns().remoteIP_ids()[1]);
+	ASSERT_EQUAL(&head.columns().get_dictionary(), &tail.columns().get_dictionary());
 }
 
 void cflow6_offsets() {
@@ -170,7 +264,11 @@ void runSuite() {
 	cute::suite s;
 	s.push_back(CUTE(isUnion));
 	s.push_back(CUTE(subflowlist_size));
-	s.push_back(CUTE(cflow_t_is_cflow6));
+	s.push_back(CUTE(cflow_t_is_cflow_mem));
+	s.push_back(CUTE(cflow_mem_offsets));
+	s.push_back(CUTE(cflow6_conversion));
+	s.push_back(CUTE(subflowlist_columns));
+	s.push_back(CUTE(ip_dictionary));
 	s.push_back(CUTE(cflow6_size));
 	s.push_back(CUTE(cflow6_aligned));
 	s.push_back(CUTE(cflow6_offsets));
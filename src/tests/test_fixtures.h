@@ -0,0 +1,121 @@
+#ifndef TEST_FIXTURES_H_
+#define TEST_FIXTURES_H_
+
+/**
+ *	\file test_fixtures.h
+ *	\brief Fixtures shared by the unit tests: temporary file names, file contents and generated flow lists.
+ */
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+
+/**
+ *	Reserve a unique name for a temporary file. The file itself does not exist.
+ *
+ *	\param suffix File name suffix (e.g. ".gz" for a cflow file)
+ *
+ *	\return File name ("/tmp/hapviewer_test_XXXXXX" + suffix)
+ */
+inline std::string make_name(const std::string & suffix) {
+	char name[] = "/tmp/hapviewer_test_XXXXXX";
+	int fd = mkstemp(name);
+	close(fd);
+	unlink(name);
+	return std::string(name) + suffix;
+}
+
+/**
+ *	\return Contents of a file (empty if it cannot be read)
+ */
+inline std::string read_contents(const std::string & filename) {
+	std::ifstream in(filename.c_str());
+	std::stringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+/**
+ *	\enum	flow_mix_t
+ *	\brief	Flow types of make_client_flows()
+ */
+enum flow_mix_t {
+	biflows_only, ///< All flows are biflows
+	with_outflows, ///< Every fifth flow is an outflow
+	with_inflows ///< Every fifth flow is a uniflow, a third of them inflows
+};
+
+/**
+ *	Flows of the client hosts 10.0.0.0 .. 10.0.0.(hosts - 1), sorted. Flow i (counted over all hosts) connects local
+ *	port 1000 + i with UDP port 53 (even i) or TCP port 80 (odd i) of the server 8.8.8.(8 + i % n), n = 2 + host %
+ *	server_spread, so the graphlets of the hosts differ. It starts at i ms and has i + 1 packets of 100 bytes.
+ *
+ *	\param hosts Number of local hosts
+ *	\param flows_per_host Flows of each host
+ *	\param server_spread Hosts talk to 2 .. (server_spread + 1) servers
+ *	\param mix Flow types
+ *
+ *	\return Flows
+ */
+inline CFlowList make_client_flows(uint32_t hosts, uint32_t flows_per_host = 30, uint32_t server_spread = 4, flow_mix_t mix = with_outflows) {
+	CFlowList flows;
+	for (uint32_t i = 0; i < flows_per_host * hosts; i++) {
+		uint32_t host = i / flows_per_host;
+		uint8_t flowtype = biflow;
+		if (mix != biflows_only && i % 5 == 0)
+			flowtype = (mix == with_inflows && i % 3 == 0) ? inflow : outflow;
+		flows.push_back(cflow_t(IPv6_addr(0x0a000000 + host), 1000 + i, IPv6_addr(0x08080808 + i % (2 + host % server_spread)), (i % 2) ? 80 : 53,
+		      (i % 2) ? IPPROTO_TCP : IPPROTO_UDP, flowtype, i, 10, 100 * (i + 1), i + 1));
+	}
+	std::sort(flows.begin(), flows.end());
+	return flows;
+}
+
+/**
+ *	Flows of the hosts 10.0.0.0 .. 10.0.0.(hosts - 1), sorted, with a second role per host: every third flow is a
+ *	connection of a client to its web server (TCP port 80), the others connect it as client to DNS and web servers
+ *	8.8.8.0 .. 8.8.8.(1 + host % server_spread), every seventh of them an outflow. Flows of a host are a second apart.
+ *
+ *	\param hosts Number of local hosts
+ *	\param flows_per_host Flows of each host
+ *	\param server_spread Hosts talk to 2 .. (server_spread + 1) servers
+ *
+ *	\return Flows
+ */
+inline CFlowList make_server_flows(uint32_t hosts, uint32_t flows_per_host, uint32_t server_spread) {
+	CFlowList flows;
+	for (uint32_t h = 0; h < hosts; h++) {
+		IPv6_addr localIP(0x0a000000 + h);
+		for (uint32_t i = 0; i < flows_per_host; i++) {
+			uint64_t start = 1000 * (h * flows_per_host + i);
+			if (i % 3 == 0) // Web server
+				flows.push_back(cflow_t(localIP, 80, IPv6_addr(0xc0a80000 + i * 7), 2000 + i, IPPROTO_TCP, biflow, start, 10, 500 * (i + 1), i + 1));
+			else // Client of DNS and web servers
+				flows.push_back(cflow_t(localIP, 3000 + i, IPv6_addr(0x08080800 + i % (2 + h % server_spread)), (i % 2) ? 80 : 53, (i % 2) ? IPPROTO_TCP
+				      : IPPROTO_UDP, (i % 7) ? biflow : outflow, start, 10, 100 * (i + 1), i + 1));
+		}
+	}
+	std::sort(flows.begin(), flows.end());
+	return flows;
+}
+
+/**
+ *	Write flows to a cflow file.
+ *
+ *	\param name File name (*.gz)
+ *	\param flows Flows
+ */
+inline void write_flow_file(const std::string & name, const CFlowList & flows) {
+	prefs_t prefs;
+	CImport(flows, prefs).write_file(name, flows, false);
+}
+
+#endif /* TEST_FIXTURES_H_ */
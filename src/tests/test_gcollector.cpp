@@ -0,0 +1,269 @@
+#include <string>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <boost/thread.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "gringbuffer.h"
+#include "gexportdecoder.h"
+#include "gcollector.h"
+
+typedef std::vector<uint8_t> bytes_t;
+
+static const IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+static const IPv6_addr netmask(IPv6_addr::getNetmask(104));
+
+static void putn16(bytes_t & b, uint16_t v) {
+	b.push_back(v >> 8);
+	b.push_back(v & 0xff);
+}
+
+static void putn32(bytes_t & b, uint32_t v) {
+	putn16(b, v >> 16);
+	putn16(b, v & 0xffff);
+}
+
+static void putn64(bytes_t & b, uint64_t v) {
+	putn32(b, v >> 32);
+	putn32(b, v & 0xffffffff);
+}
+
+/// Set with header
+static bytes_t set(uint16_t id, const bytes_t & content) {
+	bytes_t b;
+	putn16(b, id);
+	putn16(b, 4 + content.size());
+	b.insert(b.end(), content.begin(), content.end());
+	return b;
+}
+
+static void producer(CRingBuffer<unsigned int> * ring, unsigned int count) {
+	for (unsigned int i = 0; i < count; i++) {
+		while (!ring->push(i))
+			boost::this_thread::yield();
+	}
+}
+
+void testRingBuffer() {
+	CRingBuffer<unsigned int> ring(1000);
+	ASSERT_EQUAL(1024, ring.capacity());
+
+	// Single thread: full and empty conditions
+	unsigned int value;
+	ASSERT(!ring.pop(value));
+	for (unsigned int i = 0; i < ring.capacity(); i++)
+		ASSERT(ring.push(i));
+	ASSERT(!ring.push(0));
+	ASSERT_EQUAL(ring.capacity(), ring.size());
+	for (unsigned int i = 0; i < ring.capacity(); i++) {
+		ASSERT(ring.pop(value));
+		ASSERT_EQUAL(i, value);
+	}
+
+	// Producer thread: all items arrive in order
+	const unsigned int count = 200000;
+	boost::thread t(&producer, &ring, count);
+	unsigned int expected = 0;
+	while (expected < count) {
+		if (ring.pop(value)) {
+			ASSERT_EQUAL(expected, value);
+			expected++;
+		}
+	}
+	t.join();
+	ASSERT_EQUAL(0, ring.size());
+}
+
+/// NetFlow v9 message: template 300 with FIRST/LAST_SWITCHED and a single record
+static bytes_t netflow_v9_message(uint32_t uptime, uint32_t unix_secs) {
+	bytes_t tmpl;
+	putn16(tmpl, 300);
+	putn16(tmpl, 8);
+	uint16_t fields[8][2] = { { 8, 4 }, { 12, 4 }, { 7, 2 }, { 11, 2 }, { 4, 1 }, { 22, 4 }, { 21, 4 }, { 1, 4 } };
+	for (int i = 0; i < 8; i++) {
+		putn16(tmpl, fields[i][0]);
+		putn16(tmpl, fields[i][1]);
+	}
+	bytes_t rec;
+	putn32(rec, 0x0a000001);
+	putn32(rec, 0xc0a80001);
+	putn16(rec, 40000);
+	putn16(rec, 53);
+	rec.push_back(IPPROTO_UDP);
+	putn32(rec, uptime - 2000); // first switched
+	putn32(rec, uptime - 1500); // last switched
+	putn32(rec, 120);
+
+	bytes_t sets = set(0, tmpl);
+	bytes_t data = set(300, rec);
+	sets.insert(sets.end(), data.begin(), data.end());
+
+	bytes_t msg;
+	putn16(msg, 9);
+	putn16(msg, 2);
+	putn32(msg, uptime);
+	putn32(msg, unix_secs);
+	putn32(msg, 1);
+	putn32(msg, 7);
+	msg.insert(msg.end(), sets.begin(), sets.end());
+	return msg;
+}
+
+void testNetflowV9() {
+	CExportDecoder decoder;
+	std::vector<CExportDecoder::decoded_t> records;
+	bytes_t msg = netflow_v9_message(100000, 1300000000);
+	decoder.decode_message(&msg[0], msg.size(), 0, records);
+	ASSERT_EQUAL(1, records.size());
+	const CFlowAssembler::record_t & rec = records[0].rec;
+	ASSERT_EQUAL(IPv6_addr(0x0a000001), rec.srcIP);
+	ASSERT_EQUAL(53, rec.dstPort);
+	ASSERT_EQUAL(IPPROTO_UDP, rec.prot);
+	ASSERT_EQUAL(120, rec.dOctets);
+	// boot time = 1300000000 s - 100 s uptime
+	ASSERT_EQUAL(1300000000000ULL - 2000, rec.startMs);
+	ASSERT_EQUAL(1300000000000ULL - 1500, rec.endMs);
+	ASSERT(!records[0].paired);
+	ASSERT_EQUAL(1, decoder.get_stats().templates);
+
+	// Same template from another exporter is unknown
+	bytes_t data(msg.begin(), msg.begin() + 20);
+	bytes_t rest(msg.begin() + 20 + 4 + 4 + 8 * 4, msg.end());
+	data.insert(data.end(), rest.begin(), rest.end());
+	records.clear();
+	decoder.decode_message(&data[0], data.size(), 1, records);
+	ASSERT_EQUAL(0, records.size());
+	ASSERT_EQUAL(1, decoder.get_stats().skipped_sets);
+}
+
+/// IPFIX message: template 256 and records of both directions of one TCP connection
+static bytes_t ipfix_message() {
+	bytes_t tmpl;
+	putn16(tmpl, 256);
+	putn16(tmpl, 8);
+	uint16_t fields[8][2] = { { 8, 4 }, { 12, 4 }, { 7, 2 }, { 11, 2 }, { 4, 1 }, { 152, 8 }, { 153, 8 }, { 1, 8 } };
+	for (int i = 0; i < 8; i++) {
+		putn16(tmpl, fields[i][0]);
+		putn16(tmpl, fields[i][1]);
+	}
+	bytes_t recs;
+	uint64_t start = 1300000000000ULL;
+	putn32(recs, 0x0a000005);
+	putn32(recs, 0xc0a80001);
+	putn16(recs, 50000);
+	putn16(recs, 80);
+	recs.push_back(IPPROTO_TCP);
+	putn64(recs, start);
+	putn64(recs, start + 100);
+	putn64(recs, 500);
+	putn32(recs, 0xc0a80001);
+	putn32(recs, 0x0a000005);
+	putn16(recs, 80);
+	putn16(recs, 50000);
+	recs.push_back(IPPROTO_TCP);
+	putn64(recs, start + 10);
+	putn64(recs, start + 200);
+	putn64(recs, 7000);
+
+	bytes_t sets = set(2, tmpl);
+	bytes_t data = set(256, recs);
+	sets.insert(sets.end(), data.begin(), data.end());
+
+	bytes_t msg;
+	putn16(msg, 10);
+	putn16(msg, 16 + sets.size());
+	putn32(msg, 1300000000);
+	putn32(msg, 1);
+	putn32(msg, 0);
+	msg.insert(msg.end(), sets.begin(), sets.end());
+	return msg;
+}
+
+struct snapshot_probe_t {
+		boost::mutex mutex;
+		boost::condition_variable changed;
+		CCollector::snapshot_t last;
+		bool found;
+		snapshot_probe_t() :
+			found(false) {
+		}
+};
+
+struct on_snapshot {
+		snapshot_probe_t * probe;
+		on_snapshot(snapshot_probe_t * probe) :
+			probe(probe) {
+		}
+		void operator()(const CCollector::snapshot_t & snapshot) const {
+			boost::mutex::scoped_lock lock(probe->mutex);
+			if (!snapshot.hosts.empty()) {
+				probe->last = snapshot;
+				probe->found = true;
+				probe->changed.notify_all();
+			}
+		}
+};
+
+void testCollectorLoopback() {
+	prefs_t prefs;
+	CCollector collector(0, CLocalNets(local_net, netmask), prefs, 1);
+	std::string hpg = "/tmp/hapviewer_test_collector.hpg";
+	collector.set_hpg_filename(hpg);
+	collector.select_host(IPv6_addr(0x0a000005));
+	snapshot_probe_t probe;
+	collector.set_update_callback(on_snapshot(&probe));
+	collector.start();
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	ASSERT(sock >= 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(collector.get_port());
+	bytes_t msg = ipfix_message();
+	ASSERT(sendto(sock, &msg[0], msg.size(), 0, (struct sockaddr *) &addr, sizeof(addr)) == (ssize_t) msg.size());
+	close(sock);
+
+	{
+		boost::mutex::scoped_lock lock(probe.mutex);
+		boost::system_time timeout = boost::get_system_time() + boost::posix_time::seconds(10);
+		while (!probe.found && probe.changed.timed_wait(lock, timeout))
+			;
+	}
+	collector.stop();
+
+	ASSERT(probe.found);
+	ASSERT_EQUAL(1, probe.last.hosts.size());
+	ASSERT_EQUAL(IPv6_addr(0x0a000005), probe.last.hosts[0].IP);
+	ASSERT_EQUAL(1, probe.last.hosts[0].flow_count); // both directions paired into one biflow
+	ASSERT_EQUAL(0, probe.last.hosts[0].uniflow_count);
+	ASSERT_EQUAL(1, probe.last.hosts[0].prot_count);
+	ASSERT_EQUAL(7500, probe.last.hosts[0].bytesForAllFlows);
+	ASSERT_EQUAL(1, probe.last.stats.paired_flows);
+	ASSERT(probe.last.graphlet_ready);
+	ASSERT(access(hpg.c_str(), R_OK) == 0);
+	unlink(hpg.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testRingBuffer));
+	s.push_back(CUTE(testNetflowV9));
+	s.push_back(CUTE(testCollectorLoopback));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_CCollector");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <boost/scoped_ptr.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ghpgdata.h"
+#include "gedgesink.h"
+#include "ginterface.h"
+#include "test_fixtures.h"
+
+/**
+ *	Sink counting edges and graphlets.
+ */
+class CCountingSink: public CEdgeSink {
+	public:
+		CCountingSink() :
+			edges(0), labels(0), graphlets(0) {
+		}
+		void add_edge(unsigned int graphlet_nr, rank_t rank, const hpg_field & value1, const hpg_field & value2) {
+			edges++;
+			if (rank == edge_label)
+				labels++;
+		}
+		void end_graphlet(unsigned int graphlet_nr, CSummaryNodeInfos * nodeInfos) {
+			graphlets++;
+		}
+		int edges, labels, graphlets;
+};
+
+void testSinksMatchFiles() {
+	CFlowList flows = make_client_flows(3, 20, 3);
+	prefs_t prefs;
+	CImport import(flows, prefs);
+	import.get_hostMetadata();
+	const ChostMetadata & host = import.get_host_metadata()[1];
+
+	// hpg file and dot file as written so far
+	std::string hpg_filename = make_name(".hpg"), dot_filename = make_name(".dot");
+	boost::scoped_ptr<CSummaryNodeInfos> nodeInfos(import.build_graphlet(import.get_host_flowlist(host), prefs, desummarizedRoles(), hpg_filename));
+	ChpgData hpgData(hpg_filename);
+	hpgData.read_hpg_file();
+	hpgData.nodeInfos = nodeInfos.get();
+	hpgData.hpg2dot(0, dot_filename);
+	std::string hpg = read_contents(hpg_filename), dot = read_contents(dot_filename);
+	unlink(hpg_filename.c_str());
+	unlink(dot_filename.c_str());
+
+	// Same data from the sinks, without files
+	CHpgBufferSink buffer;
+	boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(host), prefs, desummarizedRoles(), buffer));
+	ASSERT_EQUAL(hpg, buffer.get_contents());
+
+	std::stringstream out;
+	CDotSink dot_sink(out);
+	boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(host), prefs, desummarizedRoles(), dot_sink));
+	ASSERT(dot.find("graph G {") != std::string::npos);
+	ASSERT_EQUAL(dot, out.str());
+
+	CCountingSink counter;
+	boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(host), prefs, desummarizedRoles(), counter));
+	ASSERT_EQUAL((int) (hpg.size() / (3 * sizeof(hpg_field))), counter.edges);
+	ASSERT(counter.labels > 0);
+	ASSERT_EQUAL(1, counter.graphlets);
+}
+
+void testDotSinkSeveralGraphlets() {
+	CFlowList flows = make_client_flows(3, 20, 3);
+	prefs_t prefs;
+	CImport import(flows, prefs);
+	import.get_hostMetadata();
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+
+	// Graphlets appended to one sink give the dot data of each graphlet on its own, one after the other
+	std::stringstream all, expected;
+	CDotSink all_sink(all);
+	for (size_t h = 0; h < hosts.size(); h++) {
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs, desummarizedRoles(), all_sink, h, h == 0));
+		CDotSink single(expected);
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs, desummarizedRoles(), single));
+	}
+	ASSERT_EQUAL(expected.str(), all.str());
+}
+
+void testInterfaceSink() {
+	std::string flows = make_name(".gz"), dot_filename = make_name(".dot");
+	write_flow_file(flows, make_client_flows(4, 20, 3));
+
+	CInterface libif;
+	ASSERT(libif.get_graphlet(flows, dot_filename, "10.0.0.2", CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>()));
+	std::stringstream out;
+	CDotSink sink(out);
+	ASSERT(libif.get_graphlet(flows, sink, "10.0.0.2", CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>()));
+	ASSERT_EQUAL(read_contents(dot_filename), out.str());
+
+	CCountingSink counter;
+	ASSERT(!libif.get_graphlet(flows, counter, "10.0.0.9", CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>()));
+	ASSERT(!libif.get_graphlet(flows, counter, "no_ip", CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>()));
+	ASSERT_EQUAL(0, counter.edges);
+
+	unlink(dot_filename.c_str());
+	unlink((flows + ".hpg").c_str());
+	unlink(flows.c_str());
+	unlink((flows + ".hidx").c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testSinksMatchFiles));
+	s.push_back(CUTE(testDotSinkSeveralGraphlets));
+	s.push_back(CUTE(testInterfaceSink));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gedgesink");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
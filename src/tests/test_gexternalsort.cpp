@@ -0,0 +1,128 @@
+#include <string>
+#include <algorithm>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "gexternalsort.h"
+#include "gimport.h"
+
+/**
+ *	\return Flows of a few local hosts in pseudo-random order
+ */
+static CFlowList make_flows(uint32_t count) {
+	CFlowList flows;
+	uint32_t x = 12345;
+	for (uint32_t i = 0; i < count; i++) {
+		x = x * 1103515245 + 12345;
+		flows.push_back(cflow_t(IPv6_addr(0x0a000000 + (x >> 8) % 37), 1024 + i % 1000, IPv6_addr(0x08080800 + (x >> 16) % 5), 80,
+		      IPPROTO_TCP, outflow, (x >> 4) % 100000, 10, 100, 1));
+	}
+	return flows;
+}
+
+/**
+ *	Sort flows with a CExternalSort and check the result against std::sort.
+ *
+ *	\return Number of runs spilled
+ */
+static size_t check_sort(const CFlowList & flows, uint64_t memory_budget) {
+	CExternalSort sorter(memory_budget);
+	for (CFlowList::const_iterator it = flows.begin(); it != flows.end(); ++it)
+		sorter.add(*it);
+	sorter.finish();
+	ASSERT_EQUAL((uint64_t) flows.size(), sorter.size());
+
+	CFlowList expected(flows);
+	std::stable_sort(expected.begin(), expected.end());
+	cflow_t flow;
+	for (CFlowList::const_iterator it = expected.begin(); it != expected.end(); ++it) {
+		ASSERT(sorter.next(flow));
+		ASSERT(!(flow < *it) && !(*it < flow));
+	}
+	ASSERT(!sorter.next(flow));
+	return sorter.get_run_count();
+}
+
+void testInMemory() {
+	ASSERT_EQUAL(0u, check_sort(make_flows(1000), 1000 * sizeof(cflow_t)));
+	ASSERT_EQUAL(0u, check_sort(CFlowList(), 1024));
+}
+
+void testSpill() {
+	CFlowList flows = make_flows(1000);
+	ASSERT_EQUAL(10u, check_sort(flows, 100 * sizeof(cflow_t)));
+
+	CExternalSort sorter(100 * sizeof(cflow_t));
+	for (CFlowList::const_iterator it = flows.begin(); it != flows.end(); ++it)
+		sorter.add(*it);
+	sorter.finish();
+	ASSERT_EQUAL((uint64_t) 1000 * sizeof(cflow_t), sorter.get_spilled_bytes());
+	ASSERT_THROWS(sorter.add(flows[0]), std::string);
+}
+
+void testMultiPass() {
+	// 16 flows per run: 300 runs need intermediate passes (fan-in 64)
+	CFlowList flows = make_flows(300 * CExternalSort::min_buffer_flows);
+	ASSERT_EQUAL(300u, check_sort(flows, 1));
+}
+
+void testNextHost() {
+	CFlowList flows = make_flows(2000);
+	CExternalSort sorter(128 * sizeof(cflow_t));
+	for (CFlowList::const_iterator it = flows.begin(); it != flows.end(); ++it)
+		sorter.add(*it);
+	sorter.finish();
+
+	CFlowList host;
+	size_t hosts = 0, total = 0;
+	IPv6_addr last;
+	while (sorter.next_host(host)) {
+		ASSERT(!host.empty());
+		if (hosts > 0)
+			ASSERT(last < host.front().localIP);
+		for (CFlowList::const_iterator it = host.begin(); it != host.end(); ++it)
+			ASSERT(it->localIP == host.front().localIP);
+		last = host.front().localIP;
+		total += host.size();
+		hosts++;
+	}
+	ASSERT_EQUAL(37u, hosts);
+	ASSERT_EQUAL(flows.size(), total);
+}
+
+void testQualifyUniflows() {
+	IPv6_addr local(0x0a000001), remote1(0x08080801), remote2(0x08080802);
+	CFlowList flows;
+	flows.push_back(cflow_t(local, 1000, remote1, 80, IPPROTO_TCP, outflow, 1, 1, 100, 1));
+	flows.push_back(cflow_t(local, 1001, remote1, 80, IPPROTO_TCP, biflow, 2, 1, 100, 1));
+	flows.push_back(cflow_t(local, 1002, remote1, 80, IPPROTO_TCP, inflow, 3, 1, 100, 1));
+	flows.push_back(cflow_t(local, 1003, remote2, 80, IPPROTO_TCP, outflow, 4, 1, 100, 1));
+	flows.push_back(cflow_t(remote1, 80, local, 1000, IPPROTO_TCP, outflow, 5, 1, 100, 1));
+	std::sort(flows.begin(), flows.end());
+
+	ASSERT_EQUAL(2u, CImport::qualify_uniflows(flows.begin(), flows.end()));
+	for (CFlowList::const_iterator it = flows.begin(); it != flows.end(); ++it) {
+		bool qualified = it->localIP == local && it->remoteIP == remote1 && (it->flowtype & uniflow) != 0;
+		ASSERT_EQUAL(qualified, (it->flowtype & unibiflow) == unibiflow);
+	}
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testInMemory));
+	s.push_back(CUTE(testSpill));
+	s.push_back(CUTE(testMultiPass));
+	s.push_back(CUTE(testNextHost));
+	s.push_back(CUTE(testQualifyUniflows));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gexternalsort");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
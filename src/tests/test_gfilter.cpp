@@ -11,7 +11,7 @@ using namespace std;
 
 class GFilterTestable: public GFilter {
 public:
-	virtual void read_file(string in_filename, CFlowList & flowlist, const IPv6_addr & local_net, const IPv6_addr & netmask, bool append) const {
+	virtual void read_file(string in_filename, CFlowList & flowlist, const CLocalNets & local_nets, CFlowPredicate & predicate, bool append) const {
 		// empty
 	}
 	virtual bool acceptFileForReading(std::string in_filename) const {
@@ -0,0 +1,205 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "gfilter_argus.h"
+
+typedef std::vector<uint8_t> bytes_t;
+
+static const IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+static const IPv6_addr netmask(IPv6_addr::getNetmask(104));
+
+static void putn16(bytes_t & b, uint16_t v) {
+	b.push_back(v >> 8);
+	b.push_back(v & 0xff);
+}
+
+static void putn32(bytes_t & b, uint32_t v) {
+	putn16(b, v >> 16);
+	putn16(b, v & 0xffff);
+}
+
+/// Record or DSR header with length in 32 bit words
+static void header(bytes_t & b, uint8_t type, uint8_t subtype, uint8_t qual, uint8_t words) {
+	b.push_back(type);
+	b.push_back(subtype);
+	b.push_back(qual);
+	b.push_back(words);
+}
+
+/// Management record starting an Argus 3 file
+static void mar(bytes_t & f) {
+	f.push_back(0x80);
+	f.push_back(0);
+	putn16(f, 8);
+	putn32(f, 0xe5712dcb);
+	f.resize(f.size() + 24, 0);
+}
+
+/// Flow activity record with flow, time and metric DSRs
+static void far(bytes_t & f, const bytes_t & flow_dsr, uint32_t start_sec, uint32_t end_sec, uint32_t spkts, uint32_t sbytes, uint32_t dpkts,
+      uint32_t dbytes) {
+	bytes_t b = flow_dsr;
+	header(b, 0x20, 0, 0x03, 5); // time: source start and end
+	putn32(b, start_sec);
+	putn32(b, 0);
+	putn32(b, end_sec);
+	putn32(b, 500000);
+	header(b, 0x30, 0x01, 0x03, 5); // metric: src and dst, 32 bit values
+	putn32(b, spkts);
+	putn32(b, sbytes);
+	putn32(b, dpkts);
+	putn32(b, dbytes);
+
+	f.push_back(0x10);
+	f.push_back(0);
+	putn16(f, 1 + b.size() / 4);
+	f.insert(f.end(), b.begin(), b.end());
+}
+
+static bytes_t flow4(uint32_t src, uint32_t dst, uint8_t prot, uint16_t sport, uint16_t dport) {
+	bytes_t b;
+	header(b, 0x10, 0x01, 0x01, 5);
+	putn32(b, src);
+	putn32(b, dst);
+	b.push_back(prot);
+	b.push_back(0);
+	putn16(b, sport);
+	putn16(b, dport);
+	putn16(b, 0);
+	return b;
+}
+
+static bytes_t flow6(uint8_t last_src_byte, uint8_t last_dst_byte, uint8_t prot, uint16_t sport, uint16_t dport) {
+	bytes_t b;
+	header(b, 0x10, 0x01, 0x02, 11);
+	for (int i = 0; i < 2; i++) {
+		b.push_back(0x20);
+		b.push_back(0x01);
+		b.resize(b.size() + 13, 0);
+		b.push_back(i == 0 ? last_src_byte : last_dst_byte);
+	}
+	b.push_back(prot);
+	b.resize(b.size() + 3, 0);
+	putn16(b, sport);
+	putn16(b, dport);
+	return b;
+}
+
+static std::string write_file(const bytes_t & f, const std::string & name) {
+	std::string fn = "/tmp/hapviewer_test_" + name;
+	std::ofstream out(fn.c_str(), std::ios::binary);
+	out.write((const char *) &f[0], f.size());
+	return fn;
+}
+
+void testIsNativeFile() {
+	bytes_t f;
+	mar(f);
+	std::string fn = write_file(f, "argus3.log");
+	ASSERT(GFilter_argus::is_native_file(fn));
+	GFilter_argus filter;
+	ASSERT(filter.acceptFileForReading(fn));
+	unlink(fn.c_str());
+
+	bytes_t gz(32, 0);
+	gz[0] = 0x1f;
+	gz[1] = 0x8b;
+	fn = write_file(gz, "argus_gz.log");
+	ASSERT(!GFilter_argus::is_native_file(fn));
+	unlink(fn.c_str());
+
+	ASSERT(!GFilter_argus::is_native_file("/tmp/hapviewer_test_does_not_exist.log"));
+}
+
+void testReadNativeIPv4() {
+	bytes_t f;
+	mar(f);
+	far(f, flow4(0x0a000001, 0xc0a80001, IPPROTO_TCP, 1234, 80), 100, 102, 3, 300, 2, 1000);
+	far(f, flow4(0xc0a80002, 0x0a000002, IPPROTO_UDP, 53, 5353), 200, 200, 1, 80, 0, 0);
+	far(f, flow4(0x0a000003, 0xc0a80003, IPPROTO_ICMP, 8, 0), 300, 300, 1, 84, 0, 0);
+	std::string fn = write_file(f, "native4.log");
+
+	GFilter_argus filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(3, flowlist.size());
+	ASSERT(flowlist[0].localIP == IPv6_addr(0x0a000001));
+	ASSERT(flowlist[0].remoteIP == IPv6_addr(0xc0a80001));
+	ASSERT_EQUAL(1234, flowlist[0].localPort);
+	ASSERT_EQUAL(80, flowlist[0].remotePort);
+	ASSERT_EQUAL(IPPROTO_TCP, flowlist[0].prot);
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(5, flowlist[0].dPkts);
+	ASSERT_EQUAL(1300, flowlist[0].dOctets);
+	ASSERT_EQUAL(100000, flowlist[0].startMs);
+	ASSERT_EQUAL(2500, flowlist[0].durationMs);
+
+	// Source is remote: flow is inverted to an inflow
+	ASSERT(flowlist[1].localIP == IPv6_addr(0x0a000002));
+	ASSERT_EQUAL(5353, flowlist[1].localPort);
+	ASSERT_EQUAL(53, flowlist[1].remotePort);
+	ASSERT_EQUAL(inflow, flowlist[1].flowtype);
+
+	ASSERT_EQUAL(outflow, flowlist[2].flowtype);
+	ASSERT_EQUAL(0, flowlist[2].localPort);
+	ASSERT_EQUAL(0, flowlist[2].remotePort);
+}
+
+void testReadNativeIPv6() {
+	bytes_t f;
+	mar(f);
+	far(f, flow6(1, 2, IPPROTO_TCP, 22, 40000), 10, 11, 4, 400, 4, 800);
+	std::string fn = write_file(f, "native6.log");
+
+	GFilter_argus filter;
+	CFlowList flowlist;
+	filter.read_file_native(fn, flowlist, CLocalNets(local_net, netmask));
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT(flowlist[0].localIP.isIPv6());
+	ASSERT_EQUAL(IPPROTO_TCP, flowlist[0].prot);
+	ASSERT_EQUAL(8, flowlist[0].dPkts);
+	ASSERT_EQUAL(1200, flowlist[0].dOctets);
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+}
+
+void testTruncatedNative() {
+	bytes_t f;
+	mar(f);
+	far(f, flow4(0x0a000001, 0xc0a80001, IPPROTO_TCP, 1, 2), 1, 1, 1, 40, 0, 0);
+	far(f, flow4(0x0a000001, 0xc0a80002, IPPROTO_TCP, 1, 2), 1, 1, 1, 40, 0, 0);
+	f.resize(f.size() - 10);
+	std::string fn = write_file(f, "truncated.log");
+
+	GFilter_argus filter;
+	CFlowList flowlist;
+	filter.read_file_native(fn, flowlist, CLocalNets(local_net, netmask));
+	unlink(fn.c_str());
+	ASSERT_EQUAL(1, flowlist.size());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testIsNativeFile));
+	s.push_back(CUTE(testReadNativeIPv4));
+	s.push_back(CUTE(testReadNativeIPv6));
+	s.push_back(CUTE(testTruncatedNative));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_GFilter_argus");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
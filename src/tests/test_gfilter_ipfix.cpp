@@ -0,0 +1,272 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "gfilter_ipfix.h"
+
+typedef std::vector<uint8_t> bytes_t;
+
+static const IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+static const IPv6_addr netmask(IPv6_addr::getNetmask(104));
+
+static const uint32_t REVERSE_PEN = 29305;
+
+static void putn16(bytes_t & b, uint16_t v) {
+	b.push_back(v >> 8);
+	b.push_back(v & 0xff);
+}
+
+static void putn32(bytes_t & b, uint32_t v) {
+	putn16(b, v >> 16);
+	putn16(b, v & 0xffff);
+}
+
+static void putn64(bytes_t & b, uint64_t v) {
+	putn32(b, v >> 32);
+	putn32(b, v & 0xffffffff);
+}
+
+/// Template field specifier, optionally enterprise specific
+static void field(bytes_t & b, uint16_t id, uint16_t length, uint32_t enterprise = 0) {
+	putn16(b, enterprise ? (id | 0x8000) : id);
+	putn16(b, length);
+	if (enterprise)
+		putn32(b, enterprise);
+}
+
+/// Set with header
+static bytes_t set(uint16_t id, const bytes_t & content) {
+	bytes_t b;
+	putn16(b, id);
+	putn16(b, 4 + content.size());
+	b.insert(b.end(), content.begin(), content.end());
+	return b;
+}
+
+/// Message with header
+static void message(bytes_t & f, uint32_t domain, uint32_t export_time, const bytes_t & sets) {
+	putn16(f, 10);
+	putn16(f, 16 + sets.size());
+	putn32(f, export_time);
+	putn32(f, 0);
+	putn32(f, domain);
+	f.insert(f.end(), sets.begin(), sets.end());
+}
+
+/// Template 256: IPv4 5-tuple, millisecond times, delta counters and optionally reverse counters
+static bytes_t template4(uint16_t id, bool reverse) {
+	bytes_t b;
+	putn16(b, id);
+	putn16(b, reverse ? 11 : 9);
+	field(b, 8, 4);
+	field(b, 12, 4);
+	field(b, 7, 2);
+	field(b, 11, 2);
+	field(b, 4, 1);
+	field(b, 152, 8);
+	field(b, 153, 8);
+	field(b, 1, 4); // reduced size encoding
+	field(b, 2, 4);
+	if (reverse) {
+		field(b, 1, 4, REVERSE_PEN);
+		field(b, 2, 4, REVERSE_PEN);
+	}
+	return set(2, b);
+}
+
+static void record4(bytes_t & b, uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, uint8_t prot, uint64_t start, uint64_t end, uint32_t octets,
+      uint32_t packets) {
+	putn32(b, src);
+	putn32(b, dst);
+	putn16(b, sport);
+	putn16(b, dport);
+	b.push_back(prot);
+	putn64(b, start);
+	putn64(b, end);
+	putn32(b, octets);
+	putn32(b, packets);
+}
+
+static std::string write_file(const bytes_t & f, const std::string & name) {
+	std::string fn = "/tmp/hapviewer_test_" + name;
+	std::ofstream out(fn.c_str(), std::ios::binary);
+	out.write((const char *) &f[0], f.size());
+	return fn;
+}
+
+void testAcceptFile() {
+	GFilter_ipfix filter;
+	ASSERTM("Should not accept filename nfcapd.201009212300", !filter.acceptFilename("nfcapd.201009212300"));
+	ASSERTM("Should accept filename export.dat", filter.acceptFilename("export.dat"));
+
+	bytes_t f;
+	message(f, 1, 1000, template4(256, false));
+	std::string fn = write_file(f, "accept.dat");
+	ASSERT(filter.acceptFileForReading(fn));
+	unlink(fn.c_str());
+
+	bytes_t other(32, 0);
+	fn = write_file(other, "other.dat");
+	ASSERT(!filter.acceptFileForReading(fn));
+	unlink(fn.c_str());
+}
+
+void testReverseBiflow() {
+	bytes_t data;
+	record4(data, 0xc0a80001, 0x0a000001, 80, 1234, IPPROTO_TCP, 5000, 7000, 1000, 5);
+	putn32(data, 300); // reverse octets
+	putn32(data, 3); // reverse packets
+	record4(data, 0x0a000002, 0xc0a80002, 5353, 53, IPPROTO_UDP, 8000, 8000, 80, 1);
+	putn32(data, 0);
+	putn32(data, 0);
+	data.resize(data.size() + 3, 0); // padding
+
+	bytes_t sets = template4(256, true);
+	bytes_t ds = set(256, data);
+	sets.insert(sets.end(), ds.begin(), ds.end());
+	bytes_t f;
+	message(f, 7, 1000, sets);
+	std::string fn = write_file(f, "biflow.dat");
+
+	GFilter_ipfix filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(2, flowlist.size());
+	ASSERT(flowlist[0].localIP == IPv6_addr(0x0a000001));
+	ASSERT(flowlist[0].remoteIP == IPv6_addr(0xc0a80001));
+	ASSERT_EQUAL(1234, flowlist[0].localPort);
+	ASSERT_EQUAL(80, flowlist[0].remotePort);
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(1300, flowlist[0].dOctets);
+	ASSERT_EQUAL(8, flowlist[0].dPkts);
+	ASSERT_EQUAL(5000, flowlist[0].startMs);
+	ASSERT_EQUAL(2000, flowlist[0].durationMs);
+	ASSERT_EQUAL(outflow, flowlist[1].flowtype);
+	ASSERT_EQUAL(IPPROTO_UDP, flowlist[1].prot);
+}
+
+void testUniflowPairing() {
+	bytes_t data;
+	record4(data, 0x0a000001, 0xc0a80001, 1234, 80, IPPROTO_TCP, 5000, 6000, 100, 2);
+	bytes_t data2;
+	record4(data2, 0xc0a80001, 0x0a000001, 80, 1234, IPPROTO_TCP, 5100, 6500, 200, 3);
+
+	// Two messages: the template is only sent with the first one
+	bytes_t sets = template4(300, false);
+	bytes_t ds = set(300, data);
+	sets.insert(sets.end(), ds.begin(), ds.end());
+	bytes_t f;
+	message(f, 1, 1000, sets);
+	message(f, 1, 1001, set(300, data2));
+	std::string fn = write_file(f, "uniflow.dat");
+
+	GFilter_ipfix filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(300, flowlist[0].dOctets);
+	ASSERT_EQUAL(5, flowlist[0].dPkts);
+	ASSERT_EQUAL(1500, flowlist[0].durationMs);
+}
+
+void testTemplatePerDomain() {
+	// Same template id in two domains: IPv4 in domain 1, IPv6 with second based times in domain 2
+	bytes_t t6;
+	putn16(t6, 256);
+	putn16(t6, 6);
+	field(t6, 27, 16);
+	field(t6, 28, 16);
+	field(t6, 4, 1);
+	field(t6, 150, 4);
+	field(t6, 85, 8);
+	field(t6, 86, 8);
+	bytes_t data6;
+	for (int i = 0; i < 2; i++) {
+		putn16(data6, 0x2001);
+		data6.resize(data6.size() + 13, 0);
+		data6.push_back(i + 1);
+	}
+	data6.push_back(IPPROTO_ICMPV6);
+	putn32(data6, 42);
+	putn64(data6, 64);
+	putn64(data6, 1);
+
+	bytes_t data4;
+	record4(data4, 0x0a000009, 0xc0a80009, 1, 2, IPPROTO_TCP, 0, 0, 40, 1);
+
+	bytes_t sets1 = template4(256, false);
+	bytes_t ds1 = set(256, data4);
+	sets1.insert(sets1.end(), ds1.begin(), ds1.end());
+	bytes_t sets2 = set(2, t6);
+	bytes_t ds2 = set(256, data6);
+	sets2.insert(sets2.end(), ds2.begin(), ds2.end());
+	bytes_t f;
+	message(f, 1, 1000, sets1);
+	message(f, 2, 1000, sets2);
+	message(f, 3, 1000, set(256, data4)); // unknown template in domain 3
+	std::string fn = write_file(f, "domains.dat");
+
+	GFilter_ipfix filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(2, flowlist.size());
+	bool found_v6 = false;
+	for (size_t i = 0; i < flowlist.size(); i++) {
+		if (flowlist[i].localIP.isIPv6()) {
+			found_v6 = true;
+			ASSERT_EQUAL(IPPROTO_ICMPV6, flowlist[i].prot);
+			ASSERT_EQUAL(64, flowlist[i].dOctets);
+			ASSERT_EQUAL(42000, flowlist[i].startMs);
+		}
+	}
+	ASSERT(found_v6);
+}
+
+void testTruncated() {
+	bytes_t data;
+	record4(data, 0x0a000001, 0xc0a80001, 1, 2, IPPROTO_TCP, 0, 0, 40, 1);
+	bytes_t sets = template4(256, false);
+	bytes_t ds = set(256, data);
+	sets.insert(sets.end(), ds.begin(), ds.end());
+	bytes_t f;
+	message(f, 1, 1000, sets);
+	message(f, 1, 1000, set(256, data));
+	f.resize(f.size() - 5);
+	std::string fn = write_file(f, "truncated.dat");
+
+	GFilter_ipfix filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+	ASSERT_EQUAL(1, flowlist.size());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testAcceptFile));
+	s.push_back(CUTE(testReverseBiflow));
+	s.push_back(CUTE(testUniflowPairing));
+	s.push_back(CUTE(testTemplatePerDomain));
+	s.push_back(CUTE(testTruncated));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_GFilter_ipfix");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -1,5 +1,10 @@
 #include <string>
+#include <vector>
+#include <fstream>
+#include <unistd.h>
 #include <libgen.h>
+#include <netinet/in.h>
+#include <stdint.h>
 
 #include "cute.h"
 #include "ide_listener.h"
@@ -7,6 +12,114 @@
 
 #include "gfilter_pcap.h"
 
+typedef std::vector<uint8_t> bytes_t;
+
+static const IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+static const IPv6_addr netmask(IPv6_addr::getNetmask(104));
+
+static void put16(bytes_t & b, uint16_t v) {
+	b.insert(b.end(), (uint8_t *) &v, (uint8_t *) &v + 2);
+}
+
+static void put32(bytes_t & b, uint32_t v) {
+	b.insert(b.end(), (uint8_t *) &v, (uint8_t *) &v + 4);
+}
+
+static void putn16(bytes_t & b, uint16_t v) {
+	b.push_back(v >> 8);
+	b.push_back(v & 0xff);
+}
+
+static void putn32(bytes_t & b, uint32_t v) {
+	putn16(b, v >> 16);
+	putn16(b, v & 0xffff);
+}
+
+/// IPv4 header plus TCP/UDP ports (payload of "len" bytes in total)
+static bytes_t ipv4(uint32_t src, uint32_t dst, uint8_t prot, uint16_t sport, uint16_t dport) {
+	bytes_t b;
+	b.push_back(0x45);
+	b.push_back(0);
+	putn16(b, 40);
+	putn32(b, 0);
+	b.push_back(64);
+	b.push_back(prot);
+	putn16(b, 0);
+	putn32(b, src);
+	putn32(b, dst);
+	putn16(b, sport);
+	putn16(b, dport);
+	b.resize(40, 0);
+	return b;
+}
+
+/// IPv6 header with a hop-by-hop extension header followed by TCP/UDP ports
+static bytes_t ipv6(uint8_t last_src_byte, uint8_t last_dst_byte, uint8_t prot, uint16_t sport, uint16_t dport) {
+	bytes_t b;
+	b.push_back(0x60);
+	b.push_back(0);
+	putn16(b, 0);
+	putn16(b, 16);
+	b.push_back(IPPROTO_HOPOPTS);
+	b.push_back(64);
+	for (int i = 0; i < 2; i++) {
+		b.push_back(0x20);
+		b.push_back(0x01);
+		b.resize(b.size() + 13, 0);
+		b.push_back(i == 0 ? last_src_byte : last_dst_byte);
+	}
+	b.push_back(prot); // hop-by-hop: next header
+	b.push_back(0);
+	b.resize(b.size() + 6, 0);
+	putn16(b, sport);
+	putn16(b, dport);
+	b.resize(b.size() + 4, 0);
+	return b;
+}
+
+static bytes_t ethernet(const bytes_t & payload, uint16_t ethertype, bool vlan) {
+	bytes_t b(12, 0xaa);
+	if (vlan) {
+		putn16(b, 0x8100);
+		putn16(b, 42);
+	}
+	putn16(b, ethertype);
+	b.insert(b.end(), payload.begin(), payload.end());
+	return b;
+}
+
+static bytes_t sll(const bytes_t & payload, uint16_t ethertype) {
+	bytes_t b(14, 0);
+	putn16(b, ethertype);
+	b.insert(b.end(), payload.begin(), payload.end());
+	return b;
+}
+
+static void pcap_header(bytes_t & f, uint32_t linktype) {
+	put32(f, 0xa1b2c3d4);
+	put16(f, 2);
+	put16(f, 4);
+	put32(f, 0);
+	put32(f, 0);
+	put32(f, 65535);
+	put32(f, linktype);
+}
+
+static void pcap_packet(bytes_t & f, uint32_t sec, uint32_t usec, const bytes_t & pkt) {
+	put32(f, sec);
+	put32(f, usec);
+	put32(f, pkt.size());
+	put32(f, pkt.size());
+	f.insert(f.end(), pkt.begin(), pkt.end());
+}
+
+static std::string write_file(const bytes_t & f, const std::string & name) {
+	std::string fn = "/tmp/hapviewer_test_" + name;
+	std::ofstream out(fn.c_str(), std::ios::binary);
+	out.write((const char *) &f[0], f.size());
+	return fn;
+}
+
 void testAcceptFilename() {
 	GFilter_pcap testImport;
 	// bad filenames
@@ -17,13 +130,223 @@ void testAcceptFilename() {
 	ASSERTM("Should not accept an empty filename", !testImport.acceptFilename(""));
 	// good filenames
 	ASSERTM("Should accept filename wireshark.pcap", testImport.acceptFilename("wireshark.pcap"));
+	ASSERTM("Should accept filename wireshark.pcapng", testImport.acceptFilename("wireshark.pcapng"));
 	ASSERTM("Should accept filename ipv6-ssh-thinkpad2c2d-fe80::21c:25ff:fe16:d4f4.pcap",
 	      testImport.acceptFilename("ipv6-ssh-thinkpad2c2d-fe80::21c:25ff:fe16:d4f4.pcap"));
 }
 
+void testReadPcapEthernet() {
+	bytes_t f;
+	pcap_header(f, 1);
+	pcap_packet(f, 100, 1000, ethernet(ipv4(0x0a000001, 0xc0a80001, IPPROTO_TCP, 1234, 80), 0x0800, false));
+	pcap_packet(f, 100, 500000, ethernet(ipv4(0xc0a80001, 0x0a000001, IPPROTO_TCP, 80, 1234), 0x0800, true));
+	pcap_packet(f, 101, 0, ethernet(bytes_t(28, 0), 0x0806, false)); // ARP
+	std::string fn = write_file(f, "eth.pcap");
+
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT(flowlist[0].localIP == IPv6_addr(0x0a000001));
+	ASSERT(flowlist[0].remoteIP == IPv6_addr(0xc0a80001));
+	ASSERT_EQUAL(1234, flowlist[0].localPort);
+	ASSERT_EQUAL(80, flowlist[0].remotePort);
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(2, flowlist[0].dPkts);
+	ASSERT_EQUAL(80, flowlist[0].dOctets);
+	ASSERT_EQUAL(100001, flowlist[0].startMs);
+	ASSERT_EQUAL(499, flowlist[0].durationMs);
+}
+
+void testImportPredicate() {
+	bytes_t f;
+	pcap_header(f, 1);
+	pcap_packet(f, 100, 0, ethernet(ipv4(0x0a000001, 0xc0a80001, IPPROTO_TCP, 1234, 80), 0x0800, false));
+	pcap_packet(f, 100, 0, ethernet(ipv4(0x0a000001, 0xc0a80001, IPPROTO_UDP, 5353, 53), 0x0800, false));
+	pcap_packet(f, 100, 0, ethernet(ipv4(0x0a000002, 0xc0a80001, IPPROTO_TCP, 1234, 443), 0x0800, false));
+	pcap_packet(f, 100, 0, ethernet(ipv4(0xc0a80001, 0x0a000001, IPPROTO_TCP, 80, 1234), 0x0800, false));
+	std::string fn = write_file(f, "predicate.pcap");
+
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	CFlowPredicate predicate;
+	predicate.add_protocols("tcp");
+	predicate.add_local_net("10.0.0.1/32");
+	filter.read_file(fn, flowlist, CLocalNets(local_net, netmask), predicate, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT(flowlist[0].localIP == IPv6_addr(0x0a000001));
+	ASSERT_EQUAL(IPPROTO_TCP, flowlist[0].prot);
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(2, predicate.get_stats().accepted);
+	ASSERT_EQUAL(1, predicate.get_stats().skipped_prot);
+	ASSERT_EQUAL(1, predicate.get_stats().skipped_local_net);
+}
+
+void testReadPcapSll() {
+	bytes_t f;
+	pcap_header(f, 113);
+	pcap_packet(f, 1, 0, sll(ipv4(0x0a000002, 0x08080808, IPPROTO_UDP, 5353, 53), 0x0800));
+	pcap_packet(f, 1, 0, sll(ipv6(1, 2, IPPROTO_UDP, 546, 547), 0x86dd));
+	std::string fn = write_file(f, "sll.pcap");
+
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(2, flowlist.size());
+	bool found_v6 = false;
+	for (size_t i = 0; i < flowlist.size(); i++) {
+		if (flowlist[i].localIP.isIPv6() || flowlist[i].remoteIP.isIPv6()) {
+			found_v6 = true;
+			ASSERT_EQUAL(IPPROTO_UDP, flowlist[i].prot);
+			ASSERT((flowlist[i].localPort == 546 && flowlist[i].remotePort == 547) || (flowlist[i].localPort == 547 && flowlist[i].remotePort == 546));
+		} else {
+			ASSERT_EQUAL(5353, flowlist[i].localPort);
+			ASSERT_EQUAL(outflow, flowlist[i].flowtype);
+		}
+	}
+	ASSERT(found_v6);
+}
+
+/**
+ *	pcapng file with an Ethernet interface and 3 packets of an inbound ssh flow at 5000, 5010 and 5020 timestamp units.
+ *
+ *	\param tsresol if_tsresol option of the interface
+ */
+static bytes_t pcapng_file(uint8_t tsresol, uint64_t first_ts = 5000) {
+	bytes_t f;
+	// Section header block
+	put32(f, 0x0a0d0d0a);
+	put32(f, 28);
+	put32(f, 0x1a2b3c4d);
+	put16(f, 1);
+	put16(f, 0);
+	put32(f, 0xffffffff);
+	put32(f, 0xffffffff);
+	put32(f, 28);
+	// Interface description block: Ethernet, if_tsresol option
+	put32(f, 1);
+	put32(f, 32);
+	put16(f, 1);
+	put16(f, 0);
+	put32(f, 0);
+	put16(f, 9);
+	put16(f, 1);
+	f.push_back(tsresol);
+	f.resize(f.size() + 3, 0);
+	put16(f, 0);
+	put16(f, 0);
+	put32(f, 32);
+	// Enhanced packet blocks
+	for (int i = 0; i < 3; i++) {
+		bytes_t pkt = ethernet(ipv4(0xc0a80001, 0x0a000001, IPPROTO_TCP, 4000, 22), 0x0800, i == 1);
+		uint32_t padded = (pkt.size() + 3) & ~3;
+		uint64_t ts = first_ts + i * 10;
+		put32(f, 6);
+		put32(f, 32 + padded);
+		put32(f, 0);
+		put32(f, ts >> 32);
+		put32(f, ts & 0xffffffff);
+		put32(f, pkt.size());
+		put32(f, pkt.size());
+		f.insert(f.end(), pkt.begin(), pkt.end());
+		f.resize(f.size() + padded - pkt.size(), 0);
+		put32(f, 32 + padded);
+	}
+	return f;
+}
+
+void testReadPcapng() {
+	std::string fn = write_file(pcapng_file(3), "test.pcapng"); // Millisecond timestamps
+
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT_EQUAL(inflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(22, flowlist[0].localPort);
+	ASSERT_EQUAL(3, flowlist[0].dPkts);
+	ASSERT_EQUAL(5000, flowlist[0].startMs);
+	ASSERT_EQUAL(20, flowlist[0].durationMs);
+}
+
+void testPcapngTimestampResolution() {
+	// Microseconds
+	std::string fn = write_file(pcapng_file(6), "us.pcapng");
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT_EQUAL(5, flowlist[0].startMs);
+
+	// 2^-60 s: 1.5 s
+	fn = write_file(pcapng_file(0x80 | 60, 3ULL << 59), "binary.pcapng");
+	GFilter_pcap binary;
+	CFlowList binary_flows;
+	binary.read_file(fn, binary_flows, local_net, netmask, false);
+	unlink(fn.c_str());
+	ASSERT_EQUAL(1, binary_flows.size());
+	ASSERT_EQUAL(1500, binary_flows[0].startMs);
+
+	// 10^-100 s: the interface is ignored
+	fn = write_file(pcapng_file(100), "invalid.pcapng");
+	GFilter_pcap invalid;
+	CFlowList flows;
+	invalid.read_file(fn, flows, local_net, netmask, false);
+	unlink(fn.c_str());
+	ASSERT_EQUAL(0, flows.size());
+}
+
+void testTruncatedPcap() {
+	bytes_t f;
+	pcap_header(f, 1);
+	pcap_packet(f, 1, 0, ethernet(ipv4(0x0a000001, 0xc0a80001, IPPROTO_TCP, 1, 2), 0x0800, false));
+	pcap_packet(f, 2, 0, ethernet(ipv4(0x0a000001, 0xc0a80002, IPPROTO_TCP, 1, 2), 0x0800, false));
+	f.resize(f.size() - 10);
+	std::string fn = write_file(f, "truncated.pcap");
+
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	filter.read_file(fn, flowlist, local_net, netmask, false);
+	unlink(fn.c_str());
+	ASSERT_EQUAL(1, flowlist.size());
+}
+
+void testUnsupportedLinktype() {
+	bytes_t f;
+	pcap_header(f, 105); // IEEE 802.11
+	std::string fn = write_file(f, "wlan.pcap");
+
+	GFilter_pcap filter;
+	CFlowList flowlist;
+	bool thrown = false;
+	try {
+		filter.read_file(fn, flowlist, local_net, netmask, false);
+	} catch (std::string &) {
+		thrown = true;
+	}
+	unlink(fn.c_str());
+	ASSERT(thrown);
+}
+
 void runSuite() {
 	cute::suite s;
 	s.push_back(CUTE(testAcceptFilename));
+	s.push_back(CUTE(testReadPcapEthernet));
+	s.push_back(CUTE(testImportPredicate));
+	s.push_back(CUTE(testReadPcapSll));
+	s.push_back(CUTE(testReadPcapng));
+	s.push_back(CUTE(testPcapngTimestampResolution));
+	s.push_back(CUTE(testTruncatedPcap));
+	s.push_back(CUTE(testUnsupportedLinktype));
 	cute::ide_listener lis;
 	cute::makeRunner(lis)(s, "test_GFilter_pcap");
 }
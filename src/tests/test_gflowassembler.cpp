@@ -0,0 +1,186 @@
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "gflowassembler.h"
+
+static const IPv6_addr local_net(0x0a000000); // 10.0.0.0/8
+static const IPv6_addr netmask(IPv6_addr::getNetmask(104));
+static const IPv6_addr localIP(0x0a000001);
+static const IPv6_addr remoteIP(0xc0a80001);
+
+void biflowPairing() {
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_net, netmask, 1, 0, 0);
+	assembler.add_packet(localIP, remoteIP, 1234, 80, IPPROTO_TCP, 1000, 60);
+	assembler.add_packet(remoteIP, localIP, 80, 1234, IPPROTO_TCP, 1500, 1500);
+	assembler.add_packet(localIP, remoteIP, 1234, 80, IPPROTO_TCP, 900, 40);
+	assembler.flush();
+
+	ASSERT_EQUAL(1, flowlist.size());
+	const cflow_t & f = flowlist[0];
+	ASSERT(f.localIP == localIP);
+	ASSERT(f.remoteIP == remoteIP);
+	ASSERT_EQUAL(1234, f.localPort);
+	ASSERT_EQUAL(80, f.remotePort);
+	ASSERT_EQUAL(biflow, f.flowtype);
+	ASSERT_EQUAL(3, f.dPkts);
+	ASSERT_EQUAL(1600, f.dOctets);
+	ASSERT_EQUAL(900, f.startMs);
+	ASSERT_EQUAL(600, f.durationMs);
+	ASSERT_EQUAL(3, assembler.get_stats().records);
+	ASSERT_EQUAL(1, assembler.get_stats().flows);
+}
+
+void directionInference() {
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_net, netmask);
+	assembler.add_packet(remoteIP, localIP, 5353, 53, IPPROTO_UDP, 1000, 80);
+	assembler.flush();
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT(flowlist[0].localIP == localIP);
+	ASSERT_EQUAL(53, flowlist[0].localPort);
+	ASSERT_EQUAL(inflow, flowlist[0].flowtype);
+}
+
+void multiplePrefixes() {
+	CLocalNets local_nets;
+	local_nets.add("10.0.0.0/8");
+	local_nets.add("192.168.1.0/24");
+	local_nets.add("2001:db8::/32");
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_nets);
+	IPv6_addr local6("2001:db8::1");
+	IPv6_addr remote6("2001:db9::1");
+	assembler.add_packet(IPv6_addr(0xc0a80105), remoteIP, 1234, 80, IPPROTO_TCP, 1000, 60); // 192.168.1.5 -> 192.168.0.1
+	assembler.add_packet(remote6, local6, 4000, 22, IPPROTO_TCP, 2000, 60);
+	assembler.flush();
+
+	ASSERT_EQUAL(2, flowlist.size());
+	std::sort(flowlist.begin(), flowlist.end());
+	ASSERT(flowlist[0].localIP == IPv6_addr(0xc0a80105));
+	ASSERT_EQUAL(outflow, flowlist[0].flowtype);
+	ASSERT(flowlist[1].localIP == local6);
+	ASSERT_EQUAL(22, flowlist[1].localPort);
+	ASSERT_EQUAL(inflow, flowlist[1].flowtype);
+}
+
+void bidirRecord() {
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_net, netmask);
+	CFlowAssembler::record_t rec;
+	rec.srcIP = localIP;
+	rec.dstIP = remoteIP;
+	rec.srcPort = 1234;
+	rec.dstPort = 443;
+	rec.prot = IPPROTO_TCP;
+	rec.startMs = 1000;
+	rec.endMs = 3000;
+	rec.dOctets = 5000;
+	rec.dPkts = 10;
+	rec.bidir = true;
+	assembler.add_record(rec);
+	assembler.flush();
+
+	ASSERT_EQUAL(1, flowlist.size());
+	ASSERT_EQUAL(biflow, flowlist[0].flowtype);
+	ASSERT_EQUAL(2000, flowlist[0].durationMs);
+	ASSERT_EQUAL(10, flowlist[0].dPkts);
+}
+
+void idleTimeout() {
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_net, netmask, 1, 0, 1000);
+	assembler.add_packet(localIP, remoteIP, 1234, 80, IPPROTO_TCP, 0, 100);
+	assembler.add_packet(localIP, remoteIP, 1234, 80, IPPROTO_TCP, 500, 100);
+	assembler.add_packet(localIP, remoteIP, 1234, 80, IPPROTO_TCP, 5000, 100); // idle for 4.5 s: new flow
+	assembler.flush();
+
+	ASSERT_EQUAL(2, flowlist.size());
+	ASSERT_EQUAL(1, assembler.get_stats().idle_timeouts);
+	ASSERT_EQUAL(2, flowlist[0].dPkts + 0);
+	ASSERT_EQUAL(1, flowlist[1].dPkts + 0);
+}
+
+void activeTimeout() {
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_net, netmask, 1, 1000, 0);
+	for (uint64_t t = 0; t < 3000; t += 100) {
+		assembler.add_packet(localIP, remoteIP, 1234, 80, IPPROTO_TCP, t, 100);
+	}
+	assembler.flush();
+
+	ASSERT_EQUAL(3, flowlist.size());
+	ASSERT(assembler.get_stats().active_timeouts >= 2);
+	uint32_t pkts = 0;
+	for (CFlowList::const_iterator it = flowlist.begin(); it != flowlist.end(); ++it)
+		pkts += it->dPkts;
+	ASSERT_EQUAL(30, pkts);
+}
+
+void expiredFlowsAreExported() {
+	// Flows of other 5-tuples advance the clock and expire idle flows
+	CFlowList flowlist;
+	CFlowAssembler assembler(flowlist, local_net, netmask, 1, 0, 1000);
+	for (uint16_t i = 0; i < 100; i++) {
+		assembler.add_packet(localIP, remoteIP, 1024 + i, 80, IPPROTO_TCP, i * 100, 100);
+	}
+	ASSERT(flowlist.size() > 0);
+	assembler.flush();
+	ASSERT_EQUAL(100, flowlist.size());
+	ASSERT(assembler.get_stats().peak_open_flows < 100);
+}
+
+void threadedEqualsSingle() {
+	CFlowList single, threaded;
+	CFlowAssembler a1(single, local_net, netmask, 1);
+	CFlowAssembler a4(threaded, local_net, netmask, 4);
+	for (uint32_t p = 0; p < 4; p++) {
+		for (uint32_t f = 0; f < 20000; f++) {
+			IPv6_addr l(0x0a000000 + f % 1000);
+			IPv6_addr r(0xc0000000 + f / 1000);
+			if (p % 2) {
+				a1.add_packet(l, r, 2000, 80, IPPROTO_TCP, p * 10, 100);
+				a4.add_packet(l, r, 2000, 80, IPPROTO_TCP, p * 10, 100);
+			} else {
+				a1.add_packet(r, l, 80, 2000, IPPROTO_TCP, p * 10, 100);
+				a4.add_packet(r, l, 80, 2000, IPPROTO_TCP, p * 10, 100);
+			}
+		}
+	}
+	a1.flush();
+	a4.flush();
+	ASSERT_EQUAL(20000, single.size());
+	ASSERT_EQUAL(single.size(), threaded.size());
+	std::sort(single.begin(), single.end());
+	std::sort(threaded.begin(), threaded.end());
+	for (size_t i = 0; i < single.size(); i++) {
+		ASSERT(single[i].localIP == threaded[i].localIP);
+		ASSERT(single[i].remoteIP == threaded[i].remoteIP);
+		ASSERT_EQUAL(single[i].dPkts, threaded[i].dPkts);
+		ASSERT_EQUAL(biflow, threaded[i].flowtype);
+	}
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(biflowPairing));
+	s.push_back(CUTE(directionInference));
+	s.push_back(CUTE(multiplePrefixes));
+	s.push_back(CUTE(bidirRecord));
+	s.push_back(CUTE(idleTimeout));
+	s.push_back(CUTE(activeTimeout));
+	s.push_back(CUTE(expiredFlowsAreExported));
+	s.push_back(CUTE(threadedEqualsSingle));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gflowassembler");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,170 @@
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "gflowcolumns.h"
+#include "gflowexpression.h"
+
+static const IPv6_addr localIP(0x0a000001); // 10.0.0.1
+static const IPv6_addr localIP2(0xc0a80001); // 192.168.0.1
+static const IPv6_addr remoteIP(0x08080808); // 8.8.8.8
+
+/**
+ *	Flows:
+ *	0: 10.0.0.1:40000 -> 8.8.8.8:443 tcp outflow, 2 MB
+ *	1: 8.8.8.8:50000 -> 192.168.0.1:443 tcp inflow, 10 kB
+ *	2: 192.168.0.1:53 <-> 8.8.8.8:40001 udp biflow, 100 B
+ *	3: 192.168.0.1:443 <-> 8.8.8.8:40002 tcp biflow, 5 MB
+ *	4: 10.0.0.1 -> 8.8.8.8 icmp outflow
+ */
+static CFlowList make_flows() {
+	CFlowList flows;
+	flows.push_back(cflow_t(localIP, 40000, remoteIP, 443, IPPROTO_TCP, outflow, 1000, 10, 2000000, 2000));
+	flows.push_back(cflow_t(localIP2, 443, remoteIP, 50000, IPPROTO_TCP, inflow, 2000, 10, 10000, 10));
+	flows.push_back(cflow_t(localIP2, 53, remoteIP, 40001, IPPROTO_UDP, biflow, 3000, 10, 100, 2));
+	flows.push_back(cflow_t(localIP2, 443, remoteIP, 40002, IPPROTO_TCP, biflow, 4000, 10, 5000000, 5000));
+	flows.push_back(cflow_t(localIP, 0, remoteIP, 0, IPPROTO_ICMP, outflow, 5000, 10, 84, 1));
+	return flows;
+}
+
+/**
+ *	\return Flow numbers matching an expression, as a string of digits
+ */
+static std::string matching(const CFlowList & flows, const std::string & text) {
+	CFlowColumns columns(flows.begin(), flows.end());
+	CFlowExpression expression(text);
+	std::vector<uint64_t> mask;
+	expression.evaluate(columns, mask);
+	std::string result;
+	for (size_t i = 0; i < flows.size(); i++)
+		if (CFlowExpression::test(mask, i))
+			result += (char) ('0' + i);
+	return result;
+}
+
+void testPrimitives() {
+	CFlowList flows = make_flows();
+	ASSERT_EQUAL("01234", matching(flows, ""));
+	ASSERT_EQUAL("01234", matching(flows, "any"));
+	ASSERT_EQUAL("013", matching(flows, "proto tcp"));
+	ASSERT_EQUAL("2", matching(flows, "udp"));
+	ASSERT_EQUAL("4", matching(flows, "proto 1"));
+	ASSERT_EQUAL("23", matching(flows, "biflow"));
+	ASSERT_EQUAL("014", matching(flows, "uniflow"));
+	ASSERT_EQUAL("013", matching(flows, "port 443"));
+	ASSERT_EQUAL("13", matching(flows, "local port 443"));
+	ASSERT_EQUAL("0", matching(flows, "remote port 443"));
+	ASSERT_EQUAL("1234", matching(flows, "local port < 1024"));
+	ASSERT_EQUAL("03", matching(flows, "bytes > 1M"));
+	ASSERT_EQUAL("24", matching(flows, "packets <= 2"));
+	ASSERT_EQUAL("04", matching(flows, "host 10.0.0.1"));
+	ASSERT_EQUAL("", matching(flows, "host 10.0.0.2"));
+	ASSERT_EQUAL("123", matching(flows, "net 192.168.0.0/16"));
+	ASSERT_EQUAL("01234", matching(flows, "remote net 8.0.0.0/8"));
+}
+
+void testSrcDst() {
+	CFlowList flows = make_flows();
+	// Outflow: local is source, inflow: remote is source, biflow: either side
+	ASSERT_EQUAL("013", matching(flows, "dst port 443"));
+	ASSERT_EQUAL("3", matching(flows, "src port 443"));
+	ASSERT_EQUAL("04", matching(flows, "src host 10.0.0.1"));
+	ASSERT_EQUAL("123", matching(flows, "dst net 192.168.0.0/24"));
+	ASSERT_EQUAL("123", matching(flows, "src host 8.8.8.8"));
+}
+
+void testOperators() {
+	CFlowList flows = make_flows();
+	ASSERT_EQUAL("0", matching(flows, "proto tcp and dst port 443 and bytes > 1M and not net 192.168.0.0/16"));
+	ASSERT_EQUAL("24", matching(flows, "not tcp"));
+	ASSERT_EQUAL("234", matching(flows, "udp or icmp or bytes gt 4M"));
+	ASSERT_EQUAL("2", matching(flows, "(udp or icmp) and biflow"));
+	ASSERT_EQUAL("24", matching(flows, "udp or icmp and outflow")); // and binds stronger than or
+	ASSERT_EQUAL("4", matching(flows, "!(tcp||udp) && outflow"));
+	ASSERT_EQUAL("1234", matching(flows, "bytes!=2000000"));
+	ASSERT_EQUAL("013", matching(flows, "NOT NOT Proto TCP"));
+}
+
+void testParseErrors() {
+	ASSERT_THROWS(CFlowExpression("proto foo"), std::string);
+	ASSERT_THROWS(CFlowExpression("port"), std::string);
+	ASSERT_THROWS(CFlowExpression("port 70000"), std::string);
+	ASSERT_THROWS(CFlowExpression("port 80k"), std::string);
+	ASSERT_THROWS(CFlowExpression("bytes > 1X"), std::string);
+	ASSERT_THROWS(CFlowExpression("(tcp or udp"), std::string);
+	ASSERT_THROWS(CFlowExpression("tcp udp"), std::string);
+	ASSERT_THROWS(CFlowExpression("net 10.0.0.0/33"), std::string);
+	ASSERT_THROWS(CFlowExpression("host not.an.address"), std::string);
+	ASSERT_THROWS(CFlowExpression("tcp and"), std::string);
+
+	CFlowExpression expression("tcp");
+	try {
+		expression.compile("tcp or");
+		FAILM("incomplete expression accepted");
+	} catch (std::string &) {
+		ASSERT(expression.matches_all());
+	}
+}
+
+void testBatches() {
+	// More flows than one batch, and a partial last word
+	CFlowList flows;
+	for (uint32_t i = 0; i < 3 * CFlowExpression::batch_size + 77; i++)
+		flows.push_back(cflow_t(IPv6_addr(0x0a000000 + i % 1000), i % 2000, remoteIP, 80, (i % 3 == 0) ? IPPROTO_UDP : IPPROTO_TCP, outflow,
+		      i, 10, i, 1));
+	CFlowColumns columns(flows.begin(), flows.end());
+	CFlowExpression expression("not (udp or local port >= 1000) or net 10.0.3.0/24");
+	std::vector<uint64_t> mask;
+	expression.evaluate(columns, mask);
+	ASSERT_EQUAL((flows.size() + 63) / 64, mask.size());
+	for (size_t i = 0; i < flows.size(); i++) {
+		bool expected = !(flows[i].prot == IPPROTO_UDP || flows[i].localPort >= 1000) || (i % 1000) / 256 == 3;
+		ASSERT_EQUAL(expected, CFlowExpression::test(mask, i));
+	}
+	ASSERT_EQUAL((uint64_t) 0, mask.back() >> (flows.size() % 64)); // no bits behind the last flow
+
+	// Columns of a few flows sharing a large dictionary look up the addresses of the flows
+	boost::shared_ptr<const CIPDictionary> dictionary(new CIPDictionary(flows.begin(), flows.end()));
+	CFlowColumns part(flows.begin() + 760, flows.begin() + 800, dictionary);
+	expression.evaluate(part, mask);
+	for (size_t i = 760; i < 800; i++)
+		ASSERT_EQUAL(i >= 768 || flows[i].prot != IPPROTO_UDP, CFlowExpression::test(mask, i - 760));
+}
+
+void testFlowFilter() {
+	CFlowList flows = make_flows();
+	Subflowlist sublist(flows);
+	prefs_t prefs;
+	prefs.filter_expression = "tcp and port 443";
+	CFlowFilter filter(sublist, prefs);
+	ASSERT(!filter.filter_flow(0));
+	ASSERT(!filter.filter_flow(1));
+	ASSERT(filter.filter_flow(2));
+	ASSERT(!filter.filter_flow(3));
+	ASSERT(filter.filter_flow(4));
+
+	prefs.filter_expression = "tcp and";
+	ASSERT_THROWS(CFlowFilter(sublist, prefs), std::string);
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testPrimitives));
+	s.push_back(CUTE(testSrcDst));
+	s.push_back(CUTE(testOperators));
+	s.push_back(CUTE(testParseErrors));
+	s.push_back(CUTE(testBatches));
+	s.push_back(CUTE(testFlowFilter));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gflowexpression");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
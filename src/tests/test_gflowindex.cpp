@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "gflowindex.h"
+#include "test_fixtures.h"
+
+/**
+ *	\return Name of a new temporary file holding some bytes (stands in for a flow file)
+ */
+static std::string make_input(size_t size) {
+	char name[] = "/tmp/test_gflowindex_XXXXXX";
+	int fd = mkstemp(name);
+	close(fd);
+	std::ofstream out(name, std::ios::binary);
+	for (size_t i = 0; i < size; i++)
+		out.put((char) (i * 7));
+	return name;
+}
+
+static void remove_files(const std::string & name) {
+	unlink(name.c_str());
+	unlink(CFlowIndex::get_index_filename(name).c_str());
+}
+
+void testRoundTrip() {
+	std::string name = make_input(1000);
+	CFlowList flows = make_client_flows(10, 10);
+	std::vector<ChostMetadata> hosts(10);
+	for (size_t i = 0; i < hosts.size(); i++) {
+		hosts[i].IP = flows[i * 10].localIP;
+		hosts[i].index = i * 10;
+		hosts[i].flow_count = 10;
+	}
+	std::vector<int> rindex;
+	for (int i = 99; i >= 0; i--)
+		rindex.push_back(i);
+
+	CFlowIndex index(name, "local nets");
+	CFlowList loaded_flows;
+	std::vector<ChostMetadata> loaded_hosts;
+	std::vector<int> loaded_rindex;
+	ASSERT(!index.load(loaded_flows, loaded_hosts, loaded_rindex)); // Not written yet
+	index.save(flows, hosts, rindex);
+
+	CFlowIndex reopened(name, "local nets");
+	ASSERT(reopened.load(loaded_flows, loaded_hosts, loaded_rindex));
+	ASSERT_EQUAL(flows.size(), loaded_flows.size());
+	for (size_t i = 0; i < flows.size(); i++) {
+		ASSERT(flows[i].localIP == loaded_flows[i].localIP);
+		ASSERT_EQUAL(flows[i].dOctets, loaded_flows[i].dOctets);
+		ASSERT_EQUAL((int) flows[i].flowtype, (int) loaded_flows[i].flowtype);
+	}
+	ASSERT_EQUAL(hosts.size(), loaded_hosts.size());
+	ASSERT(hosts[3].IP == loaded_hosts[3].IP);
+	ASSERT_EQUAL(30u, loaded_hosts[3].index);
+	ASSERT(rindex == loaded_rindex);
+	remove_files(name);
+}
+
+void testInvalidation() {
+	std::string name = make_input(3 * CFlowIndex::hash_block_size);
+	CFlowList flows = make_client_flows(10, 10);
+	std::vector<ChostMetadata> hosts(1);
+	std::vector<int> rindex;
+	CFlowIndex(name, "a").save(flows, hosts, rindex);
+
+	CFlowList loaded_flows;
+	std::vector<ChostMetadata> loaded_hosts;
+	std::vector<int> loaded_rindex;
+	ASSERT(CFlowIndex(name, "a").load(loaded_flows, loaded_hosts, loaded_rindex));
+	ASSERT(!CFlowIndex(name, "b").load(loaded_flows, loaded_hosts, loaded_rindex)); // Other import parameters
+
+	// Same size and modification time, changed content in the last block
+	struct stat st;
+	stat(name.c_str(), &st);
+	{
+		std::fstream out(name.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+		out.seekp(3 * CFlowIndex::hash_block_size - 10);
+		out.put('X');
+	}
+	struct timespec times[2] = { st.st_atim, st.st_mtim };
+	utimensat(AT_FDCWD, name.c_str(), times, 0);
+	ASSERT(!CFlowIndex(name, "a").load(loaded_flows, loaded_hosts, loaded_rindex));
+
+	// Truncated index
+	CFlowIndex(name, "a").save(flows, hosts, rindex);
+	ASSERT_EQUAL(0, truncate(CFlowIndex::get_index_filename(name).c_str(), 200));
+	ASSERT(!CFlowIndex(name, "a").load(loaded_flows, loaded_hosts, loaded_rindex));
+	ASSERT_EQUAL(flows.size(), loaded_flows.size()); // Unchanged by the failed loads
+
+	remove_files(name);
+	ASSERT_THROWS(CFlowIndex(name, "a"), std::string);
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testRoundTrip));
+	s.push_back(CUTE(testInvalidation));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gflowindex");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include <string>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "gflowpredicate.h"
+
+static const IPv6_addr localIP(0x0a000001);
+static const IPv6_addr remoteIP(0xc0a80001);
+
+void testAcceptsAll() {
+	CFlowPredicate predicate;
+	ASSERT(predicate.accepts_all());
+	cflow_t flow(localIP, 1234, remoteIP, 80, IPPROTO_TCP, outflow, 1000, 10);
+	ASSERT(predicate.accept(flow));
+	ASSERT_EQUAL(1, predicate.get_stats().accepted);
+	ASSERT_EQUAL(0, predicate.get_stats().skipped());
+}
+
+void testConditions() {
+	CFlowPredicate predicate;
+	predicate.add_protocols("tcp, udp");
+	predicate.add_local_net("10.0.0.0/24");
+	predicate.set_time_range(1000, 2000);
+	predicate.add_port_ranges("53,8000-8080");
+	ASSERT(!predicate.accepts_all());
+
+	ASSERT(predicate.accept(cflow_t(localIP, 40000, remoteIP, 53, IPPROTO_UDP, outflow, 1500, 10)));
+	ASSERT(predicate.accept(cflow_t(localIP, 8080, remoteIP, 50000, IPPROTO_TCP, inflow, 1999, 10)));
+	ASSERT(predicate.accept(cflow_t(localIP, 8000, remoteIP, 50000, IPPROTO_TCP, inflow, 500, 500))); // ends at 1000
+	ASSERT(!predicate.accept(cflow_t(localIP, 40000, remoteIP, 53, IPPROTO_ICMP, outflow, 1500, 10)));
+	ASSERT(!predicate.accept(cflow_t(IPv6_addr(0x0a000101), 40000, remoteIP, 53, IPPROTO_UDP, outflow, 1500, 10)));
+	ASSERT(!predicate.accept(cflow_t(localIP, 40000, remoteIP, 53, IPPROTO_UDP, outflow, 2000, 10)));
+	ASSERT(!predicate.accept(cflow_t(localIP, 40000, remoteIP, 53, IPPROTO_UDP, outflow, 500, 499)));
+	ASSERT(!predicate.accept(cflow_t(localIP, 40000, remoteIP, 80, IPPROTO_TCP, outflow, 1500, 10)));
+
+	const CFlowPredicate::stats_t & stats = predicate.get_stats();
+	ASSERT_EQUAL(3, stats.accepted);
+	ASSERT_EQUAL(1, stats.skipped_prot);
+	ASSERT_EQUAL(1, stats.skipped_local_net);
+	ASSERT_EQUAL(2, stats.skipped_time);
+	ASSERT_EQUAL(1, stats.skipped_port);
+	ASSERT_EQUAL(5, stats.skipped());
+
+	// Counters of worker threads are merged
+	CFlowPredicate::stats_t job_stats;
+	ASSERT(!predicate.accept(cflow_t(localIP, 1, remoteIP, 2, IPPROTO_GRE, outflow, 1500, 10), job_stats));
+	ASSERT_EQUAL(1, job_stats.skipped_prot);
+	predicate.add_stats(job_stats);
+	ASSERT_EQUAL(2, predicate.get_stats().skipped_prot);
+	predicate.reset_stats();
+	ASSERT_EQUAL(0, predicate.get_stats().skipped());
+}
+
+void testParseErrors() {
+	CFlowPredicate predicate;
+	ASSERT_THROWS(predicate.add_protocols("tcp,foo"), std::string);
+	ASSERT_THROWS(predicate.add_protocols("256"), std::string);
+	ASSERT_THROWS(predicate.add_port_ranges("80-x"), std::string);
+	ASSERT_THROWS(predicate.add_port_ranges("70000"), std::string);
+	ASSERT_THROWS(predicate.add_local_net("10.0.0.0/40"), std::string);
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testAcceptsAll));
+	s.push_back(CUTE(testConditions));
+	s.push_back(CUTE(testParseErrors));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gflowpredicate");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
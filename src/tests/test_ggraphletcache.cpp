@@ -0,0 +1,97 @@
+#include <string>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "ggraphletcache.h"
+#include "gsummarynodeinfo.h"
+
+void testFind() {
+	CGraphletCache cache;
+	std::string dot = "unchanged", hpg = "unchanged";
+	ASSERT(!cache.find("a", dot, hpg));
+	ASSERT_EQUAL("unchanged", dot);
+
+	cache.insert("a", "digraph a {}", "hpg a");
+	ASSERT(cache.find("a", dot, hpg));
+	ASSERT_EQUAL("digraph a {}", dot);
+	ASSERT_EQUAL("hpg a", hpg);
+	ASSERT_EQUAL(1u, cache.get_hits());
+	ASSERT_EQUAL(1u, cache.get_misses());
+
+	// Replacing outputs of the same request
+	cache.insert("a", "digraph b {}", "");
+	ASSERT_EQUAL(1u, cache.size());
+	ASSERT_EQUAL(std::string("a").size() + std::string("digraph b {}").size(), cache.get_bytes());
+	ASSERT(cache.find("a", dot, hpg));
+	ASSERT_EQUAL("digraph b {}", dot);
+	ASSERT_EQUAL("", hpg);
+
+	cache.clear();
+	ASSERT_EQUAL(0u, cache.size());
+	ASSERT_EQUAL(0u, cache.get_bytes());
+	ASSERT_EQUAL(2u, cache.get_hits());
+}
+
+void testBudget() {
+	CGraphletCache cache(30); // Three entries of 10 bytes
+	std::string dot, hpg;
+	cache.insert("1", "dot1", "hpg01");
+	cache.insert("2", "dot2", "hpg02");
+	cache.insert("3", "dot3", "hpg03");
+	ASSERT_EQUAL(30u, cache.get_bytes());
+	ASSERT(cache.find("1", dot, hpg)); // 2 is least recently used now
+
+	cache.insert("4", "dot4", "hpg04");
+	ASSERT_EQUAL(3u, cache.size());
+	ASSERT(!cache.find("2", dot, hpg));
+	ASSERT(cache.find("1", dot, hpg));
+	ASSERT(cache.find("3", dot, hpg));
+	ASSERT(cache.find("4", dot, hpg));
+
+	// Outputs larger than the budget are not cached
+	cache.insert("5", std::string(100, 'x'), "");
+	ASSERT(!cache.find("5", dot, hpg));
+	ASSERT_EQUAL(3u, cache.size());
+
+	cache.set_byte_budget(10);
+	ASSERT_EQUAL(1u, cache.size());
+	ASSERT(cache.find("4", dot, hpg));
+	cache.set_byte_budget(0);
+	ASSERT_EQUAL(0u, cache.size());
+}
+
+void testNodeInfos() {
+	CGraphletCache cache;
+	std::string dot, hpg;
+	boost::shared_ptr<const CSummaryNodeInfos> node_infos(new CSummaryNodeInfos());
+	cache.insert("a", "digraph a {}", "hpg a", node_infos);
+	cache.insert("b", "digraph b {}", "hpg b");
+
+	boost::shared_ptr<const CSummaryNodeInfos> found;
+	ASSERT(cache.find("a", dot, hpg, found));
+	ASSERT(found == node_infos);
+	ASSERT(cache.find("b", dot, hpg, found));
+	ASSERT(!found);
+
+	// Outlive the cache entry
+	found = node_infos;
+	cache.clear();
+	node_infos.reset();
+	ASSERT(found.unique());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testFind));
+	s.push_back(CUTE(testBudget));
+	s.push_back(CUTE(testNodeInfos));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_ggraphletcache");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ghpgdata.h"
+#include "ghpgv4.h"
+#include "ggraphletexport.h"
+#include "test_fixtures.h"
+
+static std::string make_dir() {
+	char name[] = "/tmp/test_ggraphletexport_XXXXXX";
+	return mkdtemp(name);
+}
+
+/**
+ *	Write an hpg file with the graphlets of all hosts and collect the dot data of each graphlet.
+ */
+static void write_hpg_file(const CFlowList & flows, CEdgeSink & sink, std::vector<std::string> & dot) {
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	for (size_t h = 0; h < hosts.size(); h++) {
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), sink, h, h == 0));
+		CHpgBufferSink buffer;
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), buffer));
+		ChpgData hpgData(&buffer.get_data()[0], buffer.get_data().size() * sizeof(hpg_field));
+		std::stringstream out;
+		hpgData.hpg2dot(0, out);
+		dot.push_back(out.str());
+	}
+	sink.finish();
+}
+
+/**
+ *	Renderer writing the dot data, counting renderers and rendered graphlets and noting the threads creating renderers.
+ */
+class CCountingRenderer: public CDotRenderer {
+	public:
+		static CDotRenderer * create() {
+			boost::mutex::scoped_lock lock(mutex);
+			renderers++;
+			creators.insert(boost::this_thread::get_id());
+			return new CCountingRenderer();
+		}
+
+		void render(const std::string & dot, const std::string & filename) {
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				rendered++;
+			}
+			std::ofstream(filename.c_str()) << dot;
+		}
+
+		static boost::mutex mutex;
+		static int renderers;
+		static int rendered;
+		static std::set<boost::thread::id> creators;
+};
+
+boost::mutex CCountingRenderer::mutex;
+int CCountingRenderer::renderers = 0;
+int CCountingRenderer::rendered = 0;
+std::set<boost::thread::id> CCountingRenderer::creators;
+
+void testDotExport() {
+	std::string dir = make_dir(), filename = dir + "/graphlets.hpg";
+	std::vector<std::string> dot;
+	{
+		CHpgV4FileSink sink(filename);
+		write_hpg_file(make_client_flows(8), sink, dot);
+	}
+	ChpgData hpgData(filename);
+	hpgData.read_hpg_file();
+	hpgData.get_hpgMetadata();
+
+	CGraphletExport exporter(hpgData, dir, CGraphletExport::dot_format);
+	exporter.set_threads(3);
+	ASSERT_EQUAL(8u, exporter.export_graphlets());
+	ASSERT_EQUAL(0u, exporter.get_failed());
+	for (int h = 0; h < 8; h++) {
+		std::string name = dir + "/" + IPv6_addr(0x0a000000 + h).toString() + ".dot";
+		ASSERT_EQUAL(dot[h], read_contents(name));
+		unlink(name.c_str());
+	}
+
+	// Range of graphlets, rendered by a renderer per thread
+	CGraphletExport images(hpgData, dir, CGraphletExport::image_format, "svg");
+	ASSERT_THROWS(images.export_graphlets(), std::string);
+	images.set_renderer(&CCountingRenderer::create);
+	images.set_threads(2);
+	ASSERT_EQUAL(4u, images.export_graphlets(2, 5));
+	ASSERT_EQUAL(2, CCountingRenderer::renderers);
+	ASSERT_EQUAL(4, CCountingRenderer::rendered);
+	ASSERT_EQUAL(1u, CCountingRenderer::creators.size()); // All created before the export threads start
+	ASSERT(boost::this_thread::get_id() == *CCountingRenderer::creators.begin());
+	for (int h = 0; h < 8; h++) {
+		std::string name = dir + "/" + IPv6_addr(0x0a000000 + h).toString() + ".svg";
+		ASSERT_EQUAL(h >= 2 && h <= 5, access(name.c_str(), F_OK) == 0);
+		unlink(name.c_str());
+	}
+	unlink(filename.c_str());
+	rmdir(dir.c_str());
+}
+
+void testJsonExport() {
+	std::string dir = make_dir(), filename = dir + "/graphlets.hpg";
+	std::vector<std::string> dot;
+	{
+		CHpgFileSink sink(filename);
+		write_hpg_file(make_client_flows(2), sink, dot);
+	}
+	ChpgData hpgData(filename);
+	hpgData.read_hpg_file();
+	hpgData.get_hpgMetadata();
+	CGraphletExport exporter(hpgData, dir, CGraphletExport::json_format);
+	ASSERT_EQUAL(2u, exporter.export_graphlets());
+
+	std::string name = dir + "/10.0.0.1.json";
+	std::string json = read_contents(name);
+	ASSERT_EQUAL(0u, json.find("{\"localIP\":\"10.0.0.1\",\"bytes\":"));
+	ASSERT(json.find("\"label\":\"TCP\"") != std::string::npos);
+	ASSERT(json.find("\"label\":\"8.8.8.8\"") != std::string::npos);
+	ASSERT(json.find("\"direction\":\"both\"") != std::string::npos);
+	ASSERT(json.find("\"flows\":") != std::string::npos);
+	// Each node id of the dot data is a node
+	std::string node_ids = dot[1];
+	for (size_t k = node_ids.find("\nk"); k != std::string::npos; k = node_ids.find("\nk", k + 1)) {
+		std::string id = node_ids.substr(k + 1, node_ids.find_first_of("[-", k + 1) - k - 1);
+		ASSERT(json.find("{\"id\":\"" + id + "\"") != std::string::npos);
+	}
+	ASSERT_EQUAL('}', json[json.size() - 2]);
+	unlink(name.c_str());
+	name = dir + "/10.0.0.0.json";
+	unlink(name.c_str());
+	unlink(filename.c_str());
+	rmdir(dir.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testDotExport));
+	s.push_back(CUTE(testJsonExport));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_ggraphletexport");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
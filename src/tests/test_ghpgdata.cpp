@@ -0,0 +1,120 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <boost/scoped_ptr.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ghpgdata.h"
+#include "ghpgv4.h"
+#include "test_fixtures.h"
+
+/**
+ *	Write the graphlets of all hosts to a sink and collect the dot data of each graphlet (without node infos).
+ */
+static void write_graphlets(const CImport & import, CEdgeSink & sink, std::vector<std::string> & dot) {
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	for (size_t h = 0; h < hosts.size(); h++) {
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), sink, h, h == 0));
+		CHpgBufferSink buffer;
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), buffer));
+		ChpgData hpgData(&buffer.get_data()[0], buffer.get_data().size() * sizeof(hpg_field));
+		std::stringstream out;
+		hpgData.hpg2dot(0, out);
+		dot.push_back(out.str());
+	}
+	sink.finish();
+}
+
+void testMappedFile() {
+	CFlowList flows = make_client_flows(6);
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	std::string filename = make_name(".hpg");
+	std::vector<std::string> dot;
+	{
+		CHpgFileSink sink(filename);
+		write_graphlets(import, sink, dot);
+	}
+
+	ChpgData hpgData(filename);
+	hpgData.read_hpg_file();
+	hpgData.get_hpgMetadata();
+	ASSERT_EQUAL(6, hpgData.get_num_graphlets());
+	int g = 0;
+	for (ChpgMetadata * metadata = hpgData.get_first_graphlet(); metadata != NULL; metadata = hpgData.get_next_graphlet(), g++) {
+		std::stringstream out;
+		hpgData.hpg2dot(hpgData.get_index(g), out);
+		ASSERT_EQUAL(dot[g], out.str());
+	}
+	ASSERT_EQUAL(6, g);
+
+	// Metadata computed again replaces the old one
+	hpgData.get_hpgMetadata();
+	ASSERT_EQUAL(6, hpgData.get_num_graphlets());
+
+	// Incomplete edge
+	std::ofstream(filename.c_str(), std::ios_base::app).write("x", 1);
+	ASSERT_THROWS(ChpgData damaged(filename), std::string);
+	unlink(filename.c_str());
+}
+
+void testLazyDecoding() {
+	CFlowList flows = make_client_flows(6);
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	std::string filename = make_name(".hpg");
+	std::vector<std::string> dot;
+	{
+		CHpgV4FileSink sink(filename);
+		write_graphlets(import, sink, dot);
+	}
+
+	// Any graphlet is decoded on its own, in any order, without metadata
+	CHpgV4Reader reader(filename);
+	ChpgData hpgData(filename);
+	hpgData.read_hpg_file();
+	int index = 3;
+	std::vector<int> indices;
+	for (size_t g = 0; g < reader.get_graphlet_count(); g++) {
+		indices.push_back(g == 0 ? 0 : index);
+		index += 3 * reader.get_entry(g).rows;
+	}
+	for (int g = 5; g >= 0; g--) {
+		std::stringstream out;
+		hpgData.hpg2dot(indices[g], out);
+		ASSERT_EQUAL(dot[g], out.str());
+	}
+	std::stringstream out;
+	ASSERT_THROWS(hpgData.hpg2dot(indices[1] + 3, out), std::string);
+	ASSERT_THROWS(hpgData.hpg2dot(index, out), std::string);
+
+	hpgData.get_hpgMetadata();
+	ASSERT_EQUAL(6, hpgData.get_num_graphlets());
+	for (int g = 0; g < 6; g++)
+		ASSERT_EQUAL(indices[g], hpgData.get_index(g));
+	unlink(filename.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testMappedFile));
+	s.push_back(CUTE(testLazyDecoding));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_ghpgdata");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,158 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <boost/scoped_ptr.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ghpgdata.h"
+#include "ghpgv4.h"
+#include "ginterface.h"
+#include "test_fixtures.h"
+
+/**
+ *	Write the graphlets of all hosts to a sink, as cflow2hpg_database() does.
+ */
+static void write_graphlets(const CImport & import, CEdgeSink & sink) {
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	for (size_t h = 0; h < hosts.size(); h++)
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), sink, h, h == 0));
+	sink.finish();
+}
+
+/**
+ *	Compare the graphlets of two hpg files: metadata and dot data.
+ */
+static void assert_same_graphlets(const std::string & filename1, const std::string & filename2, int graphlets) {
+	ChpgData hpgData1(filename1), hpgData2(filename2);
+	hpgData1.read_hpg_file();
+	hpgData1.get_hpgMetadata();
+	hpgData2.read_hpg_file();
+	hpgData2.get_hpgMetadata();
+	ASSERT_EQUAL(graphlets, hpgData1.get_num_graphlets());
+	ASSERT_EQUAL(graphlets, hpgData2.get_num_graphlets());
+	ASSERT_EQUAL(hpgData1.get_edges(), hpgData2.get_edges());
+	ChpgMetadata * metadata1 = hpgData1.get_first_graphlet();
+	ChpgMetadata * metadata2 = hpgData2.get_first_graphlet();
+	for (int g = 0; g < graphlets; g++) {
+		ASSERT(metadata1 != NULL && metadata2 != NULL);
+		ASSERT_EQUAL(metadata1->graphlet_nr, metadata2->graphlet_nr);
+		ASSERT_EQUAL(metadata1->index, metadata2->index);
+		ASSERT_EQUAL(metadata1->edge_count, metadata2->edge_count);
+		ASSERT_EQUAL(metadata1->prot_count, metadata2->prot_count);
+		ASSERT_EQUAL(metadata1->dstIP_cnt, metadata2->dstIP_cnt);
+		ASSERT_EQUAL(metadata1->srcPort_cnt, metadata2->srcPort_cnt);
+		ASSERT_EQUAL(metadata1->dstPort_cnt, metadata2->dstPort_cnt);
+		ASSERT_EQUAL(metadata1->bytesForAllFlows, metadata2->bytesForAllFlows);
+		ASSERT_EQUAL(hpgData1.get_index(g), hpgData2.get_index(g));
+		std::stringstream dot1, dot2;
+		hpgData1.hpg2dot(metadata1->index, dot1);
+		hpgData2.hpg2dot(metadata2->index, dot2);
+		ASSERT(dot1.str().find("graph G {") != std::string::npos);
+		ASSERT_EQUAL(dot1.str(), dot2.str());
+		metadata1 = hpgData1.get_next_graphlet();
+		metadata2 = hpgData2.get_next_graphlet();
+	}
+}
+
+void testRoundTrip() {
+	CFlowList flows = make_server_flows(12, 60, 5);
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	import.prepare_columns();
+	std::string v3_filename = make_name(".hpg"), v4_filename = make_name(".hpg");
+	{
+		CHpgFileSink v3(v3_filename);
+		write_graphlets(import, v3);
+		CHpgV4FileSink v4(v4_filename);
+		write_graphlets(import, v4);
+	}
+	std::string v3_data = read_contents(v3_filename), v4_data = read_contents(v4_filename);
+	ASSERT(CHpgV4Reader::is_v4_file(v4_filename));
+	ASSERT(!CHpgV4Reader::is_v4_file(v3_filename));
+	ASSERT(v4_data.size() * 4 < v3_data.size());
+
+	// Decoded edges are the version 3 data
+	CHpgV4Reader reader(v4_filename);
+	ASSERT_EQUAL(12u, reader.get_graphlet_count());
+	CHpgBufferSink decoded;
+	hpg_field version_num, build_time;
+	version_num.reset();
+	version_num.eightbytevalue.data = 3;
+	build_time.reset();
+	decoded.add_edge(0, version, version_num, build_time);
+	for (size_t g = 0; g < reader.get_graphlet_count(); g++) {
+		ASSERT_EQUAL(g, reader.get_entry(g).graphlet_nr);
+		reader.decode_graphlet(g, decoded);
+	}
+	ASSERT(v3_data == decoded.get_contents());
+
+	assert_same_graphlets(v3_filename, v4_filename, 12);
+	unlink(v3_filename.c_str());
+	unlink(v4_filename.c_str());
+}
+
+void testDamagedFile() {
+	CFlowList flows = make_server_flows(2, 60, 5);
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	std::string filename = make_name(".hpg");
+	{
+		CHpgV4FileSink v4(filename);
+		write_graphlets(import, v4);
+	}
+	std::string data = read_contents(filename);
+	std::ofstream(filename.c_str()).write(data.data(), data.size() - 5);
+	ASSERT_THROWS(ChpgData hpgData(filename), std::string);
+	unlink(filename.c_str());
+
+	// Empty graph database
+	{
+		CHpgV4FileSink v4(filename);
+	}
+	ChpgData empty(filename);
+	empty.read_hpg_file();
+	empty.get_hpgMetadata();
+	ASSERT_EQUAL(0, empty.get_num_graphlets());
+	unlink(filename.c_str());
+}
+
+void testGraphDatabase() {
+	std::string flows = make_name(".gz"), v3_filename = make_name(".hpg"), v4_filename = make_name(".hpg");
+	CFlowList flowlist = make_server_flows(5, 60, 5);
+	write_flow_file(flows, flowlist);
+
+	CInterface libif;
+	ASSERT(libif.get_hpg_database(flows, v3_filename, CLocalNets(), 1 << 20));
+	ASSERT(libif.get_hpg_database(flows, v4_filename, CLocalNets(), 1 << 20, "", 4));
+	ASSERT(!libif.get_hpg_database(flows, v4_filename, CLocalNets(), 1 << 20, "", 5));
+	assert_same_graphlets(v3_filename, v4_filename, 5);
+
+	unlink(flows.c_str());
+	unlink(v3_filename.c_str());
+	unlink(v4_filename.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testRoundTrip));
+	s.push_back(CUTE(testDamagedFile));
+	s.push_back(CUTE(testGraphDatabase));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_ghpgv4");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
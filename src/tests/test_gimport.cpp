@@ -0,0 +1,126 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ghpgdata.h"
+#include "test_fixtures.h"
+
+/**
+ *	Build the graphlet of a host and convert it to dot format.
+ *
+ *	\return Graphlet in dot format
+ */
+static std::string build_dot(const CImport & import, const ChostMetadata & host, const prefs_t & prefs) {
+	std::string hpg_filename = make_name(".hpg"), dot_filename = make_name(".dot");
+	boost::scoped_ptr<CSummaryNodeInfos> nodeInfos(import.build_graphlet(import.get_host_flowlist(host), prefs, desummarizedRoles(), hpg_filename));
+	ChpgData hpgData(hpg_filename);
+	hpgData.read_hpg_file();
+	hpgData.nodeInfos = nodeInfos.get();
+	hpgData.hpg2dot(0, dot_filename);
+	std::string dot = read_contents(dot_filename);
+	unlink(hpg_filename.c_str());
+	unlink(dot_filename.c_str());
+	return dot;
+}
+
+void testBuildGraphlet() {
+	CFlowList flows = make_server_flows(3, 40, 3);
+	prefs_t prefs;
+	CImport import(flows, prefs);
+	import.get_hostMetadata();
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	ASSERT_EQUAL(3u, hosts.size());
+
+	// Same graphlet as cflow2hpg() on the active flowlist, and the same on every call
+	std::string hpg_filename = make_name(".hpg"), dot_filename = make_name(".dot");
+	import.set_hpg_filename(hpg_filename);
+	import.setBegin(hosts[1].index);
+	import.setEnd(hosts[1].index + hosts[1].flow_count);
+	import.cflow2hpg();
+	ChpgData hpgData(hpg_filename);
+	hpgData.read_hpg_file();
+	hpgData.nodeInfos = import.nodeInfos;
+	hpgData.hpg2dot(0, dot_filename);
+	std::string dot = read_contents(dot_filename);
+	unlink(hpg_filename.c_str());
+	unlink(dot_filename.c_str());
+
+	ASSERT(dot.find("graph G {") != std::string::npos);
+	ASSERT_EQUAL(dot, build_dot(import, hosts[1], prefs));
+	ASSERT_EQUAL(dot, build_dot(import, hosts[1], prefs));
+	ASSERT(dot != build_dot(import, hosts[0], prefs));
+}
+
+/**
+ *	Builder thread: build the graphlets of all hosts several times, count the ones differing from expected.
+ */
+static void run_builder(const CImport * import, const prefs_t * prefs, const std::vector<std::string> * expected, int * failures) {
+	const std::vector<ChostMetadata> & hosts = import->get_host_metadata();
+	for (int round = 0; round < 3; round++) {
+		for (size_t h = 0; h < hosts.size(); h++) {
+			try {
+				if (build_dot(*import, hosts[h], *prefs) != (*expected)[h])
+					(*failures)++;
+			} catch (std::string &) {
+				(*failures)++;
+			}
+		}
+	}
+}
+
+void testConcurrentGraphlets() {
+	CFlowList flows = make_server_flows(6, 40, 3);
+	prefs_t prefs, unsummarized;
+	unsummarized.summarize_clt_roles = unsummarized.summarize_multclt_roles = false;
+	unsummarized.summarize_srv_roles = unsummarized.summarize_p2p_roles = false;
+	CImport import(flows, prefs);
+	import.get_hostMetadata();
+	import.prepare_columns();
+
+	// Serial results first
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	std::vector<std::string> expected, expected_unsummarized;
+	for (size_t h = 0; h < hosts.size(); h++) {
+		expected.push_back(build_dot(import, hosts[h], prefs));
+		expected_unsummarized.push_back(build_dot(import, hosts[h], unsummarized));
+	}
+	ASSERT(expected[0] != expected_unsummarized[0]);
+
+	// Threads share the data set, each with its own preferences
+	const int threads = 8;
+	int failures[threads] = { 0 };
+	boost::thread_group group;
+	for (int i = 0; i < threads; i++)
+		group.add_thread(new boost::thread(&run_builder, &import, (i % 2) ? &prefs : &unsummarized, (i % 2) ? &expected : &expected_unsummarized,
+		      &failures[i]));
+	group.join_all();
+	for (int i = 0; i < threads; i++)
+		ASSERT_EQUAL(0, failures[i]);
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testBuildGraphlet));
+	s.push_back(CUTE(testConcurrentGraphlets));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gimport");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <string>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "gimportcache.h"
+#include "test_fixtures.h"
+
+void testReuse() {
+	std::string name = make_name(".gz");
+	write_flow_file(name, make_client_flows(5, 10, 1, biflows_only));
+	prefs_t prefs;
+	CImportCache cache(prefs);
+
+	CImport * import = cache.get(name, CLocalNets(), CFlowPredicate(), false);
+	ASSERT_EQUAL(50, import->get_flow_count());
+	ASSERT(import->set_localIP(IPv6_addr(0x0a000004), 1));
+	ASSERT_EQUAL(10u, import->getActiveFlowlist().size());
+
+	// Other local networks do not matter for cflow files
+	ASSERT(import == cache.get(name, CLocalNets(IPv6_addr(0x0a000001), IPv6_addr::getNetmask(128)), CFlowPredicate(), false));
+	ASSERT_EQUAL(1u, cache.get_hits());
+	ASSERT_EQUAL(1u, cache.get_misses());
+	ASSERT(import->set_localIP(IPv6_addr(0x0a000001), 1));
+	ASSERT(IPv6_addr(0x0a000001) == import->getActiveFlowlist()[9].localIP);
+
+	// Other import predicate: separate data set
+	CFlowPredicate tcp;
+	tcp.add_protocols("tcp");
+	CImport * tcp_import = cache.get(name, CLocalNets(), tcp, false);
+	ASSERT(tcp_import != import);
+	ASSERT_EQUAL(25, tcp_import->get_flow_count());
+	ASSERT_EQUAL(2u, cache.size());
+	ASSERT_EQUAL(import->get_memory_size() + tcp_import->get_memory_size(), cache.get_memory_size());
+
+	// Changed file: imported again
+	write_flow_file(name, make_client_flows(3, 10, 1, biflows_only));
+	struct timespec times[2] = { { 0, UTIME_OMIT }, { time(NULL) + 10, 0 } };
+	utimensat(AT_FDCWD, name.c_str(), times, 0);
+	import = cache.get(name, CLocalNets(), CFlowPredicate(), false);
+	ASSERT_EQUAL(30, import->get_flow_count());
+	ASSERT_EQUAL(3u, cache.get_misses());
+
+	unlink(name.c_str());
+	ASSERT_THROWS(cache.get(name, CLocalNets(), CFlowPredicate(), false), std::string);
+}
+
+void testEviction() {
+	std::string name = make_name(".gz");
+	write_flow_file(name, make_client_flows(5, 10, 1, biflows_only));
+	prefs_t prefs;
+	CImportCache cache(prefs, 0);
+
+	CFlowPredicate tcp, udp;
+	tcp.add_protocols("tcp");
+	udp.add_protocols("udp");
+	cache.get(name, CLocalNets(), tcp, false);
+	CImport * import = cache.get(name, CLocalNets(), udp, false);
+	ASSERT_EQUAL(1u, cache.size()); // Last data set is kept despite the limit
+	ASSERT_EQUAL(import->get_memory_size(), cache.get_memory_size());
+
+	cache.set_memory_limit(CImportCache::default_memory_limit);
+	cache.get(name, CLocalNets(), tcp, false);
+	ASSERT(import == cache.get(name, CLocalNets(), udp, false));
+	ASSERT_EQUAL(2u, cache.size());
+	cache.clear();
+	ASSERT_EQUAL(0u, cache.size());
+	ASSERT_EQUAL(0u, cache.get_memory_size());
+	unlink(name.c_str());
+}
+
+void testPreparedSize() {
+	std::string name = make_name(".gz");
+	write_flow_file(name, make_client_flows(5, 10, 1, biflows_only));
+	prefs_t prefs;
+	CImportCache cache(prefs);
+
+	CImport * import = cache.get(name, CLocalNets(), CFlowPredicate(), false, false);
+	uint64_t unprepared = cache.get_memory_size();
+	ASSERT_EQUAL(import->get_memory_size(), unprepared);
+	ASSERT(unprepared >= 50 * (sizeof(cflow_t) + 34)); // Flows and their columns (34 bytes per flow)
+
+	// Preparing a cached data set is measured again
+	ASSERT(import == cache.get(name, CLocalNets(), CFlowPredicate(), false, false, true));
+	ASSERT_EQUAL(5u, import->get_host_metadata().size());
+	ASSERT_EQUAL(import->get_memory_size(), cache.get_memory_size());
+	ASSERT_EQUAL(unprepared + 5 * sizeof(ChostMetadata), cache.get_memory_size());
+	unlink(name.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testReuse));
+	s.push_back(CUTE(testEviction));
+	s.push_back(CUTE(testPreparedSize));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gimportcache");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,161 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ginterface.h"
+#include "test_fixtures.h"
+
+/**
+ *	Callback of get_graphlets(): collects the graphlets by IP.
+ */
+struct collector_t {
+		std::map<std::string, std::string> * graphlets;
+		void operator()(const IPv6_addr & IP, const std::string & dot) {
+			(*graphlets)[IP.toString()] = dot;
+		}
+};
+
+/**
+ *	Graphlet of a host built by get_graphlet() of an interface.
+ */
+static std::string get_graphlet(CInterface & libif, const std::string & flows, const std::string & IP, const std::set<uint32_t> & roles) {
+	std::string dot_filename = make_name(".dot");
+	if (!libif.get_graphlet(flows, dot_filename, IP, CInterface::summarize_all, (CInterface::filter_flags_t) 0, roles))
+		return "";
+	std::string dot = read_contents(dot_filename);
+	unlink(dot_filename.c_str());
+	return dot;
+}
+
+/**
+ *	Graphlet of a host built by get_graphlet() of a new interface.
+ */
+static std::string single_graphlet(const std::string & flows, const std::string & IP) {
+	CInterface libif;
+	return get_graphlet(libif, flows, IP, std::set<uint32_t>());
+}
+
+void testGetGraphlets() {
+	std::string flows = make_name(".gz");
+	write_flow_file(flows, make_client_flows(6, 10, 3, biflows_only));
+	std::map<std::string, std::string> graphlets;
+	collector_t collector = { &graphlets };
+
+	// A prefix and a list of IPs select the same hosts, with the same graphlets as get_graphlet()
+	CInterface libif;
+	libif.set_batch_threads(3);
+	std::vector<std::string> prefix(1, "10.0.0.0/30");
+	ASSERT_EQUAL(4u, libif.get_graphlets(flows, prefix, CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>(), collector));
+	ASSERT_EQUAL(4u, graphlets.size());
+	for (int h = 0; h < 4; h++) {
+		std::string IP = "10.0.0." + std::string(1, '0' + h);
+		ASSERT(graphlets[IP].find("graph G {") != std::string::npos);
+		ASSERT_EQUAL(single_graphlet(flows, IP), graphlets[IP]);
+	}
+
+	std::vector<std::string> list;
+	list.push_back("10.0.0.5");
+	list.push_back("10.0.0.1");
+	list.push_back("10.0.0.9"); // No flows: skipped
+	std::map<std::string, std::string> listed;
+	collector.graphlets = &listed;
+	ASSERT_EQUAL(2u, libif.get_graphlets(flows, list, CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>(), collector));
+	ASSERT_EQUAL(graphlets["10.0.0.1"], listed["10.0.0.1"]);
+	ASSERT_EQUAL(single_graphlet(flows, "10.0.0.5"), listed["10.0.0.5"]);
+
+	std::vector<std::string> invalid(1, "no_ip");
+	ASSERT_EQUAL(0u, libif.get_graphlets(flows, invalid, CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>(), collector));
+
+	unlink(flows.c_str());
+	unlink((flows + ".hidx").c_str());
+}
+
+void testWriteGraphlets() {
+	std::string flows = make_name(".gz");
+	write_flow_file(flows, make_client_flows(3, 10, 3, biflows_only));
+	char dir[] = "/tmp/test_ginterface_XXXXXX";
+	ASSERT(mkdtemp(dir) != NULL);
+
+	CInterface libif;
+	std::vector<std::string> all(1, "10.0.0.0/24");
+	ASSERT_EQUAL(3u, libif.write_graphlets(flows, all, CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>(), dir));
+	for (int h = 0; h < 3; h++) {
+		std::string IP = "10.0.0." + std::string(1, '0' + h), filename = std::string(dir) + "/" + IP + ".dot";
+		ASSERT_EQUAL(single_graphlet(flows, IP), read_contents(filename));
+		unlink(filename.c_str());
+	}
+	ASSERT_EQUAL(0u, libif.write_graphlets(flows, all, CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>(),
+	      std::string(dir) + "/missing"));
+
+	rmdir(dir);
+	unlink(flows.c_str());
+	unlink((flows + ".hidx").c_str());
+}
+
+void testWriteIndex() {
+	std::string flows = make_name(".gz");
+	write_flow_file(flows, make_client_flows(2, 10, 3, biflows_only));
+	std::string index = flows + ".hidx";
+
+	// Only loaded by default, written on request
+	ASSERT(!single_graphlet(flows, "10.0.0.1").empty());
+	ASSERT(access(index.c_str(), F_OK) != 0);
+	CInterface libif;
+	libif.set_write_index(true);
+	std::string dot_filename = make_name(".dot");
+	ASSERT(libif.get_graphlet(flows, dot_filename, "10.0.0.1", CInterface::summarize_all, (CInterface::filter_flags_t) 0, std::set<uint32_t>()));
+	ASSERT(access(index.c_str(), F_OK) == 0);
+	ASSERT_EQUAL(single_graphlet(flows, "10.0.0.1"), read_contents(dot_filename));
+
+	unlink(dot_filename.c_str());
+	unlink(index.c_str());
+	unlink(flows.c_str());
+}
+
+void testDesummarizedRoles() {
+	std::string flows = make_name(".gz");
+	write_flow_file(flows, make_client_flows(1, 10, 3, biflows_only));
+	std::string summarized = single_graphlet(flows, "10.0.0.0");
+	size_t pos = summarized.find("rolnum=\"");
+	ASSERT(pos != std::string::npos);
+	std::set<uint32_t> roles;
+	roles.insert(atoi(summarized.c_str() + pos + 8));
+
+	// Desummarized roles apply to their own request only
+	CInterface libif;
+	std::string desummarized = get_graphlet(libif, flows, "10.0.0.0", roles);
+	ASSERT(!desummarized.empty());
+	ASSERT(desummarized != summarized);
+	ASSERT_EQUAL(summarized, get_graphlet(libif, flows, "10.0.0.0", std::set<uint32_t>()));
+	ASSERT_EQUAL(desummarized, get_graphlet(libif, flows, "10.0.0.0", roles));
+
+	unlink(flows.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testGetGraphlets));
+	s.push_back(CUTE(testWriteGraphlets));
+	s.push_back(CUTE(testWriteIndex));
+	s.push_back(CUTE(testDesummarizedRoles));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_ginterface");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
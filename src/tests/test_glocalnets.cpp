@@ -0,0 +1,131 @@
+#include <string>
+#include <fstream>
+#include <unistd.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "glocalnets.h"
+
+void testEmpty() {
+	CLocalNets nets;
+	ASSERT(nets.empty());
+	ASSERT(!nets.is_local(IPv6_addr(0x0a000001)));
+	ASSERT(!nets.is_local(IPv6_addr("2001:db8::1")));
+}
+
+void testLongestPrefixMatch() {
+	CLocalNets nets;
+	int net8 = nets.add("10.0.0.0/8");
+	int net20 = nets.add("10.1.16.0/20");
+	int net32 = nets.add("10.1.17.3");
+	int net6 = nets.add("2001:db8::/32");
+	int net6_57 = nets.add("2001:db8:0:80::/57");
+	ASSERT_EQUAL(5, nets.size());
+	ASSERT_EQUAL(net8, nets.add("10.255.0.0/8")); // host bits are ignored: same prefix
+
+	ASSERT_EQUAL(net8, nets.lookup(IPv6_addr(0x0a000001)));
+	ASSERT_EQUAL(net20, nets.lookup(IPv6_addr(0x0a011001))); // 10.1.16.1
+	ASSERT_EQUAL(net20, nets.lookup(IPv6_addr(0x0a011fff))); // 10.1.31.255
+	ASSERT_EQUAL(net8, nets.lookup(IPv6_addr(0x0a012000))); // 10.1.32.0
+	ASSERT_EQUAL(net32, nets.lookup(IPv6_addr(0x0a011103))); // 10.1.17.3
+	ASSERT_EQUAL(CLocalNets::no_match, nets.lookup(IPv6_addr(0x0b000000)));
+	ASSERT_EQUAL(net6, nets.lookup(IPv6_addr("2001:db8:1::1")));
+	ASSERT_EQUAL(net6_57, nets.lookup(IPv6_addr("2001:db8:0:ff::1")));
+	ASSERT_EQUAL(net6, nets.lookup(IPv6_addr("2001:db8:0:7f::1")));
+	ASSERT_EQUAL(CLocalNets::no_match, nets.lookup(IPv6_addr("2001:db9::1")));
+
+	// Shorter prefix added after longer ones must not override them
+	nets.add("10.1.0.0/16");
+	ASSERT_EQUAL(net20, nets.lookup(IPv6_addr(0x0a011001)));
+	ASSERT_EQUAL(net32, nets.lookup(IPv6_addr(0x0a011103)));
+
+	ASSERT_EQUAL(20 + 96, nets.get_prefix(net20).length);
+	ASSERT_EQUAL(IPv6_addr(0x0a011000), nets.get_prefix(net20).net);
+	ASSERT_EQUAL(std::string("10.0.0.0/8"), nets.toString().substr(0, 10));
+}
+
+void testNetmask() {
+	// Single network given by address and netmask, as used by the import filters so far
+	CLocalNets nets(IPv6_addr(0x0a000000), IPv6_addr::getNetmask(104));
+	ASSERT_EQUAL(1, nets.size());
+	ASSERT(nets.is_local(IPv6_addr(0x0a0000ff)));
+	ASSERT(!nets.is_local(IPv6_addr(0xc0a80001)));
+
+	// All zero netmask: every address is local
+	CLocalNets all((IPv6_addr()), IPv6_addr());
+	ASSERT(all.is_local(IPv6_addr(0xc0a80001)));
+	ASSERT(all.is_local(IPv6_addr("2001:db8::1")));
+
+	// ::ffff:0:0/96 covers all IPv4 addresses, but no IPv6 address
+	CLocalNets ipv4;
+	ipv4.add("0.0.0.0/0");
+	ASSERT(ipv4.is_local(IPv6_addr(0xc0a80001)));
+	ASSERT(!ipv4.is_local(IPv6_addr("2001:db8::1")));
+}
+
+void testBatchLookup() {
+	CLocalNets nets;
+	nets.add("192.168.0.0/16");
+	nets.add("fe80::/10");
+	IPv6_addr IPs[5] = { IPv6_addr(0xc0a80001), IPv6_addr(0xc0a80001), IPv6_addr(0xc0a90001), IPv6_addr("fe80::1"), IPv6_addr("fec0::1") };
+	int matches[5];
+	nets.lookup(IPs, 5, matches);
+	for (int i = 0; i < 5; i++)
+		ASSERT_EQUAL(nets.lookup(IPs[i]), matches[i]);
+	ASSERT_EQUAL(0, matches[1]);
+	ASSERT_EQUAL(CLocalNets::no_match, matches[2]);
+	ASSERT_EQUAL(1, matches[3]);
+	ASSERT_EQUAL(CLocalNets::no_match, matches[4]);
+}
+
+void testLoad() {
+	std::string fn = "/tmp/hapviewer_test_localnets.txt";
+	{
+		std::ofstream out(fn.c_str());
+		out << "# site prefixes\n";
+		out << "10.0.0.0/8\n";
+		out << "\n";
+		out << "  172.16.0.0/12   # VPN\n";
+		out << "2001:db8::/48\r\n";
+	}
+	CLocalNets nets;
+	nets.load(fn);
+	ASSERT_EQUAL(3, nets.size());
+	ASSERT(nets.is_local(IPv6_addr(0xac1f0001))); // 172.31.0.1
+	ASSERT(!nets.is_local(IPv6_addr(0xac200001))); // 172.32.0.1
+	ASSERT(nets.is_local(IPv6_addr("2001:db8:0:1::1")));
+
+	{
+		std::ofstream out(fn.c_str());
+		out << "10.0.0.0/8\n";
+		out << "10.0.0.0/33\n";
+	}
+	try {
+		nets.load(fn);
+		FAILM("invalid prefix length accepted");
+	} catch (std::string & e) {
+		ASSERT(e.find(":2:") != std::string::npos);
+	}
+	unlink(fn.c_str());
+
+	ASSERT_THROWS(nets.add("not an address"), std::string);
+	ASSERT_THROWS(nets.load("/nonexistent/localnets"), std::string);
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testEmpty));
+	s.push_back(CUTE(testLongestPrefixMatch));
+	s.push_back(CUTE(testNetmask));
+	s.push_back(CUTE(testBatchLookup));
+	s.push_back(CUTE(testLoad));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_glocalnets");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
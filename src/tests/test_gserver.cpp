@@ -0,0 +1,177 @@
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <boost/thread.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "gserver.h"
+#include "test_fixtures.h"
+
+static size_t count_lines(const std::string & text) {
+	size_t lines = 0;
+	for (std::string::const_iterator it = text.begin(); it != text.end(); ++it)
+		if (*it == '\n')
+			lines++;
+	return lines;
+}
+
+void testRequests() {
+	std::string flows = make_name(".gz"), socket_path = make_name(".sock");
+	write_flow_file(flows, make_client_flows(5, 10, 3, biflows_only));
+	CGraphletServer server(socket_path, CLocalNets(), 2);
+	server.start();
+
+	std::string hosts = CGraphletServer::request(socket_path, "hosts " + flows);
+	ASSERT_EQUAL(5u, count_lines(hosts));
+	ASSERT_EQUAL(0u, hosts.find("10.0.0.0\t10\t0\t2\t"));
+
+	uint64_t time_us = 0;
+	std::string host_flows = CGraphletServer::request(socket_path, "flows " + flows + " 10.0.0.4", &time_us);
+	ASSERT_EQUAL(10u, count_lines(host_flows));
+	ASSERT_EQUAL(0u, host_flows.find("1042\t8.8.8.8\t53\t17\t4\t42\t10\t43\t4300\n"));
+
+	std::string dot = CGraphletServer::request(socket_path, "graphlet " + flows + " 10.0.0.2");
+	ASSERT(dot.find("graph G {") != std::string::npos);
+	ASSERT_EQUAL(dot, CGraphletServer::request(socket_path, "graphlet " + flows + " 10.0.0.2"));
+	std::string tcp_only = CGraphletServer::request(socket_path, "graphlet " + flows + " 10.0.0.2 summarize=0 expr=proto tcp");
+	ASSERT(tcp_only != dot);
+
+	ASSERT_THROWS(CGraphletServer::request(socket_path, "flows " + flows + " 10.0.0.9"), std::string);
+	ASSERT_THROWS(CGraphletServer::request(socket_path, "graphlet " + flows + " no_ip"), std::string);
+	ASSERT_THROWS(CGraphletServer::request(socket_path, "graphlet " + flows + " 10.0.0.2 expr=proto"), std::string);
+	ASSERT_THROWS(CGraphletServer::request(socket_path, "hosts /nonexistent.gz"), std::string);
+	ASSERT_THROWS(CGraphletServer::request(socket_path, "unknown"), std::string);
+
+	CGraphletServer::stats_t stats = server.get_stats();
+	ASSERT_EQUAL(1u, stats.datasets_loaded);
+	ASSERT_EQUAL(2u, stats.graphlets_built);
+	ASSERT_EQUAL(1u, stats.graphlets_cached);
+	ASSERT_EQUAL(5u, stats.errors);
+	ASSERT(CGraphletServer::request(socket_path, "stats").find("graphlets_cached\t1\n") != std::string::npos);
+
+	server.stop();
+	unlink(flows.c_str());
+	unlink((flows + ".hidx").c_str());
+}
+
+void testDatasetEviction() {
+	std::string first = make_name(".gz"), second = make_name(".gz"), socket_path = make_name(".sock");
+	write_flow_file(first, make_client_flows(5, 10, 3, biflows_only));
+	write_flow_file(second, make_client_flows(3, 10, 3, biflows_only));
+	CGraphletServer server(socket_path, CLocalNets(), 2);
+	server.set_dataset_memory_limit(0); // Keep the last data set only
+	server.start();
+
+	ASSERT_EQUAL(5u, count_lines(CGraphletServer::request(socket_path, "hosts " + first)));
+	ASSERT_EQUAL(3u, count_lines(CGraphletServer::request(socket_path, "hosts " + second)));
+	ASSERT_EQUAL(3u, count_lines(CGraphletServer::request(socket_path, "hosts " + second)));
+	ASSERT_EQUAL(5u, count_lines(CGraphletServer::request(socket_path, "hosts " + first)));
+
+	CGraphletServer::stats_t stats = server.get_stats();
+	ASSERT_EQUAL(3u, stats.datasets_loaded);
+	ASSERT_EQUAL(2u, stats.datasets_evicted);
+	ASSERT(CGraphletServer::request(socket_path, "stats").find("datasets\t1\n") != std::string::npos);
+
+	// Within the limit both stay loaded
+	server.set_dataset_memory_limit(CGraphletServer::default_dataset_memory_limit);
+	CGraphletServer::request(socket_path, "hosts " + second);
+	CGraphletServer::request(socket_path, "hosts " + first);
+	ASSERT_EQUAL(4u, server.get_stats().datasets_loaded);
+	ASSERT(CGraphletServer::request(socket_path, "stats").find("datasets\t2\n") != std::string::npos);
+
+	server.stop();
+	unlink(first.c_str());
+	unlink(second.c_str());
+}
+
+/**
+ *	Client thread: send mixed requests, count the failed ones.
+ */
+static void run_client(const std::string & socket_path, const std::string & flows, int client, int * failures) {
+	for (int i = 0; i < 10; i++) {
+		std::string IP = "10.0.0." + std::string(1, '0' + (client + i) % 5);
+		try {
+			if (count_lines(CGraphletServer::request(socket_path, "hosts " + flows)) != 5)
+				(*failures)++;
+			if (count_lines(CGraphletServer::request(socket_path, "flows " + flows + " " + IP)) != 10)
+				(*failures)++;
+			if (CGraphletServer::request(socket_path, "graphlet " + flows + " " + IP).find("graph G {") == std::string::npos)
+				(*failures)++;
+		} catch (std::string &) {
+			(*failures)++;
+		}
+	}
+}
+
+void testConcurrentClients() {
+	std::string flows = make_name(".gz"), socket_path = make_name(".sock");
+	write_flow_file(flows, make_client_flows(5, 10, 3, biflows_only));
+	CGraphletServer server(socket_path, CLocalNets(), 4);
+	server.start();
+
+	const int clients = 6;
+	int failures[clients] = { 0 };
+	boost::thread_group group;
+	for (int i = 0; i < clients; i++)
+		group.add_thread(new boost::thread(&run_client, socket_path, flows, i, &failures[i]));
+	group.join_all();
+	for (int i = 0; i < clients; i++)
+		ASSERT_EQUAL(0, failures[i]);
+
+	CGraphletServer::stats_t stats = server.get_stats();
+	ASSERT_EQUAL(1u, stats.datasets_loaded);
+	ASSERT_EQUAL(5u, stats.graphlets_built);
+	ASSERT_EQUAL((uint64_t) clients * 10 * 3, stats.requests);
+	server.stop();
+	unlink(flows.c_str());
+	unlink((flows + ".hidx").c_str());
+}
+
+void testIdleConnection() {
+	std::string flows = make_name(".gz"), socket_path = make_name(".sock");
+	write_flow_file(flows, make_client_flows(2, 10, 3, biflows_only));
+	CGraphletServer server(socket_path, CLocalNets(), 1);
+	server.set_idle_timeout(300);
+	server.start();
+
+	// An idle client holds the only worker until the idle timeout closes its connection
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT(fd >= 0);
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+	ASSERT_EQUAL(0, connect(fd, (struct sockaddr *) &addr, sizeof(addr)));
+	ASSERT_EQUAL(2u, count_lines(CGraphletServer::request(socket_path, "hosts " + flows)));
+	char c;
+	ASSERT_EQUAL(0, (int) read(fd, &c, 1)); // Closed by the server
+	close(fd);
+
+	server.stop();
+	unlink(flows.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testRequests));
+	s.push_back(CUTE(testDatasetEviction));
+	s.push_back(CUTE(testConcurrentClients));
+	s.push_back(CUTE(testIdleConnection));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gserver");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "gsnapshot.h"
+#include "test_fixtures.h"
+
+static CFlowList make_flows() {
+	CFlowList flows;
+	for (uint32_t i = 0; i < 100; i++)
+		flows.push_back(cflow_t(IPv6_addr(0x0a000000 + i / 10), 1000 + i, IPv6_addr(0x08080800 + i % 7), 80, IPPROTO_TCP, (i % 3 == 0) ? biflow
+		      : outflow, i, 10, 100 * i, i));
+	std::sort(flows.begin(), flows.end());
+	return flows;
+}
+
+void testImage() {
+	std::string name = make_name(".hsnap");
+	std::vector<int> numbers;
+	for (int i = 0; i < 1000; i++)
+		numbers.push_back(i * i);
+	std::vector<char> text(3, 'x');
+	std::vector<double> empty;
+	{
+		CSnapshotImage image;
+		image.add_section(CSnapshotImage::section_remoteIP_index, numbers);
+		image.add_section(CSnapshotImage::section_in_filename, text);
+		image.add_section(CSnapshotImage::section_hosts, empty);
+		ASSERT_THROWS(image.add_section(CSnapshotImage::section_hosts, empty), std::string);
+		image.write(name);
+	}
+
+	CSnapshotImage image(name);
+	ASSERT(image.has_section(CSnapshotImage::section_in_filename));
+	ASSERT(!image.has_section(CSnapshotImage::section_flows));
+	uint64_t count;
+	const void * data = image.get_section(CSnapshotImage::section_in_filename, sizeof(char), count);
+	ASSERT_EQUAL(0u, (size_t) data % CSnapshotImage::alignment);
+	ASSERT_EQUAL(3u, count);
+
+	std::vector<int> loaded;
+	image.get_section(CSnapshotImage::section_remoteIP_index, loaded);
+	ASSERT(numbers == loaded);
+	std::vector<double> loaded_empty(1);
+	image.get_section(CSnapshotImage::section_hosts, loaded_empty);
+	ASSERT(loaded_empty.empty());
+	std::vector<short> wrong_size;
+	ASSERT_THROWS(image.get_section(CSnapshotImage::section_remoteIP_index, wrong_size), std::string);
+	ASSERT_THROWS(image.get_section(CSnapshotImage::section_flows, wrong_size), std::string);
+
+	// Truncated image
+	ASSERT_EQUAL(0, truncate(name.c_str(), 1000));
+	ASSERT_THROWS(CSnapshotImage truncated(name), std::string);
+	unlink(name.c_str());
+	ASSERT_THROWS(CSnapshotImage missing(name), std::string);
+}
+
+void testImportSnapshot() {
+	std::string name = make_name(".hsnap");
+	prefs_t prefs;
+	CFlowList flows = make_flows();
+	{
+		CImport original(flows, prefs);
+		original.save_snapshot(name);
+	}
+	ASSERT(CImport::is_snapshot_filename(name));
+	ASSERT(CImport::acceptForImport(name));
+	ASSERT(!CImport::is_snapshot_filename(".hsnap"));
+
+	CImport resumed(CFlowList(), prefs);
+	resumed.load_snapshot(name);
+	ASSERT_EQUAL((int) flows.size(), resumed.get_flow_count());
+	Subflowlist loaded = resumed.get_flow(0, flows.size());
+	for (size_t i = 0; i < flows.size(); i++) {
+		ASSERT(flows[i].localIP == loaded[i].localIP);
+		ASSERT(flows[i].remoteIP == loaded[i].remoteIP);
+		ASSERT_EQUAL(flows[i].dOctets, loaded[i].dOctets);
+	}
+	ASSERT_EQUAL(15u, resumed.get_outside_graphlet_flows(IPv6_addr(0x08080800)).size());
+	resumed.get_hostMetadata();
+	ASSERT(IPv6_addr(0x0a000000) == resumed.get_first_host_metadata().IP);
+	ASSERT_EQUAL(10u, resumed.get_first_host_metadata().flow_count);
+
+	// Saved again with the host metadata, opened like a flow file
+	std::string name2 = make_name(".hsnap");
+	resumed.save_snapshot(name2);
+	CImport reopened(name2, "", prefs);
+	reopened.read_file();
+	ASSERT_EQUAL((int) flows.size(), reopened.get_flow_count());
+	reopened.get_hostMetadata();
+	ASSERT(IPv6_addr(0x0a000000) == reopened.get_first_host_metadata().IP);
+	ASSERT(IPv6_addr(0x0a000001) == reopened.get_next_host_metadata().IP);
+
+	unlink(name.c_str());
+	unlink(name2.c_str());
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testImage));
+	s.push_back(CUTE(testImportSnapshot));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gsnapshot");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
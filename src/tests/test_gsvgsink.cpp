@@ -0,0 +1,131 @@
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <boost/scoped_ptr.hpp>
+
+#include "cute.h"
+#include "ide_listener.h"
+#include "cute_runner.h"
+
+#include "cflow.h"
+#include "global.h"
+#include "gimport.h"
+#include "ghpgdata.h"
+#include "gsvgsink.h"
+#include "ggraphletexport.h"
+#include "test_fixtures.h"
+
+static size_t count(const std::string & text, const std::string & pattern) {
+	size_t n = 0;
+	for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+		n++;
+	return n;
+}
+
+void testGraphletImages() {
+	CFlowList flows = make_client_flows(3, 30, 4, with_inflows);
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	std::stringstream images;
+	CSvgSink sink(images);
+	for (size_t h = 0; h < hosts.size(); h++)
+		boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), sink, h, h == 0));
+	sink.finish();
+	ASSERT_EQUAL(3u, count(images.str(), "<svg "));
+	ASSERT_EQUAL(3u, count(images.str(), "</svg>"));
+
+	// An image of each graphlet: a line per edge, a box per summary node, a label per node
+	CHpgBufferSink buffer;
+	boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[1]), prefs_t(), desummarizedRoles(), buffer));
+	std::vector<hpg_field> & data = buffer.get_data();
+	std::stringstream image;
+	CSvgSink::write_svg(data, image);
+	std::string svg = image.str();
+	ASSERT_EQUAL(0u, svg.find("<?xml"));
+	ASSERT(svg.find("<title>10.0.0.1</title>") != std::string::npos);
+	ASSERT_EQUAL(std::string("</svg>\n"), svg.substr(svg.size() - 7));
+	size_t edges = 0;
+	std::set<std::string> summary_nodes, nodes;
+	for (size_t i = 0; i < data.size(); i += 3) {
+		rank_t rank = (rank_t) (data[i].eightbytevalue.data & 0xf);
+		if (ChpgData::get_partition(rank) == 0)
+			continue;
+		edges++;
+		nodes.insert(ChpgData::get_node_id(rank, data[i + 1], false));
+		nodes.insert(ChpgData::get_node_id(rank, data[i + 2], true));
+		if (ChpgData::is_summary_node(rank))
+			summary_nodes.insert(ChpgData::get_node_id(rank, data[i + 2], true));
+		else
+			ASSERT(svg.find(">" + ChpgData::get_node_label(rank, data[i + 2]) + "</text>") != std::string::npos);
+	}
+	ASSERT(!summary_nodes.empty());
+	ASSERT_EQUAL(edges, count(svg, "<line "));
+	ASSERT_EQUAL(summary_nodes.size() + 1, count(svg, "<rect ")); // And the background
+	ASSERT_EQUAL(nodes.size() - summary_nodes.size(), count(svg, "<ellipse "));
+	ASSERT(svg.find("marker-end=\"url(#arrow-red)\"") != std::string::npos);
+	ASSERT(svg.find("marker-start=\"url(#arrow-red)\"") != std::string::npos);
+	ASSERT(svg.find(">TCP</text>") != std::string::npos);
+
+	// No edges
+	data.resize(3);
+	std::stringstream empty;
+	ASSERT_THROWS(CSvgSink::write_svg(data, empty), std::string);
+}
+
+void testExport() {
+	char dir[] = "/tmp/test_gsvgsink_XXXXXX";
+	ASSERT(mkdtemp(dir) != NULL);
+	std::string filename = std::string(dir) + "/graphlets.hpg";
+	CFlowList flows = make_client_flows(4, 30, 4, with_inflows);
+	CImport import(flows, prefs_t());
+	import.get_hostMetadata();
+	const std::vector<ChostMetadata> & hosts = import.get_host_metadata();
+	std::stringstream images;
+	{
+		CHpgFileSink hpg(filename);
+		CSvgSink sink(images);
+		for (size_t h = 0; h < hosts.size(); h++) {
+			boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), hpg, h, h == 0));
+			boost::scoped_ptr<CSummaryNodeInfos>(import.build_graphlet(import.get_host_flowlist(hosts[h]), prefs_t(), desummarizedRoles(), sink, h));
+		}
+	}
+
+	ChpgData hpgData(filename);
+	hpgData.read_hpg_file();
+	hpgData.get_hpgMetadata();
+	CGraphletExport exporter(hpgData, dir, CGraphletExport::svg_format);
+	exporter.set_threads(2);
+	ASSERT_EQUAL(4u, exporter.export_graphlets());
+	std::string exported;
+	for (uint32_t h = 0; h < 4; h++) {
+		std::string name = std::string(dir) + "/" + IPv6_addr(0x0a000000 + h).toString() + ".svg";
+		std::ifstream in(name.c_str());
+		std::stringstream contents;
+		contents << in.rdbuf();
+		exported += contents.str();
+		unlink(name.c_str());
+	}
+	ASSERT_EQUAL(images.str(), exported);
+	unlink(filename.c_str());
+	rmdir(dir);
+}
+
+void runSuite() {
+	cute::suite s;
+	s.push_back(CUTE(testGraphletImages));
+	s.push_back(CUTE(testExport));
+	cute::ide_listener lis;
+	cute::makeRunner(lis)(s, "test_gsvgsink");
+}
+
+int main() {
+	runSuite();
+	return 0;
+}
@@ -9,6 +9,8 @@
 #include <netinet/ip6.h>
 #include <sys/socket.h>
 #include <iostream>
+#include <algorithm>
+#include <string.h>
 
 #include "IPv6_addr.h"
 
@@ -261,6 +263,38 @@ void test_lessOperator() {
 	ASSERT_EQUAL(false, huge < huge2);
 }
 
+void test_wordOperations() {
+	// Word wise comparison has to give the byte wise (lexicographic) order
+	uint32_t seed = 1;
+	for (int i = 0; i < 1000; i++) {
+		IPv6_addr a, b;
+		for (int j = 0; j < 16; j++) {
+			seed = seed * 1103515245 + 12345;
+			a[j] = (seed >> 16) & 0x03; // few values: many equal prefixes
+			b[j] = (seed >> 20) & 0x03;
+		}
+		bool bytewise_less = std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+		ASSERT_EQUAL(bytewise_less, a < b);
+		ASSERT_EQUAL(std::equal(a.begin(), a.end(), b.begin()), a == b);
+	}
+	IPv6_addr high_byte, low_byte;
+	high_byte[0] = 0x80;
+	low_byte[15] = 0xff;
+	ASSERT(low_byte < high_byte);
+
+	// IPv4-mapped test looks at exactly the first 12 bytes
+	ASSERT(get_IPv4_0().isIPv4());
+	IPv6_addr almost_v4 = get_IPv4_0();
+	almost_v4[9] = 1;
+	ASSERT(almost_v4.isIPv6());
+
+	// Hash: sum of the four 32 bit words
+	IPv6_addr ip("2001:db8::1");
+	uint32_t w[4];
+	memcpy(w, ip.begin(), sizeof(w));
+	ASSERT_EQUAL((w[0] + w[1] + w[2] + w[3]) & 0xffffff, ip.get24bitHash());
+}
+
 void runSuite() {
 	cute::suite s;
 	s.push_back(CUTE(test_ConstructorFromUint32_t));
@@ -270,6 +304,7 @@ void runSuite() {
 	s.push_back(CUTE(test_ipV6AddressToString));
 	s.push_back(CUTE(test_andOperator));
 	s.push_back(CUTE(test_lessOperator));
+	s.push_back(CUTE(test_wordOperations));
 	cute::ide_listener lis;
 	cute::makeRunner(lis)(s, "test_ipv6_addr");
 }